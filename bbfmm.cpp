@@ -0,0 +1,112 @@
+/* bbfmm.cpp
+ *
+ * Building blocks of the black-box fast multipole method: Chebyshev
+ * interpolation on the cluster boxes and the evaluation of the full space
+ * kernel between interpolation nodes.
+ */
+
+#include <math.h>
+#include <complex>
+#include "greeneval3d.h"
+#include "greenrotate3d.h"
+
+using namespace std;
+
+//==============================================================================
+void chebNodes(const unsigned int& p, double* const xNod)
+//==============================================================================
+{
+  const double pi=3.141592653589793;
+  for (unsigned int m=0; m<p; m++) xNod[m]=cos((2.0*m+1.0)*pi/(2.0*p));
+}
+
+//==============================================================================
+void chebInterp(const unsigned int& p, const double* const xNod,
+                const double& x, double* const S)
+/* S_m(x) = 1/p + 2/p sum_{k=1}^{p-1} T_k(x) T_k(xNod[m]), with the Chebyshev
+ * polynomials T_k evaluated by their three term recurrence.
+ */
+//==============================================================================
+{
+  for (unsigned int m=0; m<p; m++)
+  {
+    double Tx0=1.0;
+    double Tx1=x;
+    double Tm0=1.0;
+    double Tm1=xNod[m];
+    double sum=0.5;
+    for (unsigned int k=1; k<p; k++)
+    {
+      sum+=Tx1*Tm1;
+      const double Tx2=2.0*x*Tx1-Tx0;
+      const double Tm2=2.0*xNod[m]*Tm1-Tm0;
+      Tx0=Tx1;
+      Tx1=Tx2;
+      Tm0=Tm1;
+      Tm1=Tm2;
+    }
+    S[m]=2.0*sum/p;
+  }
+}
+
+//==============================================================================
+void fmmKernel3d(const void* const* const greenPtr, const bool& ugCmplx,
+                 const bool& tgCmplx, const double* const xTrg,
+                 const double* const xSrc, complex<double>* const K)
+//==============================================================================
+{
+  const unsigned int nGrSet=1;
+  const bool tg0Cmplx=false;
+  const bool UmatOut=true;
+  const bool TmatOut=true;
+
+  const double Xdiff=xSrc[0]-xTrg[0];
+  const double Ydiff=xSrc[1]-xTrg[1];
+  const double Zdiff=xSrc[2]-xTrg[2];
+  const double xiR=sqrt(Xdiff*Xdiff + Ydiff*Ydiff);
+  const double xiTheta=atan2(Ydiff,Xdiff);
+  const double xiZ=Zdiff;
+
+  unsigned int r1=0;
+  unsigned int r2=1;
+  unsigned int z1=0;
+  unsigned int z2=1;
+  unsigned int zs1=0;
+  bool extrapFlag=false;
+  double interpr[2];
+  double interpz[2];
+
+  double UgrRe[5];
+  double UgrIm[5];
+  double TgrRe[10];
+  double TgrIm[10];
+  double UXiRe[9];
+  double UXiIm[9];
+  double TXiRe[9];
+  double TXiIm[9];
+
+  const unsigned int zPos=2;
+  greeneval3d(greenPtr,nGrSet,ugCmplx,tgCmplx,tg0Cmplx,xiR,xiZ,r1,r2,z1,z2,zs1,
+              interpr,interpz,extrapFlag,UmatOut,TmatOut,xTrg,1,0,zPos,
+              UgrRe,UgrIm,TgrRe,TgrIm,0,0);
+
+  // The displacement kernel is evaluated once, the traction kernel for the
+  // three unit normals.
+  for (unsigned int iDir=0; iDir<3; iDir++)
+  {
+    double normal[3]={0.0,0.0,0.0};
+    normal[iDir]=1.0;
+    greenrotate3d(normal,0,xiTheta,nGrSet,ugCmplx,tgCmplx,tg0Cmplx,
+                  UgrRe,UgrIm,TgrRe,TgrIm,0,0,UXiRe,UXiIm,TXiRe,TXiIm,0,0,
+                  iDir==0,TmatOut);
+    if (iDir==0)
+    {
+      for (unsigned int a=0; a<3; a++)
+        for (unsigned int b=0; b<3; b++)
+          K[a+3*b]=complex<double>(UXiRe[3*a+b],(ugCmplx ? UXiIm[3*a+b] : 0.0));
+    }
+    for (unsigned int a=0; a<3; a++)
+      for (unsigned int b=0; b<3; b++)
+        K[a+3*(3+3*iDir+b)]=complex<double>(TXiRe[3*a+b],(tgCmplx ? TXiIm[3*a+b] : 0.0));
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef _CHEBNODES_
+#define _CHEBNODES_
+void chebNodes(const unsigned int& p, double* const xNod);
+/*   Chebyshev nodes of the first kind on [-1,1].
+ *   p     Number of nodes.
+ *   xNod  Nodes xNod[m] = cos((2m+1)pi/(2p)) (p).
+ */
+#endif
+
+#ifndef _CHEBINTERP_
+#define _CHEBINTERP_
+void chebInterp(const unsigned int& p, const double* const xNod,
+                const double& x, double* const S);
+/*   Chebyshev interpolation weights in a point of [-1,1].
+ *   p     Number of nodes.
+ *   xNod  Chebyshev nodes (p).
+ *   x     Point where the interpolant is evaluated.
+ *   S     Weights (p), such that f(x) = sum_m S[m]*f(xNod[m]).
+ */
+#endif
+
+#ifndef _FMMKERNEL3D_
+#define _FMMKERNEL3D_
+void fmmKernel3d(const void* const* const greenPtr, const bool& ugCmplx,
+                 const bool& tgCmplx, const double* const xTrg,
+                 const double* const xSrc, std::complex<double>* const K);
+/*   Full space Green's function between a target and a source point, as used
+ *   by the black-box fast multipole method. The traction kernel is linear in
+ *   the normal and is split into its contributions for the unit normals.
+ *   greenPtr  Green's function pointer array (type 3, a single set).
+ *   xTrg      Target (collocation) point coordinates (3).
+ *   xSrc      Source (integration) point coordinates (3).
+ *   K         Kernel (3 * 12) [Ug Tg(ex) Tg(ey) Tg(ez)], column major.
+ */
+#endif
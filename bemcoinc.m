@@ -0,0 +1,12 @@
+%BEMCOINC   Coincident points.
+%
+%   master = BEMCOINC(x,tol) finds the points that coincide with a point
+%   that precedes them. For each point j, master(j) is the smallest index i<j
+%   such that the distance between the points i and j is smaller than tol,
+%   or 0 if there is no such point. The points are sorted into a grid of
+%   cells of size tol, so that only the points in neighbouring cells are
+%   compared.
+%
+%   x       Point coordinates (nPoint * 3).
+%   tol     Tolerance for point coincidence (1 * 1).
+%   master  Index of the master point (nPoint * 1).
@@ -0,0 +1,71 @@
+/*BEMCOINC   Coincident points.
+ *
+ *   master = BEMCOINC(x,tol) finds the points that coincide with a point
+ *   that precedes them. For each point j, master(j) is the smallest index i<j
+ *   such that the distance between the points i and j is smaller than tol,
+ *   or 0 if there is no such point. The points are sorted into a grid of
+ *   cells of size tol, so that only the points in neighbouring cells are
+ *   compared.
+ *
+ *   x       Point coordinates (nPoint * 3).
+ *   tol     Tolerance for point coincidence (1 * 1).
+ *   master  Index of the master point (nPoint * 1).
+ */
+
+/* $Make: mex -O -output bemcoinc bemcoinc_mex.cpp pointgrid.cpp checklicense.cpp ripemd128.cpp$*/
+
+#include "mex.h"
+#include <new>
+#include "pointgrid.h"
+#include "checklicense.h"
+
+using namespace std;
+
+//==============================================================================
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+//==============================================================================
+{
+  PointGrid grid={};
+  unsigned int* near=0;
+  const char* error=0;
+  try
+  {
+    checklicense();
+
+    if (nrhs<2) throw("Not enough input arguments.");
+    if (nrhs>2) throw("Too many input arguments.");
+    if (nlhs>1) throw("Too many output arguments.");
+
+    if (!mxIsDouble(prhs[0]) || mxIsSparse(prhs[0]) || mxIsComplex(prhs[0]))
+      throw("Input argument 'x' must be a real full matrix.");
+    if (mxGetN(prhs[0])!=3) throw("Input argument 'x' should have 3 columns.");
+    const unsigned int nPoint=mxGetM(prhs[0]);
+    const double* const x=mxGetPr(prhs[0]);
+
+    if (!mxIsDouble(prhs[1]) || mxIsComplex(prhs[1]) || (mxGetNumberOfElements(prhs[1])!=1))
+      throw("Input argument 'tol' must be a real scalar.");
+    const double tol=mxGetScalar(prhs[1]);
+    if (!(tol>=0.0)) throw("Input argument 'tol' must not be negative.");
+
+    plhs[0]=mxCreateDoubleMatrix(nPoint,1,mxREAL);
+    double* const master=mxGetPr(plhs[0]);
+    if (nPoint>0)
+    {
+      near=new(nothrow) unsigned int[nPoint];
+      if (near==0) throw("Out of memory.");
+      pointgridinit(x,nPoint,tol,grid);
+      for (unsigned int jPoint=0; jPoint<nPoint; jPoint++)
+      {
+        const unsigned int nNear=pointgridnear(grid,jPoint,tol,false,near);
+        master[jPoint]=((nNear>0) && (near[0]<jPoint) ? near[0]+1 : 0.0);
+      }
+    }
+  }
+  catch (const char* exception)
+  {
+    error=exception;
+  }
+  pointgridclear(grid);
+  delete [] near;
+  if (error!=0) mexErrMsgTxt(error);
+}
@@ -1,6 +1,7 @@
 #include "eltdef.h"
 #include "mex.h"
 #include "shapefun.h"
+#include "pointgrid.h"
 #include <complex>
 
 using namespace std;
@@ -226,37 +227,69 @@ void BemCollCoords(const double* const Elt, const double* const Nod,
 void BemCoincNodes(const double* const Nod, const unsigned int& nNod,
                    double* const CoincNod, bool& SlavesExist)
 /*
- *  Retreive coincident nodes from a given node list.
+ *  Retreive coincident nodes from a given node list. The nodes are sorted
+ *  into a grid of cells (pointgrid), so that only the nodes in the
+ *  neighbouring cells are compared.
+ *
+ *  CoincNod[0*nNod+iNod]  1 for a slave node, 0 for a master node.
+ *  CoincNod[1*nNod+iNod]  Node number of the master of a slave node.
+ *  CoincNod[2*nNod+iNod]  Index of the next node in the ring of the master
+ *                         node and its slave nodes, or iNod.
  */
 {
-  double diff;
   const double CoincEps=1.0e-10;
   SlavesExist =false;
   for (unsigned int iNod=0; iNod<2*nNod; iNod++) CoincNod[iNod]=0.0;
+  for (unsigned int iNod=0; iNod<nNod; iNod++) CoincNod[2*nNod+iNod]=iNod;
+  if (nNod==0) return;
+
+  unsigned int* const master=new(nothrow) unsigned int[2*nNod];
+  if (master==0) throw("Out of memory.");
+  unsigned int* const near=master+nNod;
+  PointGrid grid;
+  try
+  {
+    pointgridinit(Nod+nNod,nNod,CoincEps,grid);
+  }
+  catch (const char*)
+  {
+    delete [] master;
+    throw;
+  }
+
+  // A MASTER NODE CLAIMS ALL LATER NODES WITHIN CoincEps
+  for (unsigned int iNod=0; iNod<nNod; iNod++) master[iNod]=iNod;
   for (unsigned int iNod=0; iNod<nNod-1; iNod++)
   {
     if (CoincNod[iNod]==0)
     {
-      for (unsigned int jNod=iNod+1; jNod<nNod; jNod++)
+      const unsigned int nNear=pointgridnear(grid,iNod,CoincEps,true,near);
+      for (unsigned int iNear=0; iNear<nNear; iNear++)
       {
-        diff=fabs(Nod[nNod+iNod]-Nod[nNod+jNod]);
-        if (diff<CoincEps)
+        const unsigned int jNod=near[iNear];
+        if (jNod>iNod)
         {
-          diff=fabs(Nod[2*nNod+iNod]-Nod[2*nNod+jNod]);
-          if (diff<CoincEps)
-          {
-            diff=fabs(Nod[3*nNod+iNod]-Nod[3*nNod+jNod]);
-            if (diff<CoincEps)
-            {
-              CoincNod[jNod]=1.0;
-              CoincNod[nNod+jNod]=Nod[iNod];
-              SlavesExist = true;
-            }
-          }
+          CoincNod[jNod]=1.0;
+          CoincNod[nNod+jNod]=Nod[iNod];
+          master[jNod]=iNod;
+          SlavesExist = true;
         }
       }
     }
   }
+  pointgridclear(grid);
+
+  // RINGS OF COINCIDENT NODES
+  for (unsigned int jNod=0; jNod<nNod; jNod++)
+  {
+    if (master[jNod]!=jNod)
+    {
+      const unsigned int iNod=master[jNod];
+      CoincNod[2*nNod+jNod]=CoincNod[2*nNod+iNod];
+      CoincNod[2*nNod+iNod]=jNod;
+    }
+  }
+  delete [] master;
 }
 
 void BemEltCollIndex(const double* const Elt, const unsigned int& iElt, const unsigned int& nElt,
@@ -335,8 +368,6 @@ void BemRegularColl(const double* const Elt,const unsigned int& iElt,
   unsigned int nGaussSing;
   unsigned int nEltDivSing;
 
-  unsigned int masterNodID;
-
   unsigned int EltType = (unsigned int)(Elt[nElt+iElt]);
   eltdef(EltType,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
          nEltType,EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,
@@ -358,29 +389,23 @@ void BemRegularColl(const double* const Elt,const unsigned int& iElt,
     // --- Check for other coincident nodes and remove if collocation point.
     if (SlavesExist)
     {
-      if (CoincNod[NodIndex]==1)   // node is a SLAVE node.
-      {
-        masterNodID = int(CoincNod[nNod+NodIndex]);
-      }
-      else masterNodID = NodID;     // else it is a MASTER node.
-      
-      for (unsigned int jNod=0; jNod<nNod; jNod++)
+      // The ring of the node contains its master and the slaves of the master
+      // ==> are singular as a collocation point.
+      unsigned int jNod=NodIndex;
+      do
       {
-        if (((CoincNod[jNod]==1) && ((unsigned int)(CoincNod[nNod+jNod])==masterNodID)) || ((unsigned int)(Nod[jNod])==masterNodID))
-        // The node is a slave node with the same master or the master itsself
-        // ==> is singular as a collocation point.
+        for (unsigned int iColl=nCentroidColl; iColl<nTotalColl; iColl++)
         {
-          for (unsigned int iColl=nCentroidColl; iColl<nTotalColl; iColl++)
+          if (((unsigned int)(CollPoints[nTotalColl+iColl])==(unsigned int)(Nod[jNod])) && (!(RegularColl[iColl]==0)))
           {
-            if (((unsigned int)(CollPoints[nTotalColl+iColl])==(unsigned int)(Nod[jNod])) && (!(RegularColl[iColl]==0)))
-            {
-              RegularColl[iColl]=0;
-              RegularColl[nTotalColl+iColl]=iNod;
-              nSingularColl++;
-            }
+            RegularColl[iColl]=0;
+            RegularColl[nTotalColl+iColl]=iNod;
+            nSingularColl++;
           }
         }
+        jNod=(unsigned int)(CoincNod[2*nNod+jNod]);
       }
+      while (jNod!=(unsigned int)NodIndex);
     }
   }
   nRegularColl=nTotalColl-nSingularColl;
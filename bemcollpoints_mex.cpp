@@ -14,7 +14,7 @@
  */
 
 /* $Make: mex -O -output bemcollpoints bemcollpoints_mex.cpp eltdef.cpp
-                         bemcollpoints.cpp shapefun.cpp$*/
+                         bemcollpoints.cpp pointgrid.cpp shapefun.cpp$*/
                          
 #include "mex.h"
 #include "string"
@@ -55,14 +55,7 @@ mu=E/2/(1+nu);
 ID(find(colTyp==1))=NaN; % REMOVE ELEMENT COLLOCATION POINTS FROM ID.
 
 nCol=size(col,1);
-slaves=zeros(nCol,1);  % master=0, slave=masterindex
-for iCol=1:nCol
-  for jCol=iCol+1:nCol
-    if (norm(col(iCol,:)-col(jCol,:)) < CoincEps) && ~slaves(jCol)
-      slaves(jCol)=iCol;
-    end
-  end
-end
+slaves=bemcoinc(col,CoincEps);  % master=0, slave=masterindex
 slaveInd=find(slaves);
 nSlave=length(slaveInd);
 
@@ -84,34 +77,44 @@ ID2=nod(notcornerInd,:);
 
 nCornerNod=length(cornerInd);
 
+% FIRST ELEMENT OF EACH COLLOCATION POINT AND COLLOCATION POINT OF EACH NODE
+eltNod=elt(:,3:end);
+[nodID,order]=sort(eltNod(:));          % stable: first occurrence first
+isFirst=[true; diff(nodID)~=0];
+nodID=nodID(isFirst);
+order=order(isFirst);
+[isNod,loc]=ismember(ID,nodID);
+[colElt,colEltNod]=ind2sub(size(eltNod),order(loc(isNod)));
+firstElt=zeros(nCol,1);
+firstEltNod=zeros(nCol,1);
+firstElt(isNod)=colElt;
+firstEltNod(isNod)=colEltNod;
+[isCol,eltColInd]=ismember(eltNod,ID);
+
 Tc=zeros(nColDof*nCornerNod,nColDof*nCol);
 for iSlave=1:nSlave
   masterInd=slaves(slaveInd(iSlave));
 
   % ELEMENT OF MASTER NODE
-  [iElt,iEltNod]=find(elt(:,3:end)==ID(masterInd),1); % Take normal of first element found
+  iElt=firstElt(masterInd); % Take normal of first element found
+  iEltNod=firstEltNod(masterInd);
   [mEltMap,mEltNod,mEltCol,mNShape,mMShape,mNodXi]=bemeltdef(elt(iElt,2),typ);
   mXi=mNodXi(iEltNod,:);
   n1 = bemnormal(nod,elt(iElt,:),typ,mXi);
   tan1 = bemtangent(nod,elt(iElt,:),typ,mXi);
-  mInd=[];
-  for iEltNod=1:mEltNod
-    mInd(iEltNod)=find((ID==elt(iElt,2+iEltNod)));
-  end
+  mInd=eltColInd(iElt,1:mEltNod);
   mCorner=find(cornerInd==masterInd);
   if dim==2, mXi=mXi(1); end
   dN1 = bemshapederiv(mMShape,mXi);
 
   % ELEMENT OF SLAVE NODE
-  [iElt,iEltNod]=find(elt(:,3:end)==ID(slaveInd(iSlave)),1); % Take normal of first element found
+  iElt=firstElt(slaveInd(iSlave)); % Take normal of first element found
+  iEltNod=firstEltNod(slaveInd(iSlave));
   [nEltMap,nEltNod,nEltCol,nNShape,nMShape,nNodXi]=bemeltdef(elt(iElt,2),typ);
   nXi=nNodXi(iEltNod,:);
   n2 = bemnormal(nod,elt(iElt,:),typ,nXi);
   tan2 = bemtangent(nod,elt(iElt,:),typ,nXi);
-  nInd=[];
-  for iEltNod=1:nEltNod
-    nInd(iEltNod)=find((ID==elt(iElt,2+iEltNod)));
-  end
+  nInd=eltColInd(iElt,1:nEltNod);
   nCorner=find(cornerInd==slaveInd(iSlave));
   if dim==2, nXi=nXi(1); end
   dN2 = bemshapederiv(nMShape,nXi);
@@ -0,0 +1,1243 @@
+/*BEMFMM   Black-box fast multipole method for boundary element matrices.
+ *
+ *   s = BEMFMM('init',nod,elt,typ,green,...) prepares the fast evaluation of
+ *   the boundary element matrix vector products U*t and T*u for a full space
+ *   Green's function. The collocation points are sorted in an octree. The
+ *   integration points of every element are assigned to the box of the
+ *   collocation point of the matrix column they contribute to, so that every
+ *   entry (i,j) of the matrices is either near or far, depending on the boxes
+ *   of the collocation points i and j. The indices s of the near entries are
+ *   returned as one submatrix per leaf box; these entries are computed by
+ *   BEMMAT, which also accounts for the singular integrals and the free term.
+ *   The mesh is cached by BEMMAT once, and all near entries are computed by a
+ *   single call:
+ *
+ *     s = bemfmm('init',nod,elt,typ,green,...);
+ *     ind = cell2mat(cellfun(@(x) x(:),s,'UniformOutput',false));
+ *     [i,j] = ind2sub([nDof nDof],ind);
+ *     bemmat(nod,elt,typ);
+ *     [Uv,Tv] = bemmat(ind,green,...);
+ *     Un = sparse(i,j,Uv,nDof,nDof); Tn = sparse(i,j,Tv,nDof,nDof);
+ *
+ *   The far entries are never assembled. Their contribution is evaluated
+ *   with the black-box fast multipole method, by Chebyshev interpolation of
+ *   the Green's function on the octree boxes, at a cost that is proportional
+ *   to the number of collocation points:
+ *
+ *     y = Un*t - Tn*u + bemfmm('apply',t,u);
+ *
+ *   The setup of the near field is not linear in the number of collocation
+ *   points: BEMMAT loops over all elements for every call, and the
+ *   regularisation of the diagonal of T integrates over the whole boundary
+ *   for every collocation point, so that its cost grows with the square of
+ *   the number of collocation points. It remains much smaller than the cost
+ *   of the complete matrices.
+ *
+ *   The interpolation of the Green's function requires that the boxes are
+ *   small with respect to the wavelength; the method is intended for low and
+ *   moderate frequencies.
+ *
+ *   s = BEMFMM('init',nod,elt,typ,opts,green,...) uses the options
+ *   opts = [p nLeaf maxMem], where p is the number of Chebyshev nodes per
+ *   direction (default 4), nLeaf the average number of collocation points
+ *   per leaf box (default 32) and maxMem the memory limit of the stored
+ *   interaction operators in MB (default 1024). An interaction operator
+ *   takes 576*p^6 bytes, about 2.4 MB for p = 4, and every level of the
+ *   octree needs up to 316 operators, about 745 MB for p = 4. Operators
+ *   beyond the memory limit are not stored but recomputed once per level by
+ *   every call of BEMFMM('apply'); maxMem = 0 stores no operators.
+ *   yf = BEMFMM('apply',t,u) evaluates the far field contribution to U*t-T*u.
+ *   If u is empty, only the contribution to U*t is evaluated.
+ *   BEMFMM('clear') clears the octree and the interaction operators.
+ *
+ *   Depending on the Green's function, the following syntax is used:
+ *
+ *   s = BEMFMM('init',nod,elt,typ,'fsgreen3d0',E,nu)
+ *   s = BEMFMM('init',nod,elt,typ,'fsgreen3d',Cs,Cp,Ds,Dp,rho,omega)
+ *
+ *   nod      Nodes (nNod * 4). Each row has the layout [nodID x y z] where
+ *            nodID is the node number and x, y, and z are the nodal
+ *            coordinates.
+ *   elt      Elements (nElt * nColumn). Each row has the layout
+ *            [eltID typID n1 n2 n3 ... ] where eltID is the element number,
+ *            typID is the element type number and n1, n2, n3, ... are the node
+ *            numbers representing the nodal connectivity of the element.
+ *   typ      Element type definitions. Cell array with the layout
+ *            {{typID type keyOpts} ... } where typID is the element type number,
+ *            type is the element type (string) and keyOpts is a cell array of
+ *            strings with key options.
+ *   opts     Options [p nLeaf maxMem] (1 * 3).
+ *   green    Green's function (string).
+ *   E        Young's modulus (1 * 1).
+ *   nu       Poisson coefficient (1 * 1).
+ *   Cs       Shear wave velocity (1 * 1).
+ *   Cp       Dilatational wave velocity (1 * 1).
+ *   Ds       Shear damping ratio (1 * 1).
+ *   Dp       Dilatational damping ratio (1 * 1).
+ *   rho      Density (1 * 1).
+ *   omega    Circular frequency (1 * 1).
+ *   s        Linear indices of the near entries in the (nDof * nDof)
+ *            matrices. Cell array (nLeaf * 1) with a submatrix for every
+ *            leaf box.
+ *   t        Boundary element tractions (nDof * nLoad).
+ *   u        Boundary element displacements (nDof * nLoad) or empty.
+ *   yf       Far field contribution to U*t-T*u (nDof * nLoad).
+ */
+
+/* $Make: mex -O -output bemfmm bemfmm_mex.cpp bbfmm.cpp eltdef.cpp
+                                bemcollpoints.cpp pointgrid.cpp shapefun.cpp bemnormal.cpp
+                                gausspw.cpp bemdimension.cpp bemisaxisym.cpp
+                                bemisperiodic.cpp greeneval3d.cpp greeninterp.cpp greenrotate3d.cpp
+                                fsgreen3d.cpp fsgreen3dt.cpp search1.cpp
+                                checklicense.cpp ripemd128.cpp$*/
+
+#include "mex.h"
+#include <string.h>
+#include <math.h>
+#include <complex>
+#include <algorithm>
+#include <new>
+#include "eltdef.h"
+#include "bemcollpoints.h"
+#include "bemdimension.h"
+#include "bemisaxisym.h"
+#include "bemisperiodic.h"
+#include "gausspw.h"
+#include "shapefun.h"
+#include "bemnormal.h"
+#include "bbfmm.h"
+#include "checklicense.h"
+
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
+#ifndef _int64_
+typedef unsigned long long int uint64;
+#endif
+
+using namespace std;
+
+// Number of charges per source point: the tractions (3) and the
+// displacements multiplied by the three components of the normal (9).
+const unsigned int nq=12;
+
+// Maximum octree depth, limited by the 21 bits per direction in the box keys.
+const unsigned int maxLevel=20;
+
+// Relative translations of two boxes at the same level in the interaction
+// lists are in the range -3..3 in every direction.
+const unsigned int nOffset=343;
+
+//==============================================================================
+// PERSISTENT OCTREE AND INTERACTION OPERATORS
+//==============================================================================
+static bool FmmValid=false;
+static unsigned int nColl=0;
+static unsigned int p=0;              // Chebyshev nodes per direction
+static unsigned int nNode=0;          // Chebyshev nodes per box (p^3)
+static double xNod[16];               // Chebyshev nodes on [-1,1]
+static unsigned int nLevel=0;         // Leaf level
+static double rootMin[3]={0.0,0.0,0.0};
+static double rootSize=0.0;           // Width of the root box
+static double margin=0.0;             // Maximum distance of a source point to
+                                      // the collocation point of its column
+static unsigned int* nBox=0;          // Number of boxes per level (nLevel+1)
+static uint64** boxKey=0;             // Sorted box keys per level
+static unsigned int** boxParent=0;    // Parent box per level
+static unsigned int** interBeg=0;     // Interaction list per level (nBox+1)
+static unsigned int** interBox=0;     // Source box of the interaction
+static unsigned int** interOp=0;      // Relative translation of the interaction
+static complex<double>** M2L=0;       // Interaction operators per level and
+                                      // translation (3*nNode * nq*nNode)
+static double maxOpMemory=0.0;        // Memory limit of the stored operators
+static double opMemory=0.0;           // Memory of the stored operators
+static double** M2M=0;                // Transfer operators per child level and
+                                      // octant (8 * nNode * nNode)
+static unsigned int* trgBeg=0;        // Collocation points per leaf (nLeaf+1)
+static unsigned int* trgInd=0;        // Collocation points sorted per leaf
+static double* trgPos=0;              // Collocation point coordinates (3 * nColl)
+static unsigned int nSrc=0;
+static unsigned int* srcBeg=0;        // Source points per leaf (nLeaf+1)
+static double* srcPos=0;              // Source coordinates (3 * nSrc)
+static double* srcNrm=0;              // Source normals (3 * nSrc)
+static double* srcW=0;                // Integration weights (nSrc)
+static unsigned int* srcCol=0;        // Collocation point of the column (nSrc)
+
+// Green's function
+static unsigned int GreenFunType=3;
+static double Cs=0.0;
+static double Cp=0.0;
+static double Ds=0.0;
+static double Dp=0.0;
+static double rho=0.0;
+static unsigned int nFreq=1;
+static double omega[1]={0.0};
+static const void* greenPtr[8];
+static bool ugCmplx=false;
+static bool tgCmplx=false;
+
+//==============================================================================
+void cleanup()
+//==============================================================================
+{
+  FmmValid=false;
+  for (unsigned int l=0; l<=nLevel; l++)
+  {
+    if ((boxKey!=0) && (boxKey[l]!=0)) delete [] boxKey[l];
+    if ((boxParent!=0) && (boxParent[l]!=0)) delete [] boxParent[l];
+    if ((interBeg!=0) && (interBeg[l]!=0)) delete [] interBeg[l];
+    if ((interBox!=0) && (interBox[l]!=0)) delete [] interBox[l];
+    if ((interOp!=0) && (interOp[l]!=0)) delete [] interOp[l];
+    if ((M2M!=0) && (M2M[l]!=0)) delete [] M2M[l];
+    if (M2L!=0)
+      for (unsigned int iOff=0; iOff<nOffset; iOff++)
+        if (M2L[nOffset*l+iOff]!=0) delete [] M2L[nOffset*l+iOff];
+  }
+  if (boxKey!=0) {delete [] boxKey; boxKey=0;}
+  if (boxParent!=0) {delete [] boxParent; boxParent=0;}
+  if (interBeg!=0) {delete [] interBeg; interBeg=0;}
+  if (interBox!=0) {delete [] interBox; interBox=0;}
+  if (interOp!=0) {delete [] interOp; interOp=0;}
+  if (M2M!=0) {delete [] M2M; M2M=0;}
+  if (M2L!=0) {delete [] M2L; M2L=0;}
+  if (nBox!=0) {delete [] nBox; nBox=0;}
+  if (trgBeg!=0) {delete [] trgBeg; trgBeg=0;}
+  if (trgInd!=0) {delete [] trgInd; trgInd=0;}
+  if (trgPos!=0) {delete [] trgPos; trgPos=0;}
+  if (srcBeg!=0) {delete [] srcBeg; srcBeg=0;}
+  if (srcPos!=0) {delete [] srcPos; srcPos=0;}
+  if (srcNrm!=0) {delete [] srcNrm; srcNrm=0;}
+  if (srcW!=0) {delete [] srcW; srcW=0;}
+  if (srcCol!=0) {delete [] srcCol; srcCol=0;}
+  nColl=0;
+  nSrc=0;
+  nLevel=0;
+  opMemory=0.0;
+  p=0;
+  nNode=0;
+}
+
+//==============================================================================
+// OCTREE
+//==============================================================================
+inline uint64 keyOf(const unsigned int* const ix)
+{
+  return (uint64)ix[0] | ((uint64)ix[1]<<21) | ((uint64)ix[2]<<42);
+}
+
+inline void keyIndex(const uint64& key, int* const ix)
+{
+  const uint64 mask=(1<<21)-1;
+  ix[0]=(int)(key & mask);
+  ix[1]=(int)((key>>21) & mask);
+  ix[2]=(int)((key>>42) & mask);
+}
+
+//==============================================================================
+uint64 pointKey(const double* const x, const unsigned int& level)
+//==============================================================================
+{
+  const unsigned int nSide=1u<<level;
+  const double h=rootSize/nSide;
+  unsigned int ix[3];
+  for (unsigned int d=0; d<3; d++)
+  {
+    const double xi=floor((x[d]-rootMin[d])/h);
+    ix[d]=(xi<0.0 ? 0 : (xi>=nSide ? nSide-1 : (unsigned int)xi));
+  }
+  return keyOf(ix);
+}
+
+//==============================================================================
+int findBox(const unsigned int& level, const int* const ix)
+/* Index of the box with integer coordinates ix at a level, or -1 if the box
+ * is out of range or does not contain collocation points.
+ */
+//==============================================================================
+{
+  const int nSide=1<<level;
+  for (unsigned int d=0; d<3; d++) if ((ix[d]<0) || (ix[d]>=nSide)) return -1;
+  unsigned int jx[3]={(unsigned int)ix[0],(unsigned int)ix[1],(unsigned int)ix[2]};
+  const uint64 key=keyOf(jx);
+  const uint64* const keys=boxKey[level];
+  const uint64* const pos=lower_bound(keys,keys+nBox[level],key);
+  if ((pos==keys+nBox[level]) || (*pos!=key)) return -1;
+  return (int)(pos-keys);
+}
+
+//==============================================================================
+unsigned int levelKeys(const unsigned int& level, uint64* const keys)
+/* Sorted unique keys of the boxes at a level that contain collocation points.
+ */
+//==============================================================================
+{
+  for (unsigned int iColl=0; iColl<nColl; iColl++) keys[iColl]=pointKey(trgPos+3*iColl,level);
+  sort(keys,keys+nColl);
+  return (unsigned int)(unique(keys,keys+nColl)-keys);
+}
+
+//==============================================================================
+void boxCenter(const unsigned int& level, const unsigned int& iBox, double* const c)
+//==============================================================================
+{
+  const double h=rootSize/(1u<<level);
+  int ix[3];
+  keyIndex(boxKey[level][iBox],ix);
+  for (unsigned int d=0; d<3; d++) c[d]=rootMin[d]+(ix[d]+0.5)*h;
+}
+
+// Half width of the interpolation domain of a box, which is enlarged such
+// that it contains all source points assigned to the box.
+inline double domainHalf(const unsigned int& level)
+{
+  return 0.5*rootSize/(1u<<level)+margin;
+}
+
+//==============================================================================
+void interpWeights(const double* const x, const double* const c, const double& a,
+                   double* const S)
+/* Tensor product interpolation weights (nNode) of the point x in the domain
+ * with center c and half width a.
+ */
+//==============================================================================
+{
+  double S1[48];
+  for (unsigned int d=0; d<3; d++) chebInterp(p,xNod,(x[d]-c[d])/a,S1+p*d);
+  for (unsigned int m2=0; m2<p; m2++)
+    for (unsigned int m1=0; m1<p; m1++)
+      for (unsigned int m0=0; m0<p; m0++)
+        S[m0+p*(m1+p*m2)]=S1[m0]*S1[p+m1]*S1[2*p+m2];
+}
+
+//==============================================================================
+void interactionOp(const unsigned int& level, const unsigned int& iOff,
+                   complex<double>* const Op)
+/* Interaction operator between the nodes of two boxes at a level
+ * (3*nNode * nq*nNode). The operator only depends on the relative
+ * translation of the boxes.
+ */
+//==============================================================================
+{
+  const double h=rootSize/(1u<<level);
+  const double a=domainHalf(level);
+  const int off[3]={(int)(iOff%7)-3,(int)((iOff/7)%7)-3,(int)(iOff/49)-3};
+
+  complex<double> K[3*nq];
+  const size_t nRow=3*nNode;
+  for (unsigned int b=0; b<nNode; b++)
+  {
+    const unsigned int bx[3]={b%p,(b/p)%p,b/(p*p)};
+    double xSrc[3];
+    for (unsigned int d=0; d<3; d++) xSrc[d]=off[d]*h+a*xNod[bx[d]];
+    for (unsigned int iNode=0; iNode<nNode; iNode++)
+    {
+      const unsigned int ax[3]={iNode%p,(iNode/p)%p,iNode/(p*p)};
+      double xTrg[3];
+      for (unsigned int d=0; d<3; d++) xTrg[d]=a*xNod[ax[d]];
+      fmmKernel3d(greenPtr,ugCmplx,tgCmplx,xTrg,xSrc,K);
+      for (unsigned int iq=0; iq<nq; iq++)
+        for (unsigned int i=0; i<3; i++)
+          Op[3*iNode+i+nRow*(nq*b+iq)]=K[i+3*iq];
+    }
+  }
+}
+
+//==============================================================================
+void cacheOp(const unsigned int& level, const unsigned int& iOff)
+/* Stores the interaction operator of a translation at a level, unless the
+ * stored operators would exceed the memory limit. The operators that are
+ * not stored are recomputed by every evaluation of the far field.
+ */
+//==============================================================================
+{
+  complex<double>*& Op=M2L[nOffset*level+iOff];
+  if (Op!=0) return;
+  const size_t nOpEntry=(size_t)3*nNode*nq*nNode;
+  const double opBytes=(double)(nOpEntry*sizeof(complex<double>));
+  if (opMemory+opBytes>maxOpMemory) return;
+  Op=new(nothrow) complex<double>[nOpEntry];
+  if (Op==0) throw("Out of memory.");
+  interactionOp(level,iOff,Op);
+  opMemory+=opBytes;
+}
+
+//==============================================================================
+void applyOp(const complex<double>* const Op, const complex<double>* const Wc,
+             complex<double>* const Lb, const unsigned int& nLoad)
+/* Adds the local expansion Op*Wc of a source box to the target box.
+ */
+//==============================================================================
+{
+  const size_t nRow=3*nNode;
+  for (unsigned int iLoad=0; iLoad<nLoad; iLoad++)
+  {
+    for (unsigned int jCol=0; jCol<nq*nNode; jCol++)
+    {
+      const complex<double> w=Wc[(size_t)nq*nNode*iLoad+jCol];
+      if (w==0.0) continue;
+      const complex<double>* const Opj=Op+nRow*jCol;
+      complex<double>* const Ll=Lb+nRow*iLoad;
+      for (unsigned int iRow=0; iRow<nRow; iRow++) Ll[iRow]+=Opj[iRow]*w;
+    }
+  }
+}
+
+//==============================================================================
+void fmmSources(const double* const Nod, const unsigned int& nNod,
+                const double* const Elt, const unsigned int& nElt,
+                const unsigned int* const TypeID, const char* const TypeName[],
+                const char* const TypeKeyOpts[], const unsigned int* const nKeyOpt,
+                const unsigned int& nEltType, const double* const CollPoints,
+                const unsigned int& nTotalColl, const unsigned int& nCentroidColl)
+/* Integration points of all elements, with the integration weight for every
+ * collocation point of the element. The same quadrature as in BEMXFER is
+ * used for the regular integrals.
+ */
+//==============================================================================
+{
+  for (unsigned int pass=0; pass<2; pass++)
+  {
+    unsigned int iSrc=0;
+    for (unsigned int iElt=0; iElt<nElt; iElt++)
+    {
+      const unsigned int EltType=(unsigned int)(Elt[nElt+iElt]);
+      unsigned int Parent,nEltNod,nEltColl,ShapeTypeN,ShapeTypeM,EltDim,AxiSym,Periodic;
+      unsigned int nGauss,nEltDiv,nGaussSing,nEltDivSing;
+      eltdef(EltType,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,Parent,nEltNod,
+             nEltColl,ShapeTypeN,ShapeTypeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,
+             nGaussSing,nEltDivSing);
+      const unsigned int nXi=(Parent==1 ? nGauss : nEltDiv*nEltDiv*nGauss*nGauss);
+      if (pass==0)
+      {
+        iSrc+=nXi*nEltColl;
+        continue;
+      }
+
+      double* const EltNod=new(nothrow) double[3*nEltNod];
+      if (EltNod==0) throw("Out of memory.");
+      for (unsigned int iEltNod=0; iEltNod<nEltNod; iEltNod++)
+      {
+        const unsigned int NodID=(unsigned int)(Elt[(2+iEltNod)*nElt+iElt]);
+        int NodIndex;
+        BemNodeIndex(Nod,nNod,NodID,NodIndex);
+        for (unsigned int d=0; d<3; d++) EltNod[d*nEltNod+iEltNod]=Nod[(1+d)*nNod+NodIndex];
+      }
+      unsigned int* const eltCollIndex=new(nothrow) unsigned int[nEltColl];
+      if (eltCollIndex==0) throw("Out of memory.");
+      BemEltCollIndex(Elt,iElt,nElt,CollPoints,nCentroidColl,nTotalColl,
+                      nEltColl,nEltNod,eltCollIndex);
+
+      double* const xi=new(nothrow) double[2*nXi];
+      if (xi==0) throw("Out of memory.");
+      double* const H=new(nothrow) double[nXi];
+      if (H==0) throw("Out of memory.");
+      double* const N=new(nothrow) double[nXi*nEltNod];
+      if (N==0) throw("Out of memory.");
+      double* const M=new(nothrow) double[nXi*nEltColl];
+      if (M==0) throw("Out of memory.");
+      double* const dN=new(nothrow) double[2*nXi*nEltNod];
+      if (dN==0) throw("Out of memory.");
+      double* const nat=new(nothrow) double[6*nXi];
+      if (nat==0) throw("Out of memory.");
+      double* const Jac=new(nothrow) double[nXi];
+      if (Jac==0) throw("Out of memory.");
+      double* const normal=new(nothrow) double[3*nXi];
+      if (normal==0) throw("Out of memory.");
+
+      if (Parent == 1) gausspwtri(nGauss,xi,H);
+      else gausspw2D(nEltDiv,nGauss,xi,H);
+      shapefun(ShapeTypeN,nXi,xi,N);
+      shapefun(ShapeTypeM,nXi,xi,M);
+      shapederiv(ShapeTypeN,nXi,xi,dN);
+      shapenatcoord(dN,nEltNod,nXi,EltNod,nat,EltDim);
+      jacobian(nat,nXi,Jac,EltDim);
+      bemnormal(nat,nXi,EltDim,normal);
+
+      for (unsigned int iXi=0; iXi<nXi; iXi++)
+      {
+        double xiCart[3]={0.0,0.0,0.0};
+        for (unsigned int iEltNod=0; iEltNod<nEltNod; iEltNod++)
+          for (unsigned int d=0; d<3; d++)
+            xiCart[d]+=N[nEltNod*iXi+iEltNod]*EltNod[d*nEltNod+iEltNod];
+        for (unsigned int iEltColl=0; iEltColl<nEltColl; iEltColl++)
+        {
+          const unsigned int iColl=eltCollIndex[iEltColl];
+          for (unsigned int d=0; d<3; d++)
+          {
+            srcPos[3*iSrc+d]=xiCart[d];
+            srcNrm[3*iSrc+d]=normal[3*iXi+d];
+            const double dist=fabs(xiCart[d]-trgPos[3*iColl+d]);
+            if (dist>margin) margin=dist;
+          }
+          srcW[iSrc]=H[iXi]*M[nEltColl*iXi+iEltColl]*Jac[iXi];
+          srcCol[iSrc]=iColl;
+          iSrc++;
+        }
+      }
+      delete [] EltNod;
+      delete [] eltCollIndex;
+      delete [] xi;
+      delete [] H;
+      delete [] N;
+      delete [] M;
+      delete [] dN;
+      delete [] nat;
+      delete [] Jac;
+      delete [] normal;
+    }
+    if (pass==0)
+    {
+      nSrc=iSrc;
+      srcPos=new(nothrow) double[3*nSrc];
+      if (srcPos==0) throw("Out of memory.");
+      srcNrm=new(nothrow) double[3*nSrc];
+      if (srcNrm==0) throw("Out of memory.");
+      srcW=new(nothrow) double[nSrc];
+      if (srcW==0) throw("Out of memory.");
+      srcCol=new(nothrow) unsigned int[nSrc];
+      if (srcCol==0) throw("Out of memory.");
+    }
+  }
+}
+
+//==============================================================================
+void fmmTree(const unsigned int& nLeafColl)
+/* Octree of the collocation points, the sorting of the collocation and
+ * source points per leaf, the interaction lists and the transfer operators.
+ */
+//==============================================================================
+{
+  // ROOT BOX
+  double xMin[3];
+  double xMax[3];
+  for (unsigned int d=0; d<3; d++)
+  {
+    xMin[d]=trgPos[d];
+    xMax[d]=trgPos[d];
+  }
+  for (unsigned int iColl=0; iColl<nColl; iColl++)
+  {
+    for (unsigned int d=0; d<3; d++)
+    {
+      if (trgPos[3*iColl+d]<xMin[d]) xMin[d]=trgPos[3*iColl+d];
+      if (trgPos[3*iColl+d]>xMax[d]) xMax[d]=trgPos[3*iColl+d];
+    }
+  }
+  rootSize=0.0;
+  for (unsigned int d=0; d<3; d++) if (xMax[d]-xMin[d]>rootSize) rootSize=xMax[d]-xMin[d];
+  if (rootSize==0.0) rootSize=1.0;
+  rootSize*=1.0+1e-10;
+  for (unsigned int d=0; d<3; d++) rootMin[d]=0.5*(xMin[d]+xMax[d]-rootSize);
+
+  // LEAF LEVEL
+  // The octree is refined until the leaves contain nLeafColl collocation
+  // points on average, as long as the source points assigned to a box do not
+  // stick out by more than half the box width.
+  uint64* const keys=new(nothrow) uint64[nColl];
+  if (keys==0) throw("Out of memory.");
+  nLevel=0;
+  while (nLevel<maxLevel)
+  {
+    const unsigned int nBoxLevel=levelKeys(nLevel,keys);
+    if (nColl<=nLeafColl*nBoxLevel) break;
+    if (0.25*rootSize/(1u<<nLevel)<2.0*margin) break;
+    nLevel++;
+  }
+
+  // BOXES PER LEVEL
+  nBox=new(nothrow) unsigned int[nLevel+1];
+  if (nBox==0) throw("Out of memory.");
+  boxKey=new(nothrow) uint64*[nLevel+1];
+  if (boxKey==0) throw("Out of memory.");
+  for (unsigned int l=0; l<=nLevel; l++) boxKey[l]=0;
+  boxParent=new(nothrow) unsigned int*[nLevel+1];
+  if (boxParent==0) throw("Out of memory.");
+  for (unsigned int l=0; l<=nLevel; l++) boxParent[l]=0;
+  interBeg=new(nothrow) unsigned int*[nLevel+1];
+  if (interBeg==0) throw("Out of memory.");
+  for (unsigned int l=0; l<=nLevel; l++) interBeg[l]=0;
+  interBox=new(nothrow) unsigned int*[nLevel+1];
+  if (interBox==0) throw("Out of memory.");
+  for (unsigned int l=0; l<=nLevel; l++) interBox[l]=0;
+  interOp=new(nothrow) unsigned int*[nLevel+1];
+  if (interOp==0) throw("Out of memory.");
+  for (unsigned int l=0; l<=nLevel; l++) interOp[l]=0;
+  M2M=new(nothrow) double*[nLevel+1];
+  if (M2M==0) throw("Out of memory.");
+  for (unsigned int l=0; l<=nLevel; l++) M2M[l]=0;
+  M2L=new(nothrow) complex<double>*[nOffset*(nLevel+1)];
+  if (M2L==0) throw("Out of memory.");
+  for (unsigned int iOp=0; iOp<nOffset*(nLevel+1); iOp++) M2L[iOp]=0;
+
+  for (unsigned int l=0; l<=nLevel; l++)
+  {
+    nBox[l]=levelKeys(l,keys);
+    boxKey[l]=new(nothrow) uint64[nBox[l]];
+    if (boxKey[l]==0) throw("Out of memory.");
+    for (unsigned int iBox=0; iBox<nBox[l]; iBox++) boxKey[l][iBox]=keys[iBox];
+    boxParent[l]=new(nothrow) unsigned int[nBox[l]];
+    if (boxParent[l]==0) throw("Out of memory.");
+    for (unsigned int iBox=0; iBox<nBox[l]; iBox++)
+    {
+      int ix[3];
+      keyIndex(boxKey[l][iBox],ix);
+      for (unsigned int d=0; d<3; d++) ix[d]/=2;
+      boxParent[l][iBox]=(l==0 ? 0 : (unsigned int)findBox(l-1,ix));
+    }
+  }
+  delete [] keys;
+
+  // COLLOCATION AND SOURCE POINTS PER LEAF
+  const unsigned int nLeaf=nBox[nLevel];
+  unsigned int* const leafOf=new(nothrow) unsigned int[nColl];
+  if (leafOf==0) throw("Out of memory.");
+  for (unsigned int iColl=0; iColl<nColl; iColl++)
+  {
+    int ix[3];
+    keyIndex(pointKey(trgPos+3*iColl,nLevel),ix);
+    leafOf[iColl]=(unsigned int)findBox(nLevel,ix);
+  }
+
+  trgBeg=new(nothrow) unsigned int[nLeaf+1];
+  if (trgBeg==0) throw("Out of memory.");
+  trgInd=new(nothrow) unsigned int[nColl];
+  if (trgInd==0) throw("Out of memory.");
+  for (unsigned int iLeaf=0; iLeaf<=nLeaf; iLeaf++) trgBeg[iLeaf]=0;
+  for (unsigned int iColl=0; iColl<nColl; iColl++) trgBeg[leafOf[iColl]+1]++;
+  for (unsigned int iLeaf=0; iLeaf<nLeaf; iLeaf++) trgBeg[iLeaf+1]+=trgBeg[iLeaf];
+  {
+    unsigned int* const pos=new(nothrow) unsigned int[nLeaf];
+    if (pos==0) throw("Out of memory.");
+    for (unsigned int iLeaf=0; iLeaf<nLeaf; iLeaf++) pos[iLeaf]=trgBeg[iLeaf];
+    for (unsigned int iColl=0; iColl<nColl; iColl++) trgInd[pos[leafOf[iColl]]++]=iColl;
+    delete [] pos;
+  }
+
+  // The source points are reordered in place per leaf of their column.
+  srcBeg=new(nothrow) unsigned int[nLeaf+1];
+  if (srcBeg==0) throw("Out of memory.");
+  for (unsigned int iLeaf=0; iLeaf<=nLeaf; iLeaf++) srcBeg[iLeaf]=0;
+  for (unsigned int iSrc=0; iSrc<nSrc; iSrc++) srcBeg[leafOf[srcCol[iSrc]]+1]++;
+  for (unsigned int iLeaf=0; iLeaf<nLeaf; iLeaf++) srcBeg[iLeaf+1]+=srcBeg[iLeaf];
+  {
+    unsigned int* const pos=new(nothrow) unsigned int[nLeaf];
+    if (pos==0) throw("Out of memory.");
+    unsigned int* const perm=new(nothrow) unsigned int[nSrc];
+    if (perm==0) throw("Out of memory.");
+    double* const tmp=new(nothrow) double[3*nSrc];
+    if (tmp==0) throw("Out of memory.");
+    for (unsigned int iLeaf=0; iLeaf<nLeaf; iLeaf++) pos[iLeaf]=srcBeg[iLeaf];
+    for (unsigned int iSrc=0; iSrc<nSrc; iSrc++) perm[iSrc]=pos[leafOf[srcCol[iSrc]]]++;
+    for (unsigned int iSrc=0; iSrc<nSrc; iSrc++)
+      for (unsigned int d=0; d<3; d++) tmp[3*perm[iSrc]+d]=srcPos[3*iSrc+d];
+    for (unsigned int i=0; i<3*nSrc; i++) srcPos[i]=tmp[i];
+    for (unsigned int iSrc=0; iSrc<nSrc; iSrc++)
+      for (unsigned int d=0; d<3; d++) tmp[3*perm[iSrc]+d]=srcNrm[3*iSrc+d];
+    for (unsigned int i=0; i<3*nSrc; i++) srcNrm[i]=tmp[i];
+    for (unsigned int iSrc=0; iSrc<nSrc; iSrc++) tmp[perm[iSrc]]=srcW[iSrc];
+    for (unsigned int i=0; i<nSrc; i++) srcW[i]=tmp[i];
+    unsigned int* const colTmp=new(nothrow) unsigned int[nSrc];
+    if (colTmp==0) throw("Out of memory.");
+    for (unsigned int iSrc=0; iSrc<nSrc; iSrc++) colTmp[perm[iSrc]]=srcCol[iSrc];
+    for (unsigned int i=0; i<nSrc; i++) srcCol[i]=colTmp[i];
+    delete [] colTmp;
+    delete [] pos;
+    delete [] perm;
+    delete [] tmp;
+  }
+  delete [] leafOf;
+
+  // INTERACTION LISTS
+  // Two boxes interact at a level if they are not adjacent while their
+  // parents are adjacent. Adjacent leaves form the near field.
+  for (unsigned int l=0; l<=nLevel; l++)
+  {
+    interBeg[l]=new(nothrow) unsigned int[nBox[l]+1];
+    if (interBeg[l]==0) throw("Out of memory.");
+    interBeg[l][0]=0;
+    if (l<2)
+    {
+      for (unsigned int iBox=0; iBox<nBox[l]; iBox++) interBeg[l][iBox+1]=0;
+      continue;
+    }
+    interBox[l]=new(nothrow) unsigned int[(size_t)189*nBox[l]];
+    if (interBox[l]==0) throw("Out of memory.");
+    interOp[l]=new(nothrow) unsigned int[(size_t)189*nBox[l]];
+    if (interOp[l]==0) throw("Out of memory.");
+    unsigned int nInter=0;
+    for (unsigned int iBox=0; iBox<nBox[l]; iBox++)
+    {
+      int ix[3];
+      keyIndex(boxKey[l][iBox],ix);
+      int px[3]={ix[0]/2,ix[1]/2,ix[2]/2};
+      for (int dz=-1; dz<=1; dz++)
+      for (int dy=-1; dy<=1; dy++)
+      for (int dx=-1; dx<=1; dx++)
+      {
+        const int nx[3]={px[0]+dx,px[1]+dy,px[2]+dz};
+        if (findBox(l-1,nx)<0) continue;
+        for (unsigned int oct=0; oct<8; oct++)
+        {
+          const int cx[3]={2*nx[0]+(int)(oct&1),2*nx[1]+(int)((oct>>1)&1),2*nx[2]+(int)((oct>>2)&1)};
+          const int off[3]={cx[0]-ix[0],cx[1]-ix[1],cx[2]-ix[2]};
+          if ((abs(off[0])<=1) && (abs(off[1])<=1) && (abs(off[2])<=1)) continue;
+          const int jBox=findBox(l,cx);
+          if (jBox<0) continue;
+          interBox[l][nInter]=(unsigned int)jBox;
+          interOp[l][nInter]=(off[0]+3)+7*((off[1]+3)+7*(off[2]+3));
+          cacheOp(l,interOp[l][nInter]);
+          nInter++;
+        }
+      }
+      interBeg[l][iBox+1]=nInter;
+    }
+  }
+
+  // TRANSFER OPERATORS BETWEEN A BOX AND ITS CHILDREN
+  for (unsigned int l=3; l<=nLevel; l++)
+  {
+    M2M[l]=new(nothrow) double[(size_t)8*nNode*nNode];
+    if (M2M[l]==0) throw("Out of memory.");
+    const double hChild=0.25*rootSize/(1u<<(l-1));
+    const double aChild=domainHalf(l);
+    const double aParent=domainHalf(l-1);
+    const double c[3]={0.0,0.0,0.0};
+    for (unsigned int oct=0; oct<8; oct++)
+    {
+      for (unsigned int k=0; k<nNode; k++)
+      {
+        const unsigned int kx[3]={k%p,(k/p)%p,k/(p*p)};
+        double x[3];
+        for (unsigned int d=0; d<3; d++)
+          x[d]=(((oct>>d)&1) ? hChild : -hChild)+aChild*xNod[kx[d]];
+        interpWeights(x,c,aParent,M2M[l]+(size_t)nNode*(k+nNode*oct));
+      }
+    }
+  }
+}
+
+//==============================================================================
+void fmmNear(mxArray* plhs[])
+/* Linear indices of the matrix entries between adjacent leaves, as a cell
+ * array with a block for every leaf. The rows of a block are the degrees of
+ * freedom of the collocation points in the leaf, the columns those of the
+ * collocation points in the leaf and its neighbours, both in ascending order
+ * as required for the selection of a submatrix by BEMMAT.
+ */
+//==============================================================================
+{
+  const unsigned int nDof=3*nColl;
+  const unsigned int nLeaf=nBox[nLevel];
+  plhs[0]=mxCreateCellMatrix(nLeaf,1);
+  unsigned int* const colColl=new(nothrow) unsigned int[nColl];
+  if (colColl==0) throw("Out of memory.");
+  for (unsigned int iLeaf=0; iLeaf<nLeaf; iLeaf++)
+  {
+    int ix[3];
+    keyIndex(boxKey[nLevel][iLeaf],ix);
+    unsigned int nColColl=0;
+    for (int dz=-1; dz<=1; dz++)
+    for (int dy=-1; dy<=1; dy++)
+    for (int dx=-1; dx<=1; dx++)
+    {
+      const int nx[3]={ix[0]+dx,ix[1]+dy,ix[2]+dz};
+      const int jLeaf=findBox(nLevel,nx);
+      if (jLeaf<0) continue;
+      for (unsigned int jj=trgBeg[jLeaf]; jj<trgBeg[jLeaf+1]; jj++) colColl[nColColl++]=trgInd[jj];
+    }
+    sort(colColl,colColl+nColColl);
+
+    const unsigned int nRowColl=trgBeg[iLeaf+1]-trgBeg[iLeaf];
+    mxArray* const sBlock=mxCreateDoubleMatrix(3*nRowColl,3*nColColl,mxREAL);
+    double* const s=mxGetPr(sBlock);
+    for (unsigned int jj=0; jj<nColColl; jj++)
+      for (unsigned int b=0; b<3; b++)
+        for (unsigned int ii=0; ii<nRowColl; ii++)
+          for (unsigned int a=0; a<3; a++)
+            s[3*ii+a+(size_t)3*nRowColl*(3*jj+b)]=(double)(3*trgInd[trgBeg[iLeaf]+ii]+a+1)+(double)nDof*(3*colColl[jj]+b);
+    mxSetCell(plhs[0],iLeaf,sBlock);
+  }
+  delete [] colColl;
+}
+
+//==============================================================================
+void fmmApply(const double* const tRe, const double* const tIm,
+              const double* const uRe, const double* const uIm,
+              const unsigned int& nLoad, double* const yRe, double* const yIm)
+/* Far field contribution y = U*t - T*u (nDof * nLoad).
+ */
+//==============================================================================
+{
+  const unsigned int nDof=3*nColl;
+  for (size_t i=0; i<(size_t)nDof*nLoad; i++)
+  {
+    yRe[i]=0.0;
+    yIm[i]=0.0;
+  }
+  if (nLevel<2) return;
+
+  // MULTIPOLE AND LOCAL EXPANSIONS PER LEVEL
+  const size_t nW=(size_t)nq*nNode*nLoad;
+  const size_t nL=(size_t)3*nNode*nLoad;
+  complex<double>** const W=new(nothrow) complex<double>*[nLevel+1];
+  if (W==0) throw("Out of memory.");
+  complex<double>** const L=new(nothrow) complex<double>*[nLevel+1];
+  if (L==0) throw("Out of memory.");
+  for (unsigned int l=0; l<=nLevel; l++)
+  {
+    W[l]=0;
+    L[l]=0;
+    if (l<2) continue;
+    W[l]=new(nothrow) complex<double>[nW*nBox[l]];
+    if (W[l]==0) throw("Out of memory.");
+    L[l]=new(nothrow) complex<double>[nL*nBox[l]];
+    if (L[l]==0) throw("Out of memory.");
+    for (size_t i=0; i<nW*nBox[l]; i++) W[l][i]=0.0;
+    for (size_t i=0; i<nL*nBox[l]; i++) L[l][i]=0.0;
+  }
+  double* const S=new(nothrow) double[nNode];
+  if (S==0) throw("Out of memory.");
+
+  // SOURCES TO MULTIPOLE EXPANSIONS OF THE LEAVES
+  const double aLeaf=domainHalf(nLevel);
+  for (unsigned int iLeaf=0; iLeaf<nBox[nLevel]; iLeaf++)
+  {
+    double c[3];
+    boxCenter(nLevel,iLeaf,c);
+    complex<double>* const Wb=W[nLevel]+nW*iLeaf;
+    for (unsigned int iSrc=srcBeg[iLeaf]; iSrc<srcBeg[iLeaf+1]; iSrc++)
+    {
+      interpWeights(srcPos+3*iSrc,c,aLeaf,S);
+      const unsigned int iDof=3*srcCol[iSrc];
+      for (unsigned int iLoad=0; iLoad<nLoad; iLoad++)
+      {
+        complex<double> q[nq];
+        const size_t ind=(size_t)nDof*iLoad+iDof;
+        for (unsigned int b=0; b<3; b++)
+        {
+          q[b]=srcW[iSrc]*complex<double>(tRe[ind+b],(tIm==0 ? 0.0 : tIm[ind+b]));
+          for (unsigned int d=0; d<3; d++)
+          {
+            if (uRe==0) q[3+3*d+b]=0.0;
+            else q[3+3*d+b]=-srcW[iSrc]*srcNrm[3*iSrc+d]*complex<double>(uRe[ind+b],(uIm==0 ? 0.0 : uIm[ind+b]));
+          }
+        }
+        complex<double>* const Wl=Wb+(size_t)nq*nNode*iLoad;
+        for (unsigned int m=0; m<nNode; m++)
+          for (unsigned int iq=0; iq<nq; iq++) Wl[nq*m+iq]+=S[m]*q[iq];
+      }
+    }
+  }
+
+  // UPWARD PASS
+  for (unsigned int l=nLevel; l>=3; l--)
+  {
+    for (unsigned int iBox=0; iBox<nBox[l]; iBox++)
+    {
+      int ix[3];
+      keyIndex(boxKey[l][iBox],ix);
+      const unsigned int oct=(ix[0]&1)+2*(ix[1]&1)+4*(ix[2]&1);
+      const double* const T=M2M[l]+(size_t)nNode*nNode*oct;
+      const complex<double>* const Wc=W[l]+nW*iBox;
+      complex<double>* const Wp=W[l-1]+nW*boxParent[l][iBox];
+      for (unsigned int iLoad=0; iLoad<nLoad; iLoad++)
+        for (unsigned int k=0; k<nNode; k++)
+          for (unsigned int m=0; m<nNode; m++)
+            for (unsigned int iq=0; iq<nq; iq++)
+              Wp[nq*(m+nNode*iLoad)+iq]+=T[m+nNode*k]*Wc[nq*(k+nNode*iLoad)+iq];
+    }
+  }
+
+  // INTERACTIONS
+  // The stored operators are applied first. An operator that is not stored
+  // is computed once per level and applied to all interactions with its
+  // translation.
+  complex<double>* Op=0;
+  for (unsigned int l=2; l<=nLevel; l++)
+  {
+    bool stored=true;
+    for (unsigned int iBox=0; iBox<nBox[l]; iBox++)
+    {
+      complex<double>* const Lb=L[l]+nL*iBox;
+      for (unsigned int iInter=interBeg[l][iBox]; iInter<interBeg[l][iBox+1]; iInter++)
+      {
+        const complex<double>* const Opi=M2L[nOffset*l+interOp[l][iInter]];
+        if (Opi==0) stored=false;
+        else applyOp(Opi,W[l]+nW*interBox[l][iInter],Lb,nLoad);
+      }
+    }
+    if (stored) continue;
+    if (Op==0)
+    {
+      Op=new(nothrow) complex<double>[(size_t)3*nNode*nq*nNode];
+      if (Op==0) throw("Out of memory.");
+    }
+    for (unsigned int iOff=0; iOff<nOffset; iOff++)
+    {
+      if (M2L[nOffset*l+iOff]!=0) continue;
+      bool computed=false;
+      for (unsigned int iBox=0; iBox<nBox[l]; iBox++)
+      {
+        complex<double>* const Lb=L[l]+nL*iBox;
+        for (unsigned int iInter=interBeg[l][iBox]; iInter<interBeg[l][iBox+1]; iInter++)
+        {
+          if (interOp[l][iInter]!=iOff) continue;
+          if (!computed)
+          {
+            interactionOp(l,iOff,Op);
+            computed=true;
+          }
+          applyOp(Op,W[l]+nW*interBox[l][iInter],Lb,nLoad);
+        }
+      }
+    }
+  }
+  if (Op!=0) delete [] Op;
+
+  // DOWNWARD PASS
+  for (unsigned int l=3; l<=nLevel; l++)
+  {
+    for (unsigned int iBox=0; iBox<nBox[l]; iBox++)
+    {
+      int ix[3];
+      keyIndex(boxKey[l][iBox],ix);
+      const unsigned int oct=(ix[0]&1)+2*(ix[1]&1)+4*(ix[2]&1);
+      const double* const T=M2M[l]+(size_t)nNode*nNode*oct;
+      const complex<double>* const Lp=L[l-1]+nL*boxParent[l][iBox];
+      complex<double>* const Lc=L[l]+nL*iBox;
+      for (unsigned int iLoad=0; iLoad<nLoad; iLoad++)
+        for (unsigned int k=0; k<nNode; k++)
+          for (unsigned int m=0; m<nNode; m++)
+            for (unsigned int i=0; i<3; i++)
+              Lc[3*(k+nNode*iLoad)+i]+=T[m+nNode*k]*Lp[3*(m+nNode*iLoad)+i];
+    }
+  }
+
+  // LOCAL EXPANSIONS OF THE LEAVES TO COLLOCATION POINTS
+  for (unsigned int iLeaf=0; iLeaf<nBox[nLevel]; iLeaf++)
+  {
+    double c[3];
+    boxCenter(nLevel,iLeaf,c);
+    const complex<double>* const Lb=L[nLevel]+nL*iLeaf;
+    for (unsigned int ii=trgBeg[iLeaf]; ii<trgBeg[iLeaf+1]; ii++)
+    {
+      const unsigned int iColl=trgInd[ii];
+      interpWeights(trgPos+3*iColl,c,aLeaf,S);
+      for (unsigned int iLoad=0; iLoad<nLoad; iLoad++)
+      {
+        for (unsigned int i=0; i<3; i++)
+        {
+          complex<double> y=0.0;
+          for (unsigned int m=0; m<nNode; m++) y+=S[m]*Lb[3*(m+nNode*iLoad)+i];
+          yRe[(size_t)nDof*iLoad+3*iColl+i]=y.real();
+          yIm[(size_t)nDof*iLoad+3*iColl+i]=y.imag();
+        }
+      }
+    }
+  }
+
+  for (unsigned int l=0; l<=nLevel; l++)
+  {
+    if (W[l]!=0) delete [] W[l];
+    if (L[l]!=0) delete [] L[l];
+  }
+  delete [] W;
+  delete [] L;
+  delete [] S;
+}
+
+//==============================================================================
+void fmmInit(mxArray* plhs[], int nrhs, const mxArray* prhs[])
+//==============================================================================
+{
+  cleanup();
+
+  if (nrhs<5) throw("Not enough input arguments.");
+
+  if (!mxIsNumeric(prhs[0])) throw("Input argument 'nod' must be numeric.");
+  if (mxIsSparse(prhs[0])) throw("Input argument 'nod' must not be sparse.");
+  if (mxIsComplex(prhs[0])) throw("Input argument 'nod' must be real.");
+  if (!(mxGetN(prhs[0])==4)) throw("Input argument 'nod' should have 4 columns.");
+  const unsigned int nNod=mxGetM(prhs[0]);
+  const double* const Nod=mxGetPr(prhs[0]);
+
+  if (!mxIsNumeric(prhs[1])) throw("Input argument 'elt' must be numeric.");
+  if (mxIsSparse(prhs[1])) throw("Input argument 'elt' must not be sparse.");
+  if (mxIsComplex(prhs[1])) throw("Input argument 'elt' must be real.");
+  if (mxGetN(prhs[1])<=3) throw("Input argument 'elt' should have at least 3 columns.");
+  const double* const Elt=mxGetPr(prhs[1]);
+  const unsigned int nElt=mxGetM(prhs[1]);
+  const unsigned int maxEltColumn=mxGetN(prhs[1]);
+
+  bool keyOpts=true;
+  if (mxGetN(prhs[2])==3) keyOpts=true;
+  else if  (mxGetN(prhs[2])==2) keyOpts=false;
+  else throw("Input argument 'typ' should have 2 or 3 columns.");
+  if (!(mxIsCell(prhs[2]))) throw("Input argument 'typ' should be a cell array.");
+  const unsigned int nEltType=mxGetM(prhs[2]);
+  const unsigned int maxKeyOpts = 50;  // Maximum number of keyoptions per element type
+  unsigned int* const TypeID=new(nothrow) unsigned int[nEltType];
+    if (TypeID==0) throw("Out of memory.");
+  unsigned int* const nKeyOpt=new(nothrow) unsigned int[nEltType];
+    if (nKeyOpt==0) throw("Out of memory.");
+  char** const TypeName=new(nothrow) char*[nEltType];
+    if (TypeName==0) throw("Out of memory.");
+  char** const TypeKeyOpts=new(nothrow) char*[nEltType*maxKeyOpts];
+    if (TypeKeyOpts==0) throw("Out of memory.");
+  for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+  {
+    // TypeID
+    const mxArray* TypPtr0=mxGetCell(prhs[2],iTyp+nEltType*0);
+    if (!mxIsNumeric(TypPtr0)) throw("Type ID should be numeric.");
+    if (mxIsSparse(TypPtr0)) throw("Type ID should not be sparse.");
+    if (mxIsComplex(TypPtr0)) throw("Type ID should not be complex.");
+    if (!(mxGetNumberOfElements(TypPtr0)==1)) throw("Type ID should be a scalar.");
+    TypeID[iTyp]= (unsigned int)(mxGetScalar(TypPtr0));
+
+    // TypeName
+    const mxArray* TypPtr1=mxGetCell(prhs[2],iTyp+nEltType*1);
+    if (!mxIsChar(TypPtr1)) throw("Element types should be input as stings.");
+    TypeName[iTyp] =  mxArrayToString(TypPtr1);
+
+    // TypeKeyOpts
+    if (keyOpts)
+    {
+      const mxArray* TypPtr2=mxGetCell(prhs[2],iTyp+nEltType*2); // Keyoptions cell array
+      if (!mxIsCell(TypPtr2)) throw("Keyopts should be input as a cell array of stings.");
+      nKeyOpt[iTyp]= mxGetNumberOfElements(TypPtr2);
+      if (nKeyOpt[iTyp] > maxKeyOpts) throw("Number of keyoptions is too large.");
+      for (unsigned int iKeyOpt=0; iKeyOpt<nKeyOpt[iTyp]; iKeyOpt++)
+      {
+        const mxArray* keyOptPtr=mxGetCell(TypPtr2,iKeyOpt);
+        if (!mxIsChar(keyOptPtr)) throw("Keyopts should be input as a cell array of stings.");
+        TypeKeyOpts[iTyp+nEltType*iKeyOpt] = mxArrayToString(keyOptPtr);
+      }
+    }
+    else nKeyOpt[iTyp]=0;
+  }
+  const unsigned int probDim=bemDimension(Elt,nElt,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType);
+  const bool probAxi=isAxisym(Elt,nElt,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType);
+  const bool probPeriodic=isPeriodic(Elt,nElt,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType);
+  if ((probDim!=3) || probAxi || probPeriodic)
+    throw("The fast multipole method is only available for three-dimensional problems.");
+
+  // OPTIONS: BEMFMM('init',nod,elt,typ,opts,green,...)
+  unsigned int greenPos=3;
+  p=4;
+  unsigned int nLeafColl=32;
+  maxOpMemory=1024.0*1048576.0;
+  if (!mxIsChar(prhs[3]))
+  {
+    if (!mxIsNumeric(prhs[3])) throw("Input argument 'opts' must be numeric.");
+    if (mxIsComplex(prhs[3])) throw("Input argument 'opts' must be real.");
+    if (mxGetNumberOfElements(prhs[3])>3) throw("Input argument 'opts' must have 3 elements at most.");
+    const double* const opts=mxGetPr(prhs[3]);
+    if (mxGetNumberOfElements(prhs[3])>0)
+    {
+      if (!((opts[0]>=2) && (opts[0]<=16))) throw("The number of Chebyshev nodes must be between 2 and 16.");
+      p=(unsigned int)opts[0];
+    }
+    if (mxGetNumberOfElements(prhs[3])>1)
+    {
+      if (!(opts[1]>=1)) throw("The number of collocation points per leaf must be strictly positive.");
+      nLeafColl=(unsigned int)opts[1];
+    }
+    if (mxGetNumberOfElements(prhs[3])>2)
+    {
+      if (!(opts[2]>=0)) throw("The memory limit of the interaction operators must be positive.");
+      maxOpMemory=opts[2]*1048576.0;
+    }
+    greenPos=4;
+  }
+  nNode=p*p*p;
+  chebNodes(p,xNod);
+
+  // GREEN'S FUNCTION
+  if (!mxIsChar(prhs[greenPos])) throw("Input argument 'green' must be a string.");
+  char* const green=mxArrayToString(prhs[greenPos]);
+  const mxArray** const par=prhs+greenPos+1;
+  const int nPar=nrhs-greenPos-1;
+  if (strcasecmp(green,"fsgreen3d0")==0)
+  {
+    mxFree(green);
+    if (!(nPar==2)) throw("Wrong number of input arguments.");
+    if (!mxIsNumeric(par[0])) throw("Input argument 'E' must be numeric.");
+    if (mxIsComplex(par[0])) throw("Input argument 'E' must be real.");
+    if (!(mxGetNumberOfElements(par[0])==1)) throw("Input argument 'E' must be a scalar.");
+    if (!mxIsNumeric(par[1])) throw("Input argument 'nu' must be numeric.");
+    if (mxIsComplex(par[1])) throw("Input argument 'nu' must be real.");
+    if (!(mxGetNumberOfElements(par[1])==1)) throw("Input argument 'nu' must be a scalar.");
+    const double E=mxGetScalar(par[0]);
+    const double nu=mxGetScalar(par[1]);
+    const double mu=0.5*E/(1.0+nu);
+    const double M=E*(1.0-nu)/(1.0+nu)/(1.0-2.0*nu);
+    rho=1.0;
+    Cs=sqrt(mu/rho);
+    Cp=sqrt(M/rho);
+    Ds=0.0;
+    Dp=0.0;
+    omega[0]=0.0;
+    ugCmplx=false;
+    tgCmplx=false;
+  }
+  else if (strcasecmp(green,"fsgreen3d")==0)
+  {
+    mxFree(green);
+    if (!(nPar==6)) throw("Wrong number of input arguments.");
+    if (!mxIsNumeric(par[0])) throw("Input argument 'Cs' must be numeric.");
+    if (mxIsComplex(par[0])) throw("Input argument 'Cs' must be real.");
+    if (!(mxGetNumberOfElements(par[0])==1)) throw("Input argument 'Cs' must be a scalar.");
+    if (!mxIsNumeric(par[1])) throw("Input argument 'Cp' must be numeric.");
+    if (mxIsComplex(par[1])) throw("Input argument 'Cp' must be real.");
+    if (!(mxGetNumberOfElements(par[1])==1)) throw("Input argument 'Cp' must be a scalar.");
+    if (!mxIsNumeric(par[2])) throw("Input argument 'Ds' must be numeric.");
+    if (mxIsComplex(par[2])) throw("Input argument 'Ds' must be real.");
+    if (!(mxGetNumberOfElements(par[2])==1)) throw("Input argument 'Ds' must be a scalar.");
+    if (!mxIsNumeric(par[3])) throw("Input argument 'Dp' must be numeric.");
+    if (mxIsComplex(par[3])) throw("Input argument 'Dp' must be real.");
+    if (!(mxGetNumberOfElements(par[3])==1)) throw("Input argument 'Dp' must be a scalar.");
+    if (!mxIsNumeric(par[4])) throw("Input argument 'rho' must be numeric.");
+    if (mxIsComplex(par[4])) throw("Input argument 'rho' must be real.");
+    if (!(mxGetNumberOfElements(par[4])==1)) throw("Input argument 'rho' must be a scalar.");
+    if (!mxIsNumeric(par[5])) throw("Input argument 'omega' must be numeric.");
+    if (mxIsComplex(par[5])) throw("Input argument 'omega' must be real.");
+    if (!(mxGetNumberOfElements(par[5])==1)) throw("Input argument 'omega' must be a scalar.");
+    Cs=mxGetScalar(par[0]);
+    Cp=mxGetScalar(par[1]);
+    Ds=mxGetScalar(par[2]);
+    Dp=mxGetScalar(par[3]);
+    rho=mxGetScalar(par[4]);
+    omega[0]=mxGetScalar(par[5]);
+    ugCmplx=true;
+    tgCmplx=true;
+  }
+  else
+  {
+    mxFree(green);
+    throw("Unknown fundamental solution type for input argument 'green'.");
+  }
+  nFreq=1;
+  GreenFunType=3;
+  greenPtr[0]=&GreenFunType;
+  greenPtr[1]=&Cs;
+  greenPtr[2]=&Cp;
+  greenPtr[3]=&Ds;
+  greenPtr[4]=&Dp;
+  greenPtr[5]=&rho;
+  greenPtr[6]=&nFreq;
+  greenPtr[7]=omega;
+
+  // COLLOCATION POINTS
+  unsigned int* const NodalColl=new(nothrow) unsigned int[nNod];
+  if (NodalColl==0) throw("Out of memory.");
+  unsigned int* const CentroidColl=new(nothrow) unsigned int[nElt];
+  if (CentroidColl==0) throw("Out of memory.");
+  unsigned int nCentroidColl;
+  unsigned int nNodalColl;
+  BemCollPoints(Elt,Nod,TypeID,nKeyOpt,TypeName,TypeKeyOpts,nEltType,
+                nElt,maxEltColumn,nNod,NodalColl,CentroidColl,nNodalColl,nCentroidColl);
+  const unsigned int nTotalColl=nNodalColl+nCentroidColl;
+  double* const CollPoints=new(nothrow) double[5*nTotalColl];
+  if (CollPoints==0) throw("Out of memory.");
+  BemCollCoords(Elt,Nod,TypeID,nKeyOpt,TypeName,TypeKeyOpts,nEltType,
+                CentroidColl,NodalColl,CollPoints,nTotalColl,nElt,nNod);
+  if (nTotalColl==0) throw("The boundary element mesh has no collocation points.");
+
+  nColl=nTotalColl;
+  trgPos=new(nothrow) double[3*nColl];
+  if (trgPos==0) throw("Out of memory.");
+  for (unsigned int iColl=0; iColl<nColl; iColl++)
+    for (unsigned int d=0; d<3; d++) trgPos[3*iColl+d]=CollPoints[(2+d)*nTotalColl+iColl];
+
+  // SOURCE POINTS, OCTREE AND OPERATORS
+  margin=0.0;
+  fmmSources(Nod,nNod,Elt,nElt,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,
+             CollPoints,nTotalColl,nCentroidColl);
+  fmmTree(nLeafColl);
+  FmmValid=true;
+
+  fmmNear(plhs);
+
+  // DEALLOCATE MEMORY ALLOCATED BY "mxArrayToString" IN TYPE DEFINITIONS
+  for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+  {
+    mxFree(TypeName[iTyp]);
+    for (unsigned int iKeyOpt=0; iKeyOpt<nKeyOpt[iTyp]; iKeyOpt++) mxFree(TypeKeyOpts[iTyp+nEltType*iKeyOpt]);
+  }
+  delete [] TypeID;
+  delete [] nKeyOpt;
+  delete [] TypeName;
+  delete [] TypeKeyOpts;
+  delete [] NodalColl;
+  delete [] CentroidColl;
+  delete [] CollPoints;
+}
+
+//==============================================================================
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray *prhs[])
+//==============================================================================
+{
+  mexAtExit(cleanup);
+  try
+  {
+    checklicense();
+
+    if (nrhs<1) throw("Not enough input arguments.");
+    if (nlhs>1) throw("Too many output arguments.");
+    if (!mxIsChar(prhs[0])) throw("Input argument 'mode' must be a string.");
+
+    char* const mode=mxArrayToString(prhs[0]);
+    if (strcasecmp(mode,"init")==0)
+    {
+      mxFree(mode);
+      fmmInit(plhs,nrhs-1,prhs+1);
+    }
+    else if (strcasecmp(mode,"apply")==0)
+    {
+      mxFree(mode);
+      if (!FmmValid) throw("The fast multipole method is not initialized.");
+      if (nrhs<2) throw("Not enough input arguments.");
+      if (nrhs>3) throw("Too many input arguments.");
+      const unsigned int nDof=3*nColl;
+
+      if (!mxIsNumeric(prhs[1])) throw("Input argument 't' must be numeric.");
+      if (mxIsSparse(prhs[1])) throw("Input argument 't' must not be sparse.");
+      if (mxGetNumberOfDimensions(prhs[1])>2) throw("Input argument 't' must have 2 dimensions at most.");
+      if (!(mxGetM(prhs[1])==nDof)) throw("Input argument 't' must have nDof rows.");
+      const unsigned int nLoad=mxGetN(prhs[1]);
+
+      const mxArray* uLoad=0;
+      if ((nrhs>2) && !mxIsEmpty(prhs[2]))
+      {
+        uLoad=prhs[2];
+        if (!mxIsNumeric(uLoad)) throw("Input argument 'u' must be numeric.");
+        if (mxIsSparse(uLoad)) throw("Input argument 'u' must not be sparse.");
+        if (!((mxGetM(uLoad)==nDof) && (mxGetN(uLoad)==nLoad) && (mxGetNumberOfDimensions(uLoad)==2)))
+          throw("Input arguments 't' and 'u' must have the same size.");
+      }
+
+      plhs[0]=mxCreateDoubleMatrix(nDof,nLoad,mxCOMPLEX);
+      fmmApply(mxGetPr(prhs[1]),mxGetPi(prhs[1]),
+               (uLoad==0 ? 0 : mxGetPr(uLoad)),(uLoad==0 ? 0 : mxGetPi(uLoad)),
+               nLoad,mxGetPr(plhs[0]),mxGetPi(plhs[0]));
+    }
+    else if (strcasecmp(mode,"clear")==0)
+    {
+      mxFree(mode);
+      if (nrhs>1) throw("Too many input arguments.");
+      if (nlhs>0) throw("Too many output arguments.");
+      cleanup();
+    }
+    else
+    {
+      mxFree(mode);
+      throw("Unknown mode.");
+    }
+  }
+  catch (const char* exception)
+  {
+    mexErrMsgTxt(exception);
+  }
+}
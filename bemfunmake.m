@@ -37,8 +37,6 @@ try
 %   pmake('bemplot',outdir); 
 %   pmake('bempressure',outdir); 
 %   pmake('bemrigid',outdir); 
-%   pmake('bemtq',outdir); 
-%   pmake('bemtu',outdir); 
 %   pmake('newmarkcoef',outdir); 
 %   pmake('newmarkforce',outdir); 
 %   pmake('newmarkstiff',outdir); 
@@ -83,14 +81,20 @@ try
   compile('uniquecoll.cpp');
   compile('bemmat.cpp');
   compile('greeneval3d.cpp');
+  compile('greeninterp.cpp');
+  compile('greenfile.cpp');
+  compile('greenmemo.cpp');
+  compile('greenlayer.cpp');
   compile('bemtangent_mex.cpp');
   compile('bemshapederiv_mex.cpp');
   compile('bemcollpoints.cpp');
   compile('bemcollpoints_mex.cpp');
+  compile('bemcoinc_mex.cpp');
   compile('bemdimension.cpp');
   compile('bemdimension_mex.cpp');
   compile('bemeltdef_mex.cpp');
-  compile('bemint.cpp');
+  compile('bemfmm_mex.cpp');
+  compile('bemgreen_mex.cpp');
   compile('bemint_mex.cpp');
   compile('bemintpoints_mex.cpp');
   compile('bemintreg2d.cpp');
@@ -107,21 +111,32 @@ try
   compile('bemisaxisym_mex.cpp');
   compile('bemisperiodic.cpp');
   compile('bemisperiodic_mex.cpp');
+  compile('bemmass.cpp');
+  compile('bemmatcompress_mex.cpp');
+  compile('bemmatfile.cpp');
   compile('bemmatconv_mex.cpp');
   compile('bemnormal.cpp');
   compile('bemnormal_mex.cpp');
+  compile('bemprecond_mex.cpp');
   compile('bemshape_mex.cpp');
+  compile('bemsolve_mex.cpp');
+  compile('bemsparse.cpp');
+  compile('bemtopology.cpp');
+  compile('bemtq_mex.cpp');
+  compile('bemtu_mex.cpp');
   compile('bemtimeconv_mex.cpp');
   compile('bemxfer2d.cpp');
   compile('bemxfer3d.cpp');
   compile('bemxfer3dperiodic.cpp');
   compile('bemxfer_mex.cpp');
   compile('bemxferaxi.cpp');
+  compile('bbfmm.cpp');
   compile('besselh.cpp');
   compile('boundaryrec2d.cpp');
   compile('boundaryrec3d.cpp');
   compile('checklicense.cpp');
   compile('eltdef.cpp');
+  compile('fft.cpp');
   compile('fminstep.cpp');
   compile('fsgreen2d_inplane.cpp');
   compile('fsgreen2d_outofplane.cpp');
@@ -134,25 +149,36 @@ try
   compile('greeneval2d.cpp');
   compile('greenrotate2d.cpp');
   compile('greenrotate3d.cpp');
+  compile('krylov.cpp');
+  compile('recgrid.cpp');
+  compile('pointgrid.cpp');
   compile('search1.cpp');
   compile('shapefun.cpp');
   
-  link(sprintf('%s/bemcollpoints',outdir),'bemcollpoints_mex.o','eltdef.o','bemcollpoints.o','shapefun.o','bemdimension.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemcollpoints',outdir),'bemcollpoints_mex.o','eltdef.o','bemcollpoints.o','pointgrid.o','shapefun.o','bemdimension.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemcoinc',outdir),'bemcoinc_mex.o','pointgrid.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/bemdimension',outdir),'bemdimension_mex.o','bemdimension.o','eltdef.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/bemeltdef',outdir),'bemeltdef_mex.o','eltdef.o','checklicense.o','ripemd128.o');
-  link(sprintf('%s/bemint',outdir),'bemint_mex.o','eltdef.o','bemcollpoints.o','shapefun.o','gausspw.o','bemint.o','bemisaxisym.o','checklicense.o','ripemd128.o');
-  link(sprintf('%s/bemintpoints',outdir),'bemintpoints_mex.o','eltdef.o','gausspw.o','bemcollpoints.o','shapefun.o','bemdimension.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemfmm',outdir),'bemfmm_mex.o','bbfmm.o','eltdef.o','bemcollpoints.o','pointgrid.o','shapefun.o','bemnormal.o','gausspw.o','bemdimension.o','bemisaxisym.o','bemisperiodic.o','greeneval3d.o','greeninterp.o','greenrotate3d.o','fsgreen3d.o','fsgreen3dt.o','search1.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemgreen',outdir),'bemgreen_mex.o','greenlayer.o','gausspw.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemint',outdir),'bemint_mex.o','bemtopology.o','bemmass.o','bemsparse.o','eltdef.o','shapefun.o','gausspw.o','bemisaxisym.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemintpoints',outdir),'bemintpoints_mex.o','eltdef.o','gausspw.o','bemcollpoints.o','pointgrid.o','shapefun.o','bemdimension.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/bemisaxisym',outdir),'bemisaxisym_mex.o','bemisaxisym.o','eltdef.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/bemisperiodic',outdir),'bemisperiodic_mex.o','bemisperiodic.o','eltdef.o','checklicense.o','ripemd128.o');
 % %   link(sprintf('%s/bemmat',outdir),'bemmat_mex.o','bemmat.o','s2coll.o','uniquecoll.o','eltdef.o','bemcollpoints.o','shapefun.o','bemintreg3d.o','bemintreg3dperiodic.o','bemintreg2d.o','bemintregaxi.o','bemintsing3d.o','bemintsing3dperiodic.o','bemintsing2d.o','bemintsingaxi.o','gausspw.o','search1.o','bemnormal.o','bemdimension.o','bemisaxisym.o','bemisperiodic.o','greeneval2d.o','greeneval3d.o','greenrotate2d.o','greenrotate3d.o','fsgreenf.o','fsgreen2d_inplane.o','fsgreen2d_outofplane.o','besselh.o','fsgreen3d.o','fsgreen3dt.o','checklicense.o','ripemd128.o');
-  link(sprintf('%s/bemmat',outdir),'bemmat_mex.o','bemmat.o','s2coll.o','uniquecoll.o','eltdef.o','bemcollpoints.o','shapefun.o','bemintreg3dnodiag.o','bemintreg3ddiag.o','bemintreg3dperiodic.o','bemintreg2d.o','bemintregaxi.o','bemintsing3d.o','bemintsing3dperiodic.o','bemintsing2d.o','bemintsingaxi.o','gausspw.o','search1.o','bemnormal.o','bemdimension.o','bemisaxisym.o','bemisperiodic.o','greeneval2d.o','greeneval3d.o','greenrotate2d.o','greenrotate3d.o','fsgreenf.o','fsgreen2d_inplane.o','fsgreen2d_outofplane.o','besselh.o','fsgreen3d.o','fsgreen3dt.o','checklicense.o','ripemd128.o');
-  link(sprintf('%s/bemmatconv',outdir),'bemmatconv_mex.o','checklicense.o','ripemd128.o');
-  link(sprintf('%s/bemnormal',outdir),'bemnormal_mex.o','eltdef.o','shapefun.o','bemnormal.o','bemcollpoints.o','bemdimension.o','checklicense.o','ripemd128.o');
-  link(sprintf('%s/bemtangent',outdir),'bemtangent_mex.o','eltdef.o','shapefun.o','bemnormal.o','bemcollpoints.o','bemdimension.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemmat',outdir),'bemmat_mex.o','bemmat.o','s2coll.o','uniquecoll.o','eltdef.o','bemcollpoints.o','pointgrid.o','shapefun.o','bemintreg3dnodiag.o','bemintreg3ddiag.o','bemintreg3dperiodic.o','bemintreg2d.o','bemintregaxi.o','bemintsing3d.o','bemintsing3dperiodic.o','bemintsing2d.o','bemintsingaxi.o','gausspw.o','search1.o','bemnormal.o','bemdimension.o','bemisaxisym.o','bemisperiodic.o','bemmatfile.o','greeneval2d.o','greeneval3d.o','greeninterp.o','greenfile.o','greenmemo.o','greenrotate2d.o','greenrotate3d.o','fsgreenf.o','fsgreen2d_inplane.o','fsgreen2d_outofplane.o','besselh.o','fsgreen3d.o','fsgreen3dt.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemmatcompress',outdir),'bemmatcompress_mex.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemmatconv',outdir),'bemmatconv_mex.o','fft.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemnormal',outdir),'bemnormal_mex.o','eltdef.o','shapefun.o','bemnormal.o','bemcollpoints.o','pointgrid.o','bemdimension.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemprecond',outdir),'bemprecond_mex.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemtangent',outdir),'bemtangent_mex.o','eltdef.o','shapefun.o','bemnormal.o','bemcollpoints.o','pointgrid.o','bemdimension.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/bemshape',outdir),'bemshape_mex.o','shapefun.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemsolve',outdir),'bemsolve_mex.o','krylov.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/bemshapederiv',outdir),'bemshapederiv_mex.o','shapefun.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemtq',outdir),'bemtq_mex.o','bemtopology.o','bemmass.o','bemsparse.o','eltdef.o','shapefun.o','gausspw.o','bemisaxisym.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemtu',outdir),'bemtu_mex.o','bemtopology.o','bemsparse.o','eltdef.o','shapefun.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/bemtimeconv',outdir),'bemtimeconv_mex.o','search1.o','checklicense.o','ripemd128.o');
-  link(sprintf('%s/bemxfer',outdir),'bemxfer_mex.o','eltdef.o','bemcollpoints.o','shapefun.o','bemnormal.o','gausspw.o','search1.o','bemxfer3d.o','bemxfer3dperiodic.o','bemxfer2d.o','bemxferaxi.o','bemdimension.o','bemisaxisym.o','bemisperiodic.o','greeneval2d.o','fsgreenf.o','fsgreen3d.o','fsgreen3dt.o','fsgreen2d_inplane.o','fsgreen2d_outofplane.o','besselh.o','greeneval3d.o','greenrotate2d.o','boundaryrec2d.o','boundaryrec3d.o','fminstep.o','greenrotate3d.o','checklicense.o','ripemd128.o');
+  link(sprintf('%s/bemxfer',outdir),'bemxfer_mex.o','eltdef.o','bemcollpoints.o','pointgrid.o','shapefun.o','bemnormal.o','gausspw.o','search1.o','bemxfer3d.o','bemxfer3dperiodic.o','bemxfer2d.o','bemxferaxi.o','bemdimension.o','bemisaxisym.o','bemisperiodic.o','greeneval2d.o','fsgreenf.o','fsgreen3d.o','fsgreen3dt.o','fsgreen2d_inplane.o','fsgreen2d_outofplane.o','besselh.o','greeneval3d.o','greeninterp.o','greenfile.o','greenrotate2d.o','boundaryrec2d.o','boundaryrec3d.o','recgrid.o','fminstep.o','greenrotate3d.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/gausspw1d',outdir),'gausspw1d_mex.o','gausspw.o','checklicense.o','ripemd128.o');
   link(sprintf('%s/gausspw2d',outdir),'gausspw2d_mex.o','gausspw.o','checklicense.o','ripemd128.o');
   
@@ -0,0 +1,219 @@
+/*BEMGREEN   Green's function tables of a horizontally layered halfspace.
+ *
+ *   [ug,sg,sg0] = BEMGREEN(green,h,Cs,Cp,Ds,Dp,rho,omega,zs,r,z) computes
+ *   the Green's displacements and stresses of a layered halfspace on the grid
+ *   of source depths zs, receiver distances r and receiver depths z, in the
+ *   layout of the tables of a user defined Green's function. The tables are
+ *   passed to BEMMAT(nod,elt,typ,'user',zs,r,z,ug,sg,sg0) and
+ *   BEMXFER(nod,elt,typ,rec,'user',zs,r,z,ug,sg), or written to a Green's
+ *   function file with BEMGREENWRITE.
+ *
+ *   The response to a point load (3D) or a line load (2D) is computed in the
+ *   wavenumber domain with the exact stiffness matrices of the layers and
+ *   transformed to the spatial domain by numerical integration over the
+ *   wavenumbers. The z-axis points downwards from the free surface at z=0.
+ *   At a layer interface, the stresses are those of the layer below the
+ *   interface.
+ *
+ *   [ug,sg,sg0] = BEMGREEN(...,'threads',nThread) distributes the wavenumbers
+ *   over nThread threads (default 1).
+ *
+ *   green    '3d' for the 3D Green's function, '2d_inplane' or
+ *            '2d_outofplane' for the 2D Green's functions.
+ *   h        Layer thickness (nLayer * 1). The last layer is the halfspace;
+ *            its thickness is not used.
+ *   Cs       Shear wave velocity (nLayer * 1).
+ *   Cp       Dilatational wave velocity (nLayer * 1).
+ *   Ds       Shear damping ratio (nLayer * 1).
+ *   Dp       Dilatational damping ratio (nLayer * 1).
+ *   rho      Density (nLayer * 1).
+ *   omega    Circular frequency (nFreq * 1). The damping ratios must be
+ *            positive for nonzero frequencies. For the 3D Green's function,
+ *            omega=0 yields the static Green's function.
+ *   zs       Source depths (nzs * 1), monotonically increasing.
+ *   r        Receiver distances (nr * 1), monotonically increasing.
+ *   z        Receiver depths (nz * 1), monotonically increasing.
+ *   ug       Green's displacements (nugComp * nzs * nr * nz * nFreq), with
+ *            nugComp 5 (3D), 4 (2D in-plane) or 1 (2D out-of-plane).
+ *   sg       Green's stresses (ntgComp * nzs * nr * nz * nFreq), with ntgComp
+ *            10 (3D), 6 (2D in-plane) or 2 (2D out-of-plane).
+ *   sg0      Static Green's stresses, of the same size as sg (real).
+ */
+
+/* $Make: mex -O -output bemgreen bemgreen_mex.cpp greenlayer.cpp gausspw.cpp checklicense.cpp ripemd128.cpp$*/
+
+#include "mex.h"
+#include <string.h>
+#include <math.h>
+#include <complex>
+#include <new>
+#include "greenlayer.h"
+#include "checklicense.h"
+
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
+using namespace std;
+
+//==============================================================================
+static const double* getvector(const mxArray* const arg, const char* const error,
+                               unsigned int& n)
+// Real nonempty vector.
+//==============================================================================
+{
+  if (!mxIsDouble(arg) || mxIsSparse(arg) || mxIsComplex(arg) || mxIsEmpty(arg)
+      || (mxGetNumberOfDimensions(arg)>2) || ((mxGetM(arg)!=1) && (mxGetN(arg)!=1))) throw(error);
+  n=(unsigned int)mxGetNumberOfElements(arg);
+  return mxGetPr(arg);
+}
+
+//==============================================================================
+static void splitcomplex(const complex<double>* const x, const size_t& n,
+                         double* const re, double* const im)
+//==============================================================================
+{
+  for (size_t i=0; i<n; i++)
+  {
+    re[i]=x[i].real();
+    if (im!=0) im[i]=x[i].imag();
+  }
+}
+
+//==============================================================================
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+//==============================================================================
+{
+  complex<double>* work=0;
+  try
+  {
+    checklicense();
+
+    if (nrhs<11) throw("Not enough input arguments.");
+    if (nlhs>3) throw("Too many output arguments.");
+
+    // GREEN'S FUNCTION
+    if (!mxIsChar(prhs[0])) throw("Input argument 'green' must be a string.");
+    char* const green=mxArrayToString(prhs[0]);
+    unsigned int greenType=0;
+    if (strcasecmp(green,"3d")==0) greenType=1;
+    else if (strcasecmp(green,"2d_inplane")==0) greenType=2;
+    else if (strcasecmp(green,"2d_outofplane")==0) greenType=3;
+    mxFree(green);
+    if (greenType==0) throw("Input argument 'green' must be '3d', '2d_inplane' or '2d_outofplane'.");
+    const unsigned int nugComp=(greenType==1 ? 5 : (greenType==2 ? 4 : 1));
+    const unsigned int ntgComp=(greenType==1 ? 10 : (greenType==2 ? 6 : 2));
+
+    // LAYERS
+    unsigned int nLayer, n;
+    const double* const h=getvector(prhs[1],"Input argument 'h' must be a real vector.",nLayer);
+    const double* const Cs=getvector(prhs[2],"Input argument 'Cs' must be a real vector.",n);
+    if (n!=nLayer) throw("Input arguments 'h' and 'Cs' must have the same length.");
+    const double* const Cp=getvector(prhs[3],"Input argument 'Cp' must be a real vector.",n);
+    if (n!=nLayer) throw("Input arguments 'h' and 'Cp' must have the same length.");
+    const double* const Ds=getvector(prhs[4],"Input argument 'Ds' must be a real vector.",n);
+    if (n!=nLayer) throw("Input arguments 'h' and 'Ds' must have the same length.");
+    const double* const Dp=getvector(prhs[5],"Input argument 'Dp' must be a real vector.",n);
+    if (n!=nLayer) throw("Input arguments 'h' and 'Dp' must have the same length.");
+    const double* const rho=getvector(prhs[6],"Input argument 'rho' must be a real vector.",n);
+    if (n!=nLayer) throw("Input arguments 'h' and 'rho' must have the same length.");
+    bool damped=true;
+    for (unsigned int iLayer=0; iLayer<nLayer; iLayer++)
+    {
+      if ((iLayer<nLayer-1) && !(h[iLayer]>0.0)) throw("Input argument 'h' must be positive.");
+      if (!(Cs[iLayer]>0.0)) throw("Input argument 'Cs' must be positive.");
+      if (!(Cp[iLayer]>Cs[iLayer])) throw("Input argument 'Cp' must be larger than 'Cs'.");
+      if (!(Ds[iLayer]>=0.0)) throw("Input argument 'Ds' must not be negative.");
+      if (!(Dp[iLayer]>=0.0)) throw("Input argument 'Dp' must not be negative.");
+      if (!(rho[iLayer]>0.0)) throw("Input argument 'rho' must be positive.");
+      if (!((Ds[iLayer]>0.0) && (Dp[iLayer]>0.0))) damped=false;
+    }
+
+    // FREQUENCIES
+    unsigned int nFreq;
+    const double* const omega=getvector(prhs[7],"Input argument 'omega' must be a real vector.",nFreq);
+    for (unsigned int iFreq=0; iFreq<nFreq; iFreq++)
+    {
+      if (!(fabs(omega[iFreq])<HUGE_VAL)) throw("Input argument 'omega' must be finite.");
+      if ((omega[iFreq]!=0.0) && !damped) throw("The damping ratios must be positive for nonzero frequencies.");
+      if ((omega[iFreq]==0.0) && (greenType!=1)) throw("The 2D Green's displacements are unbounded at zero frequency.");
+    }
+
+    // GRID
+    unsigned int nzs, nr, nz;
+    const double* const zs=getvector(prhs[8],"Input argument 'zs' must be a real vector.",nzs);
+    const double* const r=getvector(prhs[9],"Input argument 'r' must be a real vector.",nr);
+    const double* const z=getvector(prhs[10],"Input argument 'z' must be a real vector.",nz);
+    if (!(zs[0]>=0.0)) throw("Input argument 'zs' must not be negative.");
+    if (!(r[0]>=0.0)) throw("Input argument 'r' must not be negative.");
+    if (!(z[0]>=0.0)) throw("Input argument 'z' must not be negative.");
+    for (unsigned int izs=1; izs<nzs; izs++) if (!(zs[izs]>zs[izs-1])) throw("Input argument 'zs' must be monotonically increasing.");
+    for (unsigned int ir=1; ir<nr; ir++) if (!(r[ir]>r[ir-1])) throw("Input argument 'r' must be monotonically increasing.");
+    for (unsigned int iz=1; iz<nz; iz++) if (!(z[iz]>z[iz-1])) throw("Input argument 'z' must be monotonically increasing.");
+
+    // OPTIONS
+    unsigned int nThread=1;
+    if ((nrhs-11)%2!=0) throw("Options must be given as 'key',value pairs.");
+    for (int iArg=11; iArg<nrhs; iArg+=2)
+    {
+      if (!mxIsChar(prhs[iArg])) throw("Options must be given as 'key',value pairs.");
+      char* const key=mxArrayToString(prhs[iArg]);
+      const mxArray* const val=prhs[iArg+1];
+      const bool isScalar=mxIsDouble(val) && (mxGetNumberOfElements(val)==1);
+      const double v=(isScalar ? mxGetScalar(val) : 0.0);
+      const bool isCount=isScalar && (v>=0.0) && (v==floor(v));
+      const char* error=0;
+      if (strcasecmp(key,"threads")==0)
+      {
+        if (isCount && (v>=1.0)) nThread=(unsigned int)v;
+        else error="Option 'threads' must be a positive integer.";
+      }
+      else error="Unknown option.";
+      mxFree(key);
+      if (error!=0) throw(error);
+    }
+
+    // OUTPUT
+    const size_t nPoint=(size_t)nzs*nr*nz;
+    size_t ugDim[5]={nugComp,nzs,nr,nz,nFreq};
+    size_t sgDim[5]={ntgComp,nzs,nr,nz,nFreq};
+    plhs[0]=mxCreateNumericArray(5,ugDim,mxDOUBLE_CLASS,mxCOMPLEX);
+    if (nlhs>1) plhs[1]=mxCreateNumericArray(5,sgDim,mxDOUBLE_CLASS,mxCOMPLEX);
+    if (nlhs>2) plhs[2]=mxCreateNumericArray(5,sgDim,mxDOUBLE_CLASS,mxREAL);
+    work=new (nothrow) complex<double>[(nugComp+ntgComp)*nPoint];
+    if (work==0) throw("Out of memory.");
+    complex<double>* const ug=work;
+    complex<double>* const sg=(nlhs>1 ? work+nugComp*nPoint : 0);
+
+    // GREEN'S FUNCTIONS
+    for (unsigned int iFreq=0; iFreq<nFreq; iFreq++)
+    {
+      greenlayer(greenType,nLayer,h,Cs,Cp,Ds,Dp,rho,omega[iFreq],nzs,zs,nr,r,nz,z,nThread,ug,sg);
+      const size_t nug=nugComp*nPoint;
+      splitcomplex(ug,nug,mxGetPr(plhs[0])+nug*iFreq,mxGetPi(plhs[0])+nug*iFreq);
+      if (nlhs>1)
+      {
+        const size_t ntg=ntgComp*nPoint;
+        splitcomplex(sg,ntg,mxGetPr(plhs[1])+ntg*iFreq,mxGetPi(plhs[1])+ntg*iFreq);
+      }
+    }
+
+    // STATIC STRESSES, EQUAL FOR ALL FREQUENCIES
+    if (nlhs>2)
+    {
+      const size_t ntg=ntgComp*nPoint;
+      complex<double>* const sg0=work+nugComp*nPoint;
+      greenlayer(greenType,nLayer,h,Cs,Cp,Ds,Dp,rho,0.0,nzs,zs,nr,r,nz,z,nThread,0,sg0);
+      double* const sg0Re=mxGetPr(plhs[2]);
+      splitcomplex(sg0,ntg,sg0Re,0);
+      for (unsigned int iFreq=1; iFreq<nFreq; iFreq++) memcpy(sg0Re+ntg*iFreq,sg0Re,ntg*sizeof(double));
+    }
+
+    delete [] work;
+  }
+  catch (const char* exception)
+  {
+    delete [] work;
+    mexErrMsgTxt(exception);
+  }
+}
@@ -0,0 +1,124 @@
+function bemgreenwrite(file,zs,r,z,ug,sg,sg0)
+%BEMGREENWRITE   Write the tables of a user defined Green's function to a file.
+%
+%   BEMGREENWRITE(file,zs,r,z,ug,sg,sg0) writes the tables of a user defined
+%   Green's function to a Green's function file, which is used by
+%   BEMMAT(nod,elt,typ,'user',file) and BEMXFER(nod,elt,typ,rec,'user',file)
+%   instead of the arrays zs, r, z, ug, sg and sg0. The file is memory
+%   mapped by BEMMAT and BEMXFER, so that the tables are loaded from disk
+%   only when they are used and are shared between all MATLAB sessions on
+%   the same machine. The tables of a horizontally layered halfspace are
+%   computed with BEMGREEN.
+%
+%   BEMGREENWRITE(file,zs,r,z,ug) and BEMGREENWRITE(file,zs,r,z,ug,sg) write
+%   a file without stresses, which only allows to compute the displacement
+%   matrices, or without static stresses, which suffices for BEMXFER.
+%
+%   If ug is of class single, the tables are written in single precision,
+%   which halves the size of the file; sg and sg0 must then be single as
+%   well. The axes zs, r and z are always written in double precision.
+%
+%   file  File name (string).
+%   zs    Source locations (vertical coordinate) (nzSrc * 1).
+%   r     Receiver locations (x-coordinate) (nxRec * 1).
+%   z     Receiver locations (z-coordinate) (nzRec * 1).
+%   ug    Green's displacements (nugComp * nzSrc * nxRec * nzRec * ...).
+%   sg    Green's stresses (ntgComp * nzSrc * nxRec * nzRec * ...).
+%   sg0   Static Green's stresses, of the same size as sg.
+%
+%   See greenfile.h for the file layout.
+
+% CHECK BEMFUN LICENSE
+bemfunlicense('VerifyOnce');
+
+if nargin<6, sg=[]; end
+if nargin<7, sg0=[]; end
+
+% CHECK INPUT ARGUMENTS
+if ~ischar(file), error('Input argument ''file'' must be a string.'); end
+checkaxis(zs,'zs');
+checkaxis(r,'r');
+checkaxis(z,'z');
+checktable(ug,'ug');
+dim=size(ug);
+if ndims(ug)>8, error('Input argument ''ug'' must not have more than 8 dimensions.'); end
+if numel(zs)~=size(ug,2), error('Input arguments ''ug'' and ''zs'' are incompatible.'); end
+if numel(r)~=size(ug,3), error('Input arguments ''ug'' and ''r'' are incompatible.'); end
+if numel(z)~=size(ug,4), error('Input arguments ''ug'' and ''z'' are incompatible.'); end
+ntgComp=0;
+if ~isempty(sg) && ~strcmp(class(sg),class(ug))
+  error('Input arguments ''ug'' and ''sg'' must have the same precision.');
+end
+if ~isempty(sg0) && ~strcmp(class(sg0),class(ug))
+  error('Input arguments ''ug'' and ''sg0'' must have the same precision.');
+end
+if isa(ug,'single'), precision='single'; valueSize=4; else precision='double'; valueSize=8; end
+if ~isempty(sg)
+  checktable(sg,'sg');
+  ntgComp=size(sg,1);
+  if ~isequal(size(sg),[ntgComp dim(2:end)])
+    error('Matrix dimensions of input arguments ''ug'' and ''sg'' are incompatible.');
+  end
+end
+if ~isempty(sg0)
+  if isempty(sg), error('Input argument ''sg'' is required with ''sg0''.'); end
+  checktable(sg0,'sg0');
+  if ~isequal(size(sg0),size(sg))
+    error('Matrix dimensions of input arguments ''sg'' and ''sg0'' must agree.');
+  end
+end
+
+% BLOCKS: zs, r, z, REAL AND IMAGINARY PARTS OF ug, sg AND sg0
+block={double(zs),double(r),double(z),real(ug),imagpart(ug),real(sg),imagpart(sg),real(sg0),imagpart(sg0)};
+blockPrecision=[{'double','double','double'} repmat({precision},1,6)];
+blockSize=[8 8 8 valueSize*ones(1,6)];
+headerSize=4096;
+offset=zeros(1,numel(block));
+pos=headerSize;
+for iBlock=1:numel(block)
+  if ~isempty(block{iBlock})
+    offset(iBlock)=pos;
+    pos=pos+headerSize*ceil(blockSize(iBlock)*numel(block{iBlock})/headerSize);
+  end
+end
+
+% WRITE FILE
+header=[ndims(ug) dim ones(1,8-ndims(ug)) ntgComp valueSize offset];
+fid=fopen(file,'w');
+if fid<0, error('Unable to create the Green''s function file.'); end
+fwrite(fid,'BEMGRN01','char');
+fwrite(fid,header,'uint64');
+fwrite(fid,zeros(headerSize-8-8*numel(header),1),'uint8');
+for iBlock=1:numel(block)
+  if ~isempty(block{iBlock})
+    n=fwrite(fid,block{iBlock},blockPrecision{iBlock});
+    pad=headerSize*ceil(blockSize(iBlock)*n/headerSize)-blockSize(iBlock)*n;
+    fwrite(fid,zeros(pad,1),'uint8');
+  end
+end
+fclose(fid);
+
+
+function checkaxis(x,name)
+% Check a vector of grid coordinates.
+if ~isnumeric(x) || issparse(x) || isempty(x) || ~isreal(x)
+  error('Input argument ''%s'' must be a real nonempty vector.',name);
+end
+if any(diff(x(:))<=0)
+  error('Input argument ''%s'' must be monotonically increasing.',name);
+end
+
+
+function checktable(x,name)
+% Check a table of the Green's function.
+if ~isnumeric(x) || issparse(x) || isempty(x)
+  error('Input argument ''%s'' must be a nonempty full numeric array.',name);
+end
+if ~all(isfinite(x(:)))
+  error('Input argument ''%s'' must not contain NaN or Inf values.',name);
+end
+
+
+function y=imagpart(x)
+% Imaginary part of a complex table, or empty for a real table.
+if isreal(x), y=[]; else y=imag(x); end
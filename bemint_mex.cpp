@@ -9,15 +9,25 @@
  *                  Sigma
  *
  *   where both the displacements and tractions are approximated by means
- *   of the boundary element shape functions. The vectors t and u may be used 
+ *   of the boundary element shape functions. The vectors t and u may be used
  *   to evaluate any regular integral of vectors over the boundary Sigma.
  *
+ *   The integral is evaluated as I_ij = t_i.' * Q * u_j, where Q is the
+ *   sparse mass matrix of the collocation points (see BEMTQ). The matrix Q
+ *   is assembled at the first call and is retained for subsequent calls
+ *   with the same mesh, so that the cost of further calls is proportional
+ *   to the number of modes and not to the number of integration points.
+ *   The matrix is released by CLEAR BEMINT.
+ *
+ *   I = BEMINT(...,'threads',nThread) distributes the work over nThread
+ *   threads (default 1).
+ *
  *   nod   Nodes (nNod * 4). Each row has the layout [nodID x y z] where
  *         nodID is the node number and x, y, and z are the nodal
  *         coordinates.
  *   elt   Elements (nElt * nColumn). Each row has the layout
  *         [eltID typID n1 n2 n3 ... ] where eltID is the element number,
- *         typID is the element type number and n1, n2, n3, ... are the node 
+ *         typID is the element type number and n1, n2, n3, ... are the node
  *         numbers representing the nodal connectivity of the element.
  *   typ   Element type definitions. Cell array with the layout
  *         {{typID type keyOpts} ... } where typID is the element type number,
@@ -34,28 +44,185 @@
  *
  */
 
-/* $Make: mex -O -output bemint bemint_mex.cpp eltdef.cpp bemcollpoints.cpp
-                      shapefun.cpp gausspw.cpp bemint.cpp bemisaxisym.cpp$*/
+/* $Make: mex -O -output bemint bemint_mex.cpp bemtopology.cpp bemmass.cpp bemsparse.cpp
+                      eltdef.cpp shapefun.cpp gausspw.cpp bemisaxisym.cpp
+                      checklicense.cpp ripemd128.cpp$*/
 
 #include "mex.h"
-#include "string"
+#include <string.h>
+#include <math.h>
+#include <new>
 #include "eltdef.h"
-#include "bemcollpoints.h"
-#include "bemint.h"
 #include "bemisaxisym.h"
+#include "bemtopology.h"
+#include "bemmass.h"
 #include "checklicense.h"
-#include <complex>
-#include <new>
+
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
 using namespace std;
 
+// Cached mass matrix of the collocation points and a copy of its mesh, which
+// is compared with the input before the matrix is reused.
+static mxArray* massQ=0;
+static unsigned int massSize[4]={0,0,0,0}; // nNod, nElt, maxEltCol, nEltType
+static double* massNod=0;            // Nodes (nNod * 4)
+static double* massElt=0;            // Elements (nElt * maxEltCol)
+static unsigned char* massTyp=0;     // Element types, see typebytes
+static size_t nMassTyp=0;            // Number of bytes of massTyp
+
+struct IntData
+{
+  const mwIndex* Jq;         // Mass matrix Q (nTotalColl * nTotalColl)
+  const mwIndex* Iq;
+  const double* Pq;
+  unsigned int nColDof;      // Number of degrees of freedom per collocation point
+  size_t nDof;
+  const double* uReal;       // Displacements (nDof * nuMode)
+  const double* uImag;
+  unsigned int nuMode;
+  double* yReal;             // Q*u (nDof * nuMode)
+  double* yImag;
+  const double* tReal;       // Tractions (nDof * ntMode*ntSet)
+  const double* tImag;
+  double* OutPr;             // Integral (nuMode * ntMode*ntSet)
+  double* OutPi;
+};
+
+//==============================================================================
+static void cleanup()
+// Releases the cached mass matrix.
+//==============================================================================
+{
+  if (massQ!=0) mxDestroyArray(massQ);
+  delete [] massNod;
+  delete [] massElt;
+  delete [] massTyp;
+  massQ=0;
+  massNod=0;
+  massElt=0;
+  massTyp=0;
+  nMassTyp=0;
+  for (unsigned int i=0; i<4; i++) massSize[i]=0;
+}
+
+//==============================================================================
+static size_t typebytes(unsigned char* const buf, const unsigned int* const TypeID,
+                        char** const TypeName, char** const TypeKeyOpts,
+                        const unsigned int* const nKeyOpt, const unsigned int& nEltType)
+// Writes the element types to buf, or only counts the bytes if buf is 0.
+//==============================================================================
+{
+  size_t n=0;
+  for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+  {
+    if (buf!=0) memcpy(buf+n,&TypeID[iTyp],sizeof(unsigned int));
+    n+=sizeof(unsigned int);
+    const size_t nName=strlen(TypeName[iTyp])+1;
+    if (buf!=0) memcpy(buf+n,TypeName[iTyp],nName);
+    n+=nName;
+    for (unsigned int iKeyOpt=0; iKeyOpt<nKeyOpt[iTyp]; iKeyOpt++)
+    {
+      const char* const opt=TypeKeyOpts[iTyp+nEltType*iKeyOpt];
+      const size_t nOpt=strlen(opt)+1;
+      if (buf!=0) memcpy(buf+n,opt,nOpt);
+      n+=nOpt;
+    }
+  }
+  return n;
+}
+
+//==============================================================================
+static void quworker(void* const data, const unsigned int& iCollBeg,
+                     const unsigned int& iCollEnd)
+// Rows of Q*u of the collocation points [iCollBeg,iCollEnd). As Q is
+// symmetric, row i of Q is read from column i.
+//==============================================================================
+{
+  IntData& d=*((IntData*)data);
+  const unsigned int nColDof=d.nColDof;
+  for (unsigned int iuMode=0; iuMode<d.nuMode; iuMode++)
+  {
+    const size_t iuBeg=iuMode*d.nDof;
+    for (unsigned int iColl=iCollBeg; iColl<iCollEnd; iColl++)
+    {
+      for (unsigned int iDim=0; iDim<nColDof; iDim++)
+      {
+        double yr=0.0;
+        double yi=0.0;
+        for (mwIndex k=d.Jq[iColl]; k<d.Jq[iColl+1]; k++)
+        {
+          const size_t iDof=iuBeg+nColDof*d.Iq[k]+iDim;
+          yr+=d.Pq[k]*d.uReal[iDof];
+          if (d.uImag!=0) yi+=d.Pq[k]*d.uImag[iDof];
+        }
+        d.yReal[iuBeg+nColDof*iColl+iDim]=yr;
+        if (d.yImag!=0) d.yImag[iuBeg+nColDof*iColl+iDim]=yi;
+      }
+    }
+  }
+}
+
+//==============================================================================
+static double dot(const double* const a, const double* const b, const size_t& n)
+// Inner product of a and b.
+//==============================================================================
+{
+  double s=0.0;
+  for (size_t i=0; i<n; i++) s+=a[i]*b[i];
+  return s;
+}
+
+//==============================================================================
+static void tyworker(void* const data, const unsigned int& itBeg,
+                     const unsigned int& itEnd)
+// Integrals of the traction modes [itBeg,itEnd) with all displacement modes.
+//==============================================================================
+{
+  IntData& d=*((IntData*)data);
+  const size_t nDof=d.nDof;
+  for (unsigned int it=itBeg; it<itEnd; it++)
+  {
+    const double* const tr=d.tReal+it*nDof;
+    const double* const ti=(d.tImag!=0 ? d.tImag+it*nDof : 0);
+    for (unsigned int iuMode=0; iuMode<d.nuMode; iuMode++)
+    {
+      const double* const yr=d.yReal+iuMode*nDof;
+      const double* const yi=(d.yImag!=0 ? d.yImag+iuMode*nDof : 0);
+      const size_t iOut=(size_t)it*d.nuMode+iuMode;
+      d.OutPr[iOut]=dot(tr,yr,nDof);
+      if ((ti!=0) && (yi!=0)) d.OutPr[iOut]-=dot(ti,yi,nDof);
+      if (d.OutPi!=0)
+      {
+        d.OutPi[iOut]=0.0;
+        if (yi!=0) d.OutPi[iOut]+=dot(tr,yi,nDof);
+        if (ti!=0) d.OutPi[iOut]+=dot(ti,yr,nDof);
+      }
+    }
+  }
+}
+
+//==============================================================================
 void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+//==============================================================================
 {
+  BemTopology topo={};
+  unsigned int nEltType=0;
+  unsigned int nTypParsed=0;
+  unsigned int* TypeID=0;
+  unsigned int* nKeyOpt=0;
+  char** TypeName=0;
+  char** TypeKeyOpts=0;
+  double* y=0;
+  const char* error=0;
+  mexAtExit(cleanup);
   try
   {
     checklicense();
-    
+
     if (nrhs<5) throw("Not enough input arguments.");
-    if (nrhs>5) throw("Too many input arguments.");
     if (nlhs>1) throw("Too many output arguments.");
 
     if (!mxIsNumeric(prhs[0])) throw("Input argument 'Nod' must be numeric.");
@@ -72,24 +239,21 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
     const double* const Elt=mxGetPr(prhs[1]);
     const unsigned int nElt=mxGetM(prhs[1]);
     const unsigned int maxEltCol=mxGetN(prhs[1]);
-    
+
     bool keyOpts=true;
     if (mxGetN(prhs[2])==3) keyOpts=true;
     else if  (mxGetN(prhs[2])==2) keyOpts=false;
     else throw("Input argument 'typ' should have 2 or 3 columns.");
     if (!(mxIsCell(prhs[2]))) throw("Input argument 'typ' should be a cell array.");
-    const unsigned int nEltType=mxGetM(prhs[2]);
+    nEltType=mxGetM(prhs[2]);
     const unsigned int maxKeyOpts = 50;  // Maximum number of keyoptions per element type
-    unsigned int* const TypeID=new(nothrow) unsigned int[nEltType];
-      if (TypeID==0) throw("Out of memory.");
-    unsigned int* const nKeyOpt=new(nothrow) unsigned int[nEltType];
-      if (nKeyOpt==0) throw("Out of memory.");
-    char** const TypeName=new(nothrow) char*[nEltType];
-      if (TypeName==0) throw("Out of memory.");
-    char** const TypeKeyOpts=new(nothrow) char*[nEltType*maxKeyOpts];
-      if (TypeKeyOpts==0) throw("Out of memory.");
+    TypeID=new(nothrow) unsigned int[nEltType];
+    nKeyOpt=new(nothrow) unsigned int[nEltType];
+    TypeName=new(nothrow) char*[nEltType];
+    TypeKeyOpts=new(nothrow) char*[nEltType*maxKeyOpts];
+    if ((TypeID==0) || (nKeyOpt==0) || (TypeName==0) || (TypeKeyOpts==0)) throw("Out of memory.");
     for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
-    { 
+    {
       // TypeID
       const mxArray* TypPtr0=mxGetCell(prhs[2],iTyp+nEltType*0);
       if (!mxIsNumeric(TypPtr0)) throw("Type ID should be numeric.");
@@ -97,48 +261,84 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
       if (mxIsComplex(TypPtr0)) throw("Type ID should not be complex.");
       if (!(mxGetNumberOfElements(TypPtr0)==1)) throw("Type ID should be a scalar.");
       TypeID[iTyp]= (unsigned int)(mxGetScalar(TypPtr0));
-      
+
       // TypeName
       const mxArray* TypPtr1=mxGetCell(prhs[2],iTyp+nEltType*1);
       if (!mxIsChar(TypPtr1)) throw("Element types should be input as stings.");
+      nKeyOpt[iTyp]=0;
       TypeName[iTyp] =  mxArrayToString(TypPtr1);
-      
+      nTypParsed=iTyp+1;
+
       // TypeKeyOpts
       if (keyOpts)
       {
         const mxArray* TypPtr2=mxGetCell(prhs[2],iTyp+nEltType*2); // Keyoptions cell array
         if (!mxIsCell(TypPtr2)) throw("Keyopts should be input as a cell array of stings.");
-        nKeyOpt[iTyp]= mxGetNumberOfElements(TypPtr2);
-        if (nKeyOpt[iTyp] > maxKeyOpts) throw("Number of keyoptions is too large.");
-        for (unsigned int iKeyOpt=0; iKeyOpt<nKeyOpt[iTyp]; iKeyOpt++)
+        if (mxGetNumberOfElements(TypPtr2)>maxKeyOpts) throw("Number of keyoptions is too large.");
+        for (unsigned int iKeyOpt=0; iKeyOpt<mxGetNumberOfElements(TypPtr2); iKeyOpt++)
         {
           const mxArray* keyOptPtr=mxGetCell(TypPtr2,iKeyOpt);
           if (!mxIsChar(keyOptPtr)) throw("Keyopts should be input as a cell array of stings.");
           TypeKeyOpts[iTyp+nEltType*iKeyOpt] = mxArrayToString(keyOptPtr);
+          nKeyOpt[iTyp]=iKeyOpt+1;
         }
       }
-      else nKeyOpt[iTyp]=0;
     }
-    
-    const bool probAxi = isAxisym(Elt,nElt,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType);
-
-    // DETERMINE COLLOCATION POINTS: NODAL AND CENTROID
-    unsigned int* const NodalColl=new(nothrow) unsigned int[nNod];
-    if (NodalColl==0) throw("Out of memory.");
-    unsigned int* const CentroidColl=new(nothrow) unsigned int[nElt];
-    if (CentroidColl==0) throw("Out of memory.");
-    unsigned int nCentroidColl=0;
-    unsigned int nNodalColl=0;
-    BemCollPoints(Elt,Nod,TypeID,nKeyOpt,TypeName,TypeKeyOpts,nEltType, 
-                   nElt,maxEltCol,nNod,NodalColl,CentroidColl,nNodalColl,nCentroidColl);
-
-
-    unsigned int nTotalColl = nNodalColl + nCentroidColl;
-    double* const CollPoints=new(nothrow) double[5*nTotalColl];
-    if (CollPoints==0) throw("Out of memory.");
-    BemCollCoords(Elt,Nod,TypeID,nKeyOpt,TypeName,TypeKeyOpts,nEltType,
-                  CentroidColl,NodalColl,CollPoints,nTotalColl,nElt,nNod);
-    
+
+    // OPTIONS
+    unsigned int nThread=1;
+    if ((nrhs-5)%2!=0) throw("Options must be given as 'key',value pairs.");
+    for (int iArg=5; iArg<nrhs; iArg+=2)
+    {
+      if (!mxIsChar(prhs[iArg])) throw("Options must be given as 'key',value pairs.");
+      char* const key=mxArrayToString(prhs[iArg]);
+      const mxArray* const v=prhs[iArg+1];
+      const bool isScalar=mxIsDouble(v) && (mxGetNumberOfElements(v)==1);
+      const double x=(isScalar ? mxGetScalar(v) : 0.0);
+      const char* keyError=0;
+      if (strcasecmp(key,"threads")==0)
+      {
+        if (isScalar && (x>=1.0) && (x==floor(x))) nThread=(unsigned int)x;
+        else keyError="Option 'threads' must be a positive integer.";
+      }
+      else keyError="Unknown option.";
+      mxFree(key);
+      if (keyError!=0) throw(keyError);
+    }
+
+    // MASS MATRIX OF THE COLLOCATION POINTS, REUSED IF THE MESH IS UNCHANGED
+    // The mesh is compared with a copy of the mesh of the cached matrix.
+    const unsigned int meshSize[4]={nNod,nElt,maxEltCol,nEltType};
+    const size_t nNodVal=4*(size_t)nNod;
+    const size_t nEltVal=(size_t)maxEltCol*nElt;
+    const size_t nTyp=typebytes(0,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType);
+    unsigned char* const typBytes=new(nothrow) unsigned char[nTyp];
+    if (typBytes==0) throw("Out of memory.");
+    typebytes(typBytes,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType);
+    const bool reuse=(massQ!=0) && (memcmp(massSize,meshSize,sizeof(meshSize))==0)
+                     && (nMassTyp==nTyp) && (memcmp(massTyp,typBytes,nTyp)==0)
+                     && (memcmp(massNod,Nod,sizeof(double)*nNodVal)==0)
+                     && (memcmp(massElt,Elt,sizeof(double)*nEltVal)==0);
+    if (reuse) delete [] typBytes;
+    else
+    {
+      cleanup();
+      massTyp=typBytes;
+      nMassTyp=nTyp;
+      massNod=new(nothrow) double[nNodVal];
+      massElt=new(nothrow) double[nEltVal];
+      if ((massNod==0) || (massElt==0)) throw("Out of memory.");
+      memcpy(massNod,Nod,sizeof(double)*nNodVal);
+      memcpy(massElt,Elt,sizeof(double)*nEltVal);
+      bemtopologyinit(Elt,nElt,maxEltCol,Nod,nNod,TypeID,nKeyOpt,TypeName,TypeKeyOpts,nEltType,topo);
+      const bool probAxi = isAxisym(Elt,nElt,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType);
+      mxArray* const Q=bemmass(topo,probAxi,nThread);
+      mexMakeArrayPersistent(Q);
+      massQ=Q;
+      memcpy(massSize,meshSize,sizeof(meshSize));
+      bemtopologyclear(topo);
+    }
+    const unsigned int nTotalColl=mxGetM(massQ);
 
     if (!mxIsNumeric(prhs[3])) throw("Input argument 't' must be numeric.");
     if (mxIsSparse(prhs[3])) throw("Input argument 't' must not be sparse.");
@@ -155,13 +355,6 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
     else if (nDof==3*nTotalColl) nColDof=3;
     else throw("The first dimension of 't' does not correspond with the number of DOFs in the boundary element mesh.");
 
-    const double* const tReal = mxGetPr(prhs[3]);
-    const double* const tImag = mxGetPi(prhs[3]);
-    complex<double>* const t = new(nothrow) complex<double>[mxGetNumberOfElements(prhs[3])];
-    if (t==0) throw("Out of memory.");
-    for (unsigned int i=0; (unsigned)i<mxGetNumberOfElements(prhs[3]); i++)
-      t[i]=complex<double>(tReal[i],(mxIsComplex(prhs[3]) ? tImag[i] : 0.0));
-
     if (!mxIsNumeric(prhs[4])) throw("Input argument 'u' must be numeric.");
     if (mxIsSparse(prhs[4])) throw("Input argument 'u' must not be sparse.");
     if (mxIsEmpty(prhs[4])) throw("Input argument 'u' must not be empty.");
@@ -170,86 +363,49 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
     if (!(udim[0]==(unsigned)nDof)) throw("The first dimension of 'u' does not correspond with the number of DOFs.");
     unsigned int nuMode =((nudim>1)? udim[1]:1);
 
-    const double* const uReal = mxGetPr(prhs[4]);
-    const double* const uImag = mxGetPi(prhs[4]);
-    complex<double>* const u = new(nothrow) complex<double>[mxGetNumberOfElements(prhs[4])];
-    if (u==0) throw("Out of memory.");
-    for (unsigned int i=0; (unsigned)i<mxGetNumberOfElements(prhs[4]); i++)
-      u[i]=complex<double>(uReal[i],(mxIsComplex(prhs[4]) ? uImag[i] : 0.0));
-
     const bool cmplx = (mxIsComplex(prhs[3]) || mxIsComplex(prhs[4]));
 
-    complex<double>* const OutMat = new(nothrow) complex<double>[ntMode*nuMode*ntSet];
-    if (OutMat==0) throw("Out of memory.");
-    for (unsigned int i=0; i<ntMode*nuMode*ntSet; i++) OutMat[i]=0.0;
-
-    for (unsigned int iElt=0; iElt<nElt; iElt++)
-    {
-      unsigned int EltType = (unsigned int)(Elt[nElt+iElt]);
-      unsigned int EltParent;
-      unsigned int nEltNod;
-      unsigned int nEltColl;
-      unsigned int EltShapeN;
-      unsigned int EltShapeM;
-      unsigned int EltDim;
-      unsigned int AxiSym;
-      unsigned int Periodic;
-      unsigned int nGauss;
-      unsigned int nEltDiv;
-      unsigned int nGaussSing;
-      unsigned int nEltDivSing;
-      eltdef(EltType,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,EltParent,nEltNod,
-             nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,
-             nGaussSing,nEltDivSing);
-
-      // element collocation points
-      unsigned int* const eltCollIndex=new(nothrow) unsigned int[nEltColl];
-      if (eltCollIndex==0) throw("Out of memory.");
-      BemEltCollIndex(Elt,iElt,nElt,CollPoints,nCentroidColl,nTotalColl,
-                                                 nEltColl,nEltNod,eltCollIndex);
-      
-      // boundary element integration
-        bemint(Nod,nNod,Elt,iElt,nElt,TypeID,nKeyOpt,TypeName,TypeKeyOpts,nEltType,
-               eltCollIndex,OutMat,nDof,t,u,ntMode,nuMode,ntSet,nColDof,probAxi);
-            
-        delete [] eltCollIndex;
-    }
-
     // OUTPUT ARGUMENT POINTER
-    size_t* const OutDim = new(nothrow) size_t[3];
-    if (OutDim==0) throw("Out of memory.");
-    OutDim[0]=nuMode;
-    OutDim[1]=ntMode;
-    OutDim[2]=ntSet;
+    const size_t OutDim[3]={nuMode,ntMode,ntSet};
     plhs[0] =mxCreateNumericArray(3,OutDim,mxDOUBLE_CLASS,(cmplx ? mxCOMPLEX : mxREAL));
-    double* const OutPr=mxGetPr(plhs[0]);
-    double* const OutPi=mxGetPi(plhs[0]);
-    for (unsigned int i=0; i<nuMode*ntMode*ntSet; i++)
-    {
-      OutPr[i] = real(OutMat[i]);
-      if (cmplx) OutPi[i] = imag(OutMat[i]);
-    }
-    
-    // DEALLOCATE MEMORY ALLOCATED BY "mxArrayToString" IN TYPE DEFINITIONS
-    for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
-    {
-      mxFree(TypeName[iTyp]); 
-      for (unsigned int iKeyOpt=0; iKeyOpt<nKeyOpt[iTyp]; iKeyOpt++) mxFree(TypeKeyOpts[iTyp+nEltType*iKeyOpt]);
-    }
-    delete [] TypeID;
-    delete [] nKeyOpt;
-    delete [] TypeName;
-    delete [] TypeKeyOpts;
-    delete [] NodalColl;
-    delete [] CentroidColl;
-    delete [] CollPoints;
-    delete [] t;
-    delete [] u;
-    delete [] OutDim;
-    delete [] OutMat;
+
+    // I = t.'*(Q*u), WITH Q EXPANDED TO nColDof DEGREES OF FREEDOM PER POINT
+    y=new(nothrow) double[(mxIsComplex(prhs[4]) ? 2 : 1)*(size_t)nDof*nuMode];
+    if (y==0) throw("Out of memory.");
+    IntData data;
+    data.Jq=mxGetJc(massQ);
+    data.Iq=mxGetIr(massQ);
+    data.Pq=mxGetPr(massQ);
+    data.nColDof=nColDof;
+    data.nDof=nDof;
+    data.uReal=mxGetPr(prhs[4]);
+    data.uImag=(mxIsComplex(prhs[4]) ? mxGetPi(prhs[4]) : 0);
+    data.nuMode=nuMode;
+    data.yReal=y;
+    data.yImag=(mxIsComplex(prhs[4]) ? y+(size_t)nDof*nuMode : 0);
+    data.tReal=mxGetPr(prhs[3]);
+    data.tImag=(mxIsComplex(prhs[3]) ? mxGetPi(prhs[3]) : 0);
+    data.OutPr=mxGetPr(plhs[0]);
+    data.OutPi=(cmplx ? mxGetPi(plhs[0]) : 0);
+    bemtopologyloop(quworker,&data,nTotalColl,nThread);
+    bemtopologyloop(tyworker,&data,ntMode*ntSet,nThread);
   }
   catch (const char* exception)
   {
-    mexErrMsgTxt(exception);
+    error=exception;
+  }
+
+  // DEALLOCATE MEMORY ALLOCATED BY "mxArrayToString" IN TYPE DEFINITIONS
+  for (unsigned int iTyp=0; iTyp<nTypParsed; iTyp++)
+  {
+    mxFree(TypeName[iTyp]);
+    for (unsigned int iKeyOpt=0; iKeyOpt<nKeyOpt[iTyp]; iKeyOpt++) mxFree(TypeKeyOpts[iTyp+nEltType*iKeyOpt]);
   }
+  delete [] TypeID;
+  delete [] nKeyOpt;
+  delete [] TypeName;
+  delete [] TypeKeyOpts;
+  bemtopologyclear(topo);
+  delete [] y;
+  if (error!=0) mexErrMsgTxt(error);
 }
@@ -11,7 +11,7 @@
  */
 
 /* $Make: mex -O -output bemintpoints bemintpoints_mex.cpp eltdef.cpp gausspw.cpp 
-                                      bemcollpoints.cpp shapefun.cpp bemdimension.cpp$*/
+                                      bemcollpoints.cpp pointgrid.cpp shapefun.cpp bemdimension.cpp$*/
 #include "mex.h"
 #include "eltdef.h"
 #include "gausspw.h"
@@ -332,7 +332,6 @@ void bemintreg3ddiag(const double* const Nod, const unsigned int& nNod,
 			else
 			{
 			 	
-			mexPrintf("FC Barcelona \n");	
 		 	if (InListuniquecollj[EltCollIndex[iEltColl]]==true)
 		 	{
 
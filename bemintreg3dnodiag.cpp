@@ -5,6 +5,7 @@
 #include "bemnormal.h"
 #include "greeneval3d.h"
 #include "greenrotate3d.h"
+#include "greenmemo.h"
 #include <math.h>
 #include <time.h>
 #include <new>
@@ -76,7 +77,8 @@ void bemintreg3dnodiag(
 				 const unsigned int& nXi, 
 				 // const double* const xi, 
 				 const double* const H,
-				 const double* const N, const double* const M, const double* const dN)
+				 const double* const N, const double* const M, const double* const dN,
+				 GreenMemo* const memo)
 {
   // ELEMENT PROPERTIES
   const unsigned int EltType = (unsigned int)(Elt[nElt+iElt]);
@@ -307,9 +309,17 @@ void bemintreg3dnodiag(
 
         // EVALUATE GREEN'S FUNCTION
         //mexPrintf("extrapFlag: %s \n", extrapFlag ? "true": "false");
-        greeneval3d(greenPtr,nGrSet,ugCmplx,tgCmplx,tg0Cmplx,xiR,xiZ,r1,r2,z1,z2,zs1,
-                    interpr,interpz,extrapFlag,UmatOut,TmatOut,Coll,nColl,uniquescolli[iuniquescolli],4,UgrRe,
-                    UgrIm,TgrRe,TgrIm,Tgr0Re,Tgr0Im);
+        // Green's function from the memo cache, if the offset recurs
+        bool memoFound=false;
+        double* const memoVal=(memo==0 ? 0 : greenmemofind(*memo,xiR,xiZ,Coll,nColl,uniquescolli[iuniquescolli],4,memoFound));
+        if (memoFound) greenmemocopy(*memo,memoVal,false,UgrRe,UgrIm,TgrRe,TgrIm,Tgr0Re,Tgr0Im);
+        else
+        {
+          greeneval3d(greenPtr,nGrSet,ugCmplx,tgCmplx,tg0Cmplx,xiR,xiZ,r1,r2,z1,z2,zs1,
+                      interpr,interpz,extrapFlag,UmatOut,TmatOut,Coll,nColl,uniquescolli[iuniquescolli],4,UgrRe,
+                      UgrIm,TgrRe,TgrIm,Tgr0Re,Tgr0Im);
+          if (memoVal!=0) greenmemocopy(*memo,memoVal,true,UgrRe,UgrIm,TgrRe,TgrIm,Tgr0Re,Tgr0Im);
+        }
         greenrotate3d(normal,iXi,xiTheta,nGrSet,ugCmplx,
                       tgCmplx,tg0Cmplx,UgrRe,UgrIm,TgrRe,TgrIm,
                       Tgr0Re,Tgr0Im,UXiRe,UXiIm,TXiRe,TXiIm,TXi0Re,
@@ -609,9 +619,17 @@ void bemintreg3dnodiag(
         const double xiZ=Zdiff;
 
         // EVALUATE GREEN'S FUNCTION
-        greeneval3d(greenPtr,nGrSet,ugCmplx,tgCmplx,tg0Cmplx,xiR,xiZ,r1,r2,z1,z2,zs1,
-                    interpr,interpz,extrapFlag,UmatOut,TmatOut,Coll,nColl,iColl,4,UgrRe,
-                    UgrIm,TgrRe,TgrIm,Tgr0Re,Tgr0Im);
+        // Green's function from the memo cache, if the offset recurs
+        bool memoFound=false;
+        double* const memoVal=(memo==0 ? 0 : greenmemofind(*memo,xiR,xiZ,Coll,nColl,iColl,4,memoFound));
+        if (memoFound) greenmemocopy(*memo,memoVal,false,UgrRe,UgrIm,TgrRe,TgrIm,Tgr0Re,Tgr0Im);
+        else
+        {
+          greeneval3d(greenPtr,nGrSet,ugCmplx,tgCmplx,tg0Cmplx,xiR,xiZ,r1,r2,z1,z2,zs1,
+                      interpr,interpz,extrapFlag,UmatOut,TmatOut,Coll,nColl,iColl,4,UgrRe,
+                      UgrIm,TgrRe,TgrIm,Tgr0Re,Tgr0Im);
+          if (memoVal!=0) greenmemocopy(*memo,memoVal,true,UgrRe,UgrIm,TgrRe,TgrIm,Tgr0Re,Tgr0Im);
+        }
         greenrotate3d(normal,iXi,xiTheta,nGrSet,ugCmplx,
                       tgCmplx,tg0Cmplx,UgrRe,UgrIm,TgrRe,TgrIm,
                       Tgr0Re,Tgr0Im,UXiRe,UXiIm,TXiRe,TXiIm,TXi0Re,
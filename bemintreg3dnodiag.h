@@ -1,6 +1,8 @@
 #ifndef _BEMINTREG3DNODIAG_
 #define _BEMINTREG3DNODIAG_
 
+#include "greenmemo.h"
+
 #ifndef _int64_
 typedef long long int int64;
 typedef unsigned long long int uint64;
@@ -51,5 +53,10 @@ void bemintreg3dnodiag(
 				 const unsigned int& nXi, 
 				 // const double* const xi, 
 				 const double* const H,
-				 const double* const N, const double* const M, const double* const dN);
+				 const double* const N, const double* const M, const double* const dN,
+				 GreenMemo* const memo);
+/*   Regular integration over element iElt for the collocation points that
+ *   are not on the element. If memo is not 0, the Green's function is taken
+ *   from and stored in the memo cache memo, which is shared by all elements.
+ */
 #endif
@@ -0,0 +1,209 @@
+#include <new>
+#include <atomic>
+#include "shapefun.h"
+#include "gausspw.h"
+#include "bemsparse.h"
+#include "bemmass.h"
+
+using namespace std;
+
+struct MassType
+{
+  unsigned int nXi;          // Number of integration points
+  double* H;                 // Integration weights (nXi)
+  double* N;                 // Shape functions of the geometry (nEltNod * nXi)
+  double* dN;                // Derivatives of N (2 * nEltNod * nXi)
+  double* M;                 // Shape functions of the collocation points (nEltColl * nXi)
+};
+
+struct MassData
+{
+  const BemTopology* topo;
+  bool probAxi;
+  const MassType* type;      // Integration data per type
+  unsigned int maxEltNod;
+  unsigned int maxEltColl;
+  const size_t* tripPtr;     // First triplet of each element (nElt+1)
+  unsigned int* row;
+  unsigned int* col;
+  double* val;
+  atomic<bool> outOfMemory;
+};
+
+//==============================================================================
+static void massworker(void* const data, const unsigned int& iEltBeg,
+                       const unsigned int& iEltEnd)
+// Triplets of the elements [iEltBeg,iEltEnd).
+//==============================================================================
+{
+  MassData& d=*((MassData*)data);
+  const BemTopology& topo=*d.topo;
+  const unsigned int nNod=topo.nNod;
+  double* const work=new(nothrow) double[3*d.maxEltNod+7*16+d.maxEltColl*d.maxEltColl];
+  if (work==0)
+  {
+    d.outOfMemory=true;
+    return;
+  }
+  double* const EltNod=work;
+  double* const nat=EltNod+3*d.maxEltNod;
+  double* const Jac=nat+6*16;
+  double* const m=Jac+16;
+
+  for (unsigned int iElt=iEltBeg; iElt<iEltEnd; iElt++)
+  {
+    const BemEltTypeDef& def=topo.typeDef[topo.eltType[iElt]];
+    const MassType& typ=d.type[topo.eltType[iElt]];
+    const unsigned int nEltNod=def.nEltNod;
+    const unsigned int nEltColl=def.nEltColl;
+    const unsigned int* const eltNod=topo.eltNod+topo.eltPtr[iElt];
+    const unsigned int* const eltColl=topo.eltColl+topo.eltPtr[iElt];
+    for (unsigned int iEltNod=0; iEltNod<nEltNod; iEltNod++)
+    {
+      for (unsigned int iCoord=0; iCoord<3; iCoord++)
+      {
+        EltNod[iCoord*nEltNod+iEltNod]=topo.Nod[(1+iCoord)*nNod+eltNod[iEltNod]];
+      }
+    }
+    shapenatcoord(typ.dN,nEltNod,typ.nXi,EltNod,nat,def.eltDim);
+    jacobian(nat,typ.nXi,Jac,def.eltDim);
+
+    // ELEMENT MASS MATRIX OF THE COLLOCATION POINTS
+    for (unsigned int i=0; i<nEltColl*nEltColl; i++) m[i]=0.0;
+    for (unsigned int iXi=0; iXi<typ.nXi; iXi++)
+    {
+      double w=typ.H[iXi]*Jac[iXi];
+      if (d.probAxi)
+      {
+        double xiRadius=0.0;
+        for (unsigned int iEltNod=0; iEltNod<nEltNod; iEltNod++) xiRadius+=typ.N[nEltNod*iXi+iEltNod]*EltNod[iEltNod];
+        w*=6.28318530717959*xiRadius;
+      }
+      const double* const M=typ.M+nEltColl*iXi;
+      for (unsigned int jColl=0; jColl<nEltColl; jColl++)
+      {
+        for (unsigned int iColl=0; iColl<=jColl; iColl++) m[nEltColl*jColl+iColl]+=w*M[iColl]*M[jColl];
+      }
+    }
+    for (unsigned int jColl=0; jColl<nEltColl; jColl++)
+    {
+      for (unsigned int iColl=jColl+1; iColl<nEltColl; iColl++) m[nEltColl*jColl+iColl]=m[nEltColl*iColl+jColl];
+    }
+
+    size_t iTrip=d.tripPtr[iElt];
+    for (unsigned int jColl=0; jColl<nEltColl; jColl++)
+    {
+      for (unsigned int iColl=0; iColl<nEltColl; iColl++)
+      {
+        d.row[iTrip]=eltColl[iColl];
+        d.col[iTrip]=eltColl[jColl];
+        d.val[iTrip]=m[nEltColl*jColl+iColl];
+        iTrip++;
+      }
+    }
+  }
+  delete [] work;
+}
+
+//==============================================================================
+mxArray* bemmass(const BemTopology& topo, const bool& probAxi,
+                 const unsigned int& nThread)
+//==============================================================================
+{
+  const unsigned int nElt=topo.nElt;
+  const unsigned int nEltType=topo.nEltType;
+  MassType* type=0;
+  double* typeWork=0;
+  size_t* tripPtr=0;
+  unsigned int* row=0;
+  unsigned int* col=0;
+  double* val=0;
+  mxArray* A=0;
+  const char* error=0;
+  try
+  {
+    // INTEGRATION POINTS AND SHAPE FUNCTIONS PER ELEMENT TYPE
+    type=new(nothrow) MassType[nEltType];
+    if (type==0) throw("Out of memory.");
+    size_t nTypeWork=0;
+    unsigned int maxEltNod=1;
+    unsigned int maxEltColl=1;
+    for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+    {
+      const BemEltTypeDef& def=topo.typeDef[iTyp];
+      type[iTyp].nXi=0;
+      if (!def.used) continue;
+      type[iTyp].nXi=(def.parent==2 ? 16 : 7);
+      nTypeWork+=(size_t)type[iTyp].nXi*(3+3*def.nEltNod+def.nEltColl);
+      if (def.nEltNod>maxEltNod) maxEltNod=def.nEltNod;
+      if (def.nEltColl>maxEltColl) maxEltColl=def.nEltColl;
+    }
+    typeWork=new(nothrow) double[nTypeWork];
+    if (typeWork==0) throw("Out of memory.");
+    double* p=typeWork;
+    for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+    {
+      const BemEltTypeDef& def=topo.typeDef[iTyp];
+      MassType& typ=type[iTyp];
+      if (!def.used) continue;
+      const unsigned int nXi=typ.nXi;
+      double* const xi=p;
+      typ.H=xi+2*nXi;
+      typ.N=typ.H+nXi;
+      typ.dN=typ.N+nXi*def.nEltNod;
+      typ.M=typ.dN+2*nXi*def.nEltNod;
+      p=typ.M+nXi*def.nEltColl;
+      for (unsigned int i=0; i<2*nXi; i++) xi[i]=0.0;
+      if (def.parent==0) gausspw1D(1,7,xi,typ.H);
+      else if (def.parent==1) gausspwtri(7,xi,typ.H);
+      else gausspw2D(1,4,xi,typ.H);
+      shapefun(def.shapeN,nXi,xi,typ.N);
+      shapefun(def.shapeM,nXi,xi,typ.M);
+      shapederiv(def.shapeN,nXi,xi,typ.dN);
+    }
+
+    // TRIPLETS, ASSEMBLED IN PARALLEL
+    tripPtr=new(nothrow) size_t[nElt+1];
+    if (tripPtr==0) throw("Out of memory.");
+    tripPtr[0]=0;
+    for (unsigned int iElt=0; iElt<nElt; iElt++)
+    {
+      const BemEltTypeDef& def=topo.typeDef[topo.eltType[iElt]];
+      tripPtr[iElt+1]=tripPtr[iElt]+(size_t)def.nEltColl*def.nEltColl;
+    }
+    const size_t nTriplet=tripPtr[nElt];
+    row=new(nothrow) unsigned int[nTriplet];
+    col=new(nothrow) unsigned int[nTriplet];
+    val=new(nothrow) double[nTriplet];
+    if ((row==0) || (col==0) || (val==0)) throw("Out of memory.");
+    MassData data;
+    data.topo=&topo;
+    data.probAxi=probAxi;
+    data.type=type;
+    data.maxEltNod=maxEltNod;
+    data.maxEltColl=maxEltColl;
+    data.tripPtr=tripPtr;
+    data.row=row;
+    data.col=col;
+    data.val=val;
+    data.outOfMemory=false;
+    bemtopologyloop(massworker,&data,nElt,nThread);
+    if (data.outOfMemory) throw("Out of memory.");
+
+    // SPARSE MATRIX: THE CONTRIBUTIONS OF THE ELEMENTS ARE SUMMED
+    const size_t nTotalColl=topo.nCentroidColl+topo.nNodalColl;
+    A=bemsparse(nTotalColl,nTotalColl,nTriplet,row,col,val,true);
+  }
+  catch (const char* exception)
+  {
+    error=exception;
+  }
+  delete [] type;
+  delete [] typeWork;
+  delete [] tripPtr;
+  delete [] row;
+  delete [] col;
+  delete [] val;
+  if (error!=0) throw(error);
+  return A;
+}
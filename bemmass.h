@@ -0,0 +1,21 @@
+#include "mex.h"
+#include "bemtopology.h"
+
+#ifndef _BEMMASS_
+#define _BEMMASS_
+mxArray* bemmass(const BemTopology& topo, const bool& probAxi,
+                 const unsigned int& nThread);
+/*   Sparse mass matrix of the collocation points (nTotalColl * nTotalColl)
+ *
+ *           /
+ *   m_ij =  |  M_i * M_j  dS
+ *           /
+ *         Gamma
+ *
+ *   with the boundary element interpolation functions M_i and M_j of the
+ *   collocation points i and j, including the factor 2*pi*r for
+ *   axisymmetric problems (probAxi). The elements are integrated with the
+ *   Gauss rules of bemint on nThread threads. The matrix is exactly
+ *   symmetric, so that its columns may be used as rows.
+ */
+#endif
@@ -3,6 +3,7 @@
 #include "bemcollpoints.h"
 #include "bemintreg3d.h"
 #include "bemintreg3dnodiag.h"
+#include "greenmemo.h"
 #include "bemintreg3ddiag.h"
 #include "bemintreg3dperiodic.h"
 #include "bemintreg2d.h"
@@ -57,7 +58,8 @@ void bemmat(const bool& probAxi, const bool& probPeriodic, const unsigned int& p
 			const unsigned int* const RegularColl, 
 			const unsigned int* const ncumulEltNod, const double* const EltNod,
 			const unsigned int* const RefEltType,  const unsigned int* const ncumulnXi, const unsigned int* const nXi, const double* const xi, const double* const H,
-			const unsigned int* const ncumulNshape, const double* const Nshape, const double* const Mshape, const double* const dNshape)
+			const unsigned int* const ncumulNshape, const double* const Nshape, const double* const Mshape, const double* const dNshape,
+			GreenMemoOptions& memoOpt)
 //==============================================================================
 {
 
@@ -591,6 +593,15 @@ for (unsigned int i=0; i<ms*ns; i++)
 		
 		
 		// /*
+  // MEMO CACHE OF THE GREEN'S FUNCTION, SHARED BY ALL ELEMENTS
+  const bool memoOn=(memoOpt.tol>0.0) && (probDim==3) && !probPeriodic;
+  GreenMemo memo;
+  if (memoOn) greenmemoinit(greenPtr,memoOpt.tol,memoOpt.maxEntry,nGrSet,ugCmplx,tgCmplx,tg0Cmplx,TmatOut,memo);
+
+  // THE CACHE IS RELEASED IF THE INTEGRATION FAILS
+  try
+  {
+
   // ELEMENT-BY-ELEMENT INTEGRATION 
   for (unsigned int iElt=0; iElt<nElt; iElt++)  // Enkel loop over nodige elementen
   {
@@ -861,7 +872,8 @@ for (unsigned int i=0; i<ms*ns; i++)
 					EltNod_loc,
 					nXi_loc,
 //					xi_loc,
-					H_loc,N_loc,M_loc,dN_loc);
+					H_loc,N_loc,M_loc,dN_loc,
+					(memoOn ? &memo : 0));
         
 	//mexPrintf("Regular %d \n",iElt);
 // float time_bemmat_elt = (float) (clock() - start_bemmat_elt) / CLOCKS_PER_SEC; 
@@ -1852,6 +1864,21 @@ for (unsigned int i=0; i<ms*ns; i++)
 
   delete [] DeltaInListuniquecollj;
   delete [] scolliOnDiaginddiag;
+
+  }
+  catch (...)
+  {
+    if (memoOn) greenmemoclear(memo);
+    throw;
+  }
+
+  if (memoOn)
+  {
+    memoOpt.nHit+=memo.nHit;
+    memoOpt.nMiss+=memo.nMiss;
+    memoOpt.nEntry+=memo.nEntry;
+    greenmemoclear(memo);
+  }
   
   // delete [] uniquescolliondiag;  
 
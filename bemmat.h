@@ -1,6 +1,8 @@
 #ifndef _BEMMAT_
 #define _BEMMAT_
 
+#include "greenmemo.h"
+
 void bemmat(const bool& probAxi, const bool& probPeriodic, const unsigned int& probDim,
             const unsigned int& nColDof, const bool& UmatOut, const bool& TmatOut,
             const double* const Nod, const unsigned int& nNod,
@@ -27,5 +29,6 @@ void bemmat(const bool& probAxi, const bool& probPeriodic, const unsigned int& p
 			const unsigned int* const RegularColl, 
 			const unsigned int* const ncumulEltNod, const double* const EltNod,
 			const unsigned int* const RefEltType, const unsigned int* const ncumulnXi, const unsigned int* const nXi, const double* const xi, const double* const H,
-			const unsigned int* const ncumulNshape, const double* const Nshape, const double* const Mshape, const double* const dNshape);
+			const unsigned int* const ncumulNshape, const double* const Nshape, const double* const Mshape, const double* const dNshape,
+			GreenMemoOptions& memoOpt);
 #endif
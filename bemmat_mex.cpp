@@ -18,9 +18,65 @@
  *   [U,T] = BEMMAT(nod,elt,typ,'fsgreen3dt',Cs,Cp,rho,delt,t)
  *   [U,T] = BEMMAT(nod,elt,typ,'fsgreenf',Cs,Cp,Ds,Dp,rho,py,omega)
  *   [U,T] = BEMMAT(nod,elt,typ,'user',zs,r,z,ug,sg,sg0)
+ *   [U,T] = BEMMAT(nod,elt,typ,'user',gfile)
  * 
  *   [Ue,Te] = BEMMAT(nod,elt,typ,s,green,...)
  *
+ *   BEMMAT('file',ufile,tfile,nod,elt,typ,green,...) writes the system
+ *   matrices directly to the files ufile and tfile instead of returning
+ *   them. The files are memory mapped, so that the operating system pages
+ *   the computed entries out to disk and the matrices need not fit in
+ *   memory. If tfile is empty, only U is computed. The file layout is
+ *   documented in bemmatfile.h; the function BEMMATREAD maps individual
+ *   slices (e.g. frequencies) back into memory.
+ *
+ *   BEMMAT('sweep',nThread,nod,elt,typ,green,...) splits the frequencies in
+ *   chunks that are assembled in parallel by nThread threads, which share the
+ *   mesh and quadrature data. Every chunk writes its own frequency slices of
+ *   U and T. BEMMAT('sweep',[nThread nChunk],...) limits the number of
+ *   frequencies per chunk to nChunk, which bounds the scratch memory of the
+ *   integration per thread. The option applies to the frequency dependent
+ *   Green's functions 'fsgreen3d', 'fsgreen2d_inplane',
+ *   'fsgreen2d_outofplane' and 'fsgreenf' and can be combined with the
+ *   option 'file'; periodic problems are assembled by a single thread.
+ *
+ *   BEMMAT('interp',method,nod,elt,typ,'user',...) selects the interpolation
+ *   of a user defined Green's function in r and z: 'linear' (default),
+ *   'spline' for a not-a-knot cubic spline or 'pchip' for a monotone piecewise
+ *   cubic interpolant, which does not overshoot near steep gradients. The
+ *   cubic methods use tables of derivatives that are computed once per call
+ *   and need three times the memory of ug, sg and sg0 (six times for single
+ *   precision tables). Near the lower bound of r, where the tables are
+ *   extrapolated, the interpolation is linear.
+ *   BEMMAT('interpzs',method,...) selects 'nearest' (default) or 'linear'
+ *   interpolation between the source depths zs. The options can be combined
+ *   with each other and with the options 'file' and 'sweep'.
+ *
+ *   BEMMAT('memo',tol,nod,elt,typ,green,...) caches the Green's function of
+ *   the regular integration of 3D problems for source to receiver offsets
+ *   (r,z) rounded to multiples of tol, so that the offsets that recur on
+ *   regular meshes are evaluated once. For a user defined Green's function,
+ *   the source depth zs is part of the key. The cache is shared by all
+ *   elements and holds at most 256 MB of values per thread;
+ *   BEMMAT('memo',[tol nEntry],...) limits it to nEntry offsets instead. The
+ *   numbers of cache hits and misses are printed. A small tol relative to the
+ *   element size keeps the error of the cached values below that of the
+ *   interpolation of the tables: the cached value may be used for offsets
+ *   that differ by up to tol in r and z.
+ *
+ *   BEMMAT(nod,elt,typ,'user',gfile) reads the tables zs, r, z, ug, sg and
+ *   sg0 from a Green's function file written by BEMGREENWRITE. The file is
+ *   memory mapped and shared between all processes that use it, so that
+ *   only the pages of the tables that are needed for the mesh are loaded
+ *   from disk and the tables need not be copied into every MATLAB session.
+ *   For periodic problems, the arguments L, ky and nmax follow gfile. The
+ *   file layout is documented in greenfile.h.
+ *
+ *   The tables ug, sg and sg0 are double or single precision arrays, or are
+ *   stored in single precision in the Green's function file. Single
+ *   precision tables halve the memory and the data read from disk; they are
+ *   interpolated without conversion and all sums are double precision.
+ *
  *
  *
  *   nod      Nodes (nNod * 4). Each row has the layout [nodID x y z] where
@@ -57,14 +113,19 @@
  *   sg       Green's stresses.
  *   sg0      Static Green's stresses, used for the regularisation of the boundary 
  *            integral equation.
+ *   gfile    Green's function file name (string).
+ *   ufile    Output file name for U (string).
+ *   tfile    Output file name for T (string) or empty.
+ *   nThread  Number of threads (1 * 1) or [nThread nChunk] (1 * 2).
+ *   method   Interpolation method (string).
  *   U        Boundary element displacement system matrix (nDof * nDof * ...).
  *   T        Boundary element traction system matrix (nDof * nDof * ...).
  */
 
 /* $Make: mex -O -output bemmat bemmat_mex.cpp bemmat.cpp eltdef.cpp 
-              bemcollpoints.cpp shapefun.cpp bemintreg3d.cpp
+              bemcollpoints.cpp pointgrid.cpp shapefun.cpp bemintreg3d.cpp
               bemintreg3dperiodic.cpp bemintreg2d.cpp bemintregaxi.cpp 
-              bemintsing3d.cpp bemintsing3dperiodic.cpp bemintsing2d.cpp bemintsingaxi.cpp gausspw.cpp search1.cpp bemnormal.cpp bemdimension.cpp bemisaxisym.cpp bemisperiodic.cpp greeneval2d.cpp greeneval3d.cpp greenrotate2d.cpp greenrotate3d.cpp fsgreenf.cpp fsgreen2d_inplane.cpp fsgreen2d_outofplane.cpp besselh.cpp fsgreen3d.cpp fsgreen3dt.cpp$*/
+              bemintsing3d.cpp bemintsing3dperiodic.cpp bemintsing2d.cpp bemintsingaxi.cpp gausspw.cpp search1.cpp bemnormal.cpp bemdimension.cpp bemisaxisym.cpp bemisperiodic.cpp bemmatfile.cpp greeneval2d.cpp greeneval3d.cpp greeninterp.cpp greenfile.cpp greenmemo.cpp greenrotate2d.cpp greenrotate3d.cpp fsgreenf.cpp fsgreen2d_inplane.cpp fsgreen2d_outofplane.cpp besselh.cpp fsgreen3d.cpp fsgreen3dt.cpp$*/
 
 
 
@@ -94,15 +155,24 @@ mexFunction-|
 #include "bemdimension.h"
 #include "bemisaxisym.h"
 #include "bemisperiodic.h"
+#include "bemmatfile.h"
+#include "search1.h"
+#include "greeninterp.h"
+#include "greenfile.h"
+#include "greenmemo.h"
 //#include "checklicense.h"
 #include <math.h>
 #include <new>
 // #include "mex.h"
 #include <time.h>
 #include <assert.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #ifndef __GNUC__
 #define strcasecmp _strcmpi
+#define isnan(x) ((x) != (x))
 #endif
 
 #ifndef _int64_
@@ -205,7 +275,169 @@ using namespace std;
 	static double* Nshape;
 	static double* Mshape;
 	static double* dNshape;
+
+    // OUT-OF-CORE OUTPUT: FILE NAMES AND MAPPINGS OF U AND T
+    static char* OutFile[2]={0,0};
+    static void* OutMap[2]={0,0};
+    static unsigned long long OutMapSize[2]={0,0};
+
+    // FREQUENCY SWEEP: NUMBER OF THREADS AND MAXIMUM NUMBER OF FREQUENCIES
+    // PER CHUNK (0: EQUAL SHARE PER THREAD)
+    static unsigned int SweepThread=1;
+    static unsigned int SweepChunk=0;
+
+    // INTERPOLATION OF USER DEFINED GREEN'S FUNCTIONS: METHOD IN (r,z)
+    // (0: LINEAR, 1: SPLINE, 2: PCHIP) AND LINEAR INTERPOLATION IN zs
+    static unsigned int InterpMethod=0;
+    static bool InterpZsLinear=false;
+
+    // MEMO CACHE OF GREEN'S FUNCTION EVALUATIONS: TOLERANCE, MAXIMUM NUMBER
+    // OF ENTRIES AND STATISTICS
+    static GreenMemoOptions MemoOptions;
+
+    // USER DEFINED GREEN'S FUNCTION: TABLES, WHICH ARE MAPPED FROM A FILE
+    // DURING THE INTEGRATION IF A GREEN'S FUNCTION FILE IS SPECIFIED
+    static GreenTable UserTable;
 	
+//==============================================================================
+void createMatOutput(mxArray* plhs[], const unsigned int& iOut,
+                     const unsigned int& nMatDim, const size_t* const MatDim,
+                     const bool& Cmplx, double*& Re, double*& Im)
+/* Allocate the system matrix U (iOut=0) or T (iOut=1) as an output argument
+ * or, if an output file is specified, as a memory mapped file.
+ */
+//==============================================================================
+{
+  if (OutFile[iOut]==0)
+  {
+    plhs[iOut]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,(Cmplx ? mxCOMPLEX : mxREAL));
+    Re=mxGetPr(plhs[iOut]);
+    Im=mxGetPi(plhs[iOut]);
+  }
+  else
+  {
+    OutMap[iOut]=bemmatFileCreate(OutFile[iOut],nMatDim,MatDim,Cmplx,Re,Im,OutMapSize[iOut]);
+  }
+}
+
+//==============================================================================
+void closeMatOutput()
+/* Flush and unmap the output files and unmap the Green's function file.
+ */
+//==============================================================================
+{
+  for (unsigned int iOut=0; iOut<2; iOut++)
+  {
+    if (OutMap[iOut]!=0) bemmatFileClose(OutMap[iOut],OutMapSize[iOut]);
+    if (OutFile[iOut]!=0) mxFree(OutFile[iOut]);
+    OutMap[iOut]=0;
+    OutFile[iOut]=0;
+  }
+  greenFileClose(UserTable);
+}
+
+//==============================================================================
+template <class Assemble>
+void sweepFreq(const bool& chunked, const unsigned int& nFreq,
+               const unsigned int& nSetFreq, const uint64& nMatU,
+               const uint64& nMatT, const void* const* const greenPtr,
+               const unsigned int& nGreenPtr, const unsigned int& nFreqPos,
+               const unsigned int& omegaPos, double* const URe,
+               double* const UIm, double* const TRe, double* const TIm,
+               Assemble assemble)
+/* Assemble the system matrices for all frequencies, split in chunks of
+ * consecutive frequencies that are distributed over SweepThread threads.
+ * The Green's function pointer array of every chunk refers to its own
+ * part of the frequency vector greenPtr[omegaPos], and every chunk writes
+ * its own slices of the output matrices, which are ordered with the
+ * frequency as the slowest varying dimension (nSetFreq function sets per
+ * frequency). The mesh and quadrature data are shared by all threads.
+ * assemble(greenPtr,nGrSet,URe,UIm,TRe,TIm) calls bemmat for a chunk.
+ */
+//==============================================================================
+{
+  const unsigned int nThread=(chunked ? SweepThread : 1);
+  unsigned int nChunkFreq=(nFreq+nThread-1)/nThread;
+  if (chunked && (SweepChunk>0) && (SweepChunk<nChunkFreq)) nChunkFreq=SweepChunk;
+  if (nChunkFreq==0) nChunkFreq=1;
+  const unsigned int nChunk=(nFreq+nChunkFreq-1)/nChunkFreq;
+
+  if (nChunk<=1)
+  {
+    assemble(greenPtr,nFreq*nSetFreq,URe,UIm,TRe,TIm);
+    return;
+  }
+
+  // GREEN'S FUNCTION POINTER ARRAYS OF THE CHUNKS
+  unsigned int* const chunkFreq=new(nothrow) unsigned int[2*nChunk];
+  if (chunkFreq==0) throw("Out of memory.");
+  const void** const chunkPtr=new(nothrow) const void*[nChunk*nGreenPtr];
+  if (chunkPtr==0)
+  {
+    delete [] chunkFreq;
+    throw("Out of memory.");
+  }
+  for (unsigned int iChunk=0; iChunk<nChunk; iChunk++)
+  {
+    const unsigned int iFreq0=iChunk*nChunkFreq;
+    chunkFreq[2*iChunk+0]=iFreq0;
+    chunkFreq[2*iChunk+1]=(iFreq0+nChunkFreq<nFreq ? nChunkFreq : nFreq-iFreq0);
+    for (unsigned int iPtr=0; iPtr<nGreenPtr; iPtr++) chunkPtr[nGreenPtr*iChunk+iPtr]=greenPtr[iPtr];
+    chunkPtr[nGreenPtr*iChunk+nFreqPos]=&chunkFreq[2*iChunk+1];
+    chunkPtr[nGreenPtr*iChunk+omegaPos]=(const double*)greenPtr[omegaPos]+iFreq0;
+  }
+
+  // WORKERS: EACH THREAD TAKES THE NEXT CHUNK UNTIL ALL ARE ASSEMBLED
+  atomic<unsigned int> nextChunk(0);
+  mutex errorLock;
+  const char* error=0;
+  auto worker=[&]()
+  {
+    for (unsigned int iChunk=nextChunk++; iChunk<nChunk; iChunk=nextChunk++)
+    {
+      const uint64 offsetU=nMatU*nSetFreq*chunkFreq[2*iChunk];
+      const uint64 offsetT=nMatT*nSetFreq*chunkFreq[2*iChunk];
+      try
+      {
+        assemble(&chunkPtr[nGreenPtr*iChunk],chunkFreq[2*iChunk+1]*nSetFreq,
+                 (URe==0 ? 0 : URe+offsetU),(UIm==0 ? 0 : UIm+offsetU),
+                 (TRe==0 ? 0 : TRe+offsetT),(TIm==0 ? 0 : TIm+offsetT));
+      }
+      catch (const char* exception)
+      {
+        lock_guard<mutex> lock(errorLock);
+        if (error==0) error=exception;
+        nextChunk=nChunk;
+      }
+    }
+  };
+
+  const unsigned int nWorker=(nThread<nChunk ? nThread : nChunk);
+  thread* const workers=new(nothrow) thread[nWorker-1];
+  if (workers==0)
+  {
+    delete [] chunkPtr;
+    delete [] chunkFreq;
+    throw("Out of memory.");
+  }
+  unsigned int nStarted=0;
+  try
+  {
+    for (; nStarted<nWorker-1; nStarted++) workers[nStarted]=thread(worker);
+  }
+  catch (...)
+  {
+    // Threads that could not be started leave their chunks to the others.
+  }
+  worker();
+  for (unsigned int iWorker=0; iWorker<nStarted; iWorker++) workers[iWorker].join();
+
+  delete [] workers;
+  delete [] chunkPtr;
+  delete [] chunkFreq;
+  if (error!=0) throw(error);
+}
+
 //==============================================================================
 void IntegrateGreenUser(mxArray* plhs[], int nrhs,
                         const mxArray* prhs[], const bool probAxi, const bool probPeriodic,
@@ -251,9 +483,17 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
 	// mexPrintf("nrhs %d \n",nrhs);
 	
   // INPUT ARGUMENT PROCESSING
+  // The tables are passed as arrays zs,r,z,ug,sg,sg0 or as the name of a
+  // Green's function file, which is mapped into memory.
+  const bool greenFileIn=mxIsChar(prhs[greenPos+1]);
+  const unsigned int periodicPos=(greenFileIn ? greenPos+2 : greenPos+7);
   if (probPeriodic)
   {
-    if (!(nrhs==13)) throw("Wrong number of input arguments.");
+    if (!(nrhs==(greenFileIn ? (int)greenPos+5 : 13))) throw("Wrong number of input arguments.");
+  }
+  else if (greenFileIn)
+  {
+    if (nrhs>(greenPos+2)) throw("Too many input arguments.");
   }
   else
   {
@@ -264,47 +504,120 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
   }
 
   // mexPrintf("nrhs<(greenPos+5): %s \n", (nrhs<(greenPos+5)) ? "true": "false");
-	
 
-  if (!mxIsNumeric(prhs[greenPos+1])) throw("Input argument 'zs' must be numeric.");
-  if (mxIsSparse(prhs[greenPos+1])) throw("Input argument 'zs' must not be sparse.");
-  if (mxIsEmpty(prhs[greenPos+1])) throw("Input argument 'zs' must not be empty.");
-  const unsigned int nzs=mxGetNumberOfElements(prhs[greenPos+1]);
-  const double* const zs=mxGetPr(prhs[greenPos+1]);
+  GreenTable& table=UserTable;
+  if (greenFileIn)
+  {
+    char* const fileName=mxArrayToString(prhs[greenPos+1]);
+    if (fileName==0) throw("Input argument 'gfile' must be a string.");
+    try
+    {
+      greenFileOpen(fileName,table);
+    }
+    catch (const char*)
+    {
+      mxFree(fileName);
+      throw;
+    }
+    mxFree(fileName);
+    if (TmatOut && ((table.sgRe==0) || (table.sg0Re==0))) throw("The Green's function file contains no stresses 'sg' and 'sg0'.");
+  }
+  else
+  {
+    if (!mxIsNumeric(prhs[greenPos+1])) throw("Input argument 'zs' must be numeric.");
+    if (mxIsSparse(prhs[greenPos+1])) throw("Input argument 'zs' must not be sparse.");
+    if (mxIsEmpty(prhs[greenPos+1])) throw("Input argument 'zs' must not be empty.");
+    table.nzs=mxGetNumberOfElements(prhs[greenPos+1]);
+    table.zs=mxGetPr(prhs[greenPos+1]);
+
+    if (!mxIsNumeric(prhs[greenPos+2])) throw("Input argument 'r' must be numeric.");
+    if (mxIsSparse(prhs[greenPos+2])) throw("Input argument 'r' must not be sparse.");
+    if (mxIsEmpty(prhs[greenPos+2])) throw("Input argument 'r' must not be empty.");
+    table.nr=mxGetNumberOfElements(prhs[greenPos+2]);
+    table.r=mxGetPr(prhs[greenPos+2]);
+
+    if (!mxIsNumeric(prhs[greenPos+3])) throw("Input argument 'z' must be numeric.");
+    if (mxIsSparse(prhs[greenPos+3])) throw("Input argument 'z' must not be sparse.");
+    if (mxIsEmpty(prhs[greenPos+3])) throw("Input argument 'z' must not be empty.");
+    table.nz=mxGetNumberOfElements(prhs[greenPos+3]);
+    table.z=mxGetPr(prhs[greenPos+3]);
+
+    if (!mxIsNumeric(prhs[greenPos+4])) throw("Input argument 'ug' must be numeric.");
+    if (mxIsSparse(prhs[greenPos+4])) throw("Input argument 'ug' must not be sparse.");
+    if (mxIsEmpty(prhs[greenPos+4])) throw("Input argument 'ug' must not be empty.");
+    table.nDim=mxGetNumberOfDimensions(prhs[greenPos+4]);
+    table.dim=mxGetDimensions(prhs[greenPos+4]);
+    if (!(mxIsDouble(prhs[greenPos+4]) || mxIsSingle(prhs[greenPos+4]))) throw("Input argument 'ug' must be double or single.");
+    table.single=mxIsSingle(prhs[greenPos+4]);
+    table.ugRe=mxGetData(prhs[greenPos+4]);
+    table.ugIm=(mxIsComplex(prhs[greenPos+4]) ? mxGetImagData(prhs[greenPos+4]) : 0);
+
+    table.ntgComp=0;
+    table.sgRe=0;
+    table.sgIm=0;
+    table.sg0Re=0;
+    table.sg0Im=0;
+    if (TmatOut)
+    {
+      if (nrhs<(greenPos+7)) throw("Not enough input arguments.");
+
+      if (!mxIsNumeric(prhs[greenPos+5])) throw("Input argument 'sg' must be numeric.");
+      if (mxIsSparse(prhs[greenPos+5])) throw("Input argument 'sg' must not be sparse.");
+      const unsigned int ntgdim=mxGetNumberOfDimensions(prhs[greenPos+5]);
+      const size_t* const tgdim=mxGetDimensions(prhs[greenPos+5]);
+      if (!(table.nDim==ntgdim)) throw("Matrix dimensions of input arguments 'ug' and 'sg' must agree.");
+      for (unsigned int iDim=1; iDim<table.nDim; iDim++)
+      {
+        if (!(table.dim[iDim]==tgdim[iDim])) throw("Matrix dimensions of input arguments 'ug' and 'sg' are incompatible.");
+      }
+
+      if (!mxIsNumeric(prhs[greenPos+6])) throw("Input argument 'sg0' must be numeric.");
+      if (mxIsSparse(prhs[greenPos+6])) throw("Input argument 'sg0' must not be sparse.");
+      const unsigned int ntg0dim=mxGetNumberOfDimensions(prhs[greenPos+6]);
+      const size_t* const tg0dim=mxGetDimensions(prhs[greenPos+6]);
+      if (!(tg0dim[0]==tgdim[0])) throw("The first dimension of input argument 'sg0' has incorrect size.");
+      if (!(table.nDim==ntg0dim)) throw("Matrix dimensions of input arguments 'ug' and 'sg0' must agree.");
+      for (unsigned int iDim=1; iDim<table.nDim; iDim++)
+      {
+        if (!(table.dim[iDim]==tg0dim[iDim])) throw("Matrix dimensions of input arguments 'ug' and 'sg0' are incompatible.");
+      }
+
+      if (!(mxGetClassID(prhs[greenPos+5])==mxGetClassID(prhs[greenPos+4]))) throw("Input arguments 'ug' and 'sg' must have the same precision.");
+      if (!(mxGetClassID(prhs[greenPos+6])==mxGetClassID(prhs[greenPos+4]))) throw("Input arguments 'ug' and 'sg0' must have the same precision.");
+      table.ntgComp=tgdim[0];
+      table.sgRe=mxGetData(prhs[greenPos+5]);
+      table.sgIm=(mxIsComplex(prhs[greenPos+5]) ? mxGetImagData(prhs[greenPos+5]) : 0);
+      table.sg0Re=mxGetData(prhs[greenPos+6]);
+      table.sg0Im=(mxIsComplex(prhs[greenPos+6]) ? mxGetImagData(prhs[greenPos+6]) : 0);
+    }
+
+    // The tables are checked for NaN and Inf values once, rather than every
+    // interpolated value at every integration point. Green's function files
+    // are checked when they are written.
+    const size_t nugVal=mxGetNumberOfElements(prhs[greenPos+4]);
+    if (!greenTableFinite(table.ugRe,table.ugIm,nugVal,table.single)) throw("Input argument 'ug' must not contain NaN or Inf values.");
+    if (TmatOut)
+    {
+      const size_t ntgVal=mxGetNumberOfElements(prhs[greenPos+5]);
+      if (!greenTableFinite(table.sgRe,table.sgIm,ntgVal,table.single)) throw("Input argument 'sg' must not contain NaN or Inf values.");
+      if (!greenTableFinite(table.sg0Re,table.sg0Im,ntgVal,table.single)) throw("Input argument 'sg0' must not contain NaN or Inf values.");
+    }
+  }
+
+  const unsigned int nzs=table.nzs;
+  const double* const zs=table.zs;
   for (unsigned int izs=1; izs<nzs; izs++) if (!(zs[izs-1]<zs[izs])) throw("Input argument 'zs' must be monotonically increasing.");
 
-  // mexPrintf("nzs: %d \n",nzs);
- // for (int i=0; i<nzs ; i++)
-	// {
-		// mexPrintf("zs [%i]: %e \n",i,zs[i]);
-	// }
-  
-  if (!mxIsNumeric(prhs[greenPos+2])) throw("Input argument 'r' must be numeric.");
-  if (mxIsSparse(prhs[greenPos+2])) throw("Input argument 'r' must not be sparse.");
-  if (mxIsEmpty(prhs[greenPos+2])) throw("Input argument 'r' must not be empty.");
-  const unsigned int nr=mxGetNumberOfElements(prhs[greenPos+2]);
-  const double* const r=mxGetPr(prhs[greenPos+2]);
+  const unsigned int nr=table.nr;
+  const double* const r=table.r;
   for (unsigned int ir=1; ir<nr; ir++) if (!(r[ir-1]<r[ir])) throw("Input argument 'r' must be monotonically increasing.");
 
-  if (!mxIsNumeric(prhs[greenPos+3])) throw("Input argument 'z' must be numeric.");
-  if (mxIsSparse(prhs[greenPos+3])) throw("Input argument 'z' must not be sparse.");
-  if (mxIsEmpty(prhs[greenPos+3])) throw("Input argument 'z' must not be empty.");
-  const unsigned int nz=mxGetNumberOfElements(prhs[greenPos+3]);
-  const double* const z=mxGetPr(prhs[greenPos+3]);
+  const unsigned int nz=table.nz;
+  const double* const z=table.z;
   for (unsigned int iz=1; iz<nz; iz++) if (!(z[iz-1]<z[iz])) throw("Input argument 'z' must be monotonically increasing.");
 
-   // mexPrintf("nz: %d \n",nz);
-	// for (int i=0; i<nz ; i++)
-	// {
-		// mexPrintf("z [%i]: %e \n",i,z[i]);
-	// }
- 
-  
-  if (!mxIsNumeric(prhs[greenPos+4])) throw("Input argument 'ug' must be numeric.");
-  if (mxIsSparse(prhs[greenPos+4])) throw("Input argument 'ug' must not be sparse.");
-  if (mxIsEmpty(prhs[greenPos+4])) throw("Input argument 'ug' must not be empty.");
-  const unsigned int nugdim=mxGetNumberOfDimensions(prhs[greenPos+4]);
-  const size_t* const ugdim=mxGetDimensions(prhs[greenPos+4]);
+  const unsigned int nugdim=table.nDim;
+  const size_t* const ugdim=table.dim;
   const unsigned int nugComp=ugdim[0];
 
   const unsigned int nGreenDim=((nugdim>4)?(nugdim-4):1);
@@ -328,50 +641,24 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
   if (!((unsigned)nzs == ((nugdim>1)? ugdim[1]:1))) throw("Input arguments 'ug' and 'zs' are incompatible");
   if (!((unsigned)nr  == ((nugdim>2)? ugdim[2]:1))) throw("Input arguments 'ug' and 'r' are incompatible");
   if (!((unsigned)nz  == ((nugdim>3)? ugdim[3]:1))) throw("Input arguments 'ug' and 'z' are incompatible");
-  const double* const ugRe=mxGetPr(prhs[greenPos+4]);
-  const double* const ugIm=mxGetPi(prhs[greenPos+4]);
-  const bool ugCmplx=mxIsComplex(prhs[greenPos+4]);
+  const void* const ugRe=table.ugRe;
+  const void* const ugIm=table.ugIm;
+  const bool ugCmplx=(ugIm!=0);
 
   unsigned int ntgComp;
   if (nugComp==1) ntgComp=2;  // 2D, out-of-plane
   if (nugComp==4) ntgComp=6;  // 2D, in-plane
   if (nugComp==5) ntgComp=10; // 3D / axisymmetric
   if (nugComp==9) ntgComp=18; // 2.5D
+  if (TmatOut && !(table.ntgComp==ntgComp)) throw("The first dimension of input argument 'sg' has incorrect size.");
 
-  if (TmatOut)
-  {
-    if (nrhs<(greenPos+7)) throw("Not enough input arguments.");
-
-    if (!mxIsNumeric(prhs[greenPos+5])) throw("Input argument 'sg' must be numeric.");
-    if (mxIsSparse(prhs[greenPos+5])) throw("Input argument 'sg' must not be sparse.");
-    const unsigned int ntgdim=mxGetNumberOfDimensions(prhs[greenPos+5]);
-    const size_t* const tgdim=mxGetDimensions(prhs[greenPos+5]);
-    if (!(tgdim[0]==(unsigned)ntgComp)) throw("The first dimension of input argument 'sg' has incorrect size.");
-    if (!(nugdim==ntgdim)) throw("Matrix dimensions of input arguments 'ug' and 'sg' must agree.");
-    for (unsigned int iDim=1; iDim<nugdim; iDim++)
-    {
-      if (!(ugdim[iDim]==tgdim[iDim])) throw("Matrix dimensions of input arguments 'ug' and 'sg' are incompatible.");
-    }
+  const void* const tgRe= (TmatOut? table.sgRe:0);
+  const void* const tgIm= (TmatOut? table.sgIm:0);
+  const bool tgCmplx=(tgIm!=0);
 
-    if (!mxIsNumeric(prhs[greenPos+6])) throw("Input argument 'sg0' must be numeric.");
-    if (mxIsSparse(prhs[greenPos+6])) throw("Input argument 'sg0' must not be sparse.");
-    const unsigned int ntg0dim=mxGetNumberOfDimensions(prhs[greenPos+6]);
-    const size_t* const tg0dim=mxGetDimensions(prhs[greenPos+6]);
-    if (!(tg0dim[0]==(unsigned)ntgComp)) throw("The first dimension of input argument 'sg0' has incorrect size.");
-    if (!(nugdim==ntg0dim)) throw("Matrix dimensions of input arguments 'ug' and 'sg0' must agree.");
-    for (unsigned int iDim=1; iDim<nugdim; iDim++)
-    {
-      if (!(ugdim[iDim]==tg0dim[iDim])) throw("Matrix dimensions of input arguments 'ug' and 'sg0' are incompatible.");
-    }
-  }
-  
-  const double* const tgRe= (TmatOut? mxGetPr(prhs[greenPos+5]):0);
-  const double* const tgIm= (TmatOut? mxGetPi(prhs[greenPos+5]):0);
-  const bool tgCmplx=(TmatOut? mxIsComplex(prhs[greenPos+5]):false);
-
-  const double* const tg0Re= (TmatOut? mxGetPr(prhs[greenPos+6]):0);
-  const double* const tg0Im= (TmatOut? mxGetPi(prhs[greenPos+6]):0);
-  const bool tg0Cmplx=(TmatOut? mxIsComplex(prhs[greenPos+6]):false);
+  const void* const tg0Re= (TmatOut? table.sg0Re:0);
+  const void* const tg0Im= (TmatOut? table.sg0Im:0);
+  const bool tg0Cmplx=(tg0Im!=0);
 
   // Number of degrees of freedom points per collocation point.
   unsigned int nColDof;
@@ -384,131 +671,175 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
   // Vertical receiver coordinate is passed relative
   const bool zRel=false;   // ! No longer relative receiver grid ...
 
-  // Copy variables to generic array of pointers greenPtr
-  const unsigned int nGreenPtr=14;
-  const unsigned int GreenFunType=1;
-  const void** const greenPtr=new(nothrow) const void*[nGreenPtr];
-    if (greenPtr==0) throw("Out of memory.");
-  greenPtr[0]=&GreenFunType;
-  greenPtr[1]=&nzs;
-  greenPtr[2]=zs;
-  greenPtr[3]=&nr;
-  greenPtr[4]=r;
-  greenPtr[5]=&nz;
-  greenPtr[6]=z;
-  greenPtr[7]=ugRe;
-  greenPtr[8]=ugIm;
-  greenPtr[9]=tgRe;
-  greenPtr[10]=tgIm;
-  greenPtr[11]=tg0Re;
-  greenPtr[12]=tg0Im;
-  greenPtr[13]=&zRel;
+  // Source depth per collocation point
+  unsigned int* const zsIndex=new(nothrow) unsigned int[nTotalColl];
+  if (zsIndex==0) throw("Out of memory.");
+  double* const zsWeight=(InterpZsLinear ? new(nothrow) double[nTotalColl] : 0);
+  if (InterpZsLinear && (zsWeight==0)) throw("Out of memory.");
+  greeninterpsource(InterpZsLinear,zs,nzs,&CollPoints[4*nTotalColl],nTotalColl,zsIndex,zsWeight);
+
+  // Derivative tables for the cubic interpolation methods and lookup plans
+  // of the grids, which make every interpolation O(1). They are freed below
+  // if the integration fails, e.g. if the range of r or z is insufficient.
+  GreenInterp gi=GreenInterp();
+  gi.method=InterpMethod;
+  gi.zsLinear=InterpZsLinear;
+  gi.zsWeight=zsWeight;
+  gi.single=table.single;
+  SearchGrid rGrid=SearchGrid();
+  SearchGrid zGrid=SearchGrid();
+  const void** greenPtr=0;
+  const char* error=0;
+  try
+  {
+    greeninterpinit(InterpMethod,r,nr,z,nz,(size_t)nugComp*nzs,nGrSet,ugRe,(ugCmplx ? ugIm : 0),gi.single,gi.ug);
+    greeninterpinit(InterpMethod,r,nr,z,nz,(size_t)ntgComp*nzs,nGrSet,tgRe,(tgCmplx ? tgIm : 0),gi.single,gi.tg);
+    greeninterpinit(InterpMethod,r,nr,z,nz,(size_t)ntgComp*nzs,nGrSet,tg0Re,(tg0Cmplx ? tg0Im : 0),gi.single,gi.tg0);
+
+    searchgridinit(r,nr-1,rGrid);
+    searchgridinit(z,nz-1,zGrid);
+
+    // Copy variables to generic array of pointers greenPtr
+    const unsigned int nGreenPtr=18;
+    const unsigned int GreenFunType=1;
+    greenPtr=new(nothrow) const void*[nGreenPtr];
+      if (greenPtr==0) throw("Out of memory.");
+    greenPtr[0]=&GreenFunType;
+    greenPtr[1]=&nzs;
+    greenPtr[2]=zs;
+    greenPtr[3]=&nr;
+    greenPtr[4]=r;
+    greenPtr[5]=&nz;
+    greenPtr[6]=z;
+    greenPtr[7]=ugRe;
+    greenPtr[8]=ugIm;
+    greenPtr[9]=tgRe;
+    greenPtr[10]=tgIm;
+    greenPtr[11]=tg0Re;
+    greenPtr[12]=tg0Im;
+    greenPtr[13]=&zRel;
+    greenPtr[14]=zsIndex;
+    greenPtr[15]=&rGrid;
+    greenPtr[16]=&zGrid;
+    greenPtr[17]=&gi;
  
- // mexPrintf("nzs: %d \n",nzs);
- // for (int i=0; i<nzs ; i++)
-	// {
-		// mexPrintf("zs [%i]: %d \n",i,zs[i]);
-	// }
+   // mexPrintf("nzs: %d \n",nzs);
+   // for (int i=0; i<nzs ; i++)
+  	// {
+  		// mexPrintf("zs [%i]: %d \n",i,zs[i]);
+  	// }
  
- // mexPrintf("nz: %d \n",nz);
- // for (int i=0; i<nz ; i++)
-	// {
-		// mexPrintf("z [%i]: %d \n",i,z[i]);
-	// }
+   // mexPrintf("nz: %d \n",nz);
+   // for (int i=0; i<nz ; i++)
+  	// {
+  		// mexPrintf("z [%i]: %d \n",i,z[i]);
+  	// }
  
  
-  // Periodic problems 
-  if (probPeriodic){
-    if (!mxIsNumeric(prhs[greenPos+7])) throw("Input argument 'L' must be numeric.");
-    if (mxIsSparse(prhs[greenPos+7])) throw("Input argument 'L' must not be sparse.");
-    if (mxIsComplex(prhs[greenPos+7])) throw("Input argument 'L' must be real.");
-    if (!(mxGetNumberOfElements(prhs[greenPos+7])==1)) throw("Input argument 'L' must be a scalar.");
+    // Periodic problems 
+    if (probPeriodic){
+      if (!mxIsNumeric(prhs[periodicPos])) throw("Input argument 'L' must be numeric.");
+      if (mxIsSparse(prhs[periodicPos])) throw("Input argument 'L' must not be sparse.");
+      if (mxIsComplex(prhs[periodicPos])) throw("Input argument 'L' must be real.");
+      if (!(mxGetNumberOfElements(prhs[periodicPos])==1)) throw("Input argument 'L' must be a scalar.");
     
-    if (!mxIsNumeric(prhs[greenPos+8])) throw("Input argument 'ky' must be numeric.");
-    if (mxIsSparse(prhs[greenPos+8])) throw("Input argument 'ky' must not be sparse.");
-    if (mxIsComplex(prhs[greenPos+8])) throw("Input argument 'ky' must be real.");
-    if ((mxGetNumberOfDimensions(prhs[greenPos+8])>2) ||
-      ((mxGetM(prhs[greenPos+8])>1) && (mxGetN(prhs[greenPos+8])>1)))
-                  throw("Input argument 'ky' must be a scalar or a vector.");
+      if (!mxIsNumeric(prhs[periodicPos+1])) throw("Input argument 'ky' must be numeric.");
+      if (mxIsSparse(prhs[periodicPos+1])) throw("Input argument 'ky' must not be sparse.");
+      if (mxIsComplex(prhs[periodicPos+1])) throw("Input argument 'ky' must be real.");
+      if ((mxGetNumberOfDimensions(prhs[periodicPos+1])>2) ||
+        ((mxGetM(prhs[periodicPos+1])>1) && (mxGetN(prhs[periodicPos+1])>1)))
+                    throw("Input argument 'ky' must be a scalar or a vector.");
     
-    if (!mxIsNumeric(prhs[greenPos+9])) throw("Input argument 'nmax' must be numeric.");
-    if (mxIsSparse(prhs[greenPos+9])) throw("Input argument 'nmax' must not be sparse.");
-    if (mxIsComplex(prhs[greenPos+9])) throw("Input argument 'nmax' must be real.");
-    if (!(mxGetNumberOfElements(prhs[greenPos+9])==1)) throw("Input argument 'nmax' must be a scalar.");
-  }
+      if (!mxIsNumeric(prhs[periodicPos+2])) throw("Input argument 'nmax' must be numeric.");
+      if (mxIsSparse(prhs[periodicPos+2])) throw("Input argument 'nmax' must not be sparse.");
+      if (mxIsComplex(prhs[periodicPos+2])) throw("Input argument 'nmax' must be real.");
+      if (!(mxGetNumberOfElements(prhs[periodicPos+2])==1)) throw("Input argument 'nmax' must be a scalar.");
+    }
 
-  const double L=(probPeriodic ? mxGetScalar(prhs[greenPos+7]) : -1.0);
-  const double* const ky=(probPeriodic ? mxGetPr(prhs[greenPos+8]) : 0);
-  const unsigned int nWave=(probPeriodic ? mxGetNumberOfElements(prhs[greenPos+8]) : 0);
-  const unsigned int nmax=(probPeriodic ? (unsigned int)mxGetScalar(prhs[greenPos+9]) : 0);
+    const double L=(probPeriodic ? mxGetScalar(prhs[periodicPos]) : -1.0);
+    const double* const ky=(probPeriodic ? mxGetPr(prhs[periodicPos+1]) : 0);
+    const unsigned int nWave=(probPeriodic ? mxGetNumberOfElements(prhs[periodicPos+1]) : 0);
+    const unsigned int nmax=(probPeriodic ? (unsigned int)mxGetScalar(prhs[periodicPos+2]) : 0);
 
   
  
   
-  // OUTPUT ARGUMENT POINTERS
-  //  unsigned int nDof=nColDof*nTotalColl;
-  uint64 nDof=nColDof*nTotalColl;
-  const unsigned int nMatDim=(probPeriodic ? 3+nGreenDim : 2+nGreenDim);
-  // size_t* const MatDim = new(nothrow) size_t[nMatDim];
-  // if (MatDim==0) throw("Out of memory.");
+    // OUTPUT ARGUMENT POINTERS
+    //  unsigned int nDof=nColDof*nTotalColl;
+    uint64 nDof=nColDof*nTotalColl;
+    const unsigned int nMatDim=(probPeriodic ? 3+nGreenDim : 2+nGreenDim);
+    // size_t* const MatDim = new(nothrow) size_t[nMatDim];
+    // if (MatDim==0) throw("Out of memory.");
   
-  size_t* const MatDimU = new(nothrow) size_t[nMatDim];
-  if (MatDimU==0) throw("Out of memory.");
-  MatDimU[0]=(s==0 ? nDof : ms);
-  MatDimU[1]=(s==0 ? nDof : ns);
-  if (UmatOut==false){MatDimU[0]=0; MatDimU[1]=0;}
+    size_t* const MatDimU = new(nothrow) size_t[nMatDim];
+    if (MatDimU==0) throw("Out of memory.");
+    MatDimU[0]=(s==0 ? nDof : ms);
+    MatDimU[1]=(s==0 ? nDof : ns);
+    if (UmatOut==false){MatDimU[0]=0; MatDimU[1]=0;}
   
-  for (unsigned int iDim=0; iDim<nGreenDim; iDim++)  MatDimU[2+iDim]=greenDim[iDim];
-  if (probPeriodic) MatDimU[nMatDim-1]=nWave;
+    for (unsigned int iDim=0; iDim<nGreenDim; iDim++)  MatDimU[2+iDim]=greenDim[iDim];
+    if (probPeriodic) MatDimU[nMatDim-1]=nWave;
   
-  bool uCmplx=false;
-  if (ugCmplx || probPeriodic){uCmplx=true;}
+    bool uCmplx=false;
+    if (ugCmplx || probPeriodic){uCmplx=true;}
   
-  // plhs[0]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,mxCOMPLEX);
-  plhs[0]=mxCreateNumericArray(nMatDim,MatDimU,mxDOUBLE_CLASS,(uCmplx ? mxCOMPLEX : mxREAL)); 
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+    // plhs[0]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,mxCOMPLEX);
+    double* URe=0;
+    double* UIm=0;
+    createMatOutput(plhs,0,nMatDim,MatDimU,uCmplx,URe,UIm);
 
-//   mexPrintf("MatDimU[0]: %d\n",MatDimU[0]);
-//   mexPrintf("MatDimU[1]: %d\n",MatDimU[1]);
+  //   mexPrintf("MatDimU[0]: %d\n",MatDimU[0]);
+  //   mexPrintf("MatDimU[1]: %d\n",MatDimU[1]);
   
-  bool tCmplx=false;
-  if (tgCmplx || probPeriodic){tCmplx=true;}
+    bool tCmplx=false;
+    if (tgCmplx || probPeriodic){tCmplx=true;}
    
-  double* TRe=0;
-  double* TIm=0;
-  if (TmatOut)
-  {
-	size_t* const MatDimT = new(nothrow) size_t[nMatDim];
-	if (MatDimT==0) throw("Out of memory.");
-	MatDimT[0]=(s==0 ? nDof : ms);
-	MatDimT[1]=(s==0 ? nDof : ns);
+    double* TRe=0;
+    double* TIm=0;
+    if (TmatOut)
+    {
+  	size_t* const MatDimT = new(nothrow) size_t[nMatDim];
+  	if (MatDimT==0) throw("Out of memory.");
+  	MatDimT[0]=(s==0 ? nDof : ms);
+  	MatDimT[1]=(s==0 ? nDof : ns);
   
-    for (unsigned int iDim=0; iDim<nGreenDim; iDim++)  MatDimT[2+iDim]=greenDim[iDim];
-	if (probPeriodic) MatDimT[nMatDim-1]=nWave;
+      for (unsigned int iDim=0; iDim<nGreenDim; iDim++)  MatDimT[2+iDim]=greenDim[iDim];
+  	if (probPeriodic) MatDimT[nMatDim-1]=nWave;
 	
-    plhs[1]=mxCreateNumericArray(nMatDim,MatDimT,mxDOUBLE_CLASS,(tCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+      createMatOutput(plhs,1,nMatDim,MatDimT,tCmplx,TRe,TIm);
 	
-	delete [] MatDimT;
-  }
-  delete [] MatDimU;
+  	delete [] MatDimT;
+    }
+    delete [] MatDimU;
    
-  // BEMMAT
-  bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
-         TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
-         greenPtr,nGrSet,nugComp,
-         ugCmplx,tgCmplx,tg0Cmplx,URe,UIm,TRe,TIm,s,ms,ns,L,ky,nWave,nmax,
-		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
-		 ncumulEltCollIndex,eltCollIndex,
-		 ncumulSingularColl,nSingularColl,NSingularColl, 
-		 RegularColl,
-		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+    // BEMMAT
+    bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
+           TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
+           greenPtr,nGrSet,nugComp,
+           ugCmplx,tgCmplx,tg0Cmplx,URe,UIm,TRe,TIm,s,ms,ns,L,ky,nWave,nmax,
+  		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
+  		 ncumulEltCollIndex,eltCollIndex,
+  		 ncumulSingularColl,nSingularColl,NSingularColl, 
+  		 RegularColl,
+  		 ncumulEltNod,EltNod,
+  		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
+  }
+  catch (const char* exception)
+  {
+    error=exception;
+  }
 
+  delete [] zsIndex;
+  if (zsWeight!=0) delete [] zsWeight;
+  greeninterpclear(gi.ug);
+  greeninterpclear(gi.tg);
+  greeninterpclear(gi.tg0);
+  searchgridclear(rGrid);
+  searchgridclear(zGrid);
+  greenFileClose(table);
   delete [] greenPtr;
   delete [] greenDim;
+  if (error!=0) throw(error);
 }
 
 //==============================================================================
@@ -599,7 +930,6 @@ void IntegrateFsGreenf(mxArray* plhs[], int nrhs, const mxArray* prhs[],
   const double* const omega = mxGetPr(prhs[greenPos+7]);
   const unsigned int nFreq = mxGetNumberOfElements(prhs[greenPos+7]);
 
-  const unsigned int nGrSet=nFreq*nWave;
   const bool ugCmplx=true;
   const bool tgCmplx=true;
   const bool tg0Cmplx=true;
@@ -637,18 +967,17 @@ void IntegrateFsGreenf(mxArray* plhs[], int nrhs, const mxArray* prhs[],
   MatDim[1]=(s==0 ? nDof : ns);
     
   for (unsigned int iDim=2; iDim<nMatDim; iDim++)  MatDim[iDim]=greenDim[iDim-2];
-  plhs[0]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(ugCmplx ? mxCOMPLEX : mxREAL));
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+  double* URe=0;
+  double* UIm=0;
+  createMatOutput(plhs,0,2+nGreenDim,MatDim,ugCmplx,URe,UIm);
 
   double* TRe=0;
   double* TIm=0;
   if (TmatOut)
   {
-    plhs[1]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(tgCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    createMatOutput(plhs,1,2+nGreenDim,MatDim,tgCmplx,TRe,TIm);
   }
+  const uint64 nMat=(uint64)MatDim[0]*MatDim[1];
   delete [] MatDim;
 
   // BEMMAT
@@ -656,16 +985,22 @@ void IntegrateFsGreenf(mxArray* plhs[], int nrhs, const mxArray* prhs[],
   const double* const ky=0;
   const unsigned int nky=0;
   const unsigned int nmax=0;
-  bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
-         TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
-         greenPtr,nGrSet,nugComp,
-         ugCmplx,tgCmplx,tg0Cmplx,URe,UIm,TRe,TIm,s,ms,ns,L,ky,nky,nmax,
-		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
-		 ncumulEltCollIndex,eltCollIndex,
-		 ncumulSingularColl,nSingularColl,NSingularColl, 
-		 RegularColl,
-		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+  sweepFreq(true,nFreq,nWave,nMat,nMat,greenPtr,nGreenPtr,7,9,URe,UIm,TRe,TIm,
+            [&](const void* const* const chunkPtr, const unsigned int& nChunkSet,
+                double* const chunkURe, double* const chunkUIm,
+                double* const chunkTRe, double* const chunkTIm)
+  {
+    bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
+           TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
+           chunkPtr,nChunkSet,nugComp,
+           ugCmplx,tgCmplx,tg0Cmplx,chunkURe,chunkUIm,chunkTRe,chunkTIm,s,ms,ns,L,ky,nky,nmax,
+  		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
+  		 ncumulEltCollIndex,eltCollIndex,
+  		 ncumulSingularColl,nSingularColl,NSingularColl, 
+  		 RegularColl,
+  		 ncumulEltNod,EltNod,
+  		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
+  });
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -783,7 +1118,6 @@ void IntegrateFsGreen3d(mxArray* plhs[], int nrhs, const mxArray* prhs[],
   const unsigned int nWave=(probPeriodic ? mxGetNumberOfElements(prhs[greenPos+8]) : 0);
   const unsigned int nmax=(probPeriodic ? (unsigned int)mxGetScalar(prhs[greenPos+9]) : 0);
 
-  const unsigned int nGrSet=nFreq;
   const bool ugCmplx=true;
   const bool tgCmplx=true;
   const bool tg0Cmplx=false;
@@ -823,9 +1157,9 @@ void IntegrateFsGreen3d(mxArray* plhs[], int nrhs, const mxArray* prhs[],
   bool uCmplx=false;
   if (ugCmplx || probPeriodic){uCmplx=true;}
   
-  plhs[0]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,(uCmplx ? mxCOMPLEX : mxREAL));
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+  double* URe=0;
+  double* UIm=0;
+  createMatOutput(plhs,0,nMatDim,MatDim,uCmplx,URe,UIm);
 
   bool tCmplx=false;
   if (tgCmplx || probPeriodic){tCmplx=true;}
@@ -834,23 +1168,28 @@ void IntegrateFsGreen3d(mxArray* plhs[], int nrhs, const mxArray* prhs[],
   double* TIm=0;
   if (TmatOut)
   {
-    plhs[1]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,(tCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    createMatOutput(plhs,1,nMatDim,MatDim,tCmplx,TRe,TIm);
   }
+  const uint64 nMat=(uint64)MatDim[0]*MatDim[1];
   delete [] MatDim;
 
   // BEMMAT
-  bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
-         TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
-         greenPtr,nGrSet,nugComp,
-         ugCmplx,tgCmplx,tg0Cmplx,URe,UIm,TRe,TIm,s,ms,ns,L,ky,nWave,nmax,
-		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
-		 ncumulEltCollIndex,eltCollIndex,
-		 ncumulSingularColl,nSingularColl,NSingularColl, 
-		 RegularColl,
-		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+  sweepFreq(!probPeriodic,nFreq,1,nMat,nMat,greenPtr,nGreenPtr,6,7,URe,UIm,TRe,TIm,
+            [&](const void* const* const chunkPtr, const unsigned int& nChunkSet,
+                double* const chunkURe, double* const chunkUIm,
+                double* const chunkTRe, double* const chunkTIm)
+  {
+    bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
+           TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
+           chunkPtr,nChunkSet,nugComp,
+           ugCmplx,tgCmplx,tg0Cmplx,chunkURe,chunkUIm,chunkTRe,chunkTIm,s,ms,ns,L,ky,nWave,nmax,
+  		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
+  		 ncumulEltCollIndex,eltCollIndex,
+  		 ncumulSingularColl,nSingularColl,NSingularColl, 
+  		 RegularColl,
+  		 ncumulEltNod,EltNod,
+  		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
+  });
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -996,9 +1335,9 @@ void IntegrateFsGreen3d0(mxArray* plhs[], int nrhs, const mxArray* prhs[],
   if (ugCmplx || probPeriodic){uCmplx=true;}
   
     
-  plhs[0]=mxCreateNumericArray(nMatDim,MatDimU,mxDOUBLE_CLASS,(uCmplx ? mxCOMPLEX : mxREAL));
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+  double* URe=0;
+  double* UIm=0;
+  createMatOutput(plhs,0,nMatDim,MatDimU,uCmplx,URe,UIm);
   
   // double* URe=0;
   // double* UIm=0;
@@ -1020,9 +1359,7 @@ void IntegrateFsGreen3d0(mxArray* plhs[], int nrhs, const mxArray* prhs[],
     for (unsigned int iDim=0; iDim<nGreenDim; iDim++)  MatDimT[2+iDim]=greenDim[iDim];
 	if (probPeriodic) MatDimT[nMatDim-1]=nWave;
 	
-    plhs[1]=mxCreateNumericArray(nMatDim,MatDimT,mxDOUBLE_CLASS,(tCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    createMatOutput(plhs,1,nMatDim,MatDimT,tCmplx,TRe,TIm);
 	
 	delete [] MatDimT;
   }
@@ -1039,7 +1376,7 @@ void IntegrateFsGreen3d0(mxArray* plhs[], int nrhs, const mxArray* prhs[],
 		 ncumulSingularColl,nSingularColl,NSingularColl, 
 		 RegularColl,
 		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
   delete [] greenPtr;
   delete [] greenDim;
   delete [] omega;
@@ -1149,17 +1486,15 @@ void IntegrateFsGreen3dt(mxArray* plhs[], int nrhs, const mxArray* prhs[],
   MatDim[1]=(s==0 ? nDof : ns);
   
   for (unsigned int iDim=2; iDim<nMatDim; iDim++)  MatDim[iDim]=greenDim[iDim-2];
-  plhs[0]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(ugCmplx ? mxCOMPLEX : mxREAL));
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+  double* URe=0;
+  double* UIm=0;
+  createMatOutput(plhs,0,2+nGreenDim,MatDim,ugCmplx,URe,UIm);
 
   double* TRe=0;
   double* TIm=0;
   if (TmatOut)
   {
-    plhs[1]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(tgCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    createMatOutput(plhs,1,2+nGreenDim,MatDim,tgCmplx,TRe,TIm);
   }
   delete [] MatDim;
 
@@ -1176,7 +1511,7 @@ void IntegrateFsGreen3dt(mxArray* plhs[], int nrhs, const mxArray* prhs[],
 		 ncumulSingularColl,nSingularColl,NSingularColl, 
 		 RegularColl,
 		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -1265,7 +1600,6 @@ void IntegrateFsGreen2d_inplane(mxArray* plhs[], int nrhs, const mxArray* prhs[]
   const double* const omega=mxGetPr(prhs[greenPos+6]);
   const unsigned int nFreq=mxGetNumberOfElements(prhs[greenPos+6]);
 
-  const unsigned int nGrSet=nFreq;
   const bool ugCmplx=true;
   const bool tgCmplx=true;
   const bool tg0Cmplx=true;
@@ -1300,18 +1634,17 @@ void IntegrateFsGreen2d_inplane(mxArray* plhs[], int nrhs, const mxArray* prhs[]
   MatDim[1]=(s==0 ? nDof : ns);
   
   for (unsigned int iDim=2; iDim<nMatDim; iDim++)  MatDim[iDim]=greenDim[iDim-2];
-  plhs[0]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(ugCmplx ? mxCOMPLEX : mxREAL));
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+  double* URe=0;
+  double* UIm=0;
+  createMatOutput(plhs,0,2+nGreenDim,MatDim,ugCmplx,URe,UIm);
 
   double* TRe=0;
   double* TIm=0;
   if (TmatOut)
   {
-    plhs[1]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(tgCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    createMatOutput(plhs,1,2+nGreenDim,MatDim,tgCmplx,TRe,TIm);
   }
+  const uint64 nMat=(uint64)MatDim[0]*MatDim[1];
   delete [] MatDim;
 
   // BEMMAT
@@ -1319,16 +1652,22 @@ void IntegrateFsGreen2d_inplane(mxArray* plhs[], int nrhs, const mxArray* prhs[]
   const double* const ky=0;
   const unsigned int nWave=0;
   const unsigned int nmax=0;
-  bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
-         TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
-         greenPtr,nGrSet,nugComp,
-         ugCmplx,tgCmplx,tg0Cmplx,URe,UIm,TRe,TIm,s,ms,ns,L,ky,nWave,nmax,
-		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
-		 ncumulEltCollIndex,eltCollIndex,
-		 ncumulSingularColl,nSingularColl,NSingularColl, 
-		 RegularColl,
-		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+  sweepFreq(!probPeriodic,nFreq,1,nMat,nMat,greenPtr,nGreenPtr,6,7,URe,UIm,TRe,TIm,
+            [&](const void* const* const chunkPtr, const unsigned int& nChunkSet,
+                double* const chunkURe, double* const chunkUIm,
+                double* const chunkTRe, double* const chunkTIm)
+  {
+    bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
+           TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
+           chunkPtr,nChunkSet,nugComp,
+           ugCmplx,tgCmplx,tg0Cmplx,chunkURe,chunkUIm,chunkTRe,chunkTIm,s,ms,ns,L,ky,nWave,nmax,
+  		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
+  		 ncumulEltCollIndex,eltCollIndex,
+  		 ncumulSingularColl,nSingularColl,NSingularColl, 
+  		 RegularColl,
+  		 ncumulEltNod,EltNod,
+  		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
+  });
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -1436,17 +1775,15 @@ void IntegrateFsGreen2d_inplane0(mxArray* plhs[], int nrhs, const mxArray* prhs[
   MatDim[0]=(s==0 ? nDof : ms);
   MatDim[1]=(s==0 ? nDof : ns);
   for (unsigned int iDim=2; iDim<nMatDim; iDim++)  MatDim[iDim]=greenDim[iDim-2];
-  plhs[0]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(ugCmplx ? mxCOMPLEX : mxREAL));
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+  double* URe=0;
+  double* UIm=0;
+  createMatOutput(plhs,0,2+nGreenDim,MatDim,ugCmplx,URe,UIm);
 
   double* TRe=0;
   double* TIm=0;
   if (TmatOut)
   {
-    plhs[1]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(tgCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    createMatOutput(plhs,1,2+nGreenDim,MatDim,tgCmplx,TRe,TIm);
   }
   delete [] MatDim;
 
@@ -1464,7 +1801,7 @@ void IntegrateFsGreen2d_inplane0(mxArray* plhs[], int nrhs, const mxArray* prhs[
 		 ncumulSingularColl,nSingularColl,NSingularColl, 
 		 RegularColl,
 		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
   delete [] greenPtr;
   delete [] greenDim;
   delete [] omega;
@@ -1542,7 +1879,6 @@ void IntegrateFsGreen2d_outofplane(mxArray* plhs[], int nrhs, const mxArray* prh
   const double* const omega = mxGetPr(prhs[greenPos+4]);
   const unsigned int nFreq = mxGetNumberOfElements(prhs[greenPos+4]);
 
-  const unsigned int nGrSet=nFreq;
   const bool ugCmplx=true;
   const bool tgCmplx=true;
   const bool tg0Cmplx=true;
@@ -1574,18 +1910,17 @@ void IntegrateFsGreen2d_outofplane(mxArray* plhs[], int nrhs, const mxArray* prh
   MatDim[0]=(s==0 ? nDof : ms);
   MatDim[1]=(s==0 ? nDof : ns);
   for (unsigned int iDim=2; iDim<nMatDim; iDim++)  MatDim[iDim]=greenDim[iDim-2];
-  plhs[0]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(ugCmplx ? mxCOMPLEX : mxREAL));
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+  double* URe=0;
+  double* UIm=0;
+  createMatOutput(plhs,0,2+nGreenDim,MatDim,ugCmplx,URe,UIm);
 
   double* TRe=0;
   double* TIm=0;
   if (TmatOut)
   {
-    plhs[1]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(tgCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    createMatOutput(plhs,1,2+nGreenDim,MatDim,tgCmplx,TRe,TIm);
   }
+  const uint64 nMat=(uint64)MatDim[0]*MatDim[1];
   delete [] MatDim;
 
   // BEMMAT
@@ -1593,16 +1928,22 @@ void IntegrateFsGreen2d_outofplane(mxArray* plhs[], int nrhs, const mxArray* prh
   const double* const ky=0;
   const unsigned int nWave=0;
   const unsigned int nmax=0;
-  bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
-         TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
-         greenPtr,nGrSet,nugComp,
-         ugCmplx,tgCmplx,tg0Cmplx,URe,UIm,TRe,TIm,s,ms,ns,L,ky,nWave,nmax,
-		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
-		 ncumulEltCollIndex,eltCollIndex,
-		 ncumulSingularColl,nSingularColl,NSingularColl, 
-		 RegularColl,
-		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+  sweepFreq(!probPeriodic,nFreq,1,nMat,nMat,greenPtr,nGreenPtr,4,5,URe,UIm,TRe,TIm,
+            [&](const void* const* const chunkPtr, const unsigned int& nChunkSet,
+                double* const chunkURe, double* const chunkUIm,
+                double* const chunkTRe, double* const chunkTIm)
+  {
+    bemmat(probAxi,probPeriodic,probDim,nColDof,UmatOut,TmatOut,Nod,nNod,Elt,nElt,TypeID,
+           TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,nTotalColl,
+           chunkPtr,nChunkSet,nugComp,
+           ugCmplx,tgCmplx,tg0Cmplx,chunkURe,chunkUIm,chunkTRe,chunkTIm,s,ms,ns,L,ky,nWave,nmax,
+  		 EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing,
+  		 ncumulEltCollIndex,eltCollIndex,
+  		 ncumulSingularColl,nSingularColl,NSingularColl, 
+  		 RegularColl,
+  		 ncumulEltNod,EltNod,
+  		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
+  });
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -1697,17 +2038,15 @@ void IntegrateFsGreen2d_outofplane0(mxArray* plhs[], int nrhs, const mxArray* pr
   MatDim[0]=(s==0 ? nDof : ms);
   MatDim[1]=(s==0 ? nDof : ns);
   for (unsigned int iDim=2; iDim<nMatDim; iDim++)  MatDim[iDim]=greenDim[iDim-2];
-  plhs[0]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(ugCmplx ? mxCOMPLEX : mxREAL));
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
+  double* URe=0;
+  double* UIm=0;
+  createMatOutput(plhs,0,2+nGreenDim,MatDim,ugCmplx,URe,UIm);
 
   double* TRe=0;
   double* TIm=0;
   if (TmatOut)
   {
-    plhs[1]=mxCreateNumericArray(2+nGreenDim,MatDim,mxDOUBLE_CLASS,(tgCmplx ? mxCOMPLEX : mxREAL));
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    createMatOutput(plhs,1,2+nGreenDim,MatDim,tgCmplx,TRe,TIm);
   }
   delete [] MatDim;
 
@@ -1725,7 +2064,7 @@ void IntegrateFsGreen2d_outofplane0(mxArray* plhs[], int nrhs, const mxArray* pr
 		 ncumulSingularColl,nSingularColl,NSingularColl, 
 		 RegularColl,
 		 ncumulEltNod,EltNod,
-		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape);
+		 RefEltType,ncumulnXi,nXi,xi,H,ncumulNshape,Nshape,Mshape,dNshape,MemoOptions);
   delete [] greenPtr;
   delete [] greenDim;
   delete [] omega;
@@ -1739,6 +2078,7 @@ void cleanup()
 	// mexPrintf("cleanup start.. \n");
 	
 	CacheValid=false;
+	closeMatOutput();
 
 	
 	// mexPrintf("Nod_pointer: %d \n",Nod); // DEBUG
@@ -1880,6 +2220,101 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
   {
     //checklicense();
 
+    // OPTIONS: BEMMAT('file',ufile,tfile,...), BEMMAT('sweep',nThread,...),
+    // BEMMAT('interp',method,...), BEMMAT('interpzs',method,...) AND
+    // BEMMAT('memo',tol,...)
+    bool FileOut=false;
+    SweepThread=1;
+    SweepChunk=0;
+    InterpMethod=0;
+    InterpZsLinear=false;
+    MemoOptions.tol=0.0;
+    MemoOptions.maxEntry=0;
+    MemoOptions.nHit=0;
+    MemoOptions.nMiss=0;
+    MemoOptions.nEntry=0;
+    while ((nrhs>0) && mxIsChar(prhs[0]))
+    {
+      char* const opt=mxArrayToString(prhs[0]);
+      const bool optFile=(strcasecmp(opt,"file")==0);
+      const bool optSweep=(strcasecmp(opt,"sweep")==0);
+      const bool optInterp=(strcasecmp(opt,"interp")==0);
+      const bool optInterpZs=(strcasecmp(opt,"interpzs")==0);
+      const bool optMemo=(strcasecmp(opt,"memo")==0);
+      mxFree(opt);
+      if (optFile)
+      {
+        if (FileOut) throw("Option 'file' is specified more than once.");
+        if (nrhs<4) throw("Not enough input arguments.");
+        if (nlhs>0) throw("Too many output arguments.");
+        if (!mxIsChar(prhs[1]) || mxIsEmpty(prhs[1])) throw("Input argument 'ufile' must be a string.");
+        if (!(mxIsChar(prhs[2]) || mxIsEmpty(prhs[2]))) throw("Input argument 'tfile' must be a string.");
+        FileOut=true;
+        OutFile[0]=mxArrayToString(prhs[1]);
+        if (!mxIsEmpty(prhs[2])) OutFile[1]=mxArrayToString(prhs[2]);
+        prhs+=3;
+        nrhs-=3;
+      }
+      else if (optSweep)
+      {
+        if (nrhs<3) throw("Not enough input arguments.");
+        if (!mxIsNumeric(prhs[1])) throw("Input argument 'nThread' must be numeric.");
+        if (mxIsSparse(prhs[1])) throw("Input argument 'nThread' must not be sparse.");
+        if (mxIsComplex(prhs[1])) throw("Input argument 'nThread' must be real.");
+        const unsigned int nSweep=mxGetNumberOfElements(prhs[1]);
+        if ((nSweep<1) || (nSweep>2)) throw("Input argument 'nThread' must have one or two elements.");
+        const double* const sweep=mxGetPr(prhs[1]);
+        if (!(sweep[0]>=1.0) || !(sweep[0]==floor(sweep[0]))) throw("The number of threads must be a positive integer.");
+        if ((nSweep==2) && (!(sweep[1]>=1.0) || !(sweep[1]==floor(sweep[1]))))
+          throw("The number of frequencies per chunk must be a positive integer.");
+        SweepThread=(unsigned int)sweep[0];
+        SweepChunk=(nSweep==2 ? (unsigned int)sweep[1] : 0);
+        prhs+=2;
+        nrhs-=2;
+      }
+      else if (optInterp || optInterpZs)
+      {
+        if (nrhs<3) throw("Not enough input arguments.");
+        if (!mxIsChar(prhs[1])) throw("Input argument 'method' must be a string.");
+        char* const method=mxArrayToString(prhs[1]);
+        const bool linear=(strcasecmp(method,"linear")==0);
+        const bool spline=(strcasecmp(method,"spline")==0);
+        const bool pchip=(strcasecmp(method,"pchip")==0);
+        const bool nearest=(strcasecmp(method,"nearest")==0);
+        mxFree(method);
+        if (optInterp)
+        {
+          if (!(linear || spline || pchip)) throw("Interpolation method must be 'linear', 'spline' or 'pchip'.");
+          InterpMethod=(spline ? 1 : (pchip ? 2 : 0));
+        }
+        else
+        {
+          if (!(linear || nearest)) throw("Interpolation method for zs must be 'nearest' or 'linear'.");
+          InterpZsLinear=linear;
+        }
+        prhs+=2;
+        nrhs-=2;
+      }
+      else if (optMemo)
+      {
+        if (nrhs<3) throw("Not enough input arguments.");
+        if (!mxIsNumeric(prhs[1])) throw("Input argument 'tol' must be numeric.");
+        if (mxIsSparse(prhs[1])) throw("Input argument 'tol' must not be sparse.");
+        if (mxIsComplex(prhs[1])) throw("Input argument 'tol' must be real.");
+        const unsigned int nMemo=mxGetNumberOfElements(prhs[1]);
+        if ((nMemo<1) || (nMemo>2)) throw("Input argument 'tol' must have one or two elements.");
+        const double* const memo=mxGetPr(prhs[1]);
+        if (!(memo[0]>0.0) || !(memo[0]<HUGE_VAL)) throw("The tolerance of the memo cache must be positive.");
+        if ((nMemo==2) && (!(memo[1]>=1.0) || !(memo[1]==floor(memo[1]))))
+          throw("The number of entries of the memo cache must be a positive integer.");
+        MemoOptions.tol=memo[0];
+        MemoOptions.maxEntry=(nMemo==2 ? (size_t)memo[1] : 0);
+        prhs+=2;
+        nrhs-=2;
+      }
+      else break;
+    }
+
     // INPUT ARGUMENT PROCESSING
     // if (nrhs<4) throw("Not enough input arguments.");
 	if (nrhs<3) throw("Not enough input arguments.");
@@ -1889,7 +2324,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 	
 
 
-	const bool TmatOut=(nlhs>1);
+	const bool TmatOut=(FileOut ? (OutFile[1]!=0) : (nlhs>1));
 	
 	bool Cache=false;
 	if (nrhs==3 && !mxIsChar(prhs[0])){Cache=true;}
@@ -2255,7 +2690,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
    // }
                   
     // CHECK FOR COINCIDENT NODES
-    double* const CoincNodes=new(nothrow) double[2*nNod];
+    double* const CoincNodes=new(nothrow) double[3*nNod];
     if (CoincNodes==0) throw("Out of memory.");
     bool SlavesExist;
     BemCoincNodes(Nod,nNod,CoincNodes,SlavesExist);
@@ -2324,8 +2759,8 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
                                   
 		// CHECK FOR COINCIDENT NODES
 		delete [] CoincNodes;
-		CoincNodes=new(nothrow) double[2*nNod];
-		// mexPrintf("2*nNod: %d \n",2*nNod); // DEBUG
+		CoincNodes=new(nothrow) double[3*nNod];
+		// mexPrintf("3*nNod: %d \n",3*nNod); // DEBUG
 		if (CoincNodes==0) throw("Out of memory.");
 		
 		BemCoincNodes(Nod,nNod,CoincNodes,SlavesExist);
@@ -3100,6 +3535,15 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 	
 	// */
 	}
+	closeMatOutput();
+	if (MemoOptions.tol>0.0)
+	{
+	  const unsigned long long nHit=MemoOptions.nHit;
+	  const unsigned long long nMiss=MemoOptions.nMiss;
+	  const unsigned long long nEntry=MemoOptions.nEntry;
+	  mexPrintf("Green's function memo: %llu hits, %llu misses, %llu entries (%.1f%% hits).\n",
+	            nHit,nMiss,nEntry,(nHit+nMiss>0 ? 100.0*nHit/(nHit+nMiss) : 0.0));
+	}
 
 	
 	if (Cache==false && getCache==false)
@@ -3197,6 +3641,10 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
   }
   catch (const char* exception)
   {
+    // The caches of the Green's function are released by the integration.
+    closeMatOutput();
+    MemoOptions.tol=0.0;
+    MemoOptions.maxEntry=0;
     mexErrMsgTxt(exception);
   }
   
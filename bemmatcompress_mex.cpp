@@ -0,0 +1,186 @@
+/*BEMMATCOMPRESS   Causal compression of time domain boundary element matrices.
+ *
+ *   C = BEMMATCOMPRESS(A,bs,tol) compresses the time domain boundary element
+ *   matrices A, as computed by BEMMAT with the Green's function 'fsgreen3dt'.
+ *   The matrices are subdivided in blocks of (bs * bs) entries, corresponding
+ *   to a pair of collocation points. Due to causality, a block is zero until
+ *   the arrival of the dilatational wave, while it is static after the
+ *   passage of the shear wave. For every block, only the active time window
+ *   is stored, together with the static value at the end of the window:
+ *
+ *   A(I,J,n) = 0                 for n < nBeg(I,J)
+ *   A(I,J,n) = window values     for nBeg(I,J) <= n <= nEnd(I,J)
+ *   A(I,J,n) = stat(I,J)         for n > nEnd(I,J)
+ *
+ *   The compressed matrices are used by BEMMATCONV('init',C).
+ *
+ *   A      Influence matrices (nRow * nDof * nTime).
+ *   bs     Block size (1 * 1), equal to the number of degrees of freedom per
+ *          collocation point. Default: 3.
+ *   tol    Relative tolerance (1 * 1). Entries that differ less than
+ *          tol*max(abs(A(:))) from zero or from the static value are
+ *          considered equal. Default: 1e-10.
+ *   C      Compressed matrices, structure with fields:
+ *          size  Size of A [nRow nDof nTime].
+ *          bs    Block size.
+ *          nBeg  First time step of the window (nRow/bs * nDof/bs).
+ *          nEnd  Last time step of the window (nRow/bs * nDof/bs).
+ *          val   Window values. For every block (column major order), the
+ *                (bs * bs) matrices for time steps nBeg to nEnd.
+ *          stat  Static values (bs * bs * nRow/bs * nDof/bs).
+ */
+
+/* $Make: mex -O -output bemmatcompress bemmatcompress_mex.cpp$*/
+
+#include "mex.h"
+#include <math.h>
+#include <new>
+#include "checklicense.h"
+
+using namespace std;
+
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+  try
+  {
+    checklicense();
+
+    if (nrhs<1) throw("Not enough input arguments.");
+    if (nrhs>3) throw("Too many input arguments.");
+    if (nlhs>1) throw("Too many output arguments.");
+
+    if (!mxIsNumeric(prhs[0])) throw("Input argument 'A' must be numeric.");
+    if (mxIsSparse(prhs[0])) throw("Input argument 'A' must not be sparse.");
+    if (mxIsComplex(prhs[0])) throw("Input argument 'A' must be real.");
+    const size_t nDimA=mxGetNumberOfDimensions(prhs[0]);
+    const size_t* const dimA=mxGetDimensions(prhs[0]);
+    if (nDimA>3) throw("Input argument 'A' must have 3 dimensions at most.");
+    const unsigned int nRow=dimA[0];
+    const unsigned int nDof=dimA[1];
+    const unsigned int nTime=(nDimA==3 ? dimA[2] : 1);
+    const double* const A=mxGetPr(prhs[0]);
+
+    unsigned int bs=3;
+    if (nrhs>1)
+    {
+      if (!mxIsNumeric(prhs[1])) throw("Input argument 'bs' must be numeric.");
+      if (mxIsComplex(prhs[1])) throw("Input argument 'bs' must be real.");
+      if (!(mxGetNumberOfElements(prhs[1])==1)) throw("Input argument 'bs' must be a scalar.");
+      if (!(mxGetScalar(prhs[1])>=1)) throw("Input argument 'bs' must be strictly positive.");
+      bs=(unsigned int)mxGetScalar(prhs[1]);
+    }
+    if (!((nRow%bs==0) && (nDof%bs==0))) throw("The dimensions of input argument 'A' must be a multiple of 'bs'.");
+
+    double tol=1e-10;
+    if (nrhs>2)
+    {
+      if (!mxIsNumeric(prhs[2])) throw("Input argument 'tol' must be numeric.");
+      if (mxIsComplex(prhs[2])) throw("Input argument 'tol' must be real.");
+      if (!(mxGetNumberOfElements(prhs[2])==1)) throw("Input argument 'tol' must be a scalar.");
+      tol=fabs(mxGetScalar(prhs[2]));
+    }
+
+    const unsigned int nBlkRow=nRow/bs;
+    const unsigned int nBlkCol=nDof/bs;
+    const size_t nBlk=(size_t)nBlkRow*nBlkCol;
+    const size_t nSlice=(size_t)nRow*nDof;
+
+    // TOLERANCE
+    double refval=0.0;
+    for (size_t i=0; i<nSlice*nTime; i++) if (fabs(A[i])>refval) refval=fabs(A[i]);
+    const double minval=tol*refval;
+
+    // ACTIVE TIME WINDOW PER BLOCK
+    unsigned int* const nBeg=new(nothrow) unsigned int[nBlk];
+    if (nBeg==0) throw("Out of memory.");
+    unsigned int* const nEnd=new(nothrow) unsigned int[nBlk];
+    if (nEnd==0) throw("Out of memory.");
+    size_t nVal=0;
+    for (unsigned int jBlk=0; jBlk<nBlkCol; jBlk++)
+    {
+      for (unsigned int iBlk=0; iBlk<nBlkRow; iBlk++)
+      {
+        const size_t iBlock=iBlk+(size_t)nBlkRow*jBlk;
+        const double* const Ablk=A+bs*iBlk+(size_t)nRow*bs*jBlk;
+        const double* const Astat=Ablk+nSlice*(nTime-1);
+
+        // Arrival: first time step with a non-zero entry
+        unsigned int iBeg=nTime;
+        for (unsigned int iTime=0; (iTime<nTime) && (iBeg==nTime); iTime++)
+        {
+          for (unsigned int jDof=0; jDof<bs; jDof++)
+            for (unsigned int iDof=0; iDof<bs; iDof++)
+              if (fabs(Ablk[iDof+(size_t)nRow*jDof+nSlice*iTime])>minval) iBeg=iTime;
+        }
+
+        // Passage: last time step that differs from the static value
+        unsigned int iEnd=iBeg;
+        for (unsigned int iTime=nTime; (iTime>iBeg) && (iEnd==iBeg); iTime--)
+        {
+          for (unsigned int jDof=0; jDof<bs; jDof++)
+            for (unsigned int iDof=0; iDof<bs; iDof++)
+            {
+              const size_t ind=iDof+(size_t)nRow*jDof;
+              if (fabs(Ablk[ind+nSlice*(iTime-1)]-Astat[ind])>minval) iEnd=iTime;
+            }
+        }
+        nBeg[iBlock]=iBeg;
+        nEnd[iBlock]=iEnd;
+        nVal+=(size_t)bs*bs*(iEnd-iBeg);
+      }
+    }
+
+    // OUTPUT ARGUMENT
+    const char* fieldNames[]={"size","bs","nBeg","nEnd","val","stat"};
+    plhs[0]=mxCreateStructMatrix(1,1,6,fieldNames);
+
+    mxArray* const sizeArr=mxCreateDoubleMatrix(1,3,mxREAL);
+    mxGetPr(sizeArr)[0]=nRow;
+    mxGetPr(sizeArr)[1]=nDof;
+    mxGetPr(sizeArr)[2]=nTime;
+    mxSetField(plhs[0],0,"size",sizeArr);
+    mxSetField(plhs[0],0,"bs",mxCreateDoubleScalar(bs));
+
+    mxArray* const nBegArr=mxCreateDoubleMatrix(nBlkRow,nBlkCol,mxREAL);
+    mxArray* const nEndArr=mxCreateDoubleMatrix(nBlkRow,nBlkCol,mxREAL);
+    mxArray* const valArr=mxCreateDoubleMatrix(nVal,1,mxREAL);
+    size_t statDim[4]={bs,bs,nBlkRow,nBlkCol};
+    mxArray* const statArr=mxCreateNumericArray(4,statDim,mxDOUBLE_CLASS,mxREAL);
+    double* const nBegOut=mxGetPr(nBegArr);
+    double* const nEndOut=mxGetPr(nEndArr);
+    double* const val=mxGetPr(valArr);
+    double* const stat=mxGetPr(statArr);
+
+    // The window [iBeg,iEnd) is zero based and half open, which corresponds
+    // to the one based closed interval [iBeg+1,iEnd].
+    size_t iVal=0;
+    for (unsigned int jBlk=0; jBlk<nBlkCol; jBlk++)
+    {
+      for (unsigned int iBlk=0; iBlk<nBlkRow; iBlk++)
+      {
+        const size_t iBlock=iBlk+(size_t)nBlkRow*jBlk;
+        const double* const Ablk=A+bs*iBlk+(size_t)nRow*bs*jBlk;
+        nBegOut[iBlock]=nBeg[iBlock]+1;
+        nEndOut[iBlock]=nEnd[iBlock];
+        for (unsigned int iTime=nBeg[iBlock]; iTime<nEnd[iBlock]; iTime++)
+          for (unsigned int jDof=0; jDof<bs; jDof++)
+            for (unsigned int iDof=0; iDof<bs; iDof++)
+              val[iVal++]=Ablk[iDof+(size_t)nRow*jDof+nSlice*iTime];
+        for (unsigned int jDof=0; jDof<bs; jDof++)
+          for (unsigned int iDof=0; iDof<bs; iDof++)
+            stat[iDof+bs*jDof+bs*bs*iBlock]=(nBeg[iBlock]<nTime ? Ablk[iDof+(size_t)nRow*jDof+nSlice*(nTime-1)] : 0.0);
+      }
+    }
+    mxSetField(plhs[0],0,"nBeg",nBegArr);
+    mxSetField(plhs[0],0,"nEnd",nEndArr);
+    mxSetField(plhs[0],0,"val",valArr);
+    mxSetField(plhs[0],0,"stat",statArr);
+
+    delete [] nBeg;
+    delete [] nEnd;
+  }
+  catch (const char* exception)
+  {
+    mexErrMsgTxt(exception);
+  }
+}
@@ -4,69 +4,630 @@
  *   matrices A and X, defined as:
  *
  *          N
- *   B  =  sum A(:,:,n) * X(:,N-n)
+ *   B  =  sum A(:,:,n) * X(:,N+1-n)
  *         n=1
  *
- *   A   Influence matrices (nRow * nDof * nTime).
- *   X   Stress or displacement history (nDof * nTime).
- *   B   Convolution (nRow * 1).
+ *   In a time stepping analysis, the convolution is evaluated incrementally
+ *   with a persistent history, so that the history is not passed and
+ *   convolved from scratch at every time step:
+ *
+ *   BEMMATCONV('init',A) stores the influence matrices A and clears the
+ *   history.
+ *   BEMMATCONV('init',A,nBlock) uses a block size nBlock for the FFT based
+ *   block convolution of the history. If nBlock is 0, the convolution is
+ *   evaluated directly. By default, the block convolution is used if A has
+ *   more than 64 time steps, with nBlock the smallest power of two not less
+ *   than 2*sqrt(nTime). The direct convolution costs O(nRow*nDof*nTime) per
+ *   time step. In the block scheme, the direct convolution within the
+ *   current block costs O(nRow*nDof*nBlock) and the convolution of a
+ *   completed block, once per nBlock time steps, O(nRow*nDof*nTime) in the
+ *   frequency domain, so that the amortised cost per time step is
+ *   O(nRow*nDof*(nBlock+nTime/nBlock)), i.e. O(nRow*nDof*sqrt(nTime)) for the
+ *   default block size.
+ *   B = BEMMATCONV('step',x) appends the vector x = X(:,N) to the history and
+ *   returns the convolution B at time step N.
+ *   BEMMATCONV('push',x) appends the vector x = X(:,N) to the history
+ *   without computing the convolution.
+ *   Bh = BEMMATCONV('history') returns the contribution of the history to
+ *   the convolution at the next time step N+1, i.e. the convolution without
+ *   the term A(:,:,1) * X(:,N+1).
+ *   BEMMATCONV('init',C) stores the causally compressed influence matrices
+ *   C, as computed by BEMMATCOMPRESS. For every block of C, only the time
+ *   steps within the active window are convolved, while the static tail is
+ *   applied to the sum of the corresponding part of the history. The cost
+ *   per time step is proportional to the support of the wave fronts rather
+ *   than to the number of time steps.
+ *   BEMMATCONV('clear') clears the influence matrices and the history.
+ *
+ *   A      Influence matrices (nRow * nDof * nTime).
+ *   C      Compressed influence matrices (structure), see BEMMATCOMPRESS.
+ *   X      Stress or displacement history (nDof * nTime).
+ *   x      Stress or displacement at the current time step (nDof * 1).
+ *   nBlock Block size (1 * 1).
+ *   B      Convolution (nRow * 1).
+ *   Bh     History contribution to the convolution (nRow * 1).
  */
- 
-/* $Make: mex -O -output bemmatconv bemmatconv_mex.cpp$*/ 
+
+/* $Make: mex -O -output bemmatconv bemmatconv_mex.cpp fft.cpp$*/
 
 #include "mex.h"
 #include "math.h"
 #include <string.h>
+#include <complex>
+#include <new>
+#include "fft.h"
 #include "checklicense.h"
 
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
+using namespace std;
+
+// Number of rows of A that are processed at once, such that the
+// corresponding part of B remains in cache while A is streamed.
+const unsigned int RowBlock=512;
+
+// Default block size of the FFT based convolution is used from this number
+// of time steps onwards.
+const unsigned int nTimeBlockConv=64;
+
+//==============================================================================
+// PERSISTENT CONVOLUTION HISTORY
+//==============================================================================
+static bool ConvValid=false;
+static unsigned int nRow=0;
+static unsigned int nDof=0;
+static unsigned int nTime=0;
+static unsigned int nBlock=0;      // 0: direct convolution
+static unsigned int nStep=0;       // Number of time steps in the history
+static unsigned int nASlice=0;     // Number of slices of A that are stored
+static double* A=0;                // Influence matrices (nRow * nDof * nASlice)
+static double* Xh=0;               // Ring buffer with history (nDof * nTime)
+                                   // or current block (nDof * nBlock)
+static unsigned int nFft=0;        // FFT length
+static unsigned int nBin=0;        // Number of non-negative frequencies
+static complex<double>* Ahat=0;    // Spectrum of A (nRow * nDof * nBin)
+static complex<double>* Xhat=0;    // Spectrum of current block (nDof * nBin)
+static complex<double>* Yhat=0;    // Spectrum of block response (nRow * nBin)
+static complex<double>* work=0;    // FFT workspace (nFft)
+static double* F=0;                // Ring buffer with the future contributions
+                                   // of completed blocks (nRow * nFft)
+
+// Compressed matrices (see BEMMATCOMPRESS)
+static bool Windowed=false;
+static unsigned int bs=0;          // Block size
+static unsigned int nBlkRow=0;
+static unsigned int nBlkCol=0;
+static unsigned int* nBeg=0;       // Window [nBeg,nEnd) per block, zero based
+static unsigned int* nEnd=0;
+static size_t* valPtr=0;           // Offset of the window values per block
+static double* val=0;              // Window values
+static double* stat=0;             // Static values (bs * bs * nBlk)
+static double* Sh=0;               // Ring buffer with cumulative sums of the
+                                   // history (nDof * (nTime+1))
+
+//==============================================================================
+void cleanup()
+//==============================================================================
+{
+  ConvValid=false;
+  if (A!=0) {delete [] A; A=0;}
+  if (Xh!=0) {delete [] Xh; Xh=0;}
+  if (Ahat!=0) {delete [] Ahat; Ahat=0;}
+  if (Xhat!=0) {delete [] Xhat; Xhat=0;}
+  if (Yhat!=0) {delete [] Yhat; Yhat=0;}
+  if (work!=0) {delete [] work; work=0;}
+  if (F!=0) {delete [] F; F=0;}
+  if (nBeg!=0) {delete [] nBeg; nBeg=0;}
+  if (nEnd!=0) {delete [] nEnd; nEnd=0;}
+  if (valPtr!=0) {delete [] valPtr; valPtr=0;}
+  if (val!=0) {delete [] val; val=0;}
+  if (stat!=0) {delete [] stat; stat=0;}
+  if (Sh!=0) {delete [] Sh; Sh=0;}
+  Windowed=false;
+  bs=0;
+  nBlkRow=0;
+  nBlkCol=0;
+  nRow=0;
+  nDof=0;
+  nTime=0;
+  nBlock=0;
+  nStep=0;
+  nASlice=0;
+  nFft=0;
+  nBin=0;
+}
+
+//==============================================================================
+void matconvsum(const unsigned int& nRow, const unsigned int& nDof,
+                const double* const* const Aslice, const double* const* const xvec,
+                const unsigned int& nTerm, double* const B)
+/* Accumulates B = B + sum_i Aslice[i] * xvec[i], where Aslice[i] is a
+ * (nRow * nDof) matrix and xvec[i] a (nDof * 1) vector. The rows are
+ * processed in blocks of RowBlock rows and the columns of A are traversed
+ * with unit stride. Zero entries of x (e.g. quiescent past) are skipped.
+ */
+//==============================================================================
+{
+  for (unsigned int rowBeg=0; rowBeg<nRow; rowBeg+=RowBlock)
+  {
+    const unsigned int rowEnd=(rowBeg+RowBlock<nRow ? rowBeg+RowBlock : nRow);
+    for (unsigned int iTerm=0; iTerm<nTerm; iTerm++)
+    {
+      const double* const Ai=Aslice[iTerm];
+      const double* const xi=xvec[iTerm];
+      for (unsigned int jDof=0; jDof<nDof; jDof++)
+      {
+        const double xj=xi[jDof];
+        if (xj==0.0) continue;
+        const double* const Acol=Ai+(size_t)nRow*jDof;
+        for (unsigned int iRow=rowBeg; iRow<rowEnd; iRow++) B[iRow]+=Acol[iRow]*xj;
+      }
+    }
+  }
+}
+
+//==============================================================================
+void nearconv(const unsigned int& iStep, const unsigned int& lagMin, double* const B)
+/* Adds the direct part of the convolution at time step iStep (zero based)
+ * to B, for lags larger than or equal to lagMin. In the direct scheme, the
+ * complete history is included. In the block scheme, only the time steps
+ * of the current block are included, while the preceding blocks are
+ * contained in F.
+ */
+//==============================================================================
+{
+  const unsigned int stepBeg=(nBlock>0 ? (iStep/nBlock)*nBlock : 0);
+  unsigned int lagMax=iStep-stepBeg;
+  if (lagMax>nASlice-1) lagMax=nASlice-1;
+  if (lagMin>lagMax) return;
+  const unsigned int nTerm=lagMax-lagMin+1;
+
+  const double** const Aslice=new(nothrow) const double*[nTerm];
+  if (Aslice==0) throw("Out of memory.");
+  const double** const xvec=new(nothrow) const double*[nTerm];
+  if (xvec==0) throw("Out of memory.");
+  for (unsigned int iTerm=0; iTerm<nTerm; iTerm++)
+  {
+    const unsigned int lag=lagMin+iTerm;
+    const unsigned int jStep=iStep-lag;
+    const unsigned int slot=(nBlock>0 ? jStep-stepBeg : jStep%nTime);
+    Aslice[iTerm]=A+(size_t)nRow*nDof*lag;
+    xvec[iTerm]=Xh+(size_t)nDof*slot;
+  }
+  matconvsum(nRow,nDof,Aslice,xvec,nTerm,B);
+  delete [] Aslice;
+  delete [] xvec;
+}
+
+//==============================================================================
+void blockconv(const unsigned int& stepBeg)
+/* Adds the contribution of the completed block starting at time step
+ * stepBeg to the future time steps in F. The block is convolved with A by
+ * means of FFTs of length nFft >= nTime+nBlock-1, so that no wrap around
+ * occurs. The summation over the degrees of freedom is performed in the
+ * frequency domain. Only the contributions to time steps after the block
+ * are retained; the contributions within the block are evaluated directly.
+ */
+//==============================================================================
+{
+  // SPECTRUM OF THE BLOCK
+  for (unsigned int jDof=0; jDof<nDof; jDof++)
+  {
+    for (unsigned int k=0; k<nBlock; k++) work[k]=Xh[jDof+(size_t)nDof*k];
+    for (unsigned int k=nBlock; k<nFft; k++) work[k]=0.0;
+    fft(work,nFft,false);
+    for (unsigned int k=0; k<nBin; k++) Xhat[jDof+(size_t)nDof*k]=work[k];
+  }
+
+  // PRODUCT IN THE FREQUENCY DOMAIN
+  for (size_t i=0; i<(size_t)nRow*nBin; i++) Yhat[i]=0.0;
+  for (unsigned int k=0; k<nBin; k++)
+  {
+    const complex<double>* const Ak=Ahat+(size_t)nRow*nDof*k;
+    const complex<double>* const Xk=Xhat+(size_t)nDof*k;
+    complex<double>* const Yk=Yhat+(size_t)nRow*k;
+    for (unsigned int jDof=0; jDof<nDof; jDof++)
+    {
+      const complex<double> xj=Xk[jDof];
+      if (xj==0.0) continue;
+      const complex<double>* const Acol=Ak+(size_t)nRow*jDof;
+      for (unsigned int iRow=0; iRow<nRow; iRow++) Yk[iRow]+=Acol[iRow]*xj;
+    }
+  }
+
+  // INVERSE TRANSFORM AND ACCUMULATION OF THE FUTURE CONTRIBUTIONS
+  for (unsigned int iRow=0; iRow<nRow; iRow++)
+  {
+    for (unsigned int k=0; k<nBin; k++) work[k]=Yhat[iRow+(size_t)nRow*k];
+    for (unsigned int k=nBin; k<nFft; k++) work[k]=conj(work[nFft-k]);
+    fft(work,nFft,true);
+    for (unsigned int lag=nBlock; lag<nBlock+nTime-1; lag++)
+    {
+      const unsigned int slot=(stepBeg+lag)%nFft;
+      F[iRow+(size_t)nRow*slot]+=work[lag].real();
+    }
+  }
+}
+
+//==============================================================================
+void initconv(const mxArray* const Ain, const int& nBlockIn)
+/* Stores the influence matrices and allocates the history. If nBlockIn is
+ * negative, the block size is chosen automatically.
+ */
+//==============================================================================
+{
+  cleanup();
+  const size_t nDimA=mxGetNumberOfDimensions(Ain);
+  const size_t* const dimA=mxGetDimensions(Ain);
+  nRow=dimA[0];
+  nDof=dimA[1];
+  nTime=(nDimA==3 ? dimA[2] : 1);
+  if (nTime==0) throw("Input argument 'A' must have at least one time step.");
+  const double* const Ain0=mxGetPr(Ain);
+
+  // A block size of about sqrt(nTime) balances the direct convolution within
+  // the current block against the convolution of the completed blocks.
+  if (nBlockIn<0)
+  {
+    if (nTime>nTimeBlockConv) nBlock=nextpow2((unsigned int)ceil(2.0*sqrt((double)nTime)));
+    else nBlock=0;
+  }
+  else nBlock=(unsigned int)nBlockIn;
+
+  // STORE INFLUENCE MATRICES: ONLY THE FIRST nBlock SLICES ARE NEEDED FOR
+  // THE DIRECT PART OF THE BLOCK SCHEME
+  nASlice=((nBlock>0)&&(nBlock<nTime) ? nBlock : nTime);
+  const size_t nA=(size_t)nRow*nDof*nASlice;
+  A=new(nothrow) double[nA];
+  if (A==0) throw("Out of memory.");
+  memcpy(A,Ain0,nA*sizeof(double));
+
+  const unsigned int nHist=(nBlock>0 ? nBlock : nTime);
+  Xh=new(nothrow) double[(size_t)nDof*nHist];
+  if (Xh==0) throw("Out of memory.");
+  for (size_t i=0; i<(size_t)nDof*nHist; i++) Xh[i]=0.0;
+
+  if (nBlock>0)
+  {
+    nFft=nextpow2(nTime+nBlock-1);
+    nBin=nFft/2+1;
+    Ahat=new(nothrow) complex<double>[(size_t)nRow*nDof*nBin];
+    if (Ahat==0) throw("Out of memory.");
+    Xhat=new(nothrow) complex<double>[(size_t)nDof*nBin];
+    if (Xhat==0) throw("Out of memory.");
+    Yhat=new(nothrow) complex<double>[(size_t)nRow*nBin];
+    if (Yhat==0) throw("Out of memory.");
+    work=new(nothrow) complex<double>[nFft];
+    if (work==0) throw("Out of memory.");
+    F=new(nothrow) double[(size_t)nRow*nFft];
+    if (F==0) throw("Out of memory.");
+    for (size_t i=0; i<(size_t)nRow*nFft; i++) F[i]=0.0;
+
+    // SPECTRUM OF THE INFLUENCE MATRICES
+    for (unsigned int jDof=0; jDof<nDof; jDof++)
+    {
+      for (unsigned int iRow=0; iRow<nRow; iRow++)
+      {
+        for (unsigned int k=0; k<nTime; k++) work[k]=Ain0[iRow+(size_t)nRow*jDof+(size_t)nRow*nDof*k];
+        for (unsigned int k=nTime; k<nFft; k++) work[k]=0.0;
+        fft(work,nFft,false);
+        for (unsigned int k=0; k<nBin; k++) Ahat[iRow+(size_t)nRow*jDof+(size_t)nRow*nDof*k]=work[k];
+      }
+    }
+  }
+  nStep=0;
+  ConvValid=true;
+}
+
+//==============================================================================
+void winconv(const unsigned int& iStep, const unsigned int& lagMin, double* const B)
+/* Adds the convolution of the compressed matrices at time step iStep (zero
+ * based) to B, for lags larger than or equal to lagMin. Within the window
+ * of a block, the history is convolved directly. The static values are
+ * multiplied with the sum of the history over the remaining lags, which
+ * follows from the cumulative sums in Sh.
+ */
+//==============================================================================
+{
+  const unsigned int lagMax=(iStep<nTime-1 ? iStep : nTime-1);
+  if (lagMin>lagMax) return;
+  const unsigned int nSh=nTime+1;
+
+  for (unsigned int jBlk=0; jBlk<nBlkCol; jBlk++)
+  {
+    for (unsigned int iBlk=0; iBlk<nBlkRow; iBlk++)
+    {
+      const size_t iBlock=iBlk+(size_t)nBlkRow*jBlk;
+      double* const Bi=B+bs*iBlk;
+
+      // WINDOW
+      const unsigned int lagBeg=(nBeg[iBlock]>lagMin ? nBeg[iBlock] : lagMin);
+      const unsigned int lagEnd=(nEnd[iBlock]<lagMax+1 ? nEnd[iBlock] : lagMax+1);
+      for (unsigned int lag=lagBeg; lag<lagEnd; lag++)
+      {
+        const double* const Ablk=val+valPtr[iBlock]+(size_t)bs*bs*(lag-nBeg[iBlock]);
+        const double* const x=Xh+(size_t)nDof*((iStep-lag)%nTime)+bs*jBlk;
+        for (unsigned int jDof=0; jDof<bs; jDof++)
+        {
+          const double xj=x[jDof];
+          if (xj==0.0) continue;
+          for (unsigned int iDof=0; iDof<bs; iDof++) Bi[iDof]+=Ablk[iDof+bs*jDof]*xj;
+        }
+      }
+
+      // STATIC TAIL: lags statBeg to lagMax
+      const unsigned int statBeg=(nEnd[iBlock]>lagMin ? nEnd[iBlock] : lagMin);
+      if ((statBeg>lagMax) || (nBeg[iBlock]>=nTime)) continue;
+      const double* const Sblk=stat+(size_t)bs*bs*iBlock;
+      const double* const S1=Sh+(size_t)nDof*((iStep-statBeg)%nSh)+bs*jBlk;
+      const double* const S0=(iStep>lagMax ? Sh+(size_t)nDof*((iStep-lagMax-1)%nSh)+bs*jBlk : 0);
+      for (unsigned int jDof=0; jDof<bs; jDof++)
+      {
+        const double xj=(S0==0 ? S1[jDof] : S1[jDof]-S0[jDof]);
+        if (xj==0.0) continue;
+        for (unsigned int iDof=0; iDof<bs; iDof++) Bi[iDof]+=Sblk[iDof+bs*jDof]*xj;
+      }
+    }
+  }
+}
+
+//==============================================================================
+void initwinconv(const mxArray* const C)
+/* Stores the compressed matrices computed by BEMMATCOMPRESS and allocates
+ * the history.
+ */
+//==============================================================================
+{
+  cleanup();
+  const mxArray* const sizeArr=mxGetField(C,0,"size");
+  const mxArray* const bsArr=mxGetField(C,0,"bs");
+  const mxArray* const nBegArr=mxGetField(C,0,"nBeg");
+  const mxArray* const nEndArr=mxGetField(C,0,"nEnd");
+  const mxArray* const valArr=mxGetField(C,0,"val");
+  const mxArray* const statArr=mxGetField(C,0,"stat");
+  if ((sizeArr==0) || (bsArr==0) || (nBegArr==0) || (nEndArr==0) || (valArr==0) || (statArr==0))
+    throw("Input argument 'C' must be computed by BEMMATCOMPRESS.");
+  if (!(mxGetNumberOfElements(sizeArr)==3)) throw("Field 'size' of input argument 'C' must have 3 elements.");
+
+  nRow=(unsigned int)mxGetPr(sizeArr)[0];
+  nDof=(unsigned int)mxGetPr(sizeArr)[1];
+  nTime=(unsigned int)mxGetPr(sizeArr)[2];
+  bs=(unsigned int)mxGetScalar(bsArr);
+  if (nTime==0) throw("Input argument 'C' must have at least one time step.");
+  if ((bs==0) || (nRow%bs!=0) || (nDof%bs!=0)) throw("Field 'bs' of input argument 'C' is incompatible with its size.");
+  nBlkRow=nRow/bs;
+  nBlkCol=nDof/bs;
+  const size_t nBlk=(size_t)nBlkRow*nBlkCol;
+  if (!(mxGetNumberOfElements(nBegArr)==nBlk)) throw("Field 'nBeg' of input argument 'C' has incorrect size.");
+  if (!(mxGetNumberOfElements(nEndArr)==nBlk)) throw("Field 'nEnd' of input argument 'C' has incorrect size.");
+  if (!(mxGetNumberOfElements(statArr)==nBlk*bs*bs)) throw("Field 'stat' of input argument 'C' has incorrect size.");
+
+  nBeg=new(nothrow) unsigned int[nBlk];
+  if (nBeg==0) throw("Out of memory.");
+  nEnd=new(nothrow) unsigned int[nBlk];
+  if (nEnd==0) throw("Out of memory.");
+  valPtr=new(nothrow) size_t[nBlk];
+  if (valPtr==0) throw("Out of memory.");
+  size_t nVal=0;
+  for (size_t iBlock=0; iBlock<nBlk; iBlock++)
+  {
+    nBeg[iBlock]=(unsigned int)mxGetPr(nBegArr)[iBlock]-1;
+    nEnd[iBlock]=(unsigned int)mxGetPr(nEndArr)[iBlock];
+    if ((nEnd[iBlock]<nBeg[iBlock]) || (nEnd[iBlock]>nTime)) throw("Fields 'nBeg' and 'nEnd' of input argument 'C' are inconsistent.");
+    valPtr[iBlock]=nVal;
+    nVal+=(size_t)bs*bs*(nEnd[iBlock]-nBeg[iBlock]);
+  }
+  if (!(mxGetNumberOfElements(valArr)==nVal)) throw("Field 'val' of input argument 'C' has incorrect size.");
+
+  val=new(nothrow) double[nVal>0 ? nVal : 1];
+  if (val==0) throw("Out of memory.");
+  memcpy(val,mxGetPr(valArr),nVal*sizeof(double));
+  stat=new(nothrow) double[nBlk*bs*bs];
+  if (stat==0) throw("Out of memory.");
+  memcpy(stat,mxGetPr(statArr),nBlk*bs*bs*sizeof(double));
+
+  Xh=new(nothrow) double[(size_t)nDof*nTime];
+  if (Xh==0) throw("Out of memory.");
+  for (size_t i=0; i<(size_t)nDof*nTime; i++) Xh[i]=0.0;
+  Sh=new(nothrow) double[(size_t)nDof*(nTime+1)];
+  if (Sh==0) throw("Out of memory.");
+  for (size_t i=0; i<(size_t)nDof*(nTime+1); i++) Sh[i]=0.0;
+
+  Windowed=true;
+  nStep=0;
+  ConvValid=true;
+}
+
+//==============================================================================
+void pushconv(const double* const x, double* const B)
+/* Appends x to the history. If B is not null, the convolution at the new
+ * time step is returned in B.
+ */
+//==============================================================================
+{
+  const unsigned int iStep=nStep;
+  const unsigned int slot=(nBlock>0 ? iStep%nBlock : iStep%nTime);
+  memcpy(Xh+(size_t)nDof*slot,x,nDof*sizeof(double));
+
+  if (Windowed)
+  {
+    double* const Si=Sh+(size_t)nDof*(iStep%(nTime+1));
+    const double* const Sprev=Sh+(size_t)nDof*((iStep+nTime)%(nTime+1));
+    for (unsigned int jDof=0; jDof<nDof; jDof++) Si[jDof]=(iStep>0 ? Sprev[jDof] : 0.0)+x[jDof];
+    if (B!=0)
+    {
+      for (unsigned int iRow=0; iRow<nRow; iRow++) B[iRow]=0.0;
+      winconv(iStep,0,B);
+    }
+  }
+  else if (nBlock>0)
+  {
+    double* const Fi=F+(size_t)nRow*(iStep%nFft);
+    if (B!=0)
+    {
+      for (unsigned int iRow=0; iRow<nRow; iRow++) B[iRow]=Fi[iRow];
+      nearconv(iStep,0,B);
+    }
+    for (unsigned int iRow=0; iRow<nRow; iRow++) Fi[iRow]=0.0;
+    if (slot==nBlock-1) blockconv(iStep+1-nBlock);
+  }
+  else if (B!=0)
+  {
+    for (unsigned int iRow=0; iRow<nRow; iRow++) B[iRow]=0.0;
+    nearconv(iStep,0,B);
+  }
+  nStep++;
+}
+
+//==============================================================================
+void historyconv(double* const B)
+/* Returns the contribution of the history to the convolution at the next
+ * time step.
+ */
+//==============================================================================
+{
+  const unsigned int iStep=nStep;
+  for (unsigned int iRow=0; iRow<nRow; iRow++) B[iRow]=0.0;
+  if (nBlock>0)
+  {
+    const double* const Fi=F+(size_t)nRow*(iStep%nFft);
+    for (unsigned int iRow=0; iRow<nRow; iRow++) B[iRow]=Fi[iRow];
+  }
+  if (Windowed) winconv(iStep,1,B);
+  else if (iStep>0) nearconv(iStep,1,B);
+}
+
+//==============================================================================
 void mexFunction(int nlhs, mxArray *plhs[],
                  int nrhs, const mxArray *prhs[])
+//==============================================================================
 {
+  mexAtExit(cleanup);
   try
-  {    
+  {
     checklicense();
-    
-    if (nrhs!=2) mexErrMsgTxt("Two input arguments required.");
-    if (nlhs>1)  mexErrMsgTxt("Only one output argument allowed.");
-    
-    
+
+    if (nrhs<1) throw("Not enough input arguments.");
+    if (nlhs>1) throw("Too many output arguments.");
+
+    // INCREMENTAL CONVOLUTION
+    if (mxIsChar(prhs[0]))
+    {
+      char* const mode=mxArrayToString(prhs[0]);
+      if (strcasecmp(mode,"init")==0)
+      {
+        mxFree(mode);
+        if (nrhs<2) throw("Not enough input arguments.");
+        if (nrhs>3) throw("Too many input arguments.");
+        if (nlhs>0) throw("Too many output arguments.");
+        if (mxIsStruct(prhs[1]))
+        {
+          if (nrhs>2) throw("Too many input arguments.");
+          initwinconv(prhs[1]);
+          return;
+        }
+        if (!mxIsNumeric(prhs[1])) throw("Input argument 'A' must be numeric.");
+        if (mxIsSparse(prhs[1])) throw("Input argument 'A' must not be sparse.");
+        if (mxIsComplex(prhs[1])) throw("Input argument 'A' must be real.");
+        if (mxGetNumberOfDimensions(prhs[1])>3) throw("Input argument 'A' must have 3 dimensions at most.");
+        int nBlockIn=-1;
+        if (nrhs==3)
+        {
+          if (!mxIsNumeric(prhs[2])) throw("Input argument 'nBlock' must be numeric.");
+          if (mxIsComplex(prhs[2])) throw("Input argument 'nBlock' must be real.");
+          if (!(mxGetNumberOfElements(prhs[2])==1)) throw("Input argument 'nBlock' must be a scalar.");
+          if (mxGetScalar(prhs[2])<0) throw("Input argument 'nBlock' must be positive or zero.");
+          nBlockIn=(int)mxGetScalar(prhs[2]);
+        }
+        initconv(prhs[1],nBlockIn);
+      }
+      else if ((strcasecmp(mode,"step")==0) || (strcasecmp(mode,"push")==0))
+      {
+        const bool BOut=(strcasecmp(mode,"step")==0);
+        mxFree(mode);
+        if (!ConvValid) throw("The convolution is not initialized.");
+        if (nrhs<2) throw("Not enough input arguments.");
+        if (nrhs>2) throw("Too many input arguments.");
+        if (!mxIsNumeric(prhs[1])) throw("Input argument 'x' must be numeric.");
+        if (mxIsSparse(prhs[1])) throw("Input argument 'x' must not be sparse.");
+        if (mxIsComplex(prhs[1])) throw("Input argument 'x' must be real.");
+        if (!(mxGetNumberOfElements(prhs[1])==nDof)) throw("Number of elements in input arguments 'A' and 'x' does not correspond.");
+        const double* const x=mxGetPr(prhs[1]);
+        double* B=0;
+        if (BOut)
+        {
+          plhs[0]=mxCreateDoubleMatrix(nRow,1,mxREAL);
+          B=mxGetPr(plhs[0]);
+        }
+        else if (nlhs>0) throw("Too many output arguments.");
+        pushconv(x,B);
+      }
+      else if (strcasecmp(mode,"history")==0)
+      {
+        mxFree(mode);
+        if (!ConvValid) throw("The convolution is not initialized.");
+        if (nrhs>1) throw("Too many input arguments.");
+        plhs[0]=mxCreateDoubleMatrix(nRow,1,mxREAL);
+        historyconv(mxGetPr(plhs[0]));
+      }
+      else if (strcasecmp(mode,"clear")==0)
+      {
+        mxFree(mode);
+        if (nrhs>1) throw("Too many input arguments.");
+        if (nlhs>0) throw("Too many output arguments.");
+        cleanup();
+      }
+      else
+      {
+        mxFree(mode);
+        throw("Unknown mode.");
+      }
+      return;
+    }
+
+    // CONVOLUTION OF A COMPLETE HISTORY
+    if (nrhs!=2) throw("Two input arguments required.");
+
     if (!mxIsNumeric(prhs[0])) throw("Input argument 'A' must be numeric.");
     if (mxIsSparse(prhs[0])) throw("Input argument 'A' must not be sparse.");
     if (mxIsComplex(prhs[0])) throw("Input argument 'A' must be real.");
     const size_t nDimA=mxGetNumberOfDimensions(prhs[0]);
     const size_t* const dimA=mxGetDimensions(prhs[0]);
     if (nDimA>3) throw("Input argument 'A' must have 3 dimensions at most.");
-    int nRow=dimA[0];
-    int nDof=dimA[1];
-    int nTime;
-    if (nDimA == 3) nTime=dimA[2]; else nTime=1;
-    const double* const A = mxGetPr(prhs[0]);
-    
+    const unsigned int nRowA=dimA[0];
+    const unsigned int nDofA=dimA[1];
+    const unsigned int nTimeA=(nDimA==3 ? dimA[2] : 1);
+    const double* const A0=mxGetPr(prhs[0]);
+
     if (!mxIsNumeric(prhs[1])) throw("Input argument 'X' must be numeric.");
     if (mxIsSparse(prhs[1])) throw("Input argument 'X' must not be sparse.");
     if (mxIsComplex(prhs[1])) throw("Input argument 'X' must be real.");
     const int nDimX=mxGetNumberOfDimensions(prhs[1]);
     const size_t* const dimX=mxGetDimensions(prhs[1]);
     if (nDimX>2) throw("Input argument 'X' must have 2 dimensions at most.");
-    if (dimX[0]!=(unsigned int)nDof) throw("Number of elements in input arguments 'A' and 'X' does not correspond.");
-    if (dimX[1]!=(unsigned int)nTime) throw("Number of elements in input arguments 'A' and 'X' does not correspond.");
+    if (dimX[0]!=nDofA) throw("Number of elements in input arguments 'A' and 'X' does not correspond.");
+    if (dimX[1]!=nTimeA) throw("Number of elements in input arguments 'A' and 'X' does not correspond.");
     const double* const X = mxGetPr(prhs[1]);
-    
+
     // OUTPUT ARGUMENT AND POINTER TO OUTPUT ARGUMENT
-    plhs[0] = mxCreateDoubleMatrix(nRow,1,mxREAL);
+    plhs[0] = mxCreateDoubleMatrix(nRowA,1,mxREAL);
     double* const B = mxGetPr(plhs[0]);
-    for (int iElt=0; iElt<nRow; iElt++) B[iElt]=0.0;
-    
-    for (int iTime=0; iTime<nTime; iTime++)
+    for (unsigned int iRow=0; iRow<nRowA; iRow++) B[iRow]=0.0;
+
+    const double** const Aslice=new(nothrow) const double*[nTimeA];
+    if (Aslice==0) throw("Out of memory.");
+    const double** const xvec=new(nothrow) const double*[nTimeA];
+    if (xvec==0) throw("Out of memory.");
+    for (unsigned int iTime=0; iTime<nTimeA; iTime++)
     {
-      for(int iRow=0; iRow<nRow; iRow++)
-      {
-        for(int jDof=0; jDof<nDof; jDof++)
-        {
-          B[iRow]=B[iRow]+A[iRow+nRow*jDof+nRow*nDof*iTime]*X[jDof+nDof*(nTime-iTime-1)];
-        }
-      }
+      Aslice[iTime]=A0+(size_t)nRowA*nDofA*iTime;
+      xvec[iTime]=X+(size_t)nDofA*(nTimeA-iTime-1);
     }
+    matconvsum(nRowA,nDofA,Aslice,xvec,nTimeA,B);
+    delete [] Aslice;
+    delete [] xvec;
   }
   catch (const char* exception)
   {
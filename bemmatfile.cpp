@@ -0,0 +1,180 @@
+/* bemmatfile.cpp
+ *
+ * Memory mapped files for boundary element matrices that exceed the
+ * available memory. The layout of the files is documented in bemmatfile.h.
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <string.h>
+#include <stddef.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+typedef unsigned long long int uint64;
+
+static const uint64 headerSize=4096;
+static const uint64 mapAlign=65536;  // Allocation granularity on Windows
+static const char fileId[8]={'B','E','M','M','A','T','0','1'};
+
+//==============================================================================
+static void* mapFile(const char* const fileName, const bool& create,
+                     const uint64& fileSize, const uint64& offset,
+                     const uint64& length)
+/* Map length bytes at offset (a multiple of mapAlign) of a file into memory.
+ * If create is true, the file is created with size fileSize and mapped for
+ * writing; otherwise an existing file is mapped read only.
+ */
+//==============================================================================
+{
+#ifdef _WIN32
+  HANDLE file=CreateFileA(fileName,(create ? GENERIC_READ|GENERIC_WRITE : GENERIC_READ),
+                          FILE_SHARE_READ,0,(create ? CREATE_ALWAYS : OPEN_EXISTING),
+                          FILE_ATTRIBUTE_NORMAL,0);
+  if (file==INVALID_HANDLE_VALUE) throw("Unable to open the boundary element matrix file.");
+  if (!create)
+  {
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file,&size) || (uint64)size.QuadPart<offset+length)
+    {
+      CloseHandle(file);
+      throw("The boundary element matrix file is truncated.");
+    }
+  }
+  HANDLE mapping=CreateFileMappingA(file,0,(create ? PAGE_READWRITE : PAGE_READONLY),
+                                    (DWORD)(fileSize>>32),(DWORD)(fileSize & 0xffffffff),0);
+  CloseHandle(file);
+  if (mapping==0) throw("Unable to allocate the boundary element matrix file.");
+  void* const map=MapViewOfFile(mapping,(create ? FILE_MAP_WRITE : FILE_MAP_READ),
+                                (DWORD)(offset>>32),(DWORD)(offset & 0xffffffff),
+                                (SIZE_T)length);
+  CloseHandle(mapping);
+  if (map==0) throw("Unable to map the boundary element matrix file.");
+  return map;
+#else
+  const int fd=open(fileName,(create ? O_RDWR|O_CREAT|O_TRUNC : O_RDONLY),0644);
+  if (fd<0) throw("Unable to open the boundary element matrix file.");
+  if (create)
+  {
+    // Reserve the disk space, so that a full disk is reported here rather
+    // than as a bus error while the matrices are written.
+  #ifdef __linux__
+    const bool allocError=(posix_fallocate(fd,0,(off_t)fileSize)!=0);
+  #else
+    const bool allocError=(ftruncate(fd,(off_t)fileSize)!=0);
+  #endif
+    if (allocError)
+    {
+      close(fd);
+      throw("Unable to allocate the boundary element matrix file.");
+    }
+  }
+  else
+  {
+    struct stat fileStat;
+    if ((fstat(fd,&fileStat)!=0) || ((uint64)fileStat.st_size<offset+length))
+    {
+      close(fd);
+      throw("The boundary element matrix file is truncated.");
+    }
+  }
+  void* const map=mmap(0,(size_t)length,(create ? PROT_READ|PROT_WRITE : PROT_READ),
+                       MAP_SHARED,fd,(off_t)offset);
+  close(fd);
+  if (map==MAP_FAILED) throw("Unable to map the boundary element matrix file.");
+  return map;
+#endif
+}
+
+//==============================================================================
+void* bemmatFileCreate(const char* const fileName, const unsigned int& nDim,
+                       const size_t* const dim, const bool& Cmplx,
+                       double*& Re, double*& Im, uint64& mapSize)
+//==============================================================================
+{
+  if (nDim>8) throw("Too many dimensions for a boundary element matrix file.");
+  uint64 n=1;
+  for (unsigned int iDim=0; iDim<nDim; iDim++) n*=dim[iDim];
+  const uint64 nByte=8*n;
+  mapSize=headerSize+(Cmplx ? 2 : 1)*nByte;
+
+  void* const map=mapFile(fileName,true,mapSize,0,mapSize);
+
+  uint64* const header=(uint64*)map;
+  memcpy(header,fileId,8);
+  header[1]=nDim;
+  for (unsigned int iDim=0; iDim<8; iDim++) header[2+iDim]=(iDim<nDim ? dim[iDim] : 1);
+  header[10]=(Cmplx ? 1 : 0);
+  header[11]=headerSize;
+  header[12]=(Cmplx ? headerSize+nByte : 0);
+
+  Re=(double*)((char*)map+headerSize);
+  Im=(Cmplx ? Re+n : 0);
+  return map;
+}
+
+//==============================================================================
+void bemmatFileClose(void* const map, const uint64& mapSize)
+//==============================================================================
+{
+#ifdef _WIN32
+  FlushViewOfFile(map,0);
+  UnmapViewOfFile(map);
+#else
+  msync(map,(size_t)mapSize,MS_SYNC);
+  munmap(map,(size_t)mapSize);
+#endif
+}
+
+//==============================================================================
+void bemmatFileSlice(const char* const fileName, const uint64& iSlice,
+                     unsigned int& nDim, uint64* const dim,
+                     const double*& Re, const double*& Im,
+                     void** const map, uint64* const mapSize)
+//==============================================================================
+{
+  // HEADER
+  uint64* const header=(uint64*)mapFile(fileName,false,0,0,headerSize);
+  const bool validId=(memcmp(header,fileId,8)==0);
+  nDim=(unsigned int)header[1];
+  for (unsigned int iDim=0; iDim<8; iDim++) dim[iDim]=header[2+iDim];
+  const bool Cmplx=(header[10]!=0);
+  const uint64 offset[2]={header[11],header[12]};
+  bemmatFileClose(header,headerSize);
+  if (!validId) throw("Invalid boundary element matrix file.");
+
+  uint64 nSlice=1;
+  for (unsigned int iDim=2; iDim<8; iDim++) nSlice*=dim[iDim];
+  if (!(iSlice<nSlice)) throw("Slice number exceeds the number of slices.");
+  const uint64 nSliceByte=8*dim[0]*dim[1];
+  if (nSliceByte==0) throw("The boundary element matrix file is empty.");
+
+  // REAL AND IMAGINARY PART OF THE SLICE
+  map[1]=0;
+  mapSize[1]=0;
+  Im=0;
+  for (unsigned int iPart=0; iPart<(Cmplx ? 2u : 1u); iPart++)
+  {
+    const uint64 sliceOffset=offset[iPart]+iSlice*nSliceByte;
+    const uint64 mapOffset=sliceOffset-sliceOffset%mapAlign;
+    mapSize[iPart]=sliceOffset-mapOffset+nSliceByte;
+    try
+    {
+      map[iPart]=mapFile(fileName,false,0,mapOffset,mapSize[iPart]);
+    }
+    catch (const char*)
+    {
+      if (iPart==1) bemmatFileClose(map[0],mapSize[0]);
+      throw;
+    }
+    const double* const part=(const double*)((const char*)map[iPart]+(sliceOffset-mapOffset));
+    if (iPart==0) Re=part;
+    else Im=part;
+  }
+}
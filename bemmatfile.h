@@ -0,0 +1,58 @@
+#ifndef _BEMMATFILECREATE_
+#define _BEMMATFILECREATE_
+void* bemmatFileCreate(const char* const fileName, const unsigned int& nDim,
+                       const size_t* const dim, const bool& Cmplx,
+                       double*& Re, double*& Im, unsigned long long& mapSize);
+/*   Create a boundary element matrix file and map it into memory.
+ *   fileName  File name.
+ *   nDim      Number of dimensions (at most 8).
+ *   dim       Dimensions (nDim), e.g. (nDof * nDof * nFreq).
+ *   Cmplx     True if the imaginary part is stored.
+ *   Re        Real part, mapped into the file and initialized to zero.
+ *   Im        Imaginary part, mapped into the file, or 0 if not Cmplx.
+ *   mapSize   Size of the mapping in bytes.
+ *   Returns the mapping, to be released with bemmatFileClose.
+ *
+ *   The file consists of a header of 4096 bytes, followed by the real part
+ *   and, if complex, the imaginary part of the array, in column major order
+ *   as double precision values. The header contains 64 bit integers:
+ *     [0]      File identifier 'BEMMAT01'.
+ *     [1]      Number of dimensions nDim.
+ *     [2..9]   Dimensions, padded with ones.
+ *     [10]     Complex flag.
+ *     [11]     Byte offset of the real part (4096).
+ *     [12]     Byte offset of the imaginary part, or zero.
+ *   All values are stored in the byte order of the machine that created
+ *   the file.
+ */
+#endif
+
+#ifndef _BEMMATFILECLOSE_
+#define _BEMMATFILECLOSE_
+void bemmatFileClose(void* const map, const unsigned long long& mapSize);
+/*   Flush a mapping of a boundary element matrix file to disk and unmap it.
+ *   map       Mapping returned by bemmatFileCreate or bemmatFileSlice.
+ *   mapSize   Size of the mapping in bytes.
+ */
+#endif
+
+#ifndef _BEMMATFILESLICE_
+#define _BEMMATFILESLICE_
+void bemmatFileSlice(const char* const fileName, const unsigned long long& iSlice,
+                     unsigned int& nDim, unsigned long long* const dim,
+                     const double*& Re, const double*& Im,
+                     void** const map, unsigned long long* const mapSize);
+/*   Map a single slice A(:,:,iSlice) of a boundary element matrix file into
+ *   memory, without copying. Only the pages of the slice are mapped.
+ *   fileName  File name.
+ *   iSlice    Slice number (zero based), counted over all dimensions
+ *             beyond the second one.
+ *   nDim      Number of dimensions of the stored array.
+ *   dim       Dimensions of the stored array (8).
+ *   Re        Real part of the slice (dim[0] * dim[1]).
+ *   Im        Imaginary part of the slice, or 0 if the file is real.
+ *   map       Mappings of the real and imaginary part (2), to be released
+ *             with bemmatFileClose. The second mapping is 0 for a real file.
+ *   mapSize   Sizes of the mappings in bytes (2).
+ */
+#endif
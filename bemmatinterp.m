@@ -0,0 +1,190 @@
+function [A,B]=bemmatinterp(varargin)
+%BEMMATINTERP   Frequency interpolation of boundary element system matrices.
+%
+%   S = BEMMATINTERP(nod,elt,typ,tol,green,...,omega) computes the boundary
+%   element system matrices at a set of anchor frequencies in the range of
+%   omega and returns an interpolant S for the full frequency range. The
+%   matrices are demodulated before interpolation: the oscillating phase
+%   exp(-i*omega*r/Cs), with r the distance between the collocation points,
+%   is factored out, so that the remaining functions vary smoothly with the
+%   frequency. The anchors are refined adaptively: the matrices are computed
+%   at the midpoints of the intervals between the anchors and compared with
+%   the interpolated matrices; intervals where the relative error exceeds tol
+%   are bisected until the interpolation error is below tol everywhere, or
+%   until an interval has been bisected 20 times, in which case a warning
+%   is issued.
+%
+%   The hysteretic damping of the Green's functions changes sign at
+%   omega=0, so that the matrices are discontinuous there. The negative and
+%   positive frequencies are therefore interpolated separately, each over
+%   the range of the requested frequencies of that sign, and the matrices
+%   at omega=0 are computed directly if omega contains 0.
+%
+%   [U,T] = BEMMATINTERP(S,omega) reconstructs the system matrices at the
+%   frequencies omega. The frequencies must lie within the range of the
+%   anchors of the same sign; an error is issued otherwise, as the spline
+%   is not extrapolated.
+%
+%   The following Green's functions are supported:
+%
+%   S = BEMMATINTERP(nod,elt,typ,tol,'fsgreen3d',Cs,Cp,Ds,Dp,rho,omega)
+%   S = BEMMATINTERP(nod,elt,typ,tol,'fsgreen2d_inplane',Cs,Cp,Ds,Dp,rho,omega)
+%   S = BEMMATINTERP(nod,elt,typ,tol,'fsgreen2d_outofplane',Cs,Ds,rho,omega)
+%
+%   nod    Nodes.
+%   elt    Elements.
+%   typ    Element types.
+%   tol    Relative interpolation tolerance (1 * 1) or [tol nInit] (1 * 2),
+%          where nInit is the initial number of equidistant anchors
+%          (default 5).
+%   green  Green's function (string), see BEMMAT.
+%   omega  Circular frequencies (nFreq * 1).
+%   S      Interpolant (struct) with fields omega (anchor frequencies), U and
+%          T (demodulated matrices at the anchors), R (collocation point
+%          distances), Cs (shear wave velocity) and err (estimated
+%          interpolation error per refinement step).
+%   U      Boundary element displacement system matrix (nDof * nDof * nFreq).
+%   T      Boundary element traction system matrix (nDof * nDof * nFreq).
+%
+%   See also BEMMAT.
+
+% CHECK BEMFUN LICENSE
+bemfunlicense('VerifyOnce');
+
+% EVALUATION OF AN EXISTING INTERPOLANT
+if isstruct(varargin{1})
+  [A,B]=evaluate(varargin{1},varargin{2}(:));
+  return
+end
+
+% INPUT ARGUMENT PROCESSING
+if nargin<7, error('Not enough input arguments.'); end
+nod=varargin{1};
+elt=varargin{2};
+typ=varargin{3};
+tol=varargin{4};
+green=varargin{5};
+par=varargin(6:end-1);
+omega=varargin{end}(:);
+if ~any(strcmpi(green,{'fsgreen3d','fsgreen2d_inplane','fsgreen2d_outofplane'}))
+  error('Unsupported Green''s function for input argument ''green''.');
+end
+nInit=5;
+if length(tol)>1, nInit=max(round(tol(2)),2); end
+tol=tol(1);
+Cs=par{1};
+
+% COLLOCATION POINT DISTANCES
+col=bemcollpoints(nod,elt,typ);
+nCol=size(col,1);
+R=zeros(nCol,nCol);
+for iDim=1:3
+  R=R+(repmat(col(:,iDim),1,nCol)-repmat(col(:,iDim).',nCol,1)).^2;
+end
+R=sqrt(R);
+
+% INITIAL ANCHORS: nInit PER SIGN OF THE FREQUENCY, AND omega=0 ITSELF
+bemmat(nod,elt,typ);
+wa=zeros(0,1);
+for sgn=[-1 0 1]
+  ws=omega(sign(omega)==sgn);
+  if isempty(ws), continue; end
+  if min(ws)==max(ws)
+    wa=[wa; ws(1)];
+  else
+    wa=[wa; linspace(min(ws),max(ws),nInit).'];
+  end
+end
+[Ua,Ta]=bemmat(green,par{:},wa);
+nColDof=size(Ua,1)/nCol;
+Rdof=kron(R,ones(nColDof));
+[Ua,Ta]=demodulate(Ua,Ta,wa,Rdof,Cs,1);
+
+% ADAPTIVE REFINEMENT OF THE INTERVALS BETWEEN ANCHORS OF THE SAME SIGN
+maxLevel=20;
+err=[];
+nFail=0;
+sa=sign(wa);
+ind=find((sa(1:end-1)==sa(2:end)) & (sa(1:end-1)~=0));
+interval=[wa(ind) wa(ind+1)];
+level=zeros(size(interval,1),1);
+while ~isempty(interval)
+  wm=mean(interval,2);
+  [Um,Tm]=bemmat(green,par{:},wm);
+  [Um,Tm]=demodulate(Um,Tm,wm,Rdof,Cs,1);
+  Ui=interpolate(wa,Ua,wm);
+  Ti=interpolate(wa,Ta,wm);
+  errm=zeros(length(wm),1);
+  for iFreq=1:length(wm)
+    errU=norm(Ui(:,:,iFreq)-Um(:,:,iFreq),'fro')/max(norm(Um(:,:,iFreq),'fro'),realmin);
+    errT=norm(Ti(:,:,iFreq)-Tm(:,:,iFreq),'fro')/max(norm(Tm(:,:,iFreq),'fro'),realmin);
+    errm(iFreq)=max(errU,errT);
+  end
+  err=[err; max(errm)];
+
+  % The midpoints are added to the anchors; intervals that do not meet the
+  % tolerance are bisected and checked again, up to maxLevel times.
+  [wa,ind]=sort([wa; wm]);
+  Ua=cat(3,Ua,Um);
+  Ua=Ua(:,:,ind);
+  Ta=cat(3,Ta,Tm);
+  Ta=Ta(:,:,ind);
+  refine=(errm>tol) & (level<maxLevel);
+  nFail=nFail+sum((errm>tol) & ~refine);
+  interval=[interval(refine,1) wm(refine); wm(refine) interval(refine,2)];
+  level=[level(refine)+1; level(refine)+1];
+end
+if nFail>0
+  warning('BEMMATINTERP:tol',['The tolerance is not met in %d intervals after ' ...
+          '%d bisections.'],nFail,maxLevel);
+end
+
+A.omega=wa;
+A.U=Ua;
+A.T=Ta;
+A.R=R;
+A.Cs=Cs;
+A.err=err;
+
+%-------------------------------------------------------------------------------
+function [U,T]=evaluate(S,omega)
+U=interpolate(S.omega,S.U,omega);
+T=interpolate(S.omega,S.T,omega);
+nColDof=size(U,1)/size(S.R,1);
+[U,T]=demodulate(U,T,omega,kron(S.R,ones(nColDof)),S.Cs,-1);
+
+%-------------------------------------------------------------------------------
+function [U,T]=demodulate(U,T,omega,R,Cs,sgn)
+% Multiply by exp(sgn*i*omega*R/Cs): sgn=1 removes the phase of the shear
+% waves, sgn=-1 restores it.
+for iFreq=1:length(omega)
+  P=exp(sgn*1i*omega(iFreq)*R/Cs);
+  U(:,:,iFreq)=U(:,:,iFreq).*P;
+  T(:,:,iFreq)=T(:,:,iFreq).*P;
+end
+
+%-------------------------------------------------------------------------------
+function Ai=interpolate(w,A,wi)
+% Cubic spline interpolation of A(:,:,k) sampled at w(k). The negative and
+% positive frequencies are interpolated separately; omega=0 must be sampled.
+% Frequencies outside the range of the samples of the same sign are refused.
+[m,n,nw]=size(A);
+Ai=zeros(m,n,length(wi));
+for sgn=[-1 0 1]
+  iw=find(sign(wi)==sgn);
+  if isempty(iw), continue; end
+  ia=find(sign(w)==sgn);
+  out=[];
+  if ~isempty(ia)
+    out=find((wi(iw)<min(w(ia))) | (wi(iw)>max(w(ia))),1);
+  end
+  if isempty(ia) || ~isempty(out)
+    if isempty(out), out=1; end
+    error('Frequency %g is outside the range of the interpolant.',wi(iw(out)));
+  elseif length(ia)==1
+    Ai(:,:,iw)=repmat(A(:,:,ia),[1 1 length(iw)]);
+  else
+    As=interp1(w(ia),reshape(A(:,:,ia),m*n,length(ia)).',wi(iw),'spline');
+    Ai(:,:,iw)=reshape(As.',m,n,length(iw));
+  end
+end
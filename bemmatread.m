@@ -0,0 +1,56 @@
+function A=bemmatread(file,k)
+%BEMMATREAD   Read boundary element system matrices from a BEMMAT file.
+%
+%   A = BEMMATREAD(file,k) reads the slice A(:,:,k) of a system matrix that
+%   has been written to a file by BEMMAT('file',...). Only this slice is read
+%   into memory. For frequency domain matrices, k is the frequency number.
+%
+%   m = BEMMATREAD(file) maps the complete file into memory without copying
+%   it. m is a memmapfile object; the real and imaginary part of the system
+%   matrix are accessed as m.Data.re and m.Data.im, e.g. m.Data.re(:,:,k).
+%
+%   file  File name (string).
+%   k     Slice number, counted over all dimensions beyond the second one.
+%   A     Slice of the system matrix (nDof * nDof).
+%   m     Memory map of the system matrix.
+%
+%   See bemmatfile.h for the file layout.
+
+% CHECK BEMFUN LICENSE
+bemfunlicense('VerifyOnce');
+
+% READ HEADER
+fid=fopen(file,'r');
+if fid<0, error('Unable to open the boundary element matrix file.'); end
+id=fread(fid,[1 8],'*char');
+header=fread(fid,12,'uint64');
+fclose(fid);
+if ~strcmp(id,'BEMMAT01') || length(header)<12
+  error('Invalid boundary element matrix file.');
+end
+nDim=header(1);
+dim=header(2:1+nDim).';
+cmplx=(header(10)~=0);
+offsetRe=header(11);
+offsetIm=header(12);
+
+% MAP COMPLETE FILE
+if nargin<2
+  format={'double',dim,'re'};
+  if cmplx, format(2,:)={'double',dim,'im'}; end
+  A=memmapfile(file,'Offset',offsetRe,'Format',format,'Repeat',1);
+  return
+end
+
+% READ SINGLE SLICE
+nSlice=prod(dim(3:end));
+if (k<1) || (k>nSlice) || (k~=round(k))
+  error('Slice number exceeds the number of slices.');
+end
+nByte=8*dim(1)*dim(2);
+m=memmapfile(file,'Offset',offsetRe+nByte*(k-1),'Format',{'double',dim(1:2),'re'},'Repeat',1);
+A=m.Data.re;
+if cmplx
+  m=memmapfile(file,'Offset',offsetIm+nByte*(k-1),'Format',{'double',dim(1:2),'im'},'Repeat',1);
+  A=complex(A,m.Data.im);
+end
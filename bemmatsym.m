@@ -0,0 +1,150 @@
+function [U,T,sgn]=bemmatsym(nod,elt,typ,sym,varargin)
+%BEMMATSYM   Boundary element system matrices of mirror symmetric models.
+%
+%   [U,T,sgn] = BEMMATSYM(nod,elt,typ,sym,green,...) computes the reduced
+%   boundary element system matrices of a 3D model that is symmetric with
+%   respect to one or two of the coordinate planes. Only the part of the mesh
+%   on one side of the symmetry planes is given; the complete mesh consists
+%   of this part and its mirror images. The displacements and tractions of
+%   the complete model are decomposed into parts that are symmetric or
+%   antisymmetric with respect to each plane. These parts are decoupled: for
+%   each combination of symmetry and antisymmetry, the reduced matrices
+%   relate the displacements and tractions on the given part of the mesh:
+%
+%     U(:,:,k) = sum over the images g of   f_kg * U_g * Q_g
+%
+%   where U_g is the influence of the image g on the given part, Q_g the
+%   reflection of the displacement components and f_kg = -1 if g is mirrored
+%   an odd number of times in a plane that is antisymmetric in combination
+%   k, and 1 otherwise. As the Green's function is invariant under the
+%   reflections, the influence of the image g on the given part follows from
+%   the influence of the given part on the image g of the collocation points:
+%
+%     U_g(x,y) = P_g * U(R_g x,y) * P_g
+%
+%   where R_g is the reflection of the coordinates and P_g the reflection of
+%   the components. Only the elements of the given part are therefore
+%   integrated, against the collocation points of the given part and their
+%   images, with BEMMAT(nod,elt,typ,s,green,...) on the complete mesh. The
+%   work and storage are reduced by a factor 2 (one plane) or 4 (two planes)
+%   compared to the complete model, and the elements of the images are not
+%   integrated.
+%
+%   The symmetry planes must not contain collocation points of the mesh.
+%
+%   nod    Nodes of the part of the mesh.
+%   elt    Elements of the part of the mesh.
+%   typ    Element types.
+%   sym    Symmetry planes (1 * nPlane): 1 for the plane x=0, 2 for the plane
+%          y=0 and 3 for the plane z=0. For a user specified Green's function,
+%          only vertical planes are allowed.
+%   green  Green's function and its parameters, see BEMMAT.
+%   U      Reduced displacement system matrices
+%          (nDof * nDof * 2^nPlane * ...).
+%   T      Reduced traction system matrices (nDof * nDof * 2^nPlane * ...).
+%   sgn    Symmetry (1) or antisymmetry (-1) with respect to each plane for
+%          each combination (2^nPlane * nPlane).
+%
+%   See also BEMMAT, BEMELTREVERSE.
+
+% CHECK BEMFUN LICENSE
+bemfunlicense('VerifyOnce');
+
+% INPUT ARGUMENT PROCESSING
+if nargin<5, error('Not enough input arguments.'); end
+sym=unique(sym(:).');
+if isempty(sym) || (length(sym)>2) || any(~ismember(sym,1:3))
+  error('Input argument ''sym'' should contain one or two of the planes 1, 2 and 3.');
+end
+if strcmpi(varargin{1},'user') && any(sym==3)
+  error('Only vertical symmetry planes are allowed for a user specified Green''s function.');
+end
+if (bemdimension(elt,typ)~=3) || bemisaxisym(elt,typ)
+  error('Mirror symmetry is only available for 3D models.');
+end
+TmatOut=(nargout>1);
+nPlane=length(sym);
+nImage=2^nPlane;
+
+% IMAGES
+% Image g is mirrored in plane sym(iPlane) if bit iPlane of g is set. An
+% odd number of reflections reverses the orientation of the elements.
+nodOffset=max(nod(:,1));
+eltOffset=max(elt(:,1));
+refl=ones(nImage,3);
+nodFull=nod;
+eltFull=elt;
+for g=1:nImage-1
+  nodg=nod;
+  eltg=elt;
+  for iPlane=find(bitget(g,1:nPlane))
+    nodg(:,1+sym(iPlane))=-nodg(:,1+sym(iPlane));
+    refl(g+1,sym(iPlane))=-1;
+  end
+  nodg(:,1)=nodg(:,1)+g*nodOffset;
+  eltg(:,1)=eltg(:,1)+g*eltOffset;
+  eltNod=eltg(:,3:end);
+  eltNod(eltNod>0)=eltNod(eltNod>0)+g*nodOffset;
+  eltg(:,3:end)=eltNod;
+  if mod(sum(bitget(g,1:nPlane)),2), eltg=bemeltreverse(eltg,typ); end
+  nodFull=[nodFull; nodg];
+  eltFull=[eltFull; eltg];
+end
+
+% COLLOCATION POINTS
+[col,colTyp,colID]=bemcollpoints(nodFull,eltFull,typ);
+offset=eltOffset*(colTyp==1)+nodOffset*(colTyp==2);
+iCol=find(colID<=offset);
+nCol=length(iCol);
+tol=1e-9*max(max(abs(nod(:,2:4))));
+if any(any(abs(col(iCol,sym))<=tol))
+  error('The symmetry planes must not contain collocation points.');
+end
+nColDof=3;
+nDof=nColDof*size(col,1);
+dof=reshape(repmat(nColDof*(iCol(:).'-1),nColDof,1)+repmat((1:nColDof).',1,nCol),[],1);
+imageDof=zeros(nColDof*nCol,nImage);
+for g=0:nImage-1
+  [found,iColg]=ismember([colTyp(iCol) colID(iCol)+g*offset(iCol)],[colTyp colID],'rows');
+  if ~all(found), error('Collocation points of the mirror images not found.'); end
+  imageDof(:,g+1)=reshape(repmat(nColDof*(iColg(:).'-1),nColDof,1)+repmat((1:nColDof).',1,nCol),[],1);
+end
+
+% INFLUENCE OF THE GIVEN PART ON ALL IMAGES OF ITS COLLOCATION POINTS
+% The complete mesh is used for the regularisation of the singular traction
+% integrals; only the elements of the given part are integrated.
+bemmat(nodFull,eltFull,typ);
+s=repmat(imageDof(:),1,length(dof))+repmat((dof(:).'-1)*nDof,numel(imageDof),1);
+if TmatOut
+  [Uf,Tf]=bemmat(s,varargin{:});
+else
+  Uf=bemmat(s,varargin{:});
+end
+dim=size(Uf);
+
+% SYMMETRIC AND ANTISYMMETRIC COMBINATIONS
+sgn=1-2*reshape(bitget(repmat((0:nImage-1).',1,nPlane),repmat(1:nPlane,nImage,1)),nImage,nPlane);
+U=reduce(Uf,imageDof,refl,sgn,dim);
+if TmatOut
+  T=reduce(Tf,imageDof,refl,sgn,dim);
+end
+
+%-------------------------------------------------------------------------------
+function Ar=reduce(A,imageDof,refl,sgn,dim)
+% Row block g of A is the influence of the given part on the image g of the
+% collocation points. The reflection P_g of the columns cancels against the
+% reflection of the displacement components of the image.
+[nDof,nImage]=size(imageDof);
+nPlane=size(sgn,2);
+nSlice=prod(dim(3:end));
+A=A(:,:,:);
+Ar=zeros(nDof,nDof,nImage,nSlice);
+for g=0:nImage-1
+  Q=repmat(refl(g+1,:).',nDof/3,1);
+  Ag=A(g*nDof+(1:nDof),:,:).*repmat(Q,[1 nDof nSlice]);
+  for k=1:nImage
+    f=prod(sgn(k,logical(bitget(g,1:nPlane))));
+    Ar(:,:,k,:)=Ar(:,:,k,:)+f*reshape(Ag,[nDof nDof 1 nSlice]);
+  end
+end
+Ar=reshape(Ar,[nDof nDof nImage dim(3:end)]);
@@ -0,0 +1,150 @@
+function [U,T]=bemmatupdate(nod0,elt0,typ0,U,T,nod,elt,typ,varargin)
+%BEMMATUPDATE   Incremental update of boundary element system matrices.
+%
+%   [U,T] = BEMMATUPDATE(nod0,elt0,typ0,U0,T0,nod,elt,typ,green,...) updates
+%   the boundary element system matrices U0 and T0, computed by BEMMAT for
+%   the mesh (nod0,elt0,typ0), to the modified mesh (nod,elt,typ). Only the
+%   entries that are affected by the modification are recomputed:
+%
+%   - the columns of the collocation points with an added, removed or
+%     modified element in their support,
+%   - the rows of the collocation points that are added or moved,
+%   - the diagonal blocks of T of the other collocation points, as these
+%     contain the integral of the static traction kernel over the complete
+%     boundary that regularises the singular integrals.
+%
+%   All other entries are copied from U0 and T0. The recomputed entries are
+%   obtained with BEMMAT(nod,elt,typ,s,green,...), so that the result is
+%   equal to a complete assembly on the modified mesh. If the collocation
+%   points are unchanged and the function is called as
+%   [U,T] = BEMMATUPDATE(...,U,T,...), the matrices are patched in place.
+%
+%   nod0   Nodes of the original mesh.
+%   elt0   Elements of the original mesh.
+%   typ0   Element types of the original mesh.
+%   U0     Original displacement system matrix (nDof0 * nDof0 * ...).
+%   T0     Original traction system matrix (nDof0 * nDof0 * ...), or empty
+%          if only U is updated.
+%   nod    Nodes of the modified mesh.
+%   elt    Elements of the modified mesh.
+%   typ    Element types of the modified mesh, equal to typ0.
+%   green  Green's function and its parameters, see BEMMAT.
+%   U      Updated displacement system matrix (nDof * nDof * ...).
+%   T      Updated traction system matrix (nDof * nDof * ...).
+%
+%   See also BEMMAT.
+
+% CHECK BEMFUN LICENSE
+bemfunlicense('VerifyOnce');
+
+if nargin<9, error('Not enough input arguments.'); end
+if ~isequal(typ0,typ)
+  error('The element types of the original and modified mesh must be equal.');
+end
+TmatOut=(nargout>1);
+
+% COLLOCATION POINTS
+[col0,colTyp0,colID0]=bemcollpoints(nod0,elt0,typ0);
+[col,colTyp,colID]=bemcollpoints(nod,elt,typ);
+nCol0=size(col0,1);
+nCol=size(col,1);
+nColDof=size(U,1)/nCol0;
+nDof=nColDof*nCol;
+
+% MODIFIED ELEMENTS
+eltChange0=modified(nod0,elt0,nod,elt);
+eltChange=modified(nod,elt,nod0,elt0);
+eltID=[elt0(eltChange0,1); elt(eltChange,1)];
+nodID=[reshape(elt0(eltChange0,3:end),[],1); reshape(elt(eltChange,3:end),[],1)];
+
+% AFFECTED COLLOCATION POINTS
+% New or moved collocation points have new rows and columns; the columns of
+% the other collocation points are affected if their support is modified.
+[match,iCol0]=ismember([colTyp colID col],[colTyp0 colID0 col0],'rows');
+rowAff=~match;
+colAff=rowAff | ((colTyp==1) & ismember(colID,eltID)) ...
+               | ((colTyp==2) & ismember(colID,nodID));
+
+% COPY UNAFFECTED ENTRIES
+if ~((nCol==nCol0) && all(iCol0==(1:nCol).'))
+  keep=find(match);
+  dim=size(U);
+  U1=zeros([nDof nDof dim(3:end)]);
+  U1(dofs(keep,nColDof),dofs(keep,nColDof),:)=U(dofs(iCol0(keep),nColDof),dofs(iCol0(keep),nColDof),:);
+  U=U1;
+  clear U1;
+  if TmatOut
+    T1=zeros([nDof nDof dim(3:end)]);
+    T1(dofs(keep,nColDof),dofs(keep,nColDof),:)=T(dofs(iCol0(keep),nColDof),dofs(iCol0(keep),nColDof),:);
+    T=T1;
+    clear T1;
+  end
+end
+if ~any(colAff) && ~any(eltChange0) && ~any(eltChange), return; end
+
+% RECOMPUTE AFFECTED ENTRIES ON THE CACHED MESH
+bemmat(nod,elt,typ);
+iColAff=find(colAff);
+iRowAff=find(rowAff);
+iColKeep=find(~colAff);
+if ~isempty(iColAff)
+  [U,T]=patch(U,T,TmatOut,(1:nCol).',iColAff,nColDof,nDof,varargin);
+end
+if ~isempty(iRowAff) && ~isempty(iColKeep)
+  [U,T]=patch(U,T,TmatOut,iRowAff,iColKeep,nColDof,nDof,varargin);
+end
+if TmatOut && ~isempty(iColKeep)
+  T=patchdiag(T,iColKeep,nColDof,nDof,varargin);
+end
+
+%-------------------------------------------------------------------------------
+function change=modified(nodA,eltA,nodB,eltB)
+% Elements of mesh A that are absent from mesh B or differ in type, nodes or
+% nodal coordinates.
+nColumn=max(size(eltA,2),size(eltB,2));
+eltA(isnan(eltA))=0;
+eltB(isnan(eltB))=0;
+eltA(:,end+1:nColumn)=0;
+eltB(:,end+1:nColumn)=0;
+[found,iB]=ismember(eltA(:,1),eltB(:,1));
+change=~found;
+change(found)=any(eltA(found,2:end)~=eltB(iB(found),2:end),2);
+[found,iB]=ismember(nodA(:,1),nodB(:,1));
+moved=true(size(nodA,1),1);
+moved(found)=any(nodA(found,2:4)~=nodB(iB(found),2:4),2);
+change=change | any(ismember(eltA(:,3:end),nodA(moved,1)),2);
+
+%-------------------------------------------------------------------------------
+function [U,T]=patch(U,T,TmatOut,iRow,iCol,nColDof,nDof,green)
+% Recompute the block of the collocation points iRow and iCol.
+row=dofs(iRow,nColDof);
+col=dofs(iCol,nColDof);
+s=repmat(row,1,length(col))+repmat((col.'-1)*nDof,length(row),1);
+if TmatOut
+  [Ue,Te]=bemmat(s,green{:});
+  T(row,col,:)=Te(:,:,:);
+else
+  Ue=bemmat(s,green{:});
+end
+U(row,col,:)=Ue(:,:,:);
+
+%-------------------------------------------------------------------------------
+function T=patchdiag(T,iCol,nColDof,nDof,green)
+% Recompute the diagonal blocks of T of the collocation points iCol in a
+% single call of BEMMAT, so that the regularisation over the boundary is
+% evaluated once. Block k is s(:,(k-1)*nColDof+(1:nColDof)).
+dof=reshape(dofs(iCol,nColDof),nColDof,[]);
+rowInd=kron(dof,ones(1,nColDof));
+colInd=repmat(reshape(dof,1,[]),nColDof,1);
+s=rowInd+(colInd-1)*nDof;
+[Ue,Te]=bemmat(s,green{:});
+dim=size(T);
+T=reshape(T,nDof*nDof,[]);
+T(s(:),:)=reshape(Te,numel(s),[]);
+T=reshape(T,dim);
+
+%-------------------------------------------------------------------------------
+function dof=dofs(iCol,nColDof)
+% Degrees of freedom of the collocation points iCol.
+dof=repmat((1:nColDof).',1,length(iCol))+nColDof*repmat(iCol(:).'-1,nColDof,1);
+dof=dof(:);
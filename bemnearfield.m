@@ -0,0 +1,123 @@
+function [Un,Tn]=bemnearfield(nod,elt,typ,radius,varargin)
+%BEMNEARFIELD   Near field part of boundary element system matrices.
+%
+%   [Un,Tn] = BEMNEARFIELD(nod,elt,typ,radius,green,...) computes the
+%   entries of the boundary element system matrices for the pairs of
+%   collocation points that are close to each other, and returns them as
+%   sparse matrices. The collocation points are sorted in cubic boxes of size
+%   radius; the near field consists of the pairs of collocation points in the
+%   same or in adjacent boxes, which includes all pairs at a distance smaller
+%   than radius. The near field contains the singular and nearly singular
+%   entries that dominate the system matrices and is a suitable basis for a
+%   preconditioner, see BEMPRECOND. The mesh is cached by BEMMAT once and
+%   the entries are computed box by box with BEMMAT(s,green,...), so that
+%   they are equal to the corresponding entries of the complete matrices.
+%   The adjacent boxes are found by a lookup of the box keys in their sorted
+%   list.
+%
+%   [Un,Tn] = BEMNEARFIELD(nod,elt,typ,radius,opt,val,...,green,...) passes
+%   the leading options 'interp', 'interpzs', 'memo' and 'sweep' with their
+%   values to BEMMAT, e.g.
+%   BEMNEARFIELD(nod,elt,typ,radius,'interp','spline','user',...).
+%
+%   nod     Nodes.
+%   elt     Elements.
+%   typ     Element types.
+%   radius  Near field radius (1 * 1).
+%   opt     BEMMAT option (string).
+%   val     Value of the BEMMAT option.
+%   green   Green's function and its parameters, see BEMMAT.
+%   Un      Near field displacement system matrix, sparse (nDof * nDof), or
+%           a cell array of sparse matrices (nSlice * 1) if the system
+%           matrices have more than two dimensions, e.g. for multiple
+%           frequencies.
+%   Tn      Near field traction system matrix, in the same format as Un.
+%
+%   See also BEMMAT, BEMPRECOND, BEMSOLVE.
+
+% CHECK BEMFUN LICENSE
+bemfunlicense('VerifyOnce');
+
+if nargin<5, error('Not enough input arguments.'); end
+if ~(isscalar(radius) && (radius>0))
+  error('Input argument ''radius'' should be a positive scalar.');
+end
+TmatOut=(nargout>1);
+
+% LEADING BEMMAT OPTIONS
+opts={};
+while ~isempty(varargin) && ischar(varargin{1}) ...
+      && any(strcmpi(varargin{1},{'interp','interpzs','memo','sweep'}))
+  if length(varargin)<3, error('Not enough input arguments.'); end
+  opts=[opts varargin(1:2)];
+  varargin=varargin(3:end);
+end
+
+% BOXES
+col=bemcollpoints(nod,elt,typ);
+nCol=size(col,1);
+key=floor((col-repmat(min(col,[],1),nCol,1))/radius);
+[boxKey,dummy,colBox]=unique(key,'rows');
+nBox=size(boxKey,1);
+[colBox,colSort]=sort(colBox);
+boxBeg=[find([true; diff(colBox)>0]); nCol+1];
+
+% ADJACENT BOXES
+% The keys of the boxes are sorted by UNIQUE, so that every shifted key is
+% looked up by ISMEMBER in O(nBox*log(nBox)) operations.
+nDim=size(boxKey,2);
+shift=double(dec2base(0:3^nDim-1,3,nDim))-double('1');
+adjBox=zeros(nBox,3^nDim);
+for iShift=1:3^nDim
+  [found,adjBox(:,iShift)]=ismember(boxKey+repmat(shift(iShift,:),nBox,1),boxKey,'rows');
+end
+
+% DEGREES OF FREEDOM PER COLLOCATION POINT
+nColDof=coldof(elt,typ,varargin);
+nDof=nColDof*nCol;
+bemmat(nod,elt,typ);
+
+% NEAR FIELD ENTRIES PER BOX
+I=cell(nBox,1);
+J=cell(nBox,1);
+VU=cell(nBox,1);
+VT=cell(nBox,1);
+for iBox=1:nBox
+  row=sort(colSort(boxBeg(iBox):boxBeg(iBox+1)-1));
+  adj=adjBox(iBox,adjBox(iBox,:)>0);
+  near=[];
+  for jBox=adj
+    near=[near; colSort(boxBeg(jBox):boxBeg(jBox+1)-1)];
+  end
+  near=sort(near);
+  rowDof=reshape(repmat(nColDof*(row(:).'-1),nColDof,1)+repmat((1:nColDof).',1,length(row)),[],1);
+  colDof=reshape(repmat(nColDof*(near(:).'-1),nColDof,1)+repmat((1:nColDof).',1,length(near)),[],1);
+  s=repmat(rowDof,1,length(colDof))+repmat((colDof.'-1)*nDof,length(rowDof),1);
+  if TmatOut
+    [Ue,Te]=bemmat(opts{:},s,varargin{:});
+    VT{iBox}=reshape(Te,numel(s),[]);
+  else
+    Ue=bemmat(opts{:},s,varargin{:});
+  end
+  VU{iBox}=reshape(Ue,numel(s),[]);
+  I{iBox}=reshape(repmat(rowDof,1,length(colDof)),[],1);
+  J{iBox}=reshape(repmat(colDof.',length(rowDof),1),[],1);
+end
+I=cat(1,I{:});
+J=cat(1,J{:});
+Un=sparseslices(I,J,cat(1,VU{:}),nDof);
+if TmatOut
+  Tn=sparseslices(I,J,cat(1,VT{:}),nDof);
+end
+
+%-------------------------------------------------------------------------------
+function A=sparseslices(I,J,V,nDof)
+nSlice=size(V,2);
+if nSlice==1
+  A=sparse(I,J,V,nDof,nDof);
+  return
+end
+A=cell(nSlice,1);
+for iSlice=1:nSlice
+  A{iSlice}=sparse(I,J,V(:,iSlice),nDof,nDof);
+end
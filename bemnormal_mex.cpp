@@ -12,7 +12,7 @@
  */
 
 /* $Make: mex -O -output bemnormal bemnormal_mex.cpp eltdef.cpp shapefun.cpp 
-                         bemnormal.cpp bemcollpoints.cpp $ */                                                                  
+                         bemnormal.cpp bemcollpoints.cpp pointgrid.cpp $ */                                                                  
 
 #include "mex.h"
 #include <string.h>
@@ -0,0 +1,448 @@
+/*BEMPRECOND   Sparse preconditioner for boundary element equations.
+ *
+ *   BEMPRECOND('init',A) computes the incomplete LU factorization without
+ *   fill-in (ILU(0)) of the sparse matrix A and stores it. A is typically the
+ *   near field part of a boundary element system matrix, as computed by
+ *   BEMNEARFIELD, which contains the singular and nearly singular entries
+ *   that dominate the system matrix.
+ *   BEMPRECOND('init',A,'ilu') is the same as BEMPRECOND('init',A).
+ *   BEMPRECOND('init',A,'jacobi') computes the block Jacobi preconditioner,
+ *   i.e. the inverses of the diagonal blocks of A of size 3 * 3.
+ *   BEMPRECOND('init',A,'jacobi',bs) uses diagonal blocks of size bs * bs,
+ *   e.g. the number of degrees of freedom per collocation point.
+ *   Y = BEMPRECOND('apply',X,k) applies the preconditioner of the k-th
+ *   matrix to the vectors X, i.e. computes an approximation of A{k}\X. If a
+ *   single matrix is stored, it is used for all k. The preconditioner can be
+ *   passed to BEMSOLVE as @(x,k) bemprecond('apply',x,k).
+ *   Y = BEMPRECOND('apply',X) is the same as BEMPRECOND('apply',X,1).
+ *   BEMPRECOND('clear') clears the preconditioners.
+ *
+ *   A      Sparse matrix (nDof * nDof), or a cell array of sparse matrices
+ *          (nSet * 1), e.g. for multiple frequencies.
+ *   bs     Block size (1 * 1).
+ *   X      Vectors (nDof * nVec).
+ *   k      Index of the matrix (1 * 1).
+ *   Y      Preconditioned vectors (nDof * nVec).
+ */
+
+/* $Make: mex -O -output bemprecond bemprecond_mex.cpp checklicense.cpp ripemd128.cpp$*/
+
+#include "mex.h"
+#include <string.h>
+#include <math.h>
+#include <complex>
+#include <new>
+#include "checklicense.h"
+
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
+using namespace std;
+
+typedef complex<double> cplx;
+
+//==============================================================================
+// PERSISTENT PRECONDITIONERS
+//==============================================================================
+struct Precond
+{
+  size_t* rowPtr;              // ILU: compressed rows of L and U (n+1)
+  size_t* colIdx;              // Sorted column indices per row (nnz)
+  size_t* diagPtr;             // Position of the diagonal per row (n)
+  cplx* val;                   // L (unit diagonal omitted) and U (nnz), or
+                               // inverted diagonal blocks (bs * bs * nBlk)
+};
+
+static bool PrecondValid=false;
+static bool Jacobi=false;
+static size_t n=0;             // Number of degrees of freedom
+static unsigned int bs=0;      // Block size of the block Jacobi method
+static unsigned int nSet=0;    // Number of preconditioners
+static Precond* P=0;
+
+//==============================================================================
+void cleanup()
+//==============================================================================
+{
+  PrecondValid=false;
+  if (P!=0)
+  {
+    for (unsigned int iSet=0; iSet<nSet; iSet++)
+    {
+      if (P[iSet].rowPtr!=0) delete [] P[iSet].rowPtr;
+      if (P[iSet].colIdx!=0) delete [] P[iSet].colIdx;
+      if (P[iSet].diagPtr!=0) delete [] P[iSet].diagPtr;
+      if (P[iSet].val!=0) delete [] P[iSet].val;
+    }
+    delete [] P;
+    P=0;
+  }
+  Jacobi=false;
+  n=0;
+  bs=0;
+  nSet=0;
+}
+
+//==============================================================================
+void initilu(const mxArray* const A, Precond& p)
+/* Converts the sparse matrix A from compressed columns to compressed rows
+ * and computes its ILU(0) factorization in place. As the columns of A are
+ * traversed in increasing order, the column indices are sorted in every
+ * row. The row k of U is subtracted from row i only at the positions that
+ * are present in row i, which are located with the work array pos.
+ */
+//==============================================================================
+{
+  const mwIndex* const jc=mxGetJc(A);
+  const mwIndex* const ir=mxGetIr(A);
+  const double* const aRe=mxGetPr(A);
+  const double* const aIm=mxGetPi(A);
+  const size_t nnz=jc[n];
+
+  p.rowPtr=new(nothrow) size_t[n+1];
+  if (p.rowPtr==0) throw("Out of memory.");
+  p.colIdx=new(nothrow) size_t[nnz];
+  if (p.colIdx==0) throw("Out of memory.");
+  p.diagPtr=new(nothrow) size_t[n];
+  if (p.diagPtr==0) throw("Out of memory.");
+  p.val=new(nothrow) cplx[nnz];
+  if (p.val==0) throw("Out of memory.");
+
+  // CONVERSION TO COMPRESSED ROWS
+  for (size_t i=0; i<=n; i++) p.rowPtr[i]=0;
+  for (size_t k=0; k<nnz; k++) p.rowPtr[ir[k]+1]++;
+  for (size_t i=0; i<n; i++) p.rowPtr[i+1]+=p.rowPtr[i];
+  for (size_t j=0; j<n; j++)
+  {
+    for (size_t k=jc[j]; k<jc[j+1]; k++)
+    {
+      const size_t pos=p.rowPtr[ir[k]]++;
+      p.colIdx[pos]=j;
+      p.val[pos]=cplx(aRe[k],(aIm==0 ? 0.0 : aIm[k]));
+    }
+  }
+  for (size_t i=n; i>0; i--) p.rowPtr[i]=p.rowPtr[i-1];
+  p.rowPtr[0]=0;
+
+  for (size_t i=0; i<n; i++)
+  {
+    size_t k=p.rowPtr[i];
+    while ((k<p.rowPtr[i+1]) && (p.colIdx[k]<i)) k++;
+    if ((k==p.rowPtr[i+1]) || (p.colIdx[k]!=i)) throw("The diagonal of the matrix must be nonzero.");
+    p.diagPtr[i]=k;
+  }
+
+  // FACTORIZATION
+  size_t* const pos=new(nothrow) size_t[n];
+  if (pos==0) throw("Out of memory.");
+  for (size_t j=0; j<n; j++) pos[j]=nnz;
+  for (size_t i=0; i<n; i++)
+  {
+    for (size_t k=p.rowPtr[i]; k<p.rowPtr[i+1]; k++) pos[p.colIdx[k]]=k;
+    for (size_t k=p.rowPtr[i]; k<p.diagPtr[i]; k++)
+    {
+      const size_t kRow=p.colIdx[k];
+      p.val[k]/=p.val[p.diagPtr[kRow]];
+      const cplx lik=p.val[k];
+      for (size_t m=p.diagPtr[kRow]+1; m<p.rowPtr[kRow+1]; m++)
+      {
+        const size_t im=pos[p.colIdx[m]];
+        if (im!=nnz) p.val[im]-=lik*p.val[m];
+      }
+    }
+    for (size_t k=p.rowPtr[i]; k<p.rowPtr[i+1]; k++) pos[p.colIdx[k]]=nnz;
+    if (abs(p.val[p.diagPtr[i]])==0.0)
+    {
+      delete [] pos;
+      throw("Zero pivot in the incomplete LU factorization.");
+    }
+  }
+  delete [] pos;
+}
+
+//==============================================================================
+void initjacobi(const mxArray* const A, Precond& p)
+/* Extracts the diagonal blocks of the sparse matrix A and inverts them by
+ * Gauss-Jordan elimination with partial pivoting. If the block size does
+ * not divide the number of degrees of freedom, the last block is smaller.
+ */
+//==============================================================================
+{
+  const mwIndex* const jc=mxGetJc(A);
+  const mwIndex* const ir=mxGetIr(A);
+  const double* const aRe=mxGetPr(A);
+  const double* const aIm=mxGetPi(A);
+  const size_t nBlk=(n+bs-1)/bs;
+
+  p.val=new(nothrow) cplx[(size_t)bs*bs*nBlk];
+  if (p.val==0) throw("Out of memory.");
+  for (size_t k=0; k<(size_t)bs*bs*nBlk; k++) p.val[k]=0.0;
+  cplx* const work=new(nothrow) cplx[(size_t)bs*bs];
+  if (work==0) throw("Out of memory.");
+
+  for (size_t iBlk=0; iBlk<nBlk; iBlk++)
+  {
+    const size_t beg=iBlk*bs;
+    const size_t m=(beg+bs<n ? bs : n-beg);
+    cplx* const inv=p.val+(size_t)bs*bs*iBlk;
+
+    // DIAGONAL BLOCK (COLUMN MAJOR, LEADING DIMENSION bs)
+    for (size_t k=0; k<(size_t)bs*bs; k++) work[k]=0.0;
+    for (size_t j=0; j<m; j++)
+    {
+      for (size_t k=jc[beg+j]; k<jc[beg+j+1]; k++)
+      {
+        if ((ir[k]>=beg) && (ir[k]<beg+m)) work[(ir[k]-beg)+bs*j]=cplx(aRe[k],(aIm==0 ? 0.0 : aIm[k]));
+      }
+    }
+    for (size_t j=0; j<m; j++) inv[j+bs*j]=1.0;
+
+    // GAUSS-JORDAN ELIMINATION
+    for (size_t c=0; c<m; c++)
+    {
+      size_t piv=c;
+      for (size_t r=c+1; r<m; r++) if (abs(work[r+bs*c])>abs(work[piv+bs*c])) piv=r;
+      if (abs(work[piv+bs*c])==0.0)
+      {
+        delete [] work;
+        throw("Singular diagonal block in the block Jacobi preconditioner.");
+      }
+      if (piv!=c)
+      {
+        for (size_t j=0; j<m; j++)
+        {
+          swap(work[c+bs*j],work[piv+bs*j]);
+          swap(inv[c+bs*j],inv[piv+bs*j]);
+        }
+      }
+      const cplx d=1.0/work[c+bs*c];
+      for (size_t j=0; j<m; j++)
+      {
+        work[c+bs*j]*=d;
+        inv[c+bs*j]*=d;
+      }
+      for (size_t r=0; r<m; r++)
+      {
+        if (r==c) continue;
+        const cplx f=work[r+bs*c];
+        if (f==0.0) continue;
+        for (size_t j=0; j<m; j++)
+        {
+          work[r+bs*j]-=f*work[c+bs*j];
+          inv[r+bs*j]-=f*inv[c+bs*j];
+        }
+      }
+    }
+  }
+  delete [] work;
+}
+
+//==============================================================================
+void applyilu(const Precond& p, cplx* const y)
+// Solves L*U*y = y in place by forward and backward substitution.
+//==============================================================================
+{
+  for (size_t i=0; i<n; i++)
+  {
+    cplx s=y[i];
+    for (size_t k=p.rowPtr[i]; k<p.diagPtr[i]; k++) s-=p.val[k]*y[p.colIdx[k]];
+    y[i]=s;
+  }
+  for (size_t i=n; i>0; i--)
+  {
+    const size_t r=i-1;
+    cplx s=y[r];
+    for (size_t k=p.diagPtr[r]+1; k<p.rowPtr[r+1]; k++) s-=p.val[k]*y[p.colIdx[k]];
+    y[r]=s/p.val[p.diagPtr[r]];
+  }
+}
+
+//==============================================================================
+void applyjacobi(const Precond& p, const cplx* const x, cplx* const y)
+// Multiplies x with the inverted diagonal blocks.
+//==============================================================================
+{
+  const size_t nBlk=(n+bs-1)/bs;
+  for (size_t iBlk=0; iBlk<nBlk; iBlk++)
+  {
+    const size_t beg=iBlk*bs;
+    const size_t m=(beg+bs<n ? bs : n-beg);
+    const cplx* const inv=p.val+(size_t)bs*bs*iBlk;
+    for (size_t r=0; r<m; r++)
+    {
+      cplx s=0.0;
+      for (size_t j=0; j<m; j++) s+=inv[r+bs*j]*x[beg+j];
+      y[beg+r]=s;
+    }
+  }
+}
+
+//==============================================================================
+void checkmatrix(const mxArray* const A, size_t& nIn)
+// Checks a sparse matrix, and that its size nIn equals that of the others.
+//==============================================================================
+{
+  if (A==0) throw("Input argument 'A' must be a sparse matrix or a cell array of sparse matrices.");
+  if (!mxIsDouble(A) || !mxIsSparse(A)) throw("Input argument 'A' must be a sparse matrix or a cell array of sparse matrices.");
+  if (mxGetNumberOfDimensions(A)!=2) throw("Input argument 'A' must be a sparse matrix or a cell array of sparse matrices.");
+  if (mxGetM(A)!=mxGetN(A)) throw("Input argument 'A' must be square.");
+  if ((nIn>0) && (mxGetM(A)!=nIn)) throw("The matrices in input argument 'A' must be of equal size.");
+  nIn=mxGetM(A);
+}
+
+//==============================================================================
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray *prhs[])
+//==============================================================================
+{
+  mexAtExit(cleanup);
+  try
+  {
+    checklicense();
+
+    if (nrhs<1) throw("Not enough input arguments.");
+    if (nlhs>1) throw("Too many output arguments.");
+    if (!mxIsChar(prhs[0])) throw("Input argument 'mode' must be a string.");
+
+    char* const mode=mxArrayToString(prhs[0]);
+    if (strcasecmp(mode,"init")==0)
+    {
+      mxFree(mode);
+      if (nrhs<2) throw("Not enough input arguments.");
+      if (nrhs>4) throw("Too many input arguments.");
+      if (nlhs>0) throw("Too many output arguments.");
+
+      bool JacobiIn=false;
+      if (nrhs>2)
+      {
+        if (!mxIsChar(prhs[2])) throw("Input argument 'method' must be a string.");
+        char* const method=mxArrayToString(prhs[2]);
+        if (strcasecmp(method,"jacobi")==0) JacobiIn=true;
+        else if (strcasecmp(method,"ilu")!=0)
+        {
+          mxFree(method);
+          throw("Unknown preconditioner.");
+        }
+        mxFree(method);
+      }
+      unsigned int bsIn=3;
+      if (nrhs>3)
+      {
+        if (!JacobiIn) throw("Too many input arguments.");
+        if (!mxIsNumeric(prhs[3])) throw("Input argument 'bs' must be numeric.");
+        if (mxIsComplex(prhs[3])) throw("Input argument 'bs' must be real.");
+        if (!(mxGetNumberOfElements(prhs[3])==1)) throw("Input argument 'bs' must be a scalar.");
+        if (mxGetScalar(prhs[3])<1) throw("Input argument 'bs' must be positive.");
+        bsIn=(unsigned int)mxGetScalar(prhs[3]);
+      }
+
+      cleanup();
+      const bool cellIn=mxIsCell(prhs[1]);
+      const unsigned int nSetIn=(cellIn ? (unsigned int)mxGetNumberOfElements(prhs[1]) : 1);
+      if (nSetIn==0) throw("Input argument 'A' must not be empty.");
+      size_t nIn=0;
+      for (unsigned int iSet=0; iSet<nSetIn; iSet++)
+      {
+        checkmatrix((cellIn ? mxGetCell(prhs[1],iSet) : prhs[1]),nIn);
+      }
+
+      n=nIn;
+      Jacobi=JacobiIn;
+      bs=bsIn;
+      P=new(nothrow) Precond[nSetIn];
+      if (P==0) throw("Out of memory.");
+      try
+      {
+        for (unsigned int iSet=0; iSet<nSetIn; iSet++)
+        {
+          P[iSet].rowPtr=0;
+          P[iSet].colIdx=0;
+          P[iSet].diagPtr=0;
+          P[iSet].val=0;
+          nSet++;
+          const mxArray* const A=(cellIn ? mxGetCell(prhs[1],iSet) : prhs[1]);
+          if (Jacobi) initjacobi(A,P[iSet]);
+          else initilu(A,P[iSet]);
+        }
+      }
+      catch (const char*)
+      {
+        cleanup();
+        throw;
+      }
+      PrecondValid=true;
+    }
+    else if (strcasecmp(mode,"apply")==0)
+    {
+      mxFree(mode);
+      if (!PrecondValid) throw("The preconditioner is not initialized.");
+      if (nrhs<2) throw("Not enough input arguments.");
+      if (nrhs>3) throw("Too many input arguments.");
+      if (!mxIsDouble(prhs[1])) throw("Input argument 'X' must be of class double.");
+      if (mxIsSparse(prhs[1])) throw("Input argument 'X' must not be sparse.");
+      if (mxGetNumberOfDimensions(prhs[1])>2) throw("Input argument 'X' must have 2 dimensions at most.");
+      if (mxGetM(prhs[1])!=n) throw("Number of rows of input argument 'X' must be equal to the size of the matrix.");
+      const size_t nVec=mxGetN(prhs[1]);
+      unsigned int iSet=0;
+      if (nrhs>2)
+      {
+        if (!mxIsNumeric(prhs[2])) throw("Input argument 'k' must be numeric.");
+        if (mxIsComplex(prhs[2])) throw("Input argument 'k' must be real.");
+        if (!(mxGetNumberOfElements(prhs[2])==1)) throw("Input argument 'k' must be a scalar.");
+        const double k=mxGetScalar(prhs[2]);
+        if ((k<1) || (k!=floor(k))) throw("Input argument 'k' must be a positive integer.");
+        if ((nSet>1) && (k>nSet)) throw("Input argument 'k' exceeds the number of preconditioners.");
+        iSet=(nSet>1 ? (unsigned int)k-1 : 0);
+      }
+      const double* const xRe=mxGetPr(prhs[1]);
+      const double* const xIm=mxGetPi(prhs[1]);
+
+      cplx* const x=new(nothrow) cplx[n];
+      if (x==0) throw("Out of memory.");
+      cplx* const y=new(nothrow) cplx[n];
+      if (y==0)
+      {
+        delete [] x;
+        throw("Out of memory.");
+      }
+      plhs[0]=mxCreateDoubleMatrix(n,nVec,mxCOMPLEX);
+      double* const yRe=mxGetPr(plhs[0]);
+      double* const yIm=mxGetPi(plhs[0]);
+      for (size_t iVec=0; iVec<nVec; iVec++)
+      {
+        const size_t off=n*iVec;
+        for (size_t i=0; i<n; i++) x[i]=cplx(xRe[off+i],(xIm==0 ? 0.0 : xIm[off+i]));
+        if (Jacobi) applyjacobi(P[iSet],x,y);
+        else
+        {
+          for (size_t i=0; i<n; i++) y[i]=x[i];
+          applyilu(P[iSet],y);
+        }
+        for (size_t i=0; i<n; i++)
+        {
+          yRe[off+i]=y[i].real();
+          yIm[off+i]=y[i].imag();
+        }
+      }
+      delete [] x;
+      delete [] y;
+    }
+    else if (strcasecmp(mode,"clear")==0)
+    {
+      mxFree(mode);
+      if (nrhs>1) throw("Too many input arguments.");
+      if (nlhs>0) throw("Too many output arguments.");
+      cleanup();
+    }
+    else
+    {
+      mxFree(mode);
+      throw("Unknown mode.");
+    }
+  }
+  catch (const char* exception)
+  {
+    mexErrMsgTxt(exception);
+  }
+}
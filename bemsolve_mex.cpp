@@ -0,0 +1,510 @@
+/*BEMSOLVE   Iterative solution of boundary element equations.
+ *
+ *   X = BEMSOLVE(A,B) solves the systems of equations A(:,:,k)*X(:,:,k) =
+ *   B(:,:,k) for all frequencies k with the restarted GMRES method. All
+ *   right hand sides of a frequency are solved simultaneously, so that the
+ *   system matrix is read once per iteration for all columns. The solution at
+ *   a frequency is used to start the iterations at the next frequency: the
+ *   initial guess is the combination of the solutions at the previous
+ *   frequencies that minimizes the residual. As the solution varies smoothly
+ *   with the frequency, this reduces the number of iterations considerably
+ *   compared to a zero initial guess.
+ *
+ *   X = BEMSOLVE(A,B,'key',value,...) uses the following options:
+ *
+ *   'method'   'gmres' (default) or 'bicgstab'.
+ *   'tol'      Tolerance on the relative residual (default 1e-6).
+ *   'maxit'    Maximum number of operator applications per right hand side
+ *              and frequency (default 1000).
+ *   'restart'  Number of GMRES iterations between restarts (default 50).
+ *   'precond'  Right preconditioner: function handle y = M(x,k) returning an
+ *              approximation of A(:,:,k)\x.
+ *              A sparse preconditioner based on the near field of the system
+ *              matrices is obtained with BEMNEARFIELD and BEMPRECOND, and
+ *              passed as @(x,k) bemprecond('apply',x,k).
+ *   'x0'       Initial guess for the first frequency (nDof * nRhs).
+ *   'recycle'  Number of previous frequencies whose solutions are combined
+ *              into the initial guess (default 2). If 0, the iterations start
+ *              from the solution at the previous frequency.
+ *   'block'    Maximum number of right hand sides that are solved
+ *              simultaneously (default 16). The memory requirements are
+ *              proportional to block*restart*nDof.
+ *   'threads'  Number of threads for the dense matrix vector products
+ *              (default 1).
+ *   'nfreq'    Number of frequencies if A is a function handle and B does not
+ *              depend on the frequency.
+ *
+ *   [X,relres,iter] = BEMSOLVE(...) also returns the relative residual and
+ *   the number of operator applications for every right hand side and
+ *   frequency, including the applications to the previous solutions that
+ *   are needed for the initial guess (one per recycled frequency). If relres
+ *   is not requested, a warning is issued when the tolerance is not reached.
+ *
+ *   A       System matrices (nDof * nDof * nFreq), or a function handle
+ *           y = A(x,k) that returns the product of the system matrix at the
+ *           k-th frequency and the vectors x (nDof * nVec), e.g. an H-matrix,
+ *           fast multipole or block Toeplitz operator.
+ *   B       Right hand sides (nDof * nRhs * nFreq) or (nDof * nRhs) if the
+ *           right hand sides are equal for all frequencies.
+ *   X       Solution (nDof * nRhs * nFreq).
+ *   relres  Relative residual norm(B-A*X)/norm(B) (nRhs * nFreq).
+ *   iter    Number of operator applications (nRhs * nFreq).
+ */
+
+/* $Make: mex -O -output bemsolve bemsolve_mex.cpp krylov.cpp checklicense.cpp ripemd128.cpp$*/
+
+#include "mex.h"
+#include <string.h>
+#include <math.h>
+#include <complex>
+#include <thread>
+#include <new>
+#include "krylov.h"
+#include "checklicense.h"
+
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
+using namespace std;
+
+typedef complex<double> cplx;
+
+//==============================================================================
+// OPERATOR DATA
+//==============================================================================
+struct SolveData
+{
+  size_t n;
+  const double* ARe;           // Dense system matrix at the current frequency
+  const double* AIm;
+  unsigned int nThread;
+  const mxArray* AFun;         // Function handles, or 0
+  const mxArray* MFun;
+  unsigned int iFreq;          // Current frequency (zero based)
+};
+
+//==============================================================================
+static void denseRows(const SolveData* const d, const cplx* const x,
+                      cplx* const y, const unsigned int& nVec,
+                      const size_t& iBeg, const size_t& iEnd)
+/* Rows iBeg..iEnd-1 of y = A*x. The columns of A are traversed in the
+ * outer loop, so that each part of a column is used for all vectors while
+ * it resides in cache.
+ */
+//==============================================================================
+{
+  const size_t n=d->n;
+  for (unsigned int iVec=0; iVec<nVec; iVec++)
+    for (size_t i=iBeg; i<iEnd; i++) y[n*iVec+i]=0.0;
+  for (size_t j=0; j<n; j++)
+  {
+    const double* const aRe=d->ARe+n*j;
+    const double* const aIm=(d->AIm==0 ? 0 : d->AIm+n*j);
+    for (unsigned int iVec=0; iVec<nVec; iVec++)
+    {
+      const cplx xj=x[n*iVec+j];
+      cplx* const yv=y+n*iVec;
+      if (aIm==0) for (size_t i=iBeg; i<iEnd; i++) yv[i]+=aRe[i]*xj;
+      else for (size_t i=iBeg; i<iEnd; i++) yv[i]+=cplx(aRe[i],aIm[i])*xj;
+    }
+  }
+}
+
+//==============================================================================
+static void denseMatvec(const cplx* const x, cplx* const y,
+                        const unsigned int& nVec, void* const data)
+// Dense product y = A*x, with the rows distributed over the threads.
+//==============================================================================
+{
+  const SolveData* const d=(const SolveData*)data;
+  const size_t n=d->n;
+  unsigned int nThread=d->nThread;
+  if (nThread>n) nThread=(unsigned int)n;
+  if (nThread<=1)
+  {
+    denseRows(d,x,y,nVec,0,n);
+    return;
+  }
+  thread* const workers=new(nothrow) thread[nThread-1];
+  if (workers==0) throw("Out of memory.");
+  const size_t nRow=(n+nThread-1)/nThread;
+  unsigned int nStarted=0;
+  try
+  {
+    for (; nStarted<nThread-1; nStarted++)
+    {
+      const size_t iBeg=nRow*(nStarted+1);
+      const size_t iEnd=(iBeg+nRow<n ? iBeg+nRow : n);
+      workers[nStarted]=thread(denseRows,d,x,y,nVec,iBeg,iEnd);
+    }
+  }
+  catch (...)
+  {
+    for (unsigned int i=0; i<nStarted; i++) workers[i].join();
+    delete [] workers;
+    throw("Unable to start the threads.");
+  }
+  denseRows(d,x,y,nVec,0,(nRow<n ? nRow : n));
+  for (unsigned int i=0; i<nStarted; i++) workers[i].join();
+  delete [] workers;
+}
+
+//==============================================================================
+static void callFun(const mxArray* const fun, const size_t& n,
+                    const unsigned int& iFreq, const cplx* const x,
+                    cplx* const y, const unsigned int& nVec)
+// Evaluate y = fun(x,k) in MATLAB.
+//==============================================================================
+{
+  mxArray* in[3];
+  in[0]=(mxArray*)fun;
+  in[1]=mxCreateDoubleMatrix(n,nVec,mxCOMPLEX);
+  in[2]=mxCreateDoubleScalar(iFreq+1);
+  double* const xRe=mxGetPr(in[1]);
+  double* const xIm=mxGetPi(in[1]);
+  for (size_t i=0; i<n*nVec; i++)
+  {
+    xRe[i]=x[i].real();
+    xIm[i]=x[i].imag();
+  }
+  mxArray* out=0;
+  mxArray* const error=mexCallMATLABWithTrap(1,&out,3,in,"feval");
+  mxDestroyArray(in[1]);
+  mxDestroyArray(in[2]);
+  if (error!=0)
+  {
+    mxDestroyArray(error);
+    throw("Error in the evaluation of the operator or preconditioner function.");
+  }
+  if (!mxIsDouble(out) || mxIsSparse(out) || (mxGetM(out)!=n) || (mxGetN(out)!=nVec))
+  {
+    mxDestroyArray(out);
+    throw("The operator and preconditioner functions must return a full matrix of size (nDof * nVec).");
+  }
+  const double* const yRe=mxGetPr(out);
+  const double* const yIm=mxGetPi(out);
+  for (size_t i=0; i<n*nVec; i++) y[i]=cplx(yRe[i],(yIm==0 ? 0.0 : yIm[i]));
+  mxDestroyArray(out);
+}
+
+//==============================================================================
+static void matvec(const cplx* const x, cplx* const y, const unsigned int& nVec,
+                   void* const data)
+//==============================================================================
+{
+  const SolveData* const d=(const SolveData*)data;
+  if (d->AFun!=0) callFun(d->AFun,d->n,d->iFreq,x,y,nVec);
+  else denseMatvec(x,y,nVec,data);
+}
+
+//==============================================================================
+static void precond(const cplx* const x, cplx* const y, const unsigned int& nVec,
+                    void* const data)
+//==============================================================================
+{
+  const SolveData* const d=(const SolveData*)data;
+  callFun(d->MFun,d->n,d->iFreq,x,y,nVec);
+}
+
+//==============================================================================
+static void recycle(const size_t& n, const unsigned int& nRhs,
+                    const unsigned int& nZ, cplx* const Z, cplx* const W,
+                    const cplx* const b, cplx* const x, SolveData* const data)
+/* Initial guess x = Z*c that minimizes norm(b-A*Z*c) for every right hand
+ * side, with Z the solutions at previous frequencies (n * nZ). W = A*Z is
+ * orthogonalised by the modified Gram-Schmidt method; the same operations
+ * are applied to Z, so that x = Z*(W'*b) afterwards. Columns that are
+ * linearly dependent on the previous ones are dropped.
+ */
+//==============================================================================
+{
+  matvec(Z,W,nZ,data);
+  unsigned int nKeep=0;
+  for (unsigned int j=0; j<nZ; j++)
+  {
+    cplx* const w=W+n*j;
+    cplx* const z=Z+n*j;
+    double wNorm0=0.0;
+    for (size_t k=0; k<n; k++) wNorm0+=norm(w[k]);
+    wNorm0=sqrt(wNorm0);
+    for (unsigned int l=0; l<nKeep; l++)
+    {
+      const cplx* const q=W+n*l;
+      const cplx* const zq=Z+n*l;
+      cplx h=0.0;
+      for (size_t k=0; k<n; k++) h+=conj(q[k])*w[k];
+      for (size_t k=0; k<n; k++)
+      {
+        w[k]-=h*q[k];
+        z[k]-=h*zq[k];
+      }
+    }
+    double wNorm=0.0;
+    for (size_t k=0; k<n; k++) wNorm+=norm(w[k]);
+    wNorm=sqrt(wNorm);
+    if (!(wNorm>1e-10*wNorm0)) continue;
+    cplx* const q=W+n*nKeep;
+    cplx* const zq=Z+n*nKeep;
+    for (size_t k=0; k<n; k++)
+    {
+      q[k]=w[k]/wNorm;
+      zq[k]=z[k]/wNorm;
+    }
+    nKeep++;
+  }
+  for (unsigned int c=0; c<nRhs; c++)
+  {
+    cplx* const xc=x+n*c;
+    for (size_t k=0; k<n; k++) xc[k]=0.0;
+    for (unsigned int l=0; l<nKeep; l++)
+    {
+      cplx h=0.0;
+      for (size_t k=0; k<n; k++) h+=conj(W[n*l+k])*b[n*c+k];
+      for (size_t k=0; k<n; k++) xc[k]+=h*Z[n*l+k];
+    }
+  }
+}
+
+//==============================================================================
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray *prhs[])
+//==============================================================================
+{
+  cplx* work=0;
+  try
+  {
+    checklicense();
+
+    if (nrhs<2) throw("Not enough input arguments.");
+    if (nlhs>3) throw("Too many output arguments.");
+
+    // SYSTEM MATRIX
+    SolveData data;
+    data.ARe=0;
+    data.AIm=0;
+    data.AFun=0;
+    data.MFun=0;
+    data.nThread=1;
+    data.iFreq=0;
+    size_t n;
+    unsigned int nFreq=1;
+    if (mxIsClass(prhs[0],"function_handle")) data.AFun=prhs[0];
+    else
+    {
+      if (!mxIsDouble(prhs[0]) || mxIsSparse(prhs[0])) throw("Input argument 'A' must be a full matrix or a function handle.");
+      const size_t* const Adim=mxGetDimensions(prhs[0]);
+      const unsigned int nAdim=mxGetNumberOfDimensions(prhs[0]);
+      if (Adim[0]!=Adim[1]) throw("Input argument 'A' must be square.");
+      for (unsigned int iDim=2; iDim<nAdim; iDim++) nFreq*=Adim[iDim];
+    }
+
+    // RIGHT HAND SIDES
+    if (!mxIsDouble(prhs[1]) || mxIsSparse(prhs[1])) throw("Input argument 'B' must be a full matrix.");
+    const size_t* const Bdim=mxGetDimensions(prhs[1]);
+    const unsigned int nBdim=mxGetNumberOfDimensions(prhs[1]);
+    n=Bdim[0];
+    const unsigned int nRhs=(unsigned int)Bdim[1];
+    unsigned int nBFreq=1;
+    for (unsigned int iDim=2; iDim<nBdim; iDim++) nBFreq*=Bdim[iDim];
+    if ((data.AFun==0) && (mxGetM(prhs[0])!=n)) throw("Input arguments 'A' and 'B' must have the same number of rows.");
+    if (data.AFun!=0) nFreq=nBFreq;
+    if ((nBFreq!=1) && (nBFreq!=nFreq)) throw("Input argument 'B' must have 1 or nFreq slices.");
+    data.n=n;
+
+    // OPTIONS
+    bool bicg=false;
+    double tol=1e-6;
+    unsigned int maxIt=1000;
+    unsigned int restart=50;
+    unsigned int nRecycle=2;
+    unsigned int nBlock=16;
+    const mxArray* X0=0;
+    if ((nrhs-2)%2!=0) throw("Options must be given as 'key',value pairs.");
+    for (int iArg=2; iArg<nrhs; iArg+=2)
+    {
+      if (!mxIsChar(prhs[iArg])) throw("Options must be given as 'key',value pairs.");
+      char* const key=mxArrayToString(prhs[iArg]);
+      const mxArray* const val=prhs[iArg+1];
+      const bool isScalar=mxIsDouble(val) && (mxGetNumberOfElements(val)==1);
+      const double v=(isScalar ? mxGetScalar(val) : 0.0);
+      const bool isCount=isScalar && (v>=0.0) && (v==floor(v));
+      const char* error=0;
+      if (strcasecmp(key,"method")==0)
+      {
+        char* const method=(mxIsChar(val) ? mxArrayToString(val) : 0);
+        if ((method!=0) && (strcasecmp(method,"gmres")==0)) bicg=false;
+        else if ((method!=0) && (strcasecmp(method,"bicgstab")==0)) bicg=true;
+        else error="Option 'method' must be 'gmres' or 'bicgstab'.";
+        if (method!=0) mxFree(method);
+      }
+      else if (strcasecmp(key,"tol")==0)
+      {
+        if (isScalar && (v>0.0)) tol=v;
+        else error="Option 'tol' must be a positive scalar.";
+      }
+      else if (strcasecmp(key,"maxit")==0)
+      {
+        if (isCount && (v>=1.0)) maxIt=(unsigned int)v;
+        else error="Option 'maxit' must be a positive integer.";
+      }
+      else if (strcasecmp(key,"restart")==0)
+      {
+        if (isCount && (v>=1.0)) restart=(unsigned int)v;
+        else error="Option 'restart' must be a positive integer.";
+      }
+      else if (strcasecmp(key,"recycle")==0)
+      {
+        if (isCount) nRecycle=(unsigned int)v;
+        else error="Option 'recycle' must be a non-negative integer.";
+      }
+      else if (strcasecmp(key,"block")==0)
+      {
+        if (isCount && (v>=1.0)) nBlock=(unsigned int)v;
+        else error="Option 'block' must be a positive integer.";
+      }
+      else if (strcasecmp(key,"threads")==0)
+      {
+        if (isCount && (v>=1.0)) data.nThread=(unsigned int)v;
+        else error="Option 'threads' must be a positive integer.";
+      }
+      else if (strcasecmp(key,"nfreq")==0)
+      {
+        if (!(isCount && (v>=1.0))) error="Option 'nfreq' must be a positive integer.";
+        else if ((data.AFun==0) || (nBFreq!=1)) error="Option 'nfreq' is only allowed for a function handle 'A' and frequency independent 'B'.";
+        else nFreq=(unsigned int)v;
+      }
+      else if (strcasecmp(key,"precond")==0)
+      {
+        if (mxIsClass(val,"function_handle")) data.MFun=val;
+        else error="Option 'precond' must be a function handle.";
+      }
+      else if (strcasecmp(key,"x0")==0)
+      {
+        if (mxIsDouble(val) && !mxIsSparse(val) && (mxGetM(val)==n) && (mxGetN(val)==nRhs)
+            && (mxGetNumberOfDimensions(val)==2)) X0=val;
+        else error="Option 'x0' must be a full matrix of size (nDof * nRhs).";
+      }
+      else error="Unknown option.";
+      mxFree(key);
+      if (error!=0) throw(error);
+    }
+    if (nBlock>nRhs) nBlock=nRhs;
+    if (nBlock==0) nBlock=1;
+
+    // OUTPUT
+    size_t Xdim[3]={n,nRhs,nFreq};
+    plhs[0]=mxCreateNumericArray(3,Xdim,mxDOUBLE_CLASS,mxCOMPLEX);
+    double* const XRe=mxGetPr(plhs[0]);
+    double* const XIm=mxGetPi(plhs[0]);
+    mxArray* const relresArr=mxCreateDoubleMatrix(nRhs,nFreq,mxREAL);
+    mxArray* const iterArr=mxCreateDoubleMatrix(nRhs,nFreq,mxREAL);
+    double* const relres=mxGetPr(relresArr);
+    double* const iter=mxGetPr(iterArr);
+
+    // WORKSPACE: b, x (n * nBlock), Z and W (n * nBlock*nRecycle),
+    // relres and iterations of the block
+    const size_t nZ=(size_t)nBlock*nRecycle;
+    work=new(nothrow) cplx[2*n*nBlock+2*n*nZ];
+    double* const blockRes=new(nothrow) double[nBlock];
+    unsigned int* const blockIt=new(nothrow) unsigned int[nBlock];
+    if ((work==0) || (blockRes==0) || (blockIt==0))
+    {
+      if (blockRes!=0) delete [] blockRes;
+      if (blockIt!=0) delete [] blockIt;
+      throw("Out of memory.");
+    }
+    cplx* const b=work;
+    cplx* const x=b+n*nBlock;
+    cplx* const Z=x+n*nBlock;
+    cplx* const W=Z+n*nZ;
+
+    const double* const BRe=mxGetPr(prhs[1]);
+    const double* const BIm=mxGetPi(prhs[1]);
+    bool converged=true;
+    try
+    {
+      for (unsigned int iFreq=0; iFreq<nFreq; iFreq++)
+      {
+        data.iFreq=iFreq;
+        if (data.AFun==0)
+        {
+          data.ARe=mxGetPr(prhs[0])+n*n*iFreq;
+          data.AIm=(mxGetPi(prhs[0])==0 ? 0 : mxGetPi(prhs[0])+n*n*iFreq);
+        }
+        const size_t offsetB=(nBFreq==1 ? 0 : n*nRhs*iFreq);
+        for (unsigned int iRhs0=0; iRhs0<nRhs; iRhs0+=nBlock)
+        {
+          const unsigned int nb=(iRhs0+nBlock<nRhs ? nBlock : nRhs-iRhs0);
+          for (size_t k=0; k<n*nb; k++)
+            b[k]=cplx(BRe[offsetB+n*iRhs0+k],(BIm==0 ? 0.0 : BIm[offsetB+n*iRhs0+k]));
+
+          // INITIAL GUESS
+          // The nb*nPrev operator applications of recycle are counted as
+          // nPrev per right hand side.
+          const unsigned int nPrev=(iFreq<nRecycle ? iFreq : nRecycle);
+          if (nPrev>0)
+          {
+            for (unsigned int iPrev=0; iPrev<nPrev; iPrev++)
+            {
+              const size_t offsetX=n*nRhs*(iFreq-1-iPrev)+n*iRhs0;
+              for (size_t k=0; k<n*nb; k++) Z[n*nb*iPrev+k]=cplx(XRe[offsetX+k],XIm[offsetX+k]);
+            }
+            recycle(n,nb,nb*nPrev,Z,W,b,x,&data);
+          }
+          else if (iFreq>0)
+          {
+            const size_t offsetX=n*nRhs*(iFreq-1)+n*iRhs0;
+            for (size_t k=0; k<n*nb; k++) x[k]=cplx(XRe[offsetX+k],XIm[offsetX+k]);
+          }
+          else if (X0!=0)
+          {
+            const double* const X0Re=mxGetPr(X0);
+            const double* const X0Im=mxGetPi(X0);
+            for (size_t k=0; k<n*nb; k++)
+              x[k]=cplx(X0Re[n*iRhs0+k],(X0Im==0 ? 0.0 : X0Im[n*iRhs0+k]));
+          }
+          else for (size_t k=0; k<n*nb; k++) x[k]=0.0;
+
+          // KRYLOV ITERATIONS
+          krylov(bicg,n,nb,matvec,(data.MFun==0 ? 0 : precond),&data,b,x,tol,maxIt,
+                 restart,blockRes,blockIt);
+
+          const size_t offsetX=n*nRhs*iFreq+n*iRhs0;
+          for (size_t k=0; k<n*nb; k++)
+          {
+            XRe[offsetX+k]=x[k].real();
+            XIm[offsetX+k]=x[k].imag();
+          }
+          for (unsigned int c=0; c<nb; c++)
+          {
+            relres[nRhs*iFreq+iRhs0+c]=blockRes[c];
+            iter[nRhs*iFreq+iRhs0+c]=blockIt[c]+nPrev;
+            if (!(blockRes[c]<=tol)) converged=false;
+          }
+        }
+      }
+    }
+    catch (const char*)
+    {
+      delete [] blockRes;
+      delete [] blockIt;
+      throw;
+    }
+    delete [] blockRes;
+    delete [] blockIt;
+    delete [] work;
+    work=0;
+
+    if (nlhs>1) plhs[1]=relresArr;
+    else mxDestroyArray(relresArr);
+    if (nlhs>2) plhs[2]=iterArr;
+    else mxDestroyArray(iterArr);
+    if ((nlhs<2) && !converged) mexWarnMsgTxt("BEMSOLVE did not converge to the requested tolerance for all right hand sides.");
+  }
+  catch (const char* exception)
+  {
+    if (work!=0) delete [] work;
+    mexErrMsgTxt(exception);
+  }
+}
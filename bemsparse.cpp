@@ -0,0 +1,103 @@
+#include <string.h>
+#include <new>
+#include "bemsparse.h"
+
+using namespace std;
+
+//==============================================================================
+mxArray* bemsparse(const size_t& m, const size_t& n, const size_t& nTriplet,
+                   const unsigned int* const row, const unsigned int* const col,
+                   const double* const val, const bool& sum)
+//==============================================================================
+{
+  size_t* const rowPtr=new(nothrow) size_t[m+1];
+  size_t* const colPtr=new(nothrow) size_t[n+1];
+  size_t* const byRow=new(nothrow) size_t[nTriplet];
+  size_t* const byCol=new(nothrow) size_t[nTriplet];
+  if ((rowPtr==0) || (colPtr==0) || (byRow==0) || (byCol==0))
+  {
+    delete [] rowPtr;
+    delete [] colPtr;
+    delete [] byRow;
+    delete [] byCol;
+    throw("Out of memory.");
+  }
+
+  // STABLE SORT BY ROW, THEN BY COLUMN
+  for (size_t i=0; i<=m; i++) rowPtr[i]=0;
+  for (size_t i=0; i<=n; i++) colPtr[i]=0;
+  for (size_t k=0; k<nTriplet; k++)
+  {
+    rowPtr[row[k]+1]++;
+    colPtr[col[k]+1]++;
+  }
+  for (size_t i=0; i<m; i++) rowPtr[i+1]+=rowPtr[i];
+  for (size_t i=0; i<n; i++) colPtr[i+1]+=colPtr[i];
+  for (size_t k=0; k<nTriplet; k++) byRow[rowPtr[row[k]]++]=k;
+  for (size_t i=0; i<nTriplet; i++)
+  {
+    const size_t k=byRow[i];
+    byCol[colPtr[col[k]]++]=k;
+  }
+  delete [] rowPtr;
+  delete [] byRow;
+  double* const merged=new(nothrow) double[nTriplet];
+  if (merged==0)
+  {
+    delete [] colPtr;
+    delete [] byCol;
+    throw("Out of memory.");
+  }
+
+  // MERGE DUPLICATES; THE ROWS ARE STORED IN PLACE OF byCol
+  size_t* const mergedRow=byCol;
+  size_t* const jc=colPtr;
+  size_t nzmax=0;
+  size_t iBeg=0;
+  for (size_t j=0; j<n; j++)
+  {
+    const size_t iEnd=colPtr[j];
+    jc[j]=nzmax;
+    size_t i=iBeg;
+    while (i<iEnd)
+    {
+      const size_t k=byCol[i];
+      double v=val[k];
+      size_t iNext=i+1;
+      while ((iNext<iEnd) && (row[byCol[iNext]]==row[k]))
+      {
+        v=(sum ? v+val[byCol[iNext]] : val[byCol[iNext]]);
+        iNext++;
+      }
+      if (v!=0.0)
+      {
+        merged[nzmax]=v;
+        mergedRow[nzmax]=row[k];
+        nzmax++;
+      }
+      i=iNext;
+    }
+    iBeg=iEnd;
+  }
+  jc[n]=nzmax;
+
+  mxArray* const A=mxCreateSparse(m,n,(nzmax>0 ? nzmax : 1),mxREAL);
+  if (A==0)
+  {
+    delete [] colPtr;
+    delete [] byCol;
+    delete [] merged;
+    throw("Out of memory.");
+  }
+  mwIndex* const Jc=mxGetJc(A);
+  mwIndex* const Ir=mxGetIr(A);
+  double* const Pr=mxGetPr(A);
+  for (size_t j=0; j<=n; j++) Jc[j]=jc[j];
+  for (size_t i=0; i<nzmax; i++) Ir[i]=mergedRow[i];
+  memcpy(Pr,merged,nzmax*sizeof(double));
+
+  delete [] colPtr;
+  delete [] byCol;
+  delete [] merged;
+  return A;
+}
@@ -0,0 +1,15 @@
+#include <stddef.h>
+#include "mex.h"
+
+#ifndef _BEMSPARSE_
+#define _BEMSPARSE_
+mxArray* bemsparse(const size_t& m, const size_t& n, const size_t& nTriplet,
+                   const unsigned int* const row, const unsigned int* const col,
+                   const double* const val, const bool& sum);
+/*   Sparse matrix (m * n) from the triplets (row,col,val). Duplicate
+ *   triplets are summed (sum) or the last one is retained, as by the
+ *   assignment A(row,col)=val in MATLAB. Zeros are not stored. The rows are
+ *   sorted within the columns by two stable counting sorts, in O(nTriplet+m+n)
+ *   operations.
+ */
+#endif
@@ -24,3 +24,6 @@
 %         3: Modified triangular shape function from -delt to 0. Used for
 %         tractions
 %   u     Convolution (... * nTimeBem) evaluated at tBem.
+%
+%   u = BEMTIMECONV(t,ug,tBem,delt,type,'threads',nThread) distributes the
+%   output times over nThread threads (default 1).
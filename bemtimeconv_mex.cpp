@@ -24,24 +24,217 @@
  *         3: Modified triangular shape function from -delt to 0. Used for 
  *         tractions
  *   u     Convolution (... * nTimeBem) evaluated at times tBem.
+ *
+ *   u = BEMTIMECONV(t,ug,tBem,delt,type,'threads',nThread) distributes the
+ *   output times over nThread threads (default 1).
  */
 
 /* $Make: mex -O -output bemtimeconv bemtimeconv_mex.cpp search1.cpp$*/
 
 #include "mex.h"
+#include <math.h>
 #include <complex>
+#include <new>
+#include <string.h>
+#include <thread>
 #include "search1.h"
 #include "checklicense.h"
 
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
 using namespace std;
+
+struct ConvData
+{
+  const double* ugt;         // Green's functions (nugComp * nTime)
+  unsigned int nugComp;      // Number of components
+  const unsigned int* kBeg;  // First time sample of the band of each output time
+  const size_t* wPtr;        // First weight of each output time (nTimeBem+1)
+  const double* wt;          // Weights
+  double* u;                 // Convolution (nugComp * nTimeBem)
+};
+
+//==============================================================================
+void timeindex(const double x, const double* const t, const unsigned int& nTime,
+               const bool& uniform, const double& dt, unsigned int& k1,
+               unsigned int& k2, double& f)
+/* Locates x in the time sampling t, such that x=(1-f)*t[k1]+f*t[k2]. For a
+ * uniform sampling, the indices follow directly from the time step dt.
+ */
+//==============================================================================
+{
+  if (nTime==1)
+  {
+    k1=0;
+    k2=0;
+    f=0.0;
+  }
+  else if (uniform)
+  {
+    const double s=(x-t[0])/dt;
+    if (s<=0.0) k1=0;
+    else if (s>=nTime-1) k1=nTime-2;
+    else k1=(unsigned int)s;
+    k2=k1+1;
+    f=(x-t[k1])/(t[k2]-t[k1]);
+  }
+  else
+  {
+    static unsigned int guess=0;
+    double ival[2];
+    bool extrapFlag=false;
+    k1=guess;
+    search1(x,t,nTime-1,k1,k2,ival,extrapFlag);
+    f=ival[1];
+    guess=k1;
+  }
+}
+
+//==============================================================================
+void timeweights(const double tBeg, const double tEnd, const double c0, const double c1,
+                 const double* const t, const unsigned int& nTime, const bool& uniform,
+                 const double& dt, double* const wTime)
+/* Adds the weights of the time samples of ug to wTime for the integral of
+ * (c0+c1*tau)*ug(tau) from tBeg to tEnd. The integration interval is limited
+ * to the sampling interval of ug. The trapezoidal rule is applied to the
+ * integrand, using the time samples within the interval and the linearly
+ * interpolated values at the end points.
+ */
+//==============================================================================
+{
+  const double a=min(max(tBeg,t[0]),t[nTime-1]);
+  const double b=min(max(tEnd,t[0]),t[nTime-1]);
+  if (!(b>a)) return;
+
+  unsigned int ka1,ka2,kb1,kb2;
+  double fa,fb;
+  timeindex(a,t,nTime,uniform,dt,ka1,ka2,fa);
+  timeindex(b,t,nTime,uniform,dt,kb1,kb2,fb);
+
+  // Start point (interpolated)
+  double tPrev=a;
+  double wPrev=c0+c1*a;
+  unsigned int kPrev1=ka1;
+  unsigned int kPrev2=ka2;
+  double fPrev=fa;
+  for (unsigned int k=ka1+1; k<=kb2; k++)
+  {
+    double tNext;
+    unsigned int kNext1,kNext2;
+    double fNext;
+    if ((k<kb2) && (t[k]>a) && (t[k]<b))   // time sample within the interval
+    {
+      tNext=t[k];
+      kNext1=k;
+      kNext2=k;
+      fNext=0.0;
+    }
+    else if (k==kb2)                       // end point (interpolated)
+    {
+      tNext=b;
+      kNext1=kb1;
+      kNext2=kb2;
+      fNext=fb;
+    }
+    else continue;
+    const double wNext=c0+c1*tNext;
+    const double h=0.5*(tNext-tPrev);
+    wTime[kPrev1]+=h*wPrev*(1.0-fPrev);
+    wTime[kPrev2]+=h*wPrev*fPrev;
+    wTime[kNext1]+=h*wNext*(1.0-fNext);
+    wTime[kNext2]+=h*wNext*fNext;
+    tPrev=tNext;
+    wPrev=wNext;
+    kPrev1=kNext1;
+    kPrev2=kNext2;
+    fPrev=fNext;
+  }
+}
+
+//==============================================================================
+static void convworker(const ConvData* const d, const unsigned int iTimeBeg,
+                       const unsigned int iTimeEnd)
+/* Applies the weights of the output times [iTimeBeg,iTimeEnd) to all
+ * components. The components are processed in blocks, such that the output
+ * column remains in cache while the time samples of ug are streamed.
+ */
+//==============================================================================
+{
+  const unsigned int CompBlock=2048;
+  const unsigned int nugComp=d->nugComp;
+  for (unsigned int iTime=iTimeBeg; iTime<iTimeEnd; iTime++)
+  {
+    double* const ui=d->u+(size_t)nugComp*iTime;
+    const double* const wi=d->wt+d->wPtr[iTime];
+    const unsigned int nBand=d->wPtr[iTime+1]-d->wPtr[iTime];
+    for (unsigned int compBeg=0; compBeg<nugComp; compBeg+=CompBlock)
+    {
+      const unsigned int compEnd=min(compBeg+CompBlock,nugComp);
+      for (unsigned int iBand=0; iBand<nBand; iBand++)
+      {
+        const double w=wi[iBand];
+        if (w==0.0) continue;
+        const double* const ugk=d->ugt+(size_t)nugComp*(d->kBeg[iTime]+iBand);
+        for (unsigned int iComp=compBeg; iComp<compEnd; iComp++) ui[iComp]+=w*ugk[iComp];
+      }
+    }
+  }
+}
+
+//==============================================================================
+static void convthreads(const ConvData* const d, const unsigned int& nTimeBem,
+                        unsigned int nThread)
+/* Distributes the output times over nThread threads. If a thread cannot be
+ * started, its output times are processed by the calling thread.
+ */
+//==============================================================================
+{
+  if (nThread>nTimeBem) nThread=nTimeBem;
+  if (nThread<=1)
+  {
+    convworker(d,0,nTimeBem);
+    return;
+  }
+  const unsigned int nRange=(nTimeBem+nThread-1)/nThread;
+  thread* const workers=new(nothrow) thread[nThread];
+  unsigned int nStarted=0;
+  if (workers!=0)
+  {
+    try
+    {
+      for (unsigned int iThread=1; iThread<nThread; iThread++)
+      {
+        const unsigned int iBeg=min(nRange*iThread,nTimeBem);
+        const unsigned int iEnd=min(iBeg+nRange,nTimeBem);
+        workers[iThread]=thread(convworker,d,iBeg,iEnd);
+        nStarted=iThread;
+      }
+    }
+    catch (...)
+    {
+    }
+  }
+  convworker(d,0,min(nRange,nTimeBem));
+  for (unsigned int iThread=1; iThread<=nStarted; iThread++) workers[iThread].join();
+  for (unsigned int iThread=nStarted+1; iThread<nThread; iThread++)
+  {
+    const unsigned int iBeg=min(nRange*iThread,nTimeBem);
+    convworker(d,iBeg,min(iBeg+nRange,nTimeBem));
+  }
+  delete [] workers;
+}
+
+//==============================================================================
 void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+//==============================================================================
 {
   try
   {
     checklicense();
     
     if (nrhs<5) throw("Not enough input arguments.");
-    if (nrhs>5) throw("Too many input arguments.");
     if (nlhs>1) throw("Too many output arguments.");
 
     if (!mxIsNumeric(prhs[0])) throw("Input argument 't' must be numeric.");
@@ -86,6 +279,27 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
     const double* const typeutil=mxGetPr(prhs[4]);
     const unsigned int type = (unsigned int)(typeutil[0]);
 
+    // OPTIONS
+    unsigned int nThread=1;
+    if ((nrhs-5)%2!=0) throw("Options must be given as 'key',value pairs.");
+    for (int iArg=5; iArg<nrhs; iArg+=2)
+    {
+      if (!mxIsChar(prhs[iArg])) throw("Options must be given as 'key',value pairs.");
+      char* const key=mxArrayToString(prhs[iArg]);
+      const mxArray* const val=prhs[iArg+1];
+      const bool isScalar=mxIsDouble(val) && (mxGetNumberOfElements(val)==1);
+      const double v=(isScalar ? mxGetScalar(val) : 0.0);
+      const char* error=0;
+      if (strcasecmp(key,"threads")==0)
+      {
+        if (isScalar && (v>=1.0) && (v==floor(v))) nThread=(unsigned int)v;
+        else error="Option 'threads' must be a positive integer.";
+      }
+      else error="Unknown option.";
+      mxFree(key);
+      if (error!=0) throw(error);
+    }
+
     // OUTPUT ARGUMENTS
     size_t* const outDims = new(nothrow) size_t[nugDims];
     if (outDims==0) throw("Out of memory.");
@@ -103,104 +317,110 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
     plhs[0]=mxCreateNumericArray(nugDims,outDims,mxDOUBLE_CLASS,mxREAL);
     double* const u=mxGetPr(plhs[0]);
 
-    // Initialise interpolation parameters
-    unsigned int t00=0;
-    unsigned int t01=0;
-    unsigned int t10=0;
-    unsigned int t11=0;
-    unsigned int t20=0;
-    unsigned int t21=0;
-    double* const ival0 = new(nothrow) double[2];
-    double* const ival1 = new(nothrow) double[2];
-    double* const ival2 = new(nothrow) double[2];
+    // TIME SAMPLING: A UNIFORM SAMPLING ALLOWS A DIRECT TABLE LOOKUP
+    const double dt=(nTime>1 ? (tMax-tMin)/(nTime-1) : 0.0);
+    bool uniform=(nTime>1);
+    for (unsigned int it=1; (it<nTime) && uniform; it++)
+    {
+      if (fabs(t[it]-(tMin+it*dt))>1e-10*(tMax-tMin)) uniform=false;
+    }
+
+    // The output times are equally shifted over an integer number of time
+    // steps if tBem is uniformly sampled with a multiple of dt as time step.
+    // The weights of the shape function are then computed once and applied
+    // as a banded FIR filter.
+    bool shiftInvariant=uniform && (nTimeBem>1);
+    double nShift=0.0;
+    if (shiftInvariant)
+    {
+      nShift=(tBem[1]-tBem[0])/dt;
+      if ((nShift<0.5) || (fabs(nShift-floor(nShift+0.5))>1e-8)) shiftInvariant=false;
+      nShift=floor(nShift+0.5);
+    }
+    for (unsigned int iTime=1; (iTime<nTimeBem) && shiftInvariant; iTime++)
+    {
+      if (fabs(tBem[iTime]-(tBem[0]+iTime*nShift*dt))>1e-8*dt) shiftInvariant=false;
+    }
+
+    // WEIGHTS OF THE TIME SAMPLES OF ug FOR EVERY OUTPUT TIME
+    // The weights of output time iTime are wt[wPtr[iTime]...wPtr[iTime+1]-1]
+    // and correspond to the time samples kBeg[iTime], kBeg[iTime]+1, ...
+    unsigned int* const kBeg=new(nothrow) unsigned int[nTimeBem];
+    if (kBeg==0) throw("Out of memory.");
+    size_t* const wPtr=new(nothrow) size_t[nTimeBem+1];
+    if (wPtr==0) throw("Out of memory.");
+    double* const wTime=new(nothrow) double[nTime];
+    if (wTime==0) throw("Out of memory.");
+    for (unsigned int it=0; it<nTime; it++) wTime[it]=0.0;
 
+    // First pass: band of every output time
+    wPtr[0]=0;
     for (unsigned int iTime=0; iTime<nTimeBem; iTime++)
     {
-      double t0=tBem[iTime]-delt;
-      double t1=tBem[iTime];
-      double t2=tBem[iTime]+delt;
-      t0=max(t0,tMin);
-      t1=max(t1,tMin);
-      t2=max(t2,tMin);
-      t0=min(t0,tMax);
-      t1=min(t1,tMax);
-      t2=min(t2,tMax);
-
-      bool extrapFlag=false;
-      search1(t0,t,nTime-1,t00,t01,ival0,extrapFlag);
-      search1(t1,t,nTime-1,t10,t11,ival1,extrapFlag);
-      search1(t2,t,nTime-1,t20,t21,ival2,extrapFlag);
-
-      if (type==1)  // Constant shape function
+      const double tBeg=min(max(tBem[iTime]-(type==1 ? 0.0 : delt),tMin),tMax);
+      const double tEnd=min(max(tBem[iTime]+delt,tMin),tMax);
+      unsigned int k1,k2,kEnd;
+      double f;
+      timeindex(tBeg,t,nTime,uniform,dt,k1,k2,f);
+      kBeg[iTime]=k1;
+      timeindex(tEnd,t,nTime,uniform,dt,k1,kEnd,f);
+      wPtr[iTime+1]=wPtr[iTime]+(kEnd-kBeg[iTime]+1);
+    }
+    double* const wt=new(nothrow) double[wPtr[nTimeBem]];
+    if (wt==0) throw("Out of memory.");
+
+    // Second pass: weights
+    unsigned int iBase=nTimeBem;
+    for (unsigned int iTime=0; iTime<nTimeBem; iTime++)
+    {
+      const bool interior=(tBem[iTime]-delt>=tMin) && (tBem[iTime]+delt<=tMax);
+      const unsigned int nBand=wPtr[iTime+1]-wPtr[iTime];
+      if (shiftInvariant && interior && (iBase<nTimeBem) && (nBand==wPtr[iBase+1]-wPtr[iBase]) &&
+          (kBeg[iTime]-kBeg[iBase]==(iTime-iBase)*(unsigned int)nShift))
       {
-      unsigned int InnerPoints= t20-t10;
-      for (unsigned int iComp=0; iComp<nugComp; iComp++)
+        for (unsigned int iBand=0; iBand<nBand; iBand++) wt[wPtr[iTime]+iBand]=wt[wPtr[iBase]+iBand];
+        continue;
+      }
+      const double t0=tBem[iTime]-delt;
+      const double t1=tBem[iTime];
+      const double t2=tBem[iTime]+delt;
+      if (type==1)       // Constant shape function
       {
-          unsigned int iPos=nugComp*iTime+iComp;
-          u[iPos]= 0.5*(t[t11]-t1)*(ival1[0]*ugt[nugComp*t10+iComp]+ival1[1]*ugt[nugComp*t11+iComp]);
-          u[iPos]+=0.5*(t[t11]-t1)*ugt[nugComp*t11+iComp];
-          for (unsigned int tInt=0; tInt<InnerPoints-1; tInt++)
-          {
-            u[iPos]+=0.5*(t[t11+tInt+1]-t[t11+tInt+0])*ugt[nugComp*(t11+tInt+0)+iComp];
-            u[iPos]+=0.5*(t[t11+tInt+1]-t[t11+tInt+0])*ugt[nugComp*(t11+tInt+1)+iComp];
-          }
-          u[iPos]+=0.5*(t2-t[t20])* ugt[nugComp*t20+iComp];
-          u[iPos]+=0.5*(t2-t[t20])*(ival2[0]*ugt[nugComp*t20+iComp]+ival2[1]*ugt[nugComp*t21+iComp]);
-        }
+        timeweights(t1,t2,1.0,0.0,t,nTime,uniform,dt,wTime);
       }
-      else if (type==2)
+      else if (type==2)  // Triangular shape function
       {
-        unsigned int ntInt=t10-t01;
-        for (unsigned int iComp=0; iComp<nugComp; iComp++)
-        {
-          unsigned int iPos=nugComp*iTime+iComp;
-          u[iPos]+=0.5*(t[t01]-t0)*((t[t01]-t0)/delt)*ugt[nugComp*t01+iComp];
-          for (unsigned int tInt=0; tInt<ntInt; tInt++)
-          {
-            u[iPos]+=0.5*(t[t01+tInt+1]-t[t01+tInt+0])*((t[t01+tInt+0]-t0)/delt)*ugt[nugComp*(t01+tInt+0)+iComp];
-            u[iPos]+=0.5*(t[t01+tInt+1]-t[t01+tInt+0])*((t[t01+tInt+1]-t0)/delt)*ugt[nugComp*(t01+tInt+1)+iComp];
-          }
-          u[iPos]+=0.5*(t1-t[t10])*((t[t10]-t0)/delt)*ugt[nugComp*t10+iComp];
-          u[iPos]+=0.5*(t1-t[t10])*1.0*(ival1[0]*ugt[nugComp*t10+iComp]+ival1[1]*ugt[nugComp*t11+iComp]);
-        }
-        
-        ntInt=t20-t11;
-        for (unsigned int iComp=0; iComp<nugComp; iComp++)
-        {
-          //tau=(1-(t-t1)/delt)
-          unsigned int iPos=nugComp*iTime+iComp;
-          u[iPos]+= 0.5*(t[t11]-t1)*(1.0-0.0)*(ival1[0]*ugt[nugComp*t10+iComp]+ival1[1]*ugt[nugComp*t11+iComp]);
-          u[iPos]+=0.5*(t[t11]-t1)*(1.0-(t[t11]-t1)/delt)*ugt[nugComp*t11+iComp];
-          for (unsigned int tInt=0; tInt<ntInt; tInt++)
-          {
-            u[iPos]+=0.5*(t[t11+tInt+1]-t[t11+tInt+0])*(1.0-(t[t11+tInt+0]-t1)/delt)*ugt[nugComp*(t11+tInt+0)+iComp];
-            u[iPos]+=0.5*(t[t11+tInt+1]-t[t11+tInt+0])*(1.0-(t[t11+tInt+1]-t1)/delt)*ugt[nugComp*(t11+tInt+1)+iComp];
-          }
-          u[iPos]+=0.5*(t2-t[t20])*(1.0-(t[t20]-t1)/delt)*ugt[nugComp*t20+iComp];
-        }
+        timeweights(t0,t1,-t0/delt,1.0/delt,t,nTime,uniform,dt,wTime);
+        timeweights(t1,t2,1.0+t1/delt,-1.0/delt,t,nTime,uniform,dt,wTime);
       }
-      else if (type==3) // Modified shape function
+      else if (type==3)  // Modified shape function
       {
-        unsigned int InnerPoints= t20-t10;
-        for (unsigned int iComp=0; iComp<nugComp; iComp++)
-        {
-          unsigned int iPos=nugComp*iTime+iComp;
-          u[iPos]= 0.5*(t[t11]-t1)*(1.0-0.0)*(ival1[0]*ugt[nugComp*t10+iComp]+ival1[1]*ugt[nugComp*t11+iComp]);
-          u[iPos]+=0.5*(t[t11]-t1)*(1.0-(t[t11]-t1)/delt)*ugt[nugComp*t11+iComp];
-          for (unsigned int tInt=0; tInt<InnerPoints-1; tInt++)
-          {
-            u[iPos]+=0.5*(t[t11+tInt+1]-t[t11+tInt+0])*(1.0-(t[t11+tInt+0]-t1)/delt)*ugt[nugComp*(t11+tInt+0)+iComp];
-            u[iPos]+=0.5*(t[t11+tInt+1]-t[t11+tInt+0])*(1.0-(t[t11+tInt+1]-t1)/delt)*ugt[nugComp*(t11+tInt+1)+iComp];
-          }
-          u[iPos]+=0.5*(t2-t[t20])*(1.0-(t[t20]-t1)/delt)*ugt[nugComp*t20+iComp];
-        }
+        timeweights(t1,t2,1.0+t1/delt,-1.0/delt,t,nTime,uniform,dt,wTime);
       }
       else throw("Unknown shape function type.");
+      for (unsigned int iBand=0; iBand<nBand; iBand++)
+      {
+        wt[wPtr[iTime]+iBand]=wTime[kBeg[iTime]+iBand];
+        wTime[kBeg[iTime]+iBand]=0.0;
+      }
+      if (shiftInvariant && interior && (iBase==nTimeBem)) iBase=iTime;
     }
+
+    // APPLY THE WEIGHTS TO ALL COMPONENTS
+    ConvData data;
+    data.ugt=ugt;
+    data.nugComp=nugComp;
+    data.kBeg=kBeg;
+    data.wPtr=wPtr;
+    data.wt=wt;
+    data.u=u;
+    convthreads(&data,nTimeBem,nThread);
+
     delete [] outDims;
-    delete [] ival0;
-    delete [] ival1;
-    delete [] ival2;
+    delete [] kBeg;
+    delete [] wPtr;
+    delete [] wTime;
+    delete [] wt;
   }
   catch (const char* exception)
   {
@@ -0,0 +1,276 @@
+function [A,B]=bemtoeplitz(varargin)
+%BEMTOEPLITZ   Block Toeplitz boundary element system matrices.
+%
+%   [SU,ST] = BEMTOEPLITZ(nod,elt,typ,d,green,...) computes the boundary
+%   element system matrices of a mesh that consists of nCell identical cells,
+%   each cell being a translation of the first cell over a multiple of the
+%   vector d, as generated by BEMMESHREP. As the Green's function is
+%   invariant for a translation, the interaction between two cells only
+%   depends on their offset, so that the system matrices are block Toeplitz
+%   matrices. The cells are detected from the mesh and verified to be
+%   translations of each other. Only the 2*nCell-1 unique offset blocks are
+%   computed with BEMMAT(nod,elt,typ,s,green,...). The diagonal blocks of T
+%   of the cells differ from the offset zero block because of the
+%   regularisation of the singular traction integrals over the complete
+%   boundary, which only affects the diagonal blocks of the collocation
+%   points. These are computed for all cells in a single call of BEMMAT. SU
+%   and ST are compact representations of U and T.
+%
+%   y = BEMTOEPLITZ(S,x) computes the product y = A*x of the system matrix A
+%   represented by S and the vectors x, using the fast Fourier transform of
+%   the offset blocks. The cost is proportional to nCell*log(nCell) instead
+%   of nCell^2.
+%   y = BEMTOEPLITZ(S,x,k) uses the system matrix A(:,:,k), e.g. at the k-th
+%   frequency.
+%
+%   nod    Nodes.
+%   elt    Elements.
+%   typ    Element types.
+%   d      Translation vector between two consecutive cells (1 * 3). For a
+%          user specified Green's function, d must be horizontal.
+%   green  Green's function and its parameters, see BEMMAT.
+%   SU,ST  Compact representation (struct) of the displacement and traction
+%          system matrix with fields nCell (number of cells), perm (degrees
+%          of freedom of each cell, nDofCell * nCell), real (true for a real
+%          system matrix), Ahat (discrete Fourier transform of the circulant
+%          embedding of the offset blocks, nDofCell * nDofCell * nFft *
+%          nSlice) and D (difference between the diagonal blocks and the
+%          offset zero block, nDofCell * nDofCell * nCell * nSlice, or empty
+%          if all diagonal blocks are equal, which is always the case for
+%          U).
+%   x      Vectors (nDof * nRhs).
+%   k      Slice number, counted over all dimensions of A beyond the second
+%          one (default 1).
+%   y      Product (nDof * nRhs).
+%
+%   See also BEMMAT, BEMMESHREP.
+
+% CHECK BEMFUN LICENSE
+bemfunlicense('VerifyOnce');
+
+% MATRIX VECTOR PRODUCT
+if isstruct(varargin{1})
+  k=1;
+  if nargin>2, k=varargin{3}; end
+  A=matvec(varargin{1},varargin{2},k);
+  return
+end
+
+% INPUT ARGUMENT PROCESSING
+if nargin<5, error('Not enough input arguments.'); end
+nod=varargin{1};
+elt=varargin{2};
+typ=varargin{3};
+d=varargin{4}(:).';
+green=varargin(5:end);
+if ~(length(d)==3) || (norm(d)==0)
+  error('Input argument ''d'' should be a non-zero vector (1 * 3).');
+end
+if strcmpi(green{1},'user') && (d(3)~=0)
+  error('The translation vector must be horizontal for a user specified Green''s function.');
+end
+TmatOut=(nargout>1);
+
+% CELLS
+[perm,nCell,nColDof]=cells(nod,elt,typ,d,green);
+m=size(perm,1);
+nDof=numel(perm);
+nFft=2^nextpow2(2*nCell-1);
+
+% UNIQUE OFFSET BLOCKS
+% Offsets 0..nCell-1 are the first block column, offsets -1..-(nCell-1) the
+% first block row.
+bemmat(nod,elt,typ);
+[Ue,Te]=block(perm(:),perm(:,1),nDof,TmatOut,green);
+nSlice=size(Ue,3);
+CU=zeros(m,m,nFft,nSlice);
+CU(:,:,1:nCell,:)=permute(reshape(Ue,[m nCell m nSlice]),[1 3 2 4]);
+if TmatOut
+  CT=zeros(m,m,nFft,nSlice);
+  CT(:,:,1:nCell,:)=permute(reshape(Te,[m nCell m nSlice]),[1 3 2 4]);
+end
+if nCell>1
+  [Ue,Te]=block(perm(:,1),reshape(perm(:,2:end),[],1),nDof,TmatOut,green);
+  CU(:,:,nFft:-1:nFft-nCell+2,:)=reshape(Ue,[m m nCell-1 nSlice]);
+  if TmatOut
+    CT(:,:,nFft:-1:nFft-nCell+2,:)=reshape(Te,[m m nCell-1 nSlice]);
+  end
+end
+
+% DIAGONAL BLOCKS
+% The diagonal blocks of the cells only differ from the offset zero block by
+% the regularisation of the traction integrals, which only affects the
+% (nColDof * nColDof) blocks of T on the diagonal. These are computed for
+% the collocation points of all cells in a single call, as in BEMMATUPDATE.
+DT=[];
+if TmatOut && (nCell>1)
+  nPoint=m/nColDof;
+  dof=reshape(perm,nColDof,[]);
+  rowInd=kron(dof,ones(1,nColDof));
+  colInd=repmat(reshape(dof,1,[]),nColDof,1);
+  [dummy,Td]=bemmat(rowInd+(colInd-1)*nDof,green{:});
+  Td=reshape(Td,[nColDof nColDof nPoint nCell nSlice]);
+  Td=Td-repmat(Td(:,:,:,1,:),[1 1 1 nCell 1]);
+  DT=zeros(m,m,nCell,nSlice);
+  for iPoint=1:nPoint
+    ind=nColDof*(iPoint-1)+(1:nColDof);
+    DT(ind,ind,:,:)=reshape(Td(:,:,iPoint,:,:),[nColDof nColDof nCell nSlice]);
+  end
+end
+
+A=compact(CU,[],perm,nCell);
+if TmatOut
+  B=compact(CT,DT,perm,nCell);
+end
+
+%-------------------------------------------------------------------------------
+function S=compact(C,D,perm,nCell)
+S.nCell=nCell;
+S.perm=perm;
+S.real=isreal(C) && isreal(D);
+S.Ahat=fft(C,[],3);
+S.D=D;
+if ~isempty(D) && (max(abs(D(:)))<=eps*max(abs(C(:)))), S.D=[]; end
+
+%-------------------------------------------------------------------------------
+function y=matvec(S,x,k)
+% Block circulant product in the Fourier domain, followed by the correction
+% of the diagonal blocks.
+[m,n,nFft,nSlice]=size(S.Ahat);
+nCell=S.nCell;
+nRhs=size(x,2);
+if size(x,1)~=numel(S.perm)
+  error('The number of rows of x must equal the number of degrees of freedom.');
+end
+if (k<1) || (k>nSlice) || (k~=round(k))
+  error('Slice number exceeds the number of slices.');
+end
+xc=reshape(x(S.perm(:),:),[m nCell nRhs]);
+xhat=fft(xc,nFft,2);
+yhat=zeros(m,nFft,nRhs);
+for iFft=1:nFft
+  yhat(:,iFft,:)=reshape(S.Ahat(:,:,iFft,k)*reshape(xhat(:,iFft,:),m,nRhs),[m 1 nRhs]);
+end
+yc=ifft(yhat,[],2);
+if S.real && isreal(x), yc=real(yc); end
+yc=yc(:,1:nCell,:);
+if ~isempty(S.D)
+  for iCell=1:nCell
+    yc(:,iCell,:)=yc(:,iCell,:)+reshape(S.D(:,:,iCell,k)*reshape(xc(:,iCell,:),m,nRhs),[m 1 nRhs]);
+  end
+end
+y=zeros(numel(S.perm),nRhs);
+y(S.perm(:),:)=reshape(yc,m*nCell,nRhs);
+
+%-------------------------------------------------------------------------------
+function [Ue,Te]=block(row,col,nDof,TmatOut,green)
+% System matrices for the degrees of freedom row and col on the cached mesh.
+[rowSort,iRow]=sort(row);
+[colSort,iCol]=sort(col);
+nDofRow=length(row);
+nDofCol=length(col);
+s=repmat(rowSort(:),1,nDofCol)+repmat((colSort(:).'-1)*nDof,nDofRow,1);
+Te=[];
+if TmatOut
+  [Us,Ts]=bemmat(s,green{:});
+  Te=zeros(nDofRow,nDofCol,size(Ts(:,:,:),3));
+  Te(iRow,iCol,:)=Ts(:,:,:);
+else
+  Us=bemmat(s,green{:});
+end
+Ue=zeros(nDofRow,nDofCol,size(Us(:,:,:),3));
+Ue(iRow,iCol,:)=Us(:,:,:);
+
+%-------------------------------------------------------------------------------
+function [perm,nCell,nColDof]=cells(nod,elt,typ,d,green)
+% Detect the cells of the mesh and return the degrees of freedom of each
+% cell, ordered as in the first cell.
+tol=1e-6*norm(d);
+elt(isnan(elt))=0;
+nElt=size(elt,1);
+nEltNod=size(elt,2)-2;
+[found,loc]=ismember(elt(:,3:end),nod(:,1));
+X=zeros(nElt,3*nEltNod);
+Xfound=logical(kron(found,[1 1 1]));
+nNodElt=sum(found,2);
+for iDim=1:3
+  Xd=zeros(nElt,nEltNod);
+  Xd(found)=nod(loc(found),1+iDim);
+  X(:,iDim:3:end)=Xd;
+end
+cen=[sum(X(:,1:3:end),2) sum(X(:,2:3:end),2) sum(X(:,3:3:end),2)]./repmat(nNodElt,1,3);
+
+% Elements are assigned to cells by the projection of their centroid on d.
+t=cen*d.'/(d*d.');
+eltCell=floor(t-min(t)+1e-6)+1;
+nCell=max(eltCell);
+eltCell0=find(eltCell==1);
+for iCell=2:nCell
+  eltCellk=find(eltCell==iCell);
+  ind=match(cen(eltCell0,:),cen(eltCellk,:)-repmat((iCell-1)*d,length(eltCellk),1),tol);
+  if isempty(ind)
+    error('The mesh does not consist of translated cells.');
+  end
+  eltCellk=eltCellk(ind);
+  Xk=X(eltCellk,:)-repmat((iCell-1)*d,length(ind),nEltNod);
+  Xk(~Xfound(eltCellk,:))=0;
+  if any(elt(eltCell0,2)~=elt(eltCellk,2)) || any(any(Xfound(eltCell0,:)~=Xfound(eltCellk,:))) ...
+     || any(any(abs(Xk-X(eltCell0,:))>tol))
+    error('The mesh does not consist of translated cells.');
+  end
+end
+
+% Collocation points are assigned to the cell of their element(s).
+[col,colTyp,colID]=bemcollpoints(nod,elt,typ);
+nCol=size(col,1);
+colCell=zeros(nCol,1);
+[isElt,iElt]=ismember(colID,elt(:,1));
+colCell(colTyp==1)=eltCell(iElt(colTyp==1 & isElt));
+nodCellMin=inf(size(nod,1),1);
+nodCellMax=zeros(size(nod,1),1);
+for iNod=1:nEltNod
+  ind=found(:,iNod);
+  nodCellMin(loc(ind,iNod))=min(nodCellMin(loc(ind,iNod)),eltCell(ind));
+  nodCellMax(loc(ind,iNod))=max(nodCellMax(loc(ind,iNod)),eltCell(ind));
+end
+[isNod,iNod]=ismember(colID,nod(:,1));
+iNod=iNod(colTyp==2 & isNod);
+if any(nodCellMin(iNod)~=nodCellMax(iNod))
+  error('Collocation points are shared by different cells.');
+end
+colCell(colTyp==2)=nodCellMin(iNod);
+
+col0=find(colCell==1);
+m=length(col0);
+colPerm=zeros(m,nCell);
+colPerm(:,1)=col0;
+for iCell=2:nCell
+  colCellk=find(colCell==iCell);
+  ind=match(col(col0,:),col(colCellk,:)-repmat((iCell-1)*d,length(colCellk),1),tol);
+  if isempty(ind) || any(colTyp(col0)~=colTyp(colCellk(ind)))
+    error('The mesh does not consist of translated cells.');
+  end
+  colPerm(:,iCell)=colCellk(ind);
+end
+
+% Degrees of freedom
+nColDof=coldof(elt,typ,green);
+perm=zeros(nColDof*m,nCell);
+for iDof=1:nColDof
+  perm(iDof:nColDof:end,:)=nColDof*(colPerm-1)+iDof;
+end
+
+%-------------------------------------------------------------------------------
+function ind=match(P,Q,tol)
+% Index ind such that Q(ind,:) equals P within the tolerance tol, or empty
+% if no such permutation exists.
+ind=[];
+if size(P,1)~=size(Q,1), return; end
+n=size(P,1);
+ind=zeros(n,1);
+for i=1:n
+  dist=sqrt(sum((Q-repmat(P(i,:),n,1)).^2,2));
+  [dmin,ind(i)]=min(dist);
+  if dmin>tol, ind=[]; return; end
+end
+if length(unique(ind))~=n, ind=[]; end
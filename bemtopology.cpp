@@ -0,0 +1,204 @@
+#include <new>
+#include <thread>
+#include "eltdef.h"
+#include "bemtopology.h"
+
+using namespace std;
+
+//==============================================================================
+static size_t hashnode(const unsigned int& NodeID)
+// Hash of a node number.
+//==============================================================================
+{
+  unsigned long long h=(unsigned long long)NodeID*0x9e3779b97f4a7c15ULL;
+  h^=h>>29;
+  return (size_t)h;
+}
+
+//==============================================================================
+void bemtopologyinit(const double* const Elt, const unsigned int& nElt,
+                     const unsigned int& maxEltCol, const double* const Nod,
+                     const unsigned int& nNod, const unsigned int* const TypeID,
+                     const unsigned int* const nKeyOpt,
+                     const char* const TypeName[], const char* const TypeKeyOpts[],
+                     const unsigned int& nEltType, BemTopology& topo)
+//==============================================================================
+{
+  topo.Nod=Nod;
+  topo.nNod=nNod;
+  topo.nElt=nElt;
+  topo.nSlot=0;
+  topo.slot=0;
+  topo.nEltType=nEltType;
+  topo.typeDef=0;
+  topo.eltType=0;
+  topo.eltPtr=0;
+  topo.eltNod=0;
+  topo.eltColl=0;
+  topo.nCentroidColl=0;
+  topo.nNodalColl=0;
+
+  // NODE HASH TABLE, AT MOST HALF FULL
+  topo.nSlot=1;
+  while (topo.nSlot<2*(size_t)nNod) topo.nSlot*=2;
+  topo.slot=new(nothrow) unsigned int[topo.nSlot];
+  if (topo.slot==0) throw("Out of memory.");
+  for (size_t iSlot=0; iSlot<topo.nSlot; iSlot++) topo.slot[iSlot]=0;
+  for (unsigned int iNod=0; iNod<nNod; iNod++)
+  {
+    const unsigned int NodeID=(unsigned int)(Nod[iNod]);
+    size_t iSlot=hashnode(NodeID)&(topo.nSlot-1);
+    bool found=false;
+    while ((topo.slot[iSlot]!=0) && !found)
+    {
+      found=((unsigned int)(Nod[topo.slot[iSlot]-1])==NodeID);
+      iSlot=(iSlot+1)&(topo.nSlot-1);
+    }
+    if (!found) topo.slot[iSlot]=iNod+1;
+  }
+
+  // ELEMENT TYPES
+  topo.typeDef=new(nothrow) BemEltTypeDef[nEltType];
+  topo.eltType=new(nothrow) unsigned int[nElt];
+  topo.eltPtr=new(nothrow) size_t[nElt+1];
+  if ((topo.typeDef==0) || (topo.eltType==0) || (topo.eltPtr==0)) throw("Out of memory.");
+  for (unsigned int iTyp=0; iTyp<nEltType; iTyp++) topo.typeDef[iTyp].used=false;
+  topo.eltPtr[0]=0;
+  for (unsigned int iElt=0; iElt<nElt; iElt++)
+  {
+    const unsigned int EltType=(unsigned int)(Elt[nElt+iElt]);
+    int TypeInd=-1;
+    for (unsigned int iTyp=0; iTyp<nEltType; iTyp++) if (TypeID[iTyp]==EltType) TypeInd=iTyp;
+    if (TypeInd==-1) throw("Element type not found in type cell array.");
+    BemEltTypeDef& def=topo.typeDef[TypeInd];
+    if (!def.used)
+    {
+      unsigned int AxiSym, Periodic, nGauss, nEltDiv, nGaussSing, nEltDivSing;
+      eltdef(EltType,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,def.parent,
+             def.nEltNod,def.nEltColl,def.shapeN,def.shapeM,def.eltDim,AxiSym,
+             Periodic,nGauss,nEltDiv,nGaussSing,nEltDivSing);
+      def.used=true;
+    }
+    if (maxEltCol<2+def.nEltNod) throw("Number of colums in the element array is incompatible with elements defined.");
+    topo.eltType[iElt]=TypeInd;
+    topo.eltPtr[iElt+1]=topo.eltPtr[iElt]+def.nEltNod;
+  }
+
+  // NODE INDICES OF THE ELEMENTS
+  const size_t nEntry=topo.eltPtr[nElt];
+  topo.eltNod=new(nothrow) unsigned int[nEntry];
+  topo.eltColl=new(nothrow) unsigned int[nEntry];
+  if ((topo.eltNod==0) || (topo.eltColl==0)) throw("Out of memory.");
+  for (unsigned int iElt=0; iElt<nElt; iElt++)
+  {
+    const unsigned int nEltNod=topo.typeDef[topo.eltType[iElt]].nEltNod;
+    for (unsigned int iEltNod=0; iEltNod<nEltNod; iEltNod++)
+    {
+      const int NodIndex=bemtopologynode(topo,(unsigned int)(Elt[(2+iEltNod)*nElt+iElt]));
+      if (NodIndex<0) throw("Unknown node in element array.");
+      topo.eltNod[topo.eltPtr[iElt]+iEltNod]=NodIndex;
+    }
+  }
+
+  // COLLOCATION POINTS: CENTROIDS FIRST, THEN THE NODES
+  unsigned int* const nodColl=new(nothrow) unsigned int[nNod];
+  if (nodColl==0) throw("Out of memory.");
+  for (unsigned int iNod=0; iNod<nNod; iNod++) nodColl[iNod]=0;
+  for (unsigned int iElt=0; iElt<nElt; iElt++)
+  {
+    const BemEltTypeDef& def=topo.typeDef[topo.eltType[iElt]];
+    if (def.nEltColl==1) topo.eltColl[topo.eltPtr[iElt]]=topo.nCentroidColl++;
+    else for (unsigned int iColl=0; iColl<def.nEltColl; iColl++) nodColl[topo.eltNod[topo.eltPtr[iElt]+iColl]]=1;
+  }
+  for (unsigned int iNod=0; iNod<nNod; iNod++)
+  {
+    if (nodColl[iNod]==1) nodColl[iNod]=topo.nCentroidColl+topo.nNodalColl++;
+  }
+  for (unsigned int iElt=0; iElt<nElt; iElt++)
+  {
+    const BemEltTypeDef& def=topo.typeDef[topo.eltType[iElt]];
+    if (def.nEltColl==1) continue;
+    for (unsigned int iColl=0; iColl<def.nEltColl; iColl++)
+    {
+      const size_t iEntry=topo.eltPtr[iElt]+iColl;
+      topo.eltColl[iEntry]=nodColl[topo.eltNod[iEntry]];
+    }
+  }
+  delete [] nodColl;
+}
+
+//==============================================================================
+int bemtopologynode(const BemTopology& topo, const unsigned int& NodeID)
+//==============================================================================
+{
+  size_t iSlot=hashnode(NodeID)&(topo.nSlot-1);
+  while (topo.slot[iSlot]!=0)
+  {
+    const unsigned int iNod=topo.slot[iSlot]-1;
+    if ((unsigned int)(topo.Nod[iNod])==NodeID) return (int)iNod;
+    iSlot=(iSlot+1)&(topo.nSlot-1);
+  }
+  return -1;
+}
+
+//==============================================================================
+void bemtopologyloop(void (*worker)(void* const data, const unsigned int& iEltBeg,
+                                    const unsigned int& iEltEnd),
+                     void* const data, const unsigned int& nElt,
+                     const unsigned int& nThread)
+//==============================================================================
+{
+  unsigned int nWorker=(nThread<nElt ? nThread : nElt);
+  if (nWorker<=1)
+  {
+    worker(data,0,nElt);
+    return;
+  }
+  const unsigned int nRange=(nElt+nWorker-1)/nWorker;
+  thread* const threads=new(nothrow) thread[nWorker];
+  unsigned int nStarted=0;
+  if (threads!=0)
+  {
+    try
+    {
+      for (unsigned int iWorker=1; iWorker<nWorker; iWorker++)
+      {
+        const unsigned int iEltBeg=(nRange*iWorker<nElt ? nRange*iWorker : nElt);
+        const unsigned int iEltEnd=(iEltBeg+nRange<nElt ? iEltBeg+nRange : nElt);
+        threads[iWorker]=thread(worker,data,iEltBeg,iEltEnd);
+        nStarted=iWorker;
+      }
+    }
+    catch (...)
+    {
+    }
+  }
+  worker(data,0,(nRange<nElt ? nRange : nElt));
+  for (unsigned int iWorker=1; iWorker<=nStarted; iWorker++) threads[iWorker].join();
+  for (unsigned int iWorker=nStarted+1; iWorker<nWorker; iWorker++)
+  {
+    const unsigned int iEltBeg=(nRange*iWorker<nElt ? nRange*iWorker : nElt);
+    const unsigned int iEltEnd=(iEltBeg+nRange<nElt ? iEltBeg+nRange : nElt);
+    worker(data,iEltBeg,iEltEnd);
+  }
+  delete [] threads;
+}
+
+//==============================================================================
+void bemtopologyclear(BemTopology& topo)
+//==============================================================================
+{
+  delete [] topo.slot;
+  delete [] topo.typeDef;
+  delete [] topo.eltType;
+  delete [] topo.eltPtr;
+  delete [] topo.eltNod;
+  delete [] topo.eltColl;
+  topo.slot=0;
+  topo.typeDef=0;
+  topo.eltType=0;
+  topo.eltPtr=0;
+  topo.eltNod=0;
+  topo.eltColl=0;
+  topo.nSlot=0;
+}
@@ -0,0 +1,76 @@
+#include <stddef.h>
+
+#ifndef _BEMELTTYPEDEF_
+#define _BEMELTTYPEDEF_
+struct BemEltTypeDef
+{
+  bool used;                 // Type occurs in the element array
+  unsigned int parent;       // Parent element (0 line, 1 triangle, 2 quadrilateral)
+  unsigned int nEltNod;      // Number of nodes
+  unsigned int nEltColl;     // Number of collocation points
+  unsigned int shapeN;       // Shape function type of the geometry
+  unsigned int shapeM;       // Shape function type of the collocation points
+  unsigned int eltDim;       // Element dimension
+};
+/*   Definition of an element type, as returned by eltdef.
+ */
+#endif
+
+#ifndef _BEMTOPOLOGY_
+#define _BEMTOPOLOGY_
+struct BemTopology
+{
+  const double* Nod;         // Node array
+  unsigned int nNod;         // Number of nodes
+  unsigned int nElt;         // Number of elements
+  size_t nSlot;              // Number of slots of the node hash table (power of 2)
+  unsigned int* slot;        // Node index+1 per slot, 0 if the slot is empty
+  unsigned int nEltType;     // Number of element types
+  BemEltTypeDef* typeDef;    // Element type definitions (nEltType)
+  unsigned int* eltType;     // Type index per element (nElt)
+  size_t* eltPtr;            // First entry of each element in eltNod (nElt+1)
+  unsigned int* eltNod;      // Node indices of the elements
+  unsigned int* eltColl;     // Collocation indices of the elements, in the
+                             // layout of eltNod: the centroid or the first
+                             // nEltColl nodes
+  unsigned int nCentroidColl; // Number of centroid collocation points
+  unsigned int nNodalColl;   // Number of nodal collocation points
+};
+/*   Topology of a boundary element mesh: the node indices and the
+ *   collocation point indices of all elements. The node numbers are looked up
+ *   in a hash table instead of the linear search of BemNodeIndex. The
+ *   collocation points are numbered as by BemCollPoints and BemCollCoords:
+ *   first the centroids in the order of the elements, then the nodal
+ *   collocation points in the order of the nodes.
+ */
+#endif
+
+#ifndef _BEMTOPOLOGYINIT_
+#define _BEMTOPOLOGYINIT_
+void bemtopologyinit(const double* const Elt, const unsigned int& nElt,
+                     const unsigned int& maxEltCol, const double* const Nod,
+                     const unsigned int& nNod, const unsigned int* const TypeID,
+                     const unsigned int* const nKeyOpt,
+                     const char* const TypeName[], const char* const TypeKeyOpts[],
+                     const unsigned int& nEltType, BemTopology& topo);
+/*   Builds the topology of the mesh (Elt,Nod). The topology must be released
+ *   with bemtopologyclear, also if an exception is thrown.
+ */
+
+int bemtopologynode(const BemTopology& topo, const unsigned int& NodeID);
+/*   Index of the first node with number NodeID, or -1 if there is none.
+ */
+
+void bemtopologyloop(void (*worker)(void* const data, const unsigned int& iEltBeg,
+                                    const unsigned int& iEltEnd),
+                     void* const data, const unsigned int& nElt,
+                     const unsigned int& nThread);
+/*   Calls worker for consecutive ranges of elements [iEltBeg,iEltEnd) on
+ *   nThread threads. The worker must not throw exceptions. If a thread
+ *   cannot be started, its range is processed by the calling thread.
+ */
+
+void bemtopologyclear(BemTopology& topo);
+/*   Releases the topology.
+ */
+#endif
@@ -0,0 +1,233 @@
+/*BEMTQ   Boundary element stress transfer matrix.
+ *
+ *   Tq = BEMTQ(nod,elt,typ) computes the boundary element stress transfer
+ *   matrix Tq defined as the integral:
+ *
+ *           /
+ *   Tq_ij = |  M_i * M_j  dS
+ *           /
+ *         Gamma
+ *
+ *   of the product of the boundary element interpolation functions M_i and
+ *   M_j of the collocation points i and j. In the case of a conforming
+ *   boundary element-finite element coupling, Tq relates the boundary
+ *   element tractions t and the finite element forces Q as:
+ *
+ *       Q=Tq*t
+ *
+ *   This relationship is derived from the principle of virtual work along the
+ *   interface: the virtual work performed by the load vector Q and the
+ *   interface traction should be equal under any virtual displacement field.
+ *   For axisymmetric elements, the integral includes the factor 2*pi*r.
+ *
+ *   The traction interpolation function is constant in the case of a centroid
+ *   collocated boundary element, in which case the diagonal of Tq contains
+ *   the element area.
+ *
+ *   Tq = BEMTQ(nod,elt,typ,probDim) computes the matrix for probDim degrees
+ *   of freedom per collocation point (default 3).
+ *
+ *   Tq = BEMTQ(...,'threads',nThread) distributes the elements over nThread
+ *   threads (default 1).
+ *
+ *   nod      Nodes (nNod * 4).
+ *   elt      Elements.
+ *   typ      Element types.
+ *   probDim  Number of degrees of freedom per collocation point (1, 2 or 3).
+ *   Tq       Sparse stress transfer matrix (nDof * nDof), with
+ *            nDof=probDim*nCol.
+ */
+
+/* $Make: mex -O -output bemtq bemtq_mex.cpp bemtopology.cpp bemmass.cpp bemsparse.cpp
+                         eltdef.cpp shapefun.cpp gausspw.cpp bemisaxisym.cpp
+                         checklicense.cpp ripemd128.cpp$*/
+
+#include "mex.h"
+#include <string.h>
+#include <math.h>
+#include <new>
+#include "eltdef.h"
+#include "bemisaxisym.h"
+#include "bemtopology.h"
+#include "bemmass.h"
+#include "checklicense.h"
+
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
+using namespace std;
+
+//==============================================================================
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+//==============================================================================
+{
+  BemTopology topo={};
+  unsigned int nEltType=0;
+  unsigned int nTypParsed=0;
+  unsigned int* TypeID=0;
+  unsigned int* nKeyOpt=0;
+  char** TypeName=0;
+  char** TypeKeyOpts=0;
+  mxArray* Q=0;
+  const char* error=0;
+  try
+  {
+    checklicense();
+
+    if (nrhs<3) throw("Not enough input arguments.");
+    if (nlhs>1) throw("Too many output arguments.");
+
+    if (!mxIsDouble(prhs[0])) throw("Input argument 'nod' must be a double array.");
+    if (mxIsSparse(prhs[0])) throw("Input argument 'nod' must not be sparse.");
+    if (mxIsComplex(prhs[0])) throw("Input argument 'nod' must be real.");
+    if (!(mxGetN(prhs[0])==4)) throw("Input argument 'nod' should have 4 columns.");
+    const unsigned int nNod=mxGetM(prhs[0]);
+    const double* const Nod=mxGetPr(prhs[0]);
+
+    if (!mxIsDouble(prhs[1])) throw("Input argument 'elt' must be a double array.");
+    if (mxIsSparse(prhs[1])) throw("Input argument 'elt' must not be sparse.");
+    if (mxIsComplex(prhs[1])) throw("Input argument 'elt' must be real.");
+    if (mxGetN(prhs[1])<=2) throw("Input argument 'elt' should have at least 3 columns.");
+    const double* const Elt=mxGetPr(prhs[1]);
+    const unsigned int nElt=mxGetM(prhs[1]);
+    const unsigned int maxEltCol=mxGetN(prhs[1]);
+
+    bool keyOpts=true;
+    if (mxGetN(prhs[2])==3) keyOpts=true;
+    else if  (mxGetN(prhs[2])==2) keyOpts=false;
+    else throw("Input argument 'typ' should have 2 or 3 columns.");
+    if (!(mxIsCell(prhs[2]))) throw("Input argument 'typ' should be a cell array.");
+    nEltType=mxGetM(prhs[2]);
+    const unsigned int maxKeyOpts=50;  // Maximum number of keyoptions per element type
+    TypeID=new(nothrow) unsigned int[nEltType];
+    nKeyOpt=new(nothrow) unsigned int[nEltType];
+    TypeName=new(nothrow) char*[nEltType];
+    TypeKeyOpts=new(nothrow) char*[nEltType*maxKeyOpts];
+    if ((TypeID==0) || (nKeyOpt==0) || (TypeName==0) || (TypeKeyOpts==0)) throw("Out of memory.");
+    for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+    {
+      // TypeID
+      const mxArray* TypPtr0=mxGetCell(prhs[2],iTyp+nEltType*0);
+      if (!mxIsNumeric(TypPtr0)) throw("Type ID should be numeric.");
+      if (mxIsSparse(TypPtr0)) throw("Type ID should not be sparse.");
+      if (mxIsComplex(TypPtr0)) throw("Type ID should not be complex.");
+      if (!(mxGetNumberOfElements(TypPtr0)==1)) throw("Type ID should be a scalar.");
+      TypeID[iTyp]=(unsigned int)(mxGetScalar(TypPtr0));
+
+      // TypeName
+      const mxArray* TypPtr1=mxGetCell(prhs[2],iTyp+nEltType*1);
+      if (!mxIsChar(TypPtr1)) throw("Element types should be input as stings.");
+      nKeyOpt[iTyp]=0;
+      TypeName[iTyp]=mxArrayToString(TypPtr1);
+      nTypParsed=iTyp+1;
+
+      // TypeKeyOpts
+      if (keyOpts)
+      {
+        const mxArray* TypPtr2=mxGetCell(prhs[2],iTyp+nEltType*2); // Keyoptions cell array
+        if (!mxIsCell(TypPtr2)) throw("Keyopts should be input as a cell array of stings.");
+        if (mxGetNumberOfElements(TypPtr2)>maxKeyOpts) throw("Number of keyoptions is too large.");
+        for (unsigned int iKeyOpt=0; iKeyOpt<mxGetNumberOfElements(TypPtr2); iKeyOpt++)
+        {
+          const mxArray* keyOptPtr=mxGetCell(TypPtr2,iKeyOpt);
+          if (!mxIsChar(keyOptPtr)) throw("Keyopts should be input as a cell array of stings.");
+          TypeKeyOpts[iTyp+nEltType*iKeyOpt]=mxArrayToString(keyOptPtr);
+          nKeyOpt[iTyp]=iKeyOpt+1;
+        }
+      }
+    }
+
+    // PROBLEM DIMENSION AND OPTIONS
+    int iArg=3;
+    unsigned int probDim=3;
+    if ((nrhs>3) && !mxIsChar(prhs[3]))
+    {
+      if (!mxIsDouble(prhs[3]) || (mxGetNumberOfElements(prhs[3])!=1)) throw("Input argument 'probDim' must be a scalar.");
+      const double v=mxGetScalar(prhs[3]);
+      if (!((v==1.0) || (v==2.0) || (v==3.0))) throw("Input argument 'probDim' must be 1, 2 or 3.");
+      probDim=(unsigned int)v;
+      iArg=4;
+    }
+    unsigned int nThread=1;
+    if ((nrhs-iArg)%2!=0) throw("Options must be given as 'key',value pairs.");
+    for (; iArg<nrhs; iArg+=2)
+    {
+      if (!mxIsChar(prhs[iArg])) throw("Options must be given as 'key',value pairs.");
+      char* const key=mxArrayToString(prhs[iArg]);
+      const mxArray* const v=prhs[iArg+1];
+      const bool isScalar=mxIsDouble(v) && (mxGetNumberOfElements(v)==1);
+      const double x=(isScalar ? mxGetScalar(v) : 0.0);
+      const char* keyError=0;
+      if (strcasecmp(key,"threads")==0)
+      {
+        if (isScalar && (x>=1.0) && (x==floor(x))) nThread=(unsigned int)x;
+        else keyError="Option 'threads' must be a positive integer.";
+      }
+      else keyError="Unknown option.";
+      mxFree(key);
+      if (keyError!=0) throw(keyError);
+    }
+
+    // MESH TOPOLOGY
+    bemtopologyinit(Elt,nElt,maxEltCol,Nod,nNod,TypeID,nKeyOpt,TypeName,TypeKeyOpts,nEltType,topo);
+    const unsigned int nTotalColl=topo.nCentroidColl+topo.nNodalColl;
+
+    const bool probAxi=isAxisym(Elt,nElt,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType);
+
+    // MASS MATRIX OF THE COLLOCATION POINTS
+    Q=bemmass(topo,probAxi,nThread);
+    if (probDim==1)
+    {
+      plhs[0]=Q;
+      Q=0;
+    }
+    else
+    {
+      // ONE BLOCK probDim*i+iDim PER DEGREE OF FREEDOM: THE ROWS REMAIN SORTED
+      const mwIndex* const Jq=mxGetJc(Q);
+      const mwIndex* const Iq=mxGetIr(Q);
+      const double* const Pq=mxGetPr(Q);
+      const size_t nDof=(size_t)probDim*nTotalColl;
+      const size_t nzmax=probDim*Jq[nTotalColl];
+      plhs[0]=mxCreateSparse(nDof,nDof,(nzmax>0 ? nzmax : 1),mxREAL);
+      if (plhs[0]==0) throw("Out of memory.");
+      mwIndex* const Jc=mxGetJc(plhs[0]);
+      mwIndex* const Ir=mxGetIr(plhs[0]);
+      double* const Pr=mxGetPr(plhs[0]);
+      size_t k=0;
+      Jc[0]=0;
+      for (unsigned int jColl=0; jColl<nTotalColl; jColl++)
+      {
+        for (unsigned int iDim=0; iDim<probDim; iDim++)
+        {
+          for (mwIndex kq=Jq[jColl]; kq<Jq[jColl+1]; kq++)
+          {
+            Ir[k]=probDim*Iq[kq]+iDim;
+            Pr[k]=Pq[kq];
+            k++;
+          }
+          Jc[probDim*jColl+iDim+1]=k;
+        }
+      }
+    }
+  }
+  catch (const char* exception)
+  {
+    error=exception;
+  }
+
+  // DEALLOCATE MEMORY ALLOCATED BY "mxArrayToString" IN TYPE DEFINITIONS
+  for (unsigned int iTyp=0; iTyp<nTypParsed; iTyp++)
+  {
+    mxFree(TypeName[iTyp]);
+    for (unsigned int iKeyOpt=0; iKeyOpt<nKeyOpt[iTyp]; iKeyOpt++) mxFree(TypeKeyOpts[iTyp+nEltType*iKeyOpt]);
+  }
+  delete [] TypeID;
+  delete [] nKeyOpt;
+  delete [] TypeName;
+  delete [] TypeKeyOpts;
+  bemtopologyclear(topo);
+  if (Q!=0) mxDestroyArray(Q);
+  if (error!=0) mexErrMsgTxt(error);
+}
@@ -0,0 +1,314 @@
+/*BEMTU   Boundary element displacement transfer matrix.
+ *
+ *   Tu = BEMTU(nod,elt,typ) computes the boundary element displacement
+ *   transfer matrix defined as:
+ *
+ *   u=Tu*unod
+ *
+ *   where u are the boundary element degrees of freedom and unod are the
+ *   nodal degrees of freedom. u and unod are equal for a nodal collocated
+ *   boundary element formulation, in which case Tu is a unity matrix.
+ *
+ *   In the case of a centroid collocated boundary element formulation,
+ *   the elements of the matrix Tu are derived from the boundary element
+ *   shape functions.
+ *
+ *   Tu = BEMTU(nod,elt,typ,probDim) computes the matrix for probDim degrees
+ *   of freedom per node and collocation point (default 3).
+ *
+ *   Tu = BEMTU(...,'threads',nThread) distributes the elements over nThread
+ *   threads (default 1).
+ *
+ *   nod      Nodes (nNod * 4).
+ *   elt      Elements.
+ *   typ      Element types.
+ *   probDim  Number of degrees of freedom per node (1, 2 or 3).
+ *   Tu       Sparse displacement transfer matrix (probDim*nCol * probDim*nNod).
+ */
+
+/* $Make: mex -O -output bemtu bemtu_mex.cpp bemtopology.cpp bemsparse.cpp
+                         eltdef.cpp shapefun.cpp checklicense.cpp ripemd128.cpp$*/
+
+#include "mex.h"
+#include <string.h>
+#include <math.h>
+#include <new>
+#include "eltdef.h"
+#include "shapefun.h"
+#include "bemtopology.h"
+#include "bemsparse.h"
+#include "checklicense.h"
+
+#ifndef __GNUC__
+#define strcasecmp _strcmpi
+#endif
+
+using namespace std;
+
+struct TuData
+{
+  const BemTopology* topo;
+  unsigned int probDim;
+  const double* const* N;   // Shape functions in the collocation points per type
+  const size_t* tripPtr;     // First triplet of each element (nElt+1)
+  unsigned int* row;
+  unsigned int* col;
+  double* val;
+};
+
+//==============================================================================
+static void tuworker(void* const data, const unsigned int& iEltBeg,
+                     const unsigned int& iEltEnd)
+// Triplets of the elements [iEltBeg,iEltEnd).
+//==============================================================================
+{
+  const TuData& d=*((const TuData*)data);
+  const BemTopology& topo=*d.topo;
+  const unsigned int probDim=d.probDim;
+  for (unsigned int iElt=iEltBeg; iElt<iEltEnd; iElt++)
+  {
+    const BemEltTypeDef& def=topo.typeDef[topo.eltType[iElt]];
+    const double* const N=d.N[topo.eltType[iElt]];
+    const unsigned int* const eltNod=topo.eltNod+topo.eltPtr[iElt];
+    const unsigned int* const eltColl=topo.eltColl+topo.eltPtr[iElt];
+    size_t iTrip=d.tripPtr[iElt];
+    for (unsigned int iEltColl=0; iEltColl<def.nEltColl; iEltColl++)
+    {
+      for (unsigned int iEltNod=0; iEltNod<def.nEltNod; iEltNod++)
+      {
+        for (unsigned int iDim=0; iDim<probDim; iDim++)
+        {
+          d.row[iTrip]=probDim*eltColl[iEltColl]+iDim;
+          d.col[iTrip]=probDim*eltNod[iEltNod]+iDim;
+          d.val[iTrip]=N[def.nEltNod*iEltColl+iEltNod];
+          iTrip++;
+        }
+      }
+    }
+  }
+}
+
+//==============================================================================
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+//==============================================================================
+{
+  BemTopology topo={};
+  unsigned int nEltType=0;
+  unsigned int nTypParsed=0;
+  unsigned int* TypeID=0;
+  unsigned int* nKeyOpt=0;
+  char** TypeName=0;
+  char** TypeKeyOpts=0;
+  double* shape=0;
+  double** N=0;
+  double* xi=0;
+  size_t* tripPtr=0;
+  unsigned int* row=0;
+  unsigned int* col=0;
+  double* val=0;
+  const char* error=0;
+  try
+  {
+    checklicense();
+
+    if (nrhs<3) throw("Not enough input arguments.");
+    if (nlhs>1) throw("Too many output arguments.");
+
+    if (!mxIsDouble(prhs[0])) throw("Input argument 'nod' must be a double array.");
+    if (mxIsSparse(prhs[0])) throw("Input argument 'nod' must not be sparse.");
+    if (mxIsComplex(prhs[0])) throw("Input argument 'nod' must be real.");
+    if (!(mxGetN(prhs[0])==4)) throw("Input argument 'nod' should have 4 columns.");
+    const unsigned int nNod=mxGetM(prhs[0]);
+    const double* const Nod=mxGetPr(prhs[0]);
+
+    if (!mxIsDouble(prhs[1])) throw("Input argument 'elt' must be a double array.");
+    if (mxIsSparse(prhs[1])) throw("Input argument 'elt' must not be sparse.");
+    if (mxIsComplex(prhs[1])) throw("Input argument 'elt' must be real.");
+    if (mxGetN(prhs[1])<=2) throw("Input argument 'elt' should have at least 3 columns.");
+    const double* const Elt=mxGetPr(prhs[1]);
+    const unsigned int nElt=mxGetM(prhs[1]);
+    const unsigned int maxEltCol=mxGetN(prhs[1]);
+
+    bool keyOpts=true;
+    if (mxGetN(prhs[2])==3) keyOpts=true;
+    else if  (mxGetN(prhs[2])==2) keyOpts=false;
+    else throw("Input argument 'typ' should have 2 or 3 columns.");
+    if (!(mxIsCell(prhs[2]))) throw("Input argument 'typ' should be a cell array.");
+    nEltType=mxGetM(prhs[2]);
+    const unsigned int maxKeyOpts=50;  // Maximum number of keyoptions per element type
+    TypeID=new(nothrow) unsigned int[nEltType];
+    nKeyOpt=new(nothrow) unsigned int[nEltType];
+    TypeName=new(nothrow) char*[nEltType];
+    TypeKeyOpts=new(nothrow) char*[nEltType*maxKeyOpts];
+    if ((TypeID==0) || (nKeyOpt==0) || (TypeName==0) || (TypeKeyOpts==0)) throw("Out of memory.");
+    for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+    {
+      // TypeID
+      const mxArray* TypPtr0=mxGetCell(prhs[2],iTyp+nEltType*0);
+      if (!mxIsNumeric(TypPtr0)) throw("Type ID should be numeric.");
+      if (mxIsSparse(TypPtr0)) throw("Type ID should not be sparse.");
+      if (mxIsComplex(TypPtr0)) throw("Type ID should not be complex.");
+      if (!(mxGetNumberOfElements(TypPtr0)==1)) throw("Type ID should be a scalar.");
+      TypeID[iTyp]=(unsigned int)(mxGetScalar(TypPtr0));
+
+      // TypeName
+      const mxArray* TypPtr1=mxGetCell(prhs[2],iTyp+nEltType*1);
+      if (!mxIsChar(TypPtr1)) throw("Element types should be input as stings.");
+      nKeyOpt[iTyp]=0;
+      TypeName[iTyp]=mxArrayToString(TypPtr1);
+      nTypParsed=iTyp+1;
+
+      // TypeKeyOpts
+      if (keyOpts)
+      {
+        const mxArray* TypPtr2=mxGetCell(prhs[2],iTyp+nEltType*2); // Keyoptions cell array
+        if (!mxIsCell(TypPtr2)) throw("Keyopts should be input as a cell array of stings.");
+        if (mxGetNumberOfElements(TypPtr2)>maxKeyOpts) throw("Number of keyoptions is too large.");
+        for (unsigned int iKeyOpt=0; iKeyOpt<mxGetNumberOfElements(TypPtr2); iKeyOpt++)
+        {
+          const mxArray* keyOptPtr=mxGetCell(TypPtr2,iKeyOpt);
+          if (!mxIsChar(keyOptPtr)) throw("Keyopts should be input as a cell array of stings.");
+          TypeKeyOpts[iTyp+nEltType*iKeyOpt]=mxArrayToString(keyOptPtr);
+          nKeyOpt[iTyp]=iKeyOpt+1;
+        }
+      }
+    }
+
+    // PROBLEM DIMENSION AND OPTIONS
+    int iArg=3;
+    unsigned int probDim=3;
+    if ((nrhs>3) && !mxIsChar(prhs[3]))
+    {
+      if (!mxIsDouble(prhs[3]) || (mxGetNumberOfElements(prhs[3])!=1)) throw("Input argument 'probDim' must be a scalar.");
+      const double v=mxGetScalar(prhs[3]);
+      if (!((v==1.0) || (v==2.0) || (v==3.0))) throw("Input argument 'probDim' must be 1, 2 or 3.");
+      probDim=(unsigned int)v;
+      iArg=4;
+    }
+    unsigned int nThread=1;
+    if ((nrhs-iArg)%2!=0) throw("Options must be given as 'key',value pairs.");
+    for (; iArg<nrhs; iArg+=2)
+    {
+      if (!mxIsChar(prhs[iArg])) throw("Options must be given as 'key',value pairs.");
+      char* const key=mxArrayToString(prhs[iArg]);
+      const mxArray* const v=prhs[iArg+1];
+      const bool isScalar=mxIsDouble(v) && (mxGetNumberOfElements(v)==1);
+      const double x=(isScalar ? mxGetScalar(v) : 0.0);
+      const char* keyError=0;
+      if (strcasecmp(key,"threads")==0)
+      {
+        if (isScalar && (x>=1.0) && (x==floor(x))) nThread=(unsigned int)x;
+        else keyError="Option 'threads' must be a positive integer.";
+      }
+      else keyError="Unknown option.";
+      mxFree(key);
+      if (keyError!=0) throw(keyError);
+    }
+
+    // MESH TOPOLOGY
+    bemtopologyinit(Elt,nElt,maxEltCol,Nod,nNod,TypeID,nKeyOpt,TypeName,TypeKeyOpts,nEltType,topo);
+    const unsigned int nTotalColl=topo.nCentroidColl+topo.nNodalColl;
+
+    // SHAPE FUNCTIONS IN THE COLLOCATION POINTS PER ELEMENT TYPE
+    size_t nShape=0;
+    unsigned int maxEltNod=1;
+    for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+    {
+      const BemEltTypeDef& def=topo.typeDef[iTyp];
+      if (!def.used) continue;
+      nShape+=(size_t)def.nEltColl*def.nEltNod;
+      if (def.nEltNod>maxEltNod) maxEltNod=def.nEltNod;
+    }
+    shape=new(nothrow) double[nShape];
+    N=new(nothrow) double*[nEltType];
+    xi=new(nothrow) double[4*maxEltNod];
+    if ((shape==0) || (N==0) || (xi==0)) throw("Out of memory.");
+    double* const eltNodXi=xi+2*maxEltNod;
+    nShape=0;
+    for (unsigned int iTyp=0; iTyp<nEltType; iTyp++)
+    {
+      const BemEltTypeDef& def=topo.typeDef[iTyp];
+      N[iTyp]=0;
+      if (!def.used) continue;
+      N[iTyp]=shape+nShape;
+      nShape+=(size_t)def.nEltColl*def.nEltNod;
+      for (unsigned int i=0; i<2*maxEltNod; i++)
+      {
+        xi[i]=0.0;
+        eltNodXi[i]=0.0;
+      }
+      if (def.nEltColl==1)
+      {
+        // Centroid collocation
+        if (def.parent==1)
+        {
+          xi[0]=3.333333333333333e-01;
+          xi[1]=3.333333333333333e-01;
+        }
+        shapefun(def.shapeN,1,xi,N[iTyp]);
+      }
+      else
+      {
+        // Nodal collocation in the first nEltColl nodes
+        eltnoddef(TypeID[iTyp],TypeID,TypeName,nEltType,eltNodXi);
+        for (unsigned int iColl=0; iColl<def.nEltColl; iColl++)
+        {
+          xi[iColl]=eltNodXi[iColl];
+          if (def.eltDim>1) xi[def.nEltColl+iColl]=eltNodXi[def.nEltNod+iColl];
+        }
+        shapefun(def.shapeN,def.nEltColl,xi,N[iTyp]);
+      }
+    }
+
+    // TRIPLETS, ASSEMBLED IN PARALLEL
+    tripPtr=new(nothrow) size_t[nElt+1];
+    if (tripPtr==0) throw("Out of memory.");
+    tripPtr[0]=0;
+    for (unsigned int iElt=0; iElt<nElt; iElt++)
+    {
+      const BemEltTypeDef& def=topo.typeDef[topo.eltType[iElt]];
+      tripPtr[iElt+1]=tripPtr[iElt]+(size_t)probDim*def.nEltColl*def.nEltNod;
+    }
+    const size_t nTriplet=tripPtr[nElt];
+    row=new(nothrow) unsigned int[nTriplet];
+    col=new(nothrow) unsigned int[nTriplet];
+    val=new(nothrow) double[nTriplet];
+    if ((row==0) || (col==0) || (val==0)) throw("Out of memory.");
+    TuData data;
+    data.topo=&topo;
+    data.probDim=probDim;
+    data.N=N;
+    data.tripPtr=tripPtr;
+    data.row=row;
+    data.col=col;
+    data.val=val;
+    bemtopologyloop(tuworker,&data,nElt,nThread);
+
+    // SPARSE MATRIX: A LATER ELEMENT OVERWRITES AN EARLIER ONE
+    plhs[0]=bemsparse((size_t)probDim*nTotalColl,(size_t)probDim*nNod,nTriplet,row,col,val,false);
+  }
+  catch (const char* exception)
+  {
+    error=exception;
+  }
+
+  // DEALLOCATE MEMORY ALLOCATED BY "mxArrayToString" IN TYPE DEFINITIONS
+  for (unsigned int iTyp=0; iTyp<nTypParsed; iTyp++)
+  {
+    mxFree(TypeName[iTyp]);
+    for (unsigned int iKeyOpt=0; iKeyOpt<nKeyOpt[iTyp]; iKeyOpt++) mxFree(TypeKeyOpts[iTyp+nEltType*iKeyOpt]);
+  }
+  delete [] TypeID;
+  delete [] nKeyOpt;
+  delete [] TypeName;
+  delete [] TypeKeyOpts;
+  bemtopologyclear(topo);
+  delete [] shape;
+  delete [] N;
+  delete [] xi;
+  delete [] tripPtr;
+  delete [] row;
+  delete [] col;
+  delete [] val;
+  if (error!=0) mexErrMsgTxt(error);
+}
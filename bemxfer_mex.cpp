@@ -12,12 +12,38 @@
  *   where t (nDof * 1) and u (nDof * 1) are the tractions and displacements on
  *   the boundary element mesh.
  *
+ *   urec = BEMXFER(nod,elt,typ,rec,t,u,green,...) evaluates the wave field
+ *   in the receivers directly, without assembling the matrices Up and Tp.
+ *   The transfer matrices of every element are multiplied with the tractions
+ *   and displacements as soon as they are integrated, so that the memory
+ *   requirements are proportional to the number of receivers instead of the
+ *   size of the transfer matrices. The receivers are processed in blocks, so
+ *   that the element matrices of a block take about as much memory as the
+ *   receiver field of a single load, or that of 256 receivers if this is
+ *   larger; the elements are integrated once per block. Any number of load
+ *   cases can be evaluated at the same time; the tractions and displacements
+ *   either apply to all sets of the Green's function (frequencies,
+ *   wavenumbers) or are given separately for every set. If u is empty, only
+ *   Up*t is evaluated.
+ *
  *   The routine detemines whether the receivers are located on the boundary 
  *   element mesh or not. For receivers located on the interface, the matrices 
  *   Up and Tp are derived from the boundary element shape functions. For 
  *   receivers not located on the boundary element mesh, the boundary integral 
  *   theorem is used.
  *
+ *   BEMXFER('interp',method,nod,elt,typ,rec,'user',...) and
+ *   BEMXFER('interpzs',method,...) select the interpolation of a user defined
+ *   Green's function in (r,z) and in zs, as in BEMMAT: 'linear' (default),
+ *   'spline' or 'pchip' in (r,z) and 'nearest' (default) or 'linear' in zs.
+ *   The transfer matrices should be computed with the same interpolation as
+ *   the system matrices.
+ *
+ *   BEMXFER(nod,elt,typ,rec,'user',gfile) reads the tables zs, r, z, ug and
+ *   sg from a memory mapped Green's function file written by BEMGREENWRITE,
+ *   as in BEMMAT. For periodic problems, the arguments L, ky and nmax follow
+ *   gfile. As in BEMMAT, the tables ug and sg are double or single precision.
+ *
  *   Depending on the Green's function, the following syntax is used:
  *
  *   [Up,Tp] = BEMXFER(nod,elt,typ,rec,green,...)
@@ -29,6 +55,8 @@
  *   [Up,Tp] = BEMXFER(nod,elt,typ,rec,'fsgreen3d',Cs,Cp,Ds,Dp,rho,omega)
  *   [Up,Tp] = BEMXFER(nod,elt,typ,rec,'fsgreenf',Cs,Cp,Ds,Dp,rho,py,omega)
  *   [Up,Tp] = BEMXFER(nod,elt,typ,rec,'user',zs,r,z,ug,sg)
+ *   [Up,Tp] = BEMXFER(nod,elt,typ,rec,'user',gfile)
+ *   urec    = BEMXFER(nod,elt,typ,rec,t,u,green,...)
  *
  *
  *   nod      Nodes (nNod * 4). Each row has the layout [nodID x y z] where
@@ -44,6 +72,9 @@
  *            strings with key options.
  *   rec      Boundary element receiver points (|nRec| * 3). Each row represents
  *            a receiver and contains the receiver coordinates x, y, and z.
+ *   t        Boundary element tractions (nDof * nLoad) or
+ *            (nDof * nLoad * nSet).
+ *   u        Boundary element displacements, of the same size as t, or empty.
  *   green    Green's function (string). 'fs***' for a full-space solution or
  *            'user' for a user specified Green's function.
  *   mu       Shear modulus (1 * 1).
@@ -63,18 +94,21 @@
  *   z        Receiver locations (z-coordinate) (nzRec * 1).
  *   ug       Green's displacements.
  *   sg       Green's stresses.
+ *   gfile    Green's function file name (string).
+ *   method   Interpolation method (string).
  *   Up       Boundary element displacement system matrix (nRecDof * nDof * nSet).
  *   Tp       Boundary element traction system matrix (nRecDof * nDof * nSet).
+ *   urec     Wave field in the receivers (nRecDof * nLoad * nSet).
  */
 
-/* $Make: mex -O -output bemxfer bemxfer_mex.cpp eltdef.cpp bemcollpoints.cpp 
+/* $Make: mex -O -output bemxfer bemxfer_mex.cpp eltdef.cpp bemcollpoints.cpp pointgrid.cpp 
                                  shapefun.cpp bemnormal.cpp gausspw.cpp search1.cpp 
                                  bemxfer3d.cpp bemxfer2d.cpp bemxferaxi.cpp 
                                  bemdimension.cpp bemisaxisym.cpp greeneval2d.cpp 
                                  fsgreenf.cpp fsgreen3d.cpp fsgreen3dt.cpp 
                                  fsgreen2d_inplane.cpp fsgreen2d_outofplane.cpp 
-                                 besselh.cpp greeneval3d.cpp greenrotate2d.cpp 
-                                 boundaryrec2d.cpp boundaryrec3d.cpp fminstep.cpp 
+                                 besselh.cpp greeneval3d.cpp greeninterp.cpp greenfile.cpp greenrotate2d.cpp 
+                                 boundaryrec2d.cpp boundaryrec3d.cpp recgrid.cpp fminstep.cpp 
                                  greenrotate3d.cpp checklicense.cpp ripemd128.cpp$*/
 
 
@@ -104,7 +138,11 @@ mexFunction----> IntegrateGreenUser --->  bemIntegrate
 #include "bemxfer3dperiodic.h"
 #include "bemxferaxi.h"
 #include "boundaryrec2d.h"
-#include "boundaryrec3d.h"     
+#include "boundaryrec3d.h"
+#include "recgrid.h"
+#include "search1.h"
+#include "greeninterp.h"
+#include "greenfile.h"
 #include "checklicense.h"
 #include <math.h>
 #include <new>
@@ -112,10 +150,105 @@ mexFunction----> IntegrateGreenUser --->  bemIntegrate
 
 #ifndef __GNUC__
 #define strcasecmp _strcmpi
+#define isnan(x) ((x) != (x))
 #endif
 
 using namespace std;
 
+// Minimum number of receivers per block of the matrix-free evaluation.
+const unsigned int minBlkRec=256;
+
+// INTERPOLATION OF USER DEFINED GREEN'S FUNCTIONS
+// Set by mexFunction for the options 'interp' (0: linear, 1: spline, 2: pchip)
+// and 'interpzs'.
+static unsigned int InterpMethod=0;
+static bool InterpZsLinear=false;
+
+// TABLES OF A USER DEFINED GREEN'S FUNCTION
+// Mapped from a Green's function file during the integration for the syntax
+// BEMXFER(nod,elt,typ,rec,'user',gfile), unmapped on errors.
+static GreenTable UserTable;
+
+//==============================================================================
+void bemLoadApply(const unsigned int& iRowBeg, const unsigned int& iRowEnd,
+                  const unsigned int& nRecDof, const unsigned int& nUrecDof,
+                  const unsigned int& nBufDof,
+                  const unsigned int& nEltDof, const unsigned int* const dofIndex,
+                  const unsigned int& nSet, const bool& UmatOut, const bool& TmatOut,
+                  double* const URe, double* const UIm,
+                  double* const TRe, double* const TIm,
+                  const double* const tRe, const double* const tIm,
+                  const double* const uRe, const double* const uIm,
+                  const unsigned int& nDof, const unsigned int& nLoad,
+                  const bool& loadSet, double* const urecRe, double* const urecIm)
+/* Adds the contribution Up*t-Tp*u of the element transfer matrices in the
+ * buffers URe, UIm, TRe and TIm (nRecDof * nBufDof * nSet) to the receiver
+ * field urec (nUrecDof * nLoad * nSet), for the rows iRowBeg to iRowEnd-1.
+ * The rows of the buffers are those of a block of receivers, and urec points
+ * to the first row of the block in the receiver field.
+ * Column jDof of the buffers corresponds to degree of freedom dofIndex[jDof].
+ * The imaginary parts UIm and TIm are omitted if zero (real Green's
+ * functions). The buffers are reset to zero afterwards.
+ */
+//==============================================================================
+{
+  for (unsigned int iSet=0; iSet<nSet; iSet++)
+  {
+    const size_t bufSet=(size_t)nRecDof*nBufDof*iSet;
+    const size_t loadSetOffset=(loadSet ? (size_t)nDof*nLoad*iSet : 0);
+    for (unsigned int jDof=0; jDof<nEltDof; jDof++)
+    {
+      const size_t bufCol=bufSet+(size_t)nRecDof*jDof;
+      for (unsigned int iLoad=0; iLoad<nLoad; iLoad++)
+      {
+        const size_t indLoad=loadSetOffset+(size_t)nDof*iLoad+dofIndex[jDof];
+        double* const recRe=urecRe+(size_t)nUrecDof*(iLoad+(size_t)nLoad*iSet);
+        double* const recIm=urecIm+(size_t)nUrecDof*(iLoad+(size_t)nLoad*iSet);
+        if (UmatOut)
+        {
+          const double tr=tRe[indLoad];
+          const double ti=(tIm==0 ? 0.0 : tIm[indLoad]);
+          for (unsigned int iRow=iRowBeg; iRow<iRowEnd; iRow++)
+          {
+            recRe[iRow]+=URe[bufCol+iRow]*tr;
+            recIm[iRow]+=URe[bufCol+iRow]*ti;
+          }
+          if (UIm!=0)
+          {
+            for (unsigned int iRow=iRowBeg; iRow<iRowEnd; iRow++)
+            {
+              recRe[iRow]-=UIm[bufCol+iRow]*ti;
+              recIm[iRow]+=UIm[bufCol+iRow]*tr;
+            }
+          }
+        }
+        if (TmatOut)
+        {
+          const double ur=uRe[indLoad];
+          const double ui=(uIm==0 ? 0.0 : uIm[indLoad]);
+          for (unsigned int iRow=iRowBeg; iRow<iRowEnd; iRow++)
+          {
+            recRe[iRow]-=TRe[bufCol+iRow]*ur;
+            recIm[iRow]-=TRe[bufCol+iRow]*ui;
+          }
+          if (TIm!=0)
+          {
+            for (unsigned int iRow=iRowBeg; iRow<iRowEnd; iRow++)
+            {
+              recRe[iRow]+=TIm[bufCol+iRow]*ui;
+              recIm[iRow]-=TIm[bufCol+iRow]*ur;
+            }
+          }
+        }
+      }
+      for (unsigned int iRow=iRowBeg; iRow<iRowEnd; iRow++) URe[bufCol+iRow]=0.0;
+      for (unsigned int iRow=iRowBeg; iRow<iRowEnd; iRow++) TRe[bufCol+iRow]=0.0;
+      if (UIm!=0) for (unsigned int iRow=iRowBeg; iRow<iRowEnd; iRow++) UIm[bufCol+iRow]=0.0;
+      if (TIm!=0) for (unsigned int iRow=iRowBeg; iRow<iRowEnd; iRow++) TIm[bufCol+iRow]=0.0;
+    }
+  }
+}
+
 //==============================================================================
 void bemIntegrate(mxArray* plhs[], const bool& probAxi, const bool& probPeriodic, const unsigned int& probDim,
                   const unsigned int& nColDof, const bool& TmatOut,
@@ -132,16 +265,28 @@ void bemIntegrate(mxArray* plhs[], const bool& probAxi, const bool& probPeriodic
                   const bool& tgCmplx, const unsigned int* const greenDim,
                   const unsigned int nGreenDim,
                   const double L, const double* const ky, const unsigned int nWave, 
-                  const unsigned int nmax)
+                  const unsigned int nmax, const mxArray* const tLoad,
+                  const mxArray* const uLoad)
 /* BemIntegrate performs the actual boundary element integration.
  * This function is called from each separate Green's function integration
  * separately.
+ *
+ * If loads are given (tLoad and, if TmatOut, uLoad), the transfer matrices
+ * are not assembled. The matrices of every element are integrated in a
+ * buffer that holds the columns of a single element, which is multiplied
+ * with the loads and cleared before proceeding to the next element. The
+ * buffer holds the rows of a block of receivers and the elements are
+ * integrated once per block, so that its size (nColDof*nBlkRec * nBufDof *
+ * nSet) does not grow with the number of element degrees of freedom and
+ * Green's function sets beyond that of a block of minBlkRec receivers.
  */
 //==============================================================================
 {
   // DEGREES OF FREEDOM
   unsigned int nDof=nColDof*nTotalColl;
   unsigned int nRecDof=nColDof*nRec;
+  const unsigned int nSet=(probPeriodic ? nGrSet*nWave : nGrSet);
+  const bool matFree=(tLoad!=0);
 
   // OUTPUT ARGUMENT POINTERS
   const unsigned int nMatDim=(probPeriodic ? 3+nGreenDim : 2+nGreenDim);
@@ -153,38 +298,203 @@ void bemIntegrate(mxArray* plhs[], const bool& probAxi, const bool& probPeriodic
   for (unsigned int iDim=0; iDim<nGreenDim; iDim++)  MatDim[2+iDim]=greenDim[iDim];
   if (probPeriodic) MatDim[nMatDim-1]=nWave;
   
-
-  plhs[0]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,mxCOMPLEX);
-  double* const URe=mxGetPr(plhs[0]);
-  double* const UIm=mxGetPi(plhs[0]);
-  
+  double* URe = 0;
+  double* UIm = 0;
   double* TRe = 0;
   double* TIm = 0;
-  if (TmatOut)
+
+  // Matrix-free evaluation: loads and buffers
+  unsigned int nLoad=0;
+  bool loadSet=false;
+  const double* tRe=0;
+  const double* tIm=0;
+  const double* uRe=0;
+  const double* uIm=0;
+  double* urecRe=0;
+  double* urecIm=0;
+  unsigned int nBufDof=0;
+  unsigned int* bufIndex=0;
+  unsigned int* dofIndex=0;
+  unsigned int* eltRec=0;
+  unsigned int nBlkRec=nRec;
+  double* blkRec=0;
+
+  if (matFree)
+  {
+    const size_t nDimLoad=mxGetNumberOfDimensions(tLoad);
+    const size_t* const dimLoad=mxGetDimensions(tLoad);
+    if (!(dimLoad[0]==nDof)) throw("Input argument 't' must have nDof rows.");
+    nLoad=dimLoad[1];
+    size_t nLoadSet=1;
+    for (unsigned int iDim=2; iDim<nDimLoad; iDim++) nLoadSet*=dimLoad[iDim];
+    if (!((nLoadSet==1) || (nLoadSet==nSet))) throw("The number of sets of input argument 't' does not match the Green's function.");
+    loadSet=(nLoadSet>1);
+    tRe=mxGetPr(tLoad);
+    tIm=mxGetPi(tLoad);
+    if (TmatOut)
+    {
+      if (!(mxGetNumberOfElements(uLoad)==mxGetNumberOfElements(tLoad) && mxGetM(uLoad)==nDof))
+        throw("Input arguments 't' and 'u' must have the same size.");
+      uRe=mxGetPr(uLoad);
+      uIm=mxGetPi(uLoad);
+    }
+
+    MatDim[1]=nLoad;
+    plhs[0]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,mxCOMPLEX);
+    urecRe=mxGetPr(plhs[0]);
+    urecIm=mxGetPi(plhs[0]);
+
+    // Buffers for the columns of a single element
+    unsigned int maxEltColl=0;
+    for (unsigned int iElt=0; iElt<nElt; iElt++)
+    {
+      unsigned int EltType = (unsigned int)(Elt[nElt+iElt]);
+      unsigned int EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic;
+      unsigned int nGauss,nEltDiv,nGaussSing,nEltDivSing;
+      eltdef(EltType,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,EltParent,nEltNod,
+             nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,
+             nGaussSing,nEltDivSing);
+      if (nEltColl>maxEltColl) maxEltColl=nEltColl;
+    }
+    nBufDof=nColDof*maxEltColl;
+
+    // The receivers are processed in blocks, so that the buffers hold about
+    // as many values as the receiver field of a single load, but at least
+    // those of minBlkRec receivers.
+    nBlkRec=(unsigned int)(nRec/((size_t)nBufDof*nSet));
+    if (nBlkRec<minBlkRec) nBlkRec=minBlkRec;
+    if (nBlkRec>nRec) nBlkRec=nRec;
+    blkRec=new(nothrow) double[(size_t)3*nBlkRec];
+    if (blkRec==0) throw("Out of memory.");
+    const size_t nBuf=(size_t)nColDof*nBlkRec*nBufDof*nSet;
+    URe=new(nothrow) double[nBuf];
+    if (URe==0) throw("Out of memory.");
+    TRe=new(nothrow) double[nBuf];
+    if (TRe==0) throw("Out of memory.");
+    for (size_t iBuf=0; iBuf<nBuf; iBuf++) URe[iBuf]=0.0;
+    for (size_t iBuf=0; iBuf<nBuf; iBuf++) TRe[iBuf]=0.0;
+    if (ugCmplx || probPeriodic)
+    {
+      UIm=new(nothrow) double[nBuf];
+      if (UIm==0) throw("Out of memory.");
+      for (size_t iBuf=0; iBuf<nBuf; iBuf++) UIm[iBuf]=0.0;
+    }
+    if (tgCmplx || probPeriodic)
+    {
+      TIm=new(nothrow) double[nBuf];
+      if (TIm==0) throw("Out of memory.");
+      for (size_t iBuf=0; iBuf<nBuf; iBuf++) TIm[iBuf]=0.0;
+    }
+    bufIndex=new(nothrow) unsigned int[maxEltColl];
+    if (bufIndex==0) throw("Out of memory.");
+    for (unsigned int iEltColl=0; iEltColl<maxEltColl; iEltColl++) bufIndex[iEltColl]=iEltColl;
+    dofIndex=new(nothrow) unsigned int[nBufDof];
+    if (dofIndex==0) throw("Out of memory.");
+    if (TmatOut)
+    {
+      eltRec=new(nothrow) unsigned int[nBlkRec];
+      if (eltRec==0) throw("Out of memory.");
+    }
+  }
+  else
   {
-    plhs[1]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,mxCOMPLEX);
-    TRe=mxGetPr(plhs[1]);
-    TIm=mxGetPi(plhs[1]);
+    // Real matrices for real Green's functions (e.g. static problems)
+    const bool uCmplx=(ugCmplx || probPeriodic);
+    const bool tCmplx=(tgCmplx || probPeriodic);
+    plhs[0]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,(uCmplx ? mxCOMPLEX : mxREAL));
+    URe=mxGetPr(plhs[0]);
+    UIm=mxGetPi(plhs[0]);
+    if (TmatOut)
+    {
+      plhs[1]=mxCreateNumericArray(nMatDim,MatDim,mxDOUBLE_CLASS,(tCmplx ? mxCOMPLEX : mxREAL));
+      TRe=mxGetPr(plhs[1]);
+      TIm=mxGetPi(plhs[1]);
+    }
   }
+  const unsigned int nKerDof=(matFree ? nBufDof : nDof);
 
-  bool* const boundaryRec=new(nothrow) bool[nRec];
+  bool* const boundaryRec=new(nothrow) bool[nBlkRec];
         if (boundaryRec==0) throw("Out of memory.");
-  for (unsigned int iRec=0; iRec<nRec; iRec++) boundaryRec[iRec]=false;
-  
+
+  // Uniform grid over the receivers for the lookup of interface receivers
+  double gridGeom[9];
+  unsigned int nCell=0;
+  unsigned int* cellStart=0;
+  unsigned int* cellRec=0;
+  if (probDim==3)
+  {
+    cellRec=new(nothrow) unsigned int[nBlkRec+1];
+    if (cellRec==0) throw("Out of memory.");
+  }
+
+  for (unsigned int recBeg=0; recBeg<nRec; recBeg+=nBlkRec)
+  {
+  // RECEIVER BLOCK
+  const unsigned int nRecBlk=(nRec-recBeg<nBlkRec ? nRec-recBeg : nBlkRec);
+  const unsigned int nRecBlkDof=nColDof*nRecBlk;
+  const double* RecBlk=Rec;
+  double* urecBlkRe=0;
+  double* urecBlkIm=0;
+  if (matFree)
+  {
+    for (unsigned int iRec=0; iRec<nRecBlk; iRec++)
+      for (unsigned int iDim=0; iDim<3; iDim++) blkRec[iDim*nRecBlk+iRec]=Rec[iDim*nRec+recBeg+iRec];
+    RecBlk=blkRec;
+    urecBlkRe=urecRe+nColDof*recBeg;
+    urecBlkIm=urecIm+nColDof*recBeg;
+  }
+  for (unsigned int iRec=0; iRec<nRecBlk; iRec++) boundaryRec[iRec]=false;
+  if (probDim==3)
+  {
+    recGridSize(RecBlk,nRecBlk,gridGeom,nCell);
+    cellStart=new(nothrow) unsigned int[nCell+1];
+    if (cellStart==0) throw("Out of memory.");
+    recGridFill(RecBlk,nRecBlk,gridGeom,nCell,cellStart,cellRec);
+  }
+
   for (unsigned int iElt=0; iElt<nElt; iElt++)
   {
+    unsigned int nEltRec=0;
     if (probDim==3)
     {
      boundaryRec3d(Nod,nNod,Elt,nElt,iElt,TypeID,TypeName,TypeKeyOpts,
                    nKeyOpt,nEltType,CollPoints,nTotalColl,nCentroidColl,
-                   Rec,nRec,nRecDof,boundaryRec,TRe,TmatOut,nDof,nGrSet);
+                   RecBlk,nRecBlk,nRecBlkDof,boundaryRec,eltRec,nEltRec,TRe,TmatOut,nKerDof,nGrSet,
+                   gridGeom,cellStart,cellRec,matFree);
     }
     else
     {
       boundaryRec2d(Nod,nNod,Elt,nElt,iElt,TypeID,TypeName,TypeKeyOpts,
                     nKeyOpt,nEltType,CollPoints,nTotalColl,nCentroidColl,
-                    Rec,nRec,nRecDof,boundaryRec,TRe,TmatOut,nDof,nGrSet,
-                    nugComp,nColDof);
+                    RecBlk,nRecBlk,nRecBlkDof,boundaryRec,eltRec,nEltRec,TRe,TmatOut,nKerDof,nGrSet,
+                    nugComp,nColDof,matFree);
+    }
+
+    // Interface receivers matched to this element: u_rec = M*u
+    if (matFree && TmatOut && (nEltRec>0))
+    {
+      unsigned int EltType = (unsigned int)(Elt[nElt+iElt]);
+      unsigned int EltParent,nEltNod,nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic;
+      unsigned int nGauss,nEltDiv,nGaussSing,nEltDivSing;
+      eltdef(EltType,TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,EltParent,nEltNod,
+             nEltColl,EltShapeN,EltShapeM,EltDim,AxiSym,Periodic,nGauss,nEltDiv,
+             nGaussSing,nEltDivSing);
+      unsigned int* const eltCollIndex=new(nothrow) unsigned int[nEltColl];
+      if (eltCollIndex==0) throw("Out of memory.");
+      BemEltCollIndex(Elt,iElt,nElt,CollPoints,nCentroidColl,nTotalColl,
+                      nEltColl,nEltNod,eltCollIndex);
+      for (unsigned int iEltColl=0; iEltColl<nEltColl; iEltColl++)
+        for (unsigned int iColDof=0; iColDof<nColDof; iColDof++)
+          dofIndex[nColDof*iEltColl+iColDof]=nColDof*eltCollIndex[iEltColl]+iColDof;
+      delete [] eltCollIndex;
+      for (unsigned int iEltRec=0; iEltRec<nEltRec; iEltRec++)
+      {
+        const unsigned int iRowBeg=nColDof*eltRec[iEltRec];
+        const unsigned int iRowEnd=nColDof*(eltRec[iEltRec]+1);
+        bemLoadApply(iRowBeg,iRowEnd,nRecBlkDof,nRecDof,nBufDof,nColDof*nEltColl,dofIndex,nSet,
+                     false,TmatOut,URe,UIm,TRe,TIm,tRe,tIm,uRe,uIm,nDof,nLoad,
+                     loadSet,urecBlkRe,urecBlkIm);
+      }
     }
   }
 
@@ -212,33 +522,58 @@ void bemIntegrate(mxArray* plhs[], const bool& probAxi, const bool& probPeriodic
     if (eltCollIndex==0) throw("Out of memory.");
     BemEltCollIndex(Elt,iElt,nElt,CollPoints,nCentroidColl,nTotalColl,
                     nEltColl,nEltNod,eltCollIndex);
+    const unsigned int* const kerIndex=(matFree ? bufIndex : eltCollIndex);
 
     if (probDim==3)
     {
       if (probPeriodic)
-        bemxfer3dperiodic(Nod,nNod,Elt,iElt,nElt,eltCollIndex,Rec,nRec,boundaryRec,
-                          URe,UIm,TRe,TIm,1,TmatOut,nDof,nRecDof,TypeID,nKeyOpt,TypeName,
+        bemxfer3dperiodic(Nod,nNod,Elt,iElt,nElt,kerIndex,RecBlk,nRecBlk,boundaryRec,
+                          URe,UIm,TRe,TIm,1,TmatOut,nKerDof,nRecBlkDof,TypeID,nKeyOpt,TypeName,
                           TypeKeyOpts,nEltType,greenPtr,nGrSet,ugCmplx,tgCmplx,L,ky,nWave,nmax);
       else
-        bemxfer3d(Nod,nNod,Elt,iElt,nElt,eltCollIndex,Rec,nRec,boundaryRec,
-                  URe,UIm,TRe,TIm,1,TmatOut,nDof,nRecDof,TypeID,nKeyOpt,TypeName,
+        bemxfer3d(Nod,nNod,Elt,iElt,nElt,kerIndex,RecBlk,nRecBlk,boundaryRec,
+                  URe,UIm,TRe,TIm,1,TmatOut,nKerDof,nRecBlkDof,TypeID,nKeyOpt,TypeName,
                   TypeKeyOpts,nEltType,greenPtr,nGrSet,ugCmplx,tgCmplx);
     }
     else if ((probDim==2)&& probAxi)
     {
-       bemxferaxi(Nod,nNod,Elt,iElt,nElt,eltCollIndex,Rec,nRec,boundaryRec,
-                  URe,UIm,TRe,TIm,1,TmatOut,nDof,nRecDof,TypeID,nKeyOpt,TypeName,
+       bemxferaxi(Nod,nNod,Elt,iElt,nElt,kerIndex,RecBlk,nRecBlk,boundaryRec,
+                  URe,UIm,TRe,TIm,1,TmatOut,nKerDof,nRecBlkDof,TypeID,nKeyOpt,TypeName,
                   TypeKeyOpts,nEltType,greenPtr,nGrSet,ugCmplx,tgCmplx);
     }
     else
     {
-       bemxfer2d(Nod,nNod,Elt,iElt,nElt,eltCollIndex,Rec,nRec,boundaryRec,
-                 URe,UIm,TRe,TIm,TmatOut,nDof,nRecDof,TypeID,nKeyOpt,TypeName,
+       bemxfer2d(Nod,nNod,Elt,iElt,nElt,kerIndex,RecBlk,nRecBlk,boundaryRec,
+                 URe,UIm,TRe,TIm,TmatOut,nKerDof,nRecBlkDof,TypeID,nKeyOpt,TypeName,
                  TypeKeyOpts,nEltType,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx);
     }
+
+    if (matFree)
+    {
+      for (unsigned int iEltColl=0; iEltColl<nEltColl; iEltColl++)
+        for (unsigned int iColDof=0; iColDof<nColDof; iColDof++)
+          dofIndex[nColDof*iEltColl+iColDof]=nColDof*eltCollIndex[iEltColl]+iColDof;
+      bemLoadApply(0,nRecBlkDof,nRecBlkDof,nRecDof,nBufDof,nColDof*nEltColl,dofIndex,nSet,
+                   true,TmatOut,URe,UIm,TRe,TIm,tRe,tIm,uRe,uIm,nDof,nLoad,
+                   loadSet,urecBlkRe,urecBlkIm);
+    }
     delete [] eltCollIndex;
   }
+  if (cellStart!=0) {delete [] cellStart; cellStart=0;}
+  }
   delete [] boundaryRec;
+  if (cellRec!=0) delete [] cellRec;
+  if (matFree)
+  {
+    delete [] URe;
+    delete [] TRe;
+    if (UIm!=0) delete [] UIm;
+    if (TIm!=0) delete [] TIm;
+    delete [] bufIndex;
+    delete [] dofIndex;
+    delete [] eltRec;
+    delete [] blkRec;
+  }
   delete [] MatDim;
 }
 
@@ -254,13 +589,22 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
                         const unsigned int* const nKeyOpt, const unsigned int& nEltType,
                         const double* const CollPoints, const unsigned int& nTotalColl,
                         const unsigned int& nCentroidColl,
-                        const bool& TmatOut)
+                        const bool& TmatOut, const mxArray* const tLoad,
+                        const mxArray* const uLoad)
 //==============================================================================
 {
   // INPUT ARGUMENT PROCESSING
+  // The tables are passed as arrays zs,r,z,ug,sg or as the name of a
+  // Green's function file, which is mapped into memory.
+  const bool greenFileIn=mxIsChar(prhs[5]);
+  const unsigned int periodicPos=(greenFileIn ? 6 : 10);
   if (probPeriodic)
   {
-    if (!(nrhs==13)) throw("Wrong number of input arguments.");
+    if (!(nrhs==(greenFileIn ? 9 : 13))) throw("Wrong number of input arguments.");
+  }
+  else if (greenFileIn)
+  {
+    if (nrhs>6) throw("Too many input arguments.");
   }
   else
   {
@@ -268,32 +612,100 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
     if (nrhs<9) throw("Not enough input arguments.");
   }
 
-  if (!mxIsNumeric(prhs[5])) throw("Input argument 'zs' must be numeric.");
-  if (mxIsSparse(prhs[5])) throw("Input argument 'zs' must not be sparse.");
-  if (mxIsEmpty(prhs[5])) throw("Input argument 'zs' must not be empty.");
-  const unsigned int nzs=mxGetNumberOfElements(prhs[5]);
-  const double* const zs=mxGetPr(prhs[5]);
+  GreenTable& table=UserTable;
+  if (greenFileIn)
+  {
+    char* const fileName=mxArrayToString(prhs[5]);
+    if (fileName==0) throw("Input argument 'gfile' must be a string.");
+    try
+    {
+      greenFileOpen(fileName,table);
+    }
+    catch (const char*)
+    {
+      mxFree(fileName);
+      throw;
+    }
+    mxFree(fileName);
+  }
+  else
+  {
+    if (!mxIsNumeric(prhs[5])) throw("Input argument 'zs' must be numeric.");
+    if (mxIsSparse(prhs[5])) throw("Input argument 'zs' must not be sparse.");
+    if (mxIsEmpty(prhs[5])) throw("Input argument 'zs' must not be empty.");
+    table.nzs=mxGetNumberOfElements(prhs[5]);
+    table.zs=mxGetPr(prhs[5]);
+
+    if (!mxIsNumeric(prhs[6])) throw("Input argument 'r' must be numeric.");
+    if (mxIsSparse(prhs[6])) throw("Input argument 'r' must not be sparse.");
+    if (mxIsEmpty(prhs[6])) throw("Input argument 'r' must not be empty.");
+    table.nr=mxGetNumberOfElements(prhs[6]);
+    table.r=mxGetPr(prhs[6]);
+
+    if (!mxIsNumeric(prhs[7])) throw("Input argument 'z' must be numeric.");
+    if (mxIsSparse(prhs[7])) throw("Input argument 'z' must not be sparse.");
+    if (mxIsEmpty(prhs[7])) throw("Input argument 'z' must not be empty.");
+    table.nz=mxGetNumberOfElements(prhs[7]);
+    table.z=mxGetPr(prhs[7]);
+
+    if (!mxIsNumeric(prhs[8])) throw("Input argument 'ug' must be numeric.");
+    if (mxIsSparse(prhs[8])) throw("Input argument 'ug' must not be sparse.");
+    if (mxIsEmpty(prhs[8])) throw("Input argument 'ug' must not be empty.");
+    table.nDim=mxGetNumberOfDimensions(prhs[8]);
+    table.dim=mxGetDimensions(prhs[8]);
+    if (!(mxIsDouble(prhs[8]) || mxIsSingle(prhs[8]))) throw("Input argument 'ug' must be double or single.");
+    table.single=mxIsSingle(prhs[8]);
+    table.ugRe=mxGetData(prhs[8]);
+    table.ugIm=(mxIsComplex(prhs[8]) ? mxGetImagData(prhs[8]) : 0);
+
+    table.ntgComp=0;
+    table.sgRe=0;
+    table.sgIm=0;
+    table.sg0Re=0;
+    table.sg0Im=0;
+    if (TmatOut && (nrhs==10))
+    {
+      if (!mxIsNumeric(prhs[9])) throw("Input argument 'sg' must be numeric.");
+      if (mxIsSparse(prhs[9])) throw("Input argument 'sg' must not be sparse.");
+      const unsigned int ntgdim=mxGetNumberOfDimensions(prhs[9]);
+      const size_t* const tgdim=mxGetDimensions(prhs[9]);
+      if (!(table.nDim==ntgdim)) throw("Matrix dimensions of input arguments 'ug' and 'sg' must agree.");
+      for (unsigned int iDim=1; iDim<table.nDim; iDim++)
+      {
+        if (!(table.dim[iDim]==tgdim[iDim])) throw("Matrix dimensions of input arguments 'ug' and 'sg' are incompatible.");
+      }
+      if (!(mxGetClassID(prhs[9])==mxGetClassID(prhs[8]))) throw("Input arguments 'ug' and 'sg' must have the same precision.");
+      table.ntgComp=tgdim[0];
+      table.sgRe=mxGetData(prhs[9]);
+      table.sgIm=(mxIsComplex(prhs[9]) ? mxGetImagData(prhs[9]) : 0);
+    }
+
+    // The tables are checked for NaN and Inf values once, rather than every
+    // interpolated value at every integration point. Green's function files
+    // are checked when they are written.
+    const size_t nugVal=mxGetNumberOfElements(prhs[8]);
+    if (!greenTableFinite(table.ugRe,table.ugIm,nugVal,table.single)) throw("Input argument 'ug' must not contain NaN or Inf values.");
+    if (table.sgRe!=0)
+    {
+      const size_t ntgVal=mxGetNumberOfElements(prhs[9]);
+      if (!greenTableFinite(table.sgRe,table.sgIm,ntgVal,table.single)) throw("Input argument 'sg' must not contain NaN or Inf values.");
+    }
+  }
+
+  const unsigned int nzs=table.nzs;
+  const double* const zs=table.zs;
   for (unsigned int izs=1; izs<nzs; izs++) if (!(zs[izs-1]<zs[izs])) throw("Input argument 'zs' must be monotonically increasing.");
 
-  if (!mxIsNumeric(prhs[6])) throw("Input argument 'r' must be numeric.");
-  if (mxIsSparse(prhs[6])) throw("Input argument 'r' must not be sparse.");
-  if (mxIsEmpty(prhs[6])) throw("Input argument 'r' must not be empty.");
-  const unsigned int nr=mxGetNumberOfElements(prhs[6]);
-  const double* const r=mxGetPr(prhs[6]);
+  const unsigned int nr=table.nr;
+  const double* const r=table.r;
   for (unsigned int ir=1; ir<nr; ir++) if (!(r[ir-1]<r[ir])) throw("Input argument 'r' must be monotonically increasing.");
 
-  if (!mxIsNumeric(prhs[7])) throw("Input argument 'z' must be numeric.");
-  if (mxIsSparse(prhs[7])) throw("Input argument 'z' must not be sparse.");
-  if (mxIsEmpty(prhs[7])) throw("Input argument 'z' must not be empty.");
-  const unsigned int nz=mxGetNumberOfElements(prhs[7]);
-  const double* const z=mxGetPr(prhs[7]);
+  const unsigned int nz=table.nz;
+  const double* const z=table.z;
   for (unsigned int iz=1; iz<nz; iz++) if (!(z[iz-1]<z[iz])) throw("Input argument 'z' must be monotonically increasing.");
 
-  if (!mxIsNumeric(prhs[8])) throw("Input argument 'ug' must be numeric.");
-  if (mxIsSparse(prhs[8])) throw("Input argument 'ug' must not be sparse.");
-  if (mxIsEmpty(prhs[8])) throw("Input argument 'ug' must not be empty.");
-  const unsigned int nugdim=mxGetNumberOfDimensions(prhs[8]);
-  const size_t* const ugdim=mxGetDimensions(prhs[8]);
+  const unsigned int nugdim=table.nDim;
+  const size_t* const ugdim=table.dim;
   const unsigned int nugComp=ugdim[0];
 
   const unsigned int nGreenDim=((nugdim>4)?(nugdim-4):1);
@@ -318,9 +730,9 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
   if (!((unsigned)nzs == ((nugdim>1)? ugdim[1]:1))) throw("Input arguments 'ug' and 'zs' are incompatible");
   if (!((unsigned)nr  == ((nugdim>2)? ugdim[2]:1))) throw("Input arguments 'ug' and 'r' are incompatible");
   if (!((unsigned)nz  == ((nugdim>3)? ugdim[3]:1))) throw("Input arguments 'ug' and 'z' are incompatible");
-  const double* const ugRe=mxGetPr(prhs[8]);
-  const double* const ugIm=mxGetPi(prhs[8]);
-  const bool ugCmplx=mxIsComplex(prhs[8]);
+  const void* const ugRe=table.ugRe;
+  const void* const ugIm=table.ugIm;
+  const bool ugCmplx=(ugIm!=0);
 
   unsigned int ntgComp;
   if (nugComp==1) ntgComp=2;  // 2D, out-of-plane
@@ -328,48 +740,33 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
   if (nugComp==5) ntgComp=10; // 3D / axisymmetric
   if (nugComp==9) ntgComp=18; // 2.5D
 
-  const bool sgIn=(nrhs==10);
-  if (TmatOut)
-  {
-    if (sgIn)
-    {
-      if (!mxIsNumeric(prhs[9])) throw("Input argument 'sg' must be numeric.");
-      if (mxIsSparse(prhs[9])) throw("Input argument 'sg' must not be sparse.");
-      const unsigned int ntgdim=mxGetNumberOfDimensions(prhs[9]);
-      const size_t* const tgdim=mxGetDimensions(prhs[9]);
-      if (!(tgdim[0]==(unsigned)ntgComp)) throw("The first dimension of input argument 'sg' has incorrect size.");
-      if (!(nugdim==ntgdim)) throw("Matrix dimensions of input arguments 'ug' and 'sg' must agree.");
-      for (unsigned int iDim=1; iDim<nugdim; iDim++)
-      {
-        if (!(ugdim[iDim]==tgdim[iDim])) throw("Matrix dimensions of input arguments 'ug' and 'sg' are incompatible.");
-      }
-    }
-  }
+  const bool sgIn=(TmatOut && (table.sgRe!=0));
+  if (sgIn && !(table.ntgComp==ntgComp)) throw("The first dimension of input argument 'sg' has incorrect size.");
   
   // Periodic problems 
   if (probPeriodic){
-    if (!mxIsNumeric(prhs[10])) throw("Input argument 'L' must be numeric.");
-    if (mxIsSparse(prhs[10])) throw("Input argument 'L' must not be sparse.");
-    if (mxIsComplex(prhs[10])) throw("Input argument 'L' must be real.");
-    if (!(mxGetNumberOfElements(prhs[10])==1)) throw("Input argument 'L' must be a scalar.");
+    if (!mxIsNumeric(prhs[periodicPos])) throw("Input argument 'L' must be numeric.");
+    if (mxIsSparse(prhs[periodicPos])) throw("Input argument 'L' must not be sparse.");
+    if (mxIsComplex(prhs[periodicPos])) throw("Input argument 'L' must be real.");
+    if (!(mxGetNumberOfElements(prhs[periodicPos])==1)) throw("Input argument 'L' must be a scalar.");
     
-    if (!mxIsNumeric(prhs[11])) throw("Input argument 'ky' must be numeric.");
-    if (mxIsSparse(prhs[11])) throw("Input argument 'ky' must not be sparse.");
-    if (mxIsComplex(prhs[11])) throw("Input argument 'ky' must be real.");
-    if ((mxGetNumberOfDimensions(prhs[11])>2) ||
-      ((mxGetM(prhs[11])>1) && (mxGetN(prhs[11])>1)))
+    if (!mxIsNumeric(prhs[periodicPos+1])) throw("Input argument 'ky' must be numeric.");
+    if (mxIsSparse(prhs[periodicPos+1])) throw("Input argument 'ky' must not be sparse.");
+    if (mxIsComplex(prhs[periodicPos+1])) throw("Input argument 'ky' must be real.");
+    if ((mxGetNumberOfDimensions(prhs[periodicPos+1])>2) ||
+      ((mxGetM(prhs[periodicPos+1])>1) && (mxGetN(prhs[periodicPos+1])>1)))
                   throw("Input argument 'ky' must be a scalar or a vector.");
     
-    if (!mxIsNumeric(prhs[12])) throw("Input argument 'nmax' must be numeric.");
-    if (mxIsSparse(prhs[12])) throw("Input argument 'nmax' must not be sparse.");
-    if (mxIsComplex(prhs[12])) throw("Input argument 'nmax' must be real.");
-    if (!(mxGetNumberOfElements(prhs[12])==1)) throw("Input argument 'nmax' must be a scalar.");
+    if (!mxIsNumeric(prhs[periodicPos+2])) throw("Input argument 'nmax' must be numeric.");
+    if (mxIsSparse(prhs[periodicPos+2])) throw("Input argument 'nmax' must not be sparse.");
+    if (mxIsComplex(prhs[periodicPos+2])) throw("Input argument 'nmax' must be real.");
+    if (!(mxGetNumberOfElements(prhs[periodicPos+2])==1)) throw("Input argument 'nmax' must be a scalar.");
   }
   
-  const double L=(probPeriodic ? mxGetScalar(prhs[10]) : -1.0);
-  const double* const ky=(probPeriodic ? mxGetPr(prhs[11]) : 0);
-  const unsigned int nWave=(probPeriodic ? mxGetNumberOfElements(prhs[11]) : 0);
-  const unsigned int nmax=(probPeriodic ? (unsigned int)mxGetScalar(prhs[12]) : 0);
+  const double L=(probPeriodic ? mxGetScalar(prhs[periodicPos]) : -1.0);
+  const double* const ky=(probPeriodic ? mxGetPr(prhs[periodicPos+1]) : 0);
+  const unsigned int nWave=(probPeriodic ? mxGetNumberOfElements(prhs[periodicPos+1]) : 0);
+  const unsigned int nmax=(probPeriodic ? (unsigned int)mxGetScalar(prhs[periodicPos+2]) : 0);
   
   // Create dummy sg array if T is requested and no sg is passed.
   // 
@@ -377,12 +774,12 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
   tgdim[0]=(unsigned)ntgComp;
   for (unsigned int iDim=1; iDim<nugdim; iDim++) tgdim[iDim]=ugdim[iDim];
   if (sgIn) for (unsigned int iDim=0; iDim<nugdim; iDim++) tgdim[iDim]=(unsigned int)0;
-  mxArray* sgdummy=mxCreateNumericArray(nugdim,tgdim,mxDOUBLE_CLASS, mxREAL);    
+  mxArray* sgdummy=mxCreateNumericArray(nugdim,tgdim,(table.single ? mxSINGLE_CLASS : mxDOUBLE_CLASS), mxREAL);    
   delete [] tgdim;
   
-  const double* const tgRe=(TmatOut?(sgIn? mxGetPr(prhs[9]):mxGetPr(sgdummy)):0);
-  const double* const tgIm=(((TmatOut)&(sgIn))?mxGetPi(prhs[9]):0);
-  const bool tgCmplx=(((TmatOut)&(sgIn))?mxIsComplex(prhs[9]):false);
+  const void* const tgRe=(TmatOut?(sgIn? table.sgRe:mxGetData(sgdummy)):0);
+  const void* const tgIm=(sgIn?table.sgIm:0);
+  const bool tgCmplx=(tgIm!=0);
   
   // Number of degrees of freedom points per collocation point.
   unsigned int nColDof;
@@ -395,35 +792,80 @@ void IntegrateGreenUser(mxArray* plhs[], int nrhs,
   // Vertical receiver coordinate is passed relative
   const bool zRel=false;
 
-  // COPY VARIABLES TO GENERIC ARRAY OF POINTERS GREENPTR
-  // The generic pointer has the same layout in both functions
-  // bemmat_mex.cpp and bemxfer_mex.cpp
-  const unsigned int nGreenPtr=14;
-  const unsigned int GreenFunType=1;
-  const void** const greenPtr=new(nothrow) const void*[nGreenPtr];
-    if (greenPtr==0) throw("Out of memory.");
-  greenPtr[0]=&GreenFunType;
-  greenPtr[1]=&nzs;
-  greenPtr[2]=zs;
-  greenPtr[3]=&nr;
-  greenPtr[4]=r;
-  greenPtr[5]=&nz;
-  greenPtr[6]=z;
-  greenPtr[7]=ugRe;
-  greenPtr[8]=ugIm;
-  greenPtr[9]=tgRe;
-  greenPtr[10]=tgIm;
-  greenPtr[11]=(double* const)0; // tg0Re
-  greenPtr[12]=(double* const)0; // tg0Im
-  greenPtr[13]=&zRel;
-  bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
-               TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
-               nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
-               greenDim,nGreenDim,L,ky,nWave,nmax);
+  // SOURCE DEPTH PER RECEIVER
+  unsigned int* const zsIndex=new(nothrow) unsigned int[nRec];
+  if (zsIndex==0) throw("Out of memory.");
+  double* const zsWeight=(InterpZsLinear ? new(nothrow) double[nRec] : 0);
+  if (InterpZsLinear && (zsWeight==0)) throw("Out of memory.");
+  greeninterpsource(InterpZsLinear,zs,nzs,&Rec[2*nRec],nRec,zsIndex,zsWeight);
+
+  // DERIVATIVE TABLES FOR THE CUBIC INTERPOLATION METHODS AND LOOKUP PLANS
+  // OF THE GRIDS. They are freed below if the integration fails, e.g. if
+  // the range of r or z is insufficient.
+  GreenInterp gi=GreenInterp();
+  gi.method=InterpMethod;
+  gi.zsLinear=InterpZsLinear;
+  gi.zsWeight=zsWeight;
+  gi.single=table.single;
+  SearchGrid rGrid=SearchGrid();
+  SearchGrid zGrid=SearchGrid();
+  const void** greenPtr=0;
+  const char* error=0;
+  try
+  {
+    greeninterpinit(InterpMethod,r,nr,z,nz,(size_t)nugComp*nzs,nGrSet,ugRe,(ugCmplx ? ugIm : 0),gi.single,gi.ug);
+    greeninterpinit(InterpMethod,r,nr,z,nz,(size_t)ntgComp*nzs,nGrSet,(sgIn ? tgRe : 0),(tgCmplx ? tgIm : 0),gi.single,gi.tg);
+    greeninterpinit(InterpMethod,r,nr,z,nz,0,0,0,0,gi.single,gi.tg0); // sg0 is not used
+
+    searchgridinit(r,nr-1,rGrid);
+    searchgridinit(z,nz-1,zGrid);
+
+    // COPY VARIABLES TO GENERIC ARRAY OF POINTERS GREENPTR
+    // The generic pointer has the same layout in both functions
+    // bemmat_mex.cpp and bemxfer_mex.cpp
+    const unsigned int nGreenPtr=18;
+    const unsigned int GreenFunType=1;
+    greenPtr=new(nothrow) const void*[nGreenPtr];
+      if (greenPtr==0) throw("Out of memory.");
+    greenPtr[0]=&GreenFunType;
+    greenPtr[1]=&nzs;
+    greenPtr[2]=zs;
+    greenPtr[3]=&nr;
+    greenPtr[4]=r;
+    greenPtr[5]=&nz;
+    greenPtr[6]=z;
+    greenPtr[7]=ugRe;
+    greenPtr[8]=ugIm;
+    greenPtr[9]=tgRe;
+    greenPtr[10]=tgIm;
+    greenPtr[11]=(void* const)0; // tg0Re
+    greenPtr[12]=(void* const)0; // tg0Im
+    greenPtr[13]=&zRel;
+    greenPtr[14]=zsIndex;
+    greenPtr[15]=&rGrid;
+    greenPtr[16]=&zGrid;
+    greenPtr[17]=&gi;
+    bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
+                 TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
+                 nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
+                 greenDim,nGreenDim,L,ky,nWave,nmax,tLoad,uLoad);
+  }
+  catch (const char* exception)
+  {
+    error=exception;
+  }
 
   mxDestroyArray(sgdummy);               
+  delete [] zsIndex;
+  if (zsWeight!=0) delete [] zsWeight;
+  greeninterpclear(gi.ug);
+  greeninterpclear(gi.tg);
+  searchgridclear(rGrid);
+  searchgridclear(zGrid);
+  greenFileClose(table);
   delete [] greenPtr;
   delete [] greenDim;
+  if (error!=0) throw(error);
 }
 
 //==============================================================================
@@ -437,7 +879,8 @@ void IntegrateFsGreenf(mxArray* plhs[], int nrhs,
                        const unsigned int* const nKeyOpt, const unsigned int& nEltType,
                        const double* const CollPoints, const unsigned int& nTotalColl,
                        const unsigned int& nCentroidColl,
-                       const bool& TmatOut)
+                       const bool& TmatOut, const mxArray* const tLoad,
+                       const mxArray* const uLoad)
 //==============================================================================
 {
   if (!(nrhs==12)) throw("Wrong number of input arguments.");
@@ -529,7 +972,7 @@ void IntegrateFsGreenf(mxArray* plhs[], int nrhs,
   bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
                TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
                nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
-               greenDim,nGreenDim,L,ky,nky,nmax);
+               greenDim,nGreenDim,L,ky,nky,nmax,tLoad,uLoad);
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -546,7 +989,8 @@ void IntegrateFsGreen3d(mxArray* plhs[], int nrhs,
                         const unsigned int* const nKeyOpt, const unsigned int& nEltType,
                         const double* const CollPoints, const unsigned int& nTotalColl,
                         const unsigned int& nCentroidColl,
-                        const bool& TmatOut)
+                        const bool& TmatOut, const mxArray* const tLoad,
+                        const mxArray* const uLoad)
 //==============================================================================
 {
    // INPUT ARGUMENT PROCESSING
@@ -653,7 +1097,7 @@ void IntegrateFsGreen3d(mxArray* plhs[], int nrhs,
   bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
                TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
                nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
-               greenDim,nGreenDim,L,ky,nWave,nmax);
+               greenDim,nGreenDim,L,ky,nWave,nmax,tLoad,uLoad);
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -669,7 +1113,8 @@ void IntegrateFsGreen3d0(mxArray* plhs[], int nrhs,
                          const unsigned int* const nKeyOpt, const unsigned int& nEltType,
                          const double* const CollPoints, const unsigned int& nTotalColl,
                          const unsigned int& nCentroidColl,
-                         const bool& TmatOut)
+                         const bool& TmatOut, const mxArray* const tLoad,
+                         const mxArray* const uLoad)
 /* Initialize Green's function for user defined Green's function ('USER')
  *
  *    greenPtr[0]=&GreenFunType;   Green's function type identifier
@@ -743,7 +1188,7 @@ void IntegrateFsGreen3d0(mxArray* plhs[], int nrhs,
   bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
                TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
                nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
-               greenDim,nGreenDim,L,ky,nWave,nmax);
+               greenDim,nGreenDim,L,ky,nWave,nmax,tLoad,uLoad);
   delete [] greenPtr;
   delete [] greenDim;
   delete [] omega;
@@ -760,7 +1205,8 @@ void IntegrateFsGreen2d_inplane(mxArray* plhs[], int nrhs,
                                 const unsigned int* const nKeyOpt, const unsigned int& nEltType,
                                 const double* const CollPoints, const unsigned int& nTotalColl,
                                 const unsigned int& nCentroidColl,
-                                const bool& TmatOut)
+                                const bool& TmatOut, const mxArray* const tLoad,
+                                const mxArray* const uLoad)
 /* Initialize Green's function for user defined Green's function ('USER')
  *
  *    greenPtr[0]=&GreenFunType;   Green's function type identifier
@@ -848,7 +1294,7 @@ void IntegrateFsGreen2d_inplane(mxArray* plhs[], int nrhs,
   bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
                TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
                nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
-               greenDim,nGreenDim,L,ky,nWave,nmax);
+               greenDim,nGreenDim,L,ky,nWave,nmax,tLoad,uLoad);
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -864,7 +1310,8 @@ void IntegrateFsGreen2d_inplane0(mxArray* plhs[], int nrhs,
                                  const unsigned int* const nKeyOpt, const unsigned int& nEltType,
                                  const double* const CollPoints, const unsigned int& nTotalColl,
                                  const unsigned int& nCentroidColl,
-                                 const bool& TmatOut)
+                                 const bool& TmatOut, const mxArray* const tLoad,
+                                 const mxArray* const uLoad)
 /* Initialize Green's function for user defined Green's function ('FSGREEN2D_INPLANE0')
  *
  *    greenPtr[0]=&GreenFunType;   Green's function type identifier
@@ -938,7 +1385,7 @@ void IntegrateFsGreen2d_inplane0(mxArray* plhs[], int nrhs,
   bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
                TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
                nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
-               greenDim,nGreenDim,L,ky,nWave,nmax);
+               greenDim,nGreenDim,L,ky,nWave,nmax,tLoad,uLoad);
   delete [] greenPtr;
   delete [] greenDim;
   delete [] omega;
@@ -955,7 +1402,8 @@ void IntegrateFsGreen2d_outofplane(mxArray* plhs[], int nrhs,
                                    const unsigned int* const nKeyOpt, const unsigned int& nEltType,
                                    const double* const CollPoints, const unsigned int& nTotalColl,
                                    const unsigned int& nCentroidColl,
-                                   const bool& TmatOut)
+                                   const bool& TmatOut, const mxArray* const tLoad,
+                                   const mxArray* const uLoad)
 /* Initialize Green's function for user defined Green's function ('USER')
  *
  *    greenPtr[0]=&GreenFunType;   Green's function type identifier
@@ -1030,7 +1478,7 @@ void IntegrateFsGreen2d_outofplane(mxArray* plhs[], int nrhs,
   bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
                TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
                nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
-               greenDim,nGreenDim,L,ky,nWave,nmax);
+               greenDim,nGreenDim,L,ky,nWave,nmax,tLoad,uLoad);
   delete [] greenPtr;
   delete [] greenDim;
 }
@@ -1046,7 +1494,8 @@ void IntegrateFsGreen2d_outofplane0(mxArray* plhs[], int nrhs,
                                     const unsigned int* const nKeyOpt, const unsigned int& nEltType,
                                     const double* const CollPoints, const unsigned int& nTotalColl,
                                     const unsigned int& nCentroidColl,
-                                    const bool& TmatOut)
+                                    const bool& TmatOut, const mxArray* const tLoad,
+                                    const mxArray* const uLoad)
 /* Initialize Green's function for user defined Green's function ('IntegrateFsGreen2d_outofplane0')
  *
  *
@@ -1107,7 +1556,7 @@ void IntegrateFsGreen2d_outofplane0(mxArray* plhs[], int nrhs,
   bemIntegrate(plhs,probAxi,probPeriodic,probDim,nColDof,TmatOut,Nod,nNod,Elt,nElt,Rec,nRec,
                TypeID,TypeName,TypeKeyOpts,nKeyOpt,nEltType,CollPoints,
                nTotalColl,nCentroidColl,greenPtr,nGrSet,nugComp,ugCmplx,tgCmplx,
-               greenDim,nGreenDim,L,ky,nWave,nmax);
+               greenDim,nGreenDim,L,ky,nWave,nmax,tLoad,uLoad);
   delete [] greenPtr;
   delete [] greenDim;
   delete [] omega;
@@ -1121,6 +1570,38 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
   {
     checklicense();
 
+    // OPTIONS: BEMXFER('interp',method,...) AND BEMXFER('interpzs',method,...)
+    InterpMethod=0;
+    InterpZsLinear=false;
+    while ((nrhs>0) && mxIsChar(prhs[0]))
+    {
+      char* const opt=mxArrayToString(prhs[0]);
+      const bool optInterp=(strcasecmp(opt,"interp")==0);
+      const bool optInterpZs=(strcasecmp(opt,"interpzs")==0);
+      mxFree(opt);
+      if (!(optInterp || optInterpZs)) break;
+      if (nrhs<3) throw("Not enough input arguments.");
+      if (!mxIsChar(prhs[1])) throw("Input argument 'method' must be a string.");
+      char* const method=mxArrayToString(prhs[1]);
+      const bool linear=(strcasecmp(method,"linear")==0);
+      const bool spline=(strcasecmp(method,"spline")==0);
+      const bool pchip=(strcasecmp(method,"pchip")==0);
+      const bool nearest=(strcasecmp(method,"nearest")==0);
+      mxFree(method);
+      if (optInterp)
+      {
+        if (!(linear || spline || pchip)) throw("Interpolation method must be 'linear', 'spline' or 'pchip'.");
+        InterpMethod=(spline ? 1 : (pchip ? 2 : 0));
+      }
+      else
+      {
+        if (!(linear || nearest)) throw("Interpolation method for zs must be 'nearest' or 'linear'.");
+        InterpZsLinear=linear;
+      }
+      prhs+=2;
+      nrhs-=2;
+    }
+
     // INPUT ARGUMENT PROCESSING
     if (nrhs<5) throw("Not enough input arguments.");
     if (nlhs>2) throw("Too many output arguments.");
@@ -1197,7 +1678,26 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
     const double* const Rec=mxGetPr(prhs[3]);
     const unsigned int nRec=mxGetM(prhs[3]);
 
-    const bool TmatOut=(nlhs>1);
+    // MATRIX-FREE EVALUATION: BEMXFER(nod,elt,typ,rec,t,u,green,...)
+    // The remaining input arguments are shifted such that the Green's function
+    // is found at the same position as for the assembly of Up and Tp.
+    const mxArray* tLoad=0;
+    const mxArray* uLoad=0;
+    if (!mxIsChar(prhs[4]))
+    {
+      if (nrhs<7) throw("Not enough input arguments.");
+      if (nlhs>1) throw("Too many output arguments.");
+      if (!mxIsNumeric(prhs[4])) throw("Input argument 't' must be numeric.");
+      if (mxIsSparse(prhs[4])) throw("Input argument 't' must not be sparse.");
+      if (!mxIsNumeric(prhs[5])) throw("Input argument 'u' must be numeric.");
+      if (mxIsSparse(prhs[5])) throw("Input argument 'u' must not be sparse.");
+      tLoad=prhs[4];
+      if (!mxIsEmpty(prhs[5])) uLoad=prhs[5];
+      prhs+=2;
+      nrhs-=2;
+    }
+
+    const bool TmatOut=(tLoad==0 ? nlhs>1 : uLoad!=0);
 
     // COLLOCATION POINTS: NODAL OR CENTROID
     unsigned int* const NodalColl=new(nothrow) unsigned int[nNod];
@@ -1225,49 +1725,49 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
     {
       IntegrateGreenUser(plhs,nrhs,prhs,probAxi,probPeriodic,probDim,Nod,nNod,Elt,nElt,
                          Rec,nRec,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
-                         nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut);
+                         nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut,tLoad,uLoad);
     }
     else if (strcasecmp(green,"fsgreenf")==0)
     {
       IntegrateFsGreenf(plhs,nrhs,prhs,probAxi,probPeriodic,probDim,Nod,nNod,Elt,nElt,
                         Rec,nRec,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
-                        nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut);
+                        nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut,tLoad,uLoad);
     }
     else if (strcasecmp(green,"fsgreen2d_inplane")==0)
     {
       IntegrateFsGreen2d_inplane(plhs,nrhs,prhs,probAxi,probPeriodic,probDim,Nod,nNod,Elt,nElt,
                                  Rec,nRec,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
-                                 nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut);
+                                 nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut,tLoad,uLoad);
     }
     else if (strcasecmp(green,"fsgreen2d_inplane0")==0)
     {
       IntegrateFsGreen2d_inplane0(plhs,nrhs,prhs,probAxi,probPeriodic,probDim,Nod,nNod,Elt,nElt,
                                   Rec,nRec,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
-                                  nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut);
+                                  nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut,tLoad,uLoad);
     }
     else if (strcasecmp(green,"fsgreen2d_outofplane")==0)
     {
       IntegrateFsGreen2d_outofplane(plhs,nrhs,prhs,probAxi,probPeriodic,probDim,Nod,nNod,Elt,nElt,
                                     Rec,nRec,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
-                                    nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut);
+                                    nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut,tLoad,uLoad);
     }
     else if (strcasecmp(green,"fsgreen2d_outofplane0")==0)
     {
       IntegrateFsGreen2d_outofplane0(plhs,nrhs,prhs,probAxi,probPeriodic,probDim,Nod,nNod,Elt,nElt,
                                      Rec,nRec,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
-                                     nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut);
+                                     nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut,tLoad,uLoad);
     }
     else if (strcasecmp(green,"fsgreen3d")==0)
     {
       IntegrateFsGreen3d(plhs,nrhs,prhs,probAxi,probPeriodic,probDim,Nod,nNod,Elt,nElt,
                          Rec,nRec,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
-                         nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut);
+                         nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut,tLoad,uLoad);
     }
     else if (strcasecmp(green,"fsgreen3d0")==0)
     {
       IntegrateFsGreen3d0(plhs,nrhs,prhs,probAxi,probPeriodic,probDim,Nod,nNod,Elt,nElt,
                           Rec,nRec,TypeID,TypeName,TypeKeyOpts,nKeyOpt,
-                          nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut);
+                          nEltType,CollPoints,nTotalColl,nCentroidColl,TmatOut,tLoad,uLoad);
     }
     else
     {
@@ -1290,6 +1790,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
   }
   catch (const char* exception)
   {
+    greenFileClose(UserTable);
     mexErrMsgTxt(exception);
   }
 }
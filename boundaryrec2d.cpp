@@ -62,14 +62,19 @@ void boundaryRec2d(const double* const Nod, const unsigned int& nNod,
                    const double* const Rec, 
                    const unsigned int& nRec, const unsigned int& nRecDof,
                    bool* const boundaryRec,
+                   unsigned int* const eltRec, unsigned int& nEltRec,
                    double* const TRe,const bool TmatOut,
                    const unsigned int& nDof,const unsigned int& nGrSet,const unsigned int& nugComp,
-                   const unsigned int& nColDof)
+                   const unsigned int& nColDof, const bool eltCol)
 /*
- *  Look up interface receivers.
+ *  Look up interface receivers. If eltCol is true, the columns of TRe refer
+ *  to the collocation points of element iElt instead of all collocation
+ *  points. If eltRec is nonzero, the nEltRec receivers matched to element
+ *  iElt are returned in eltRec (nRec).
  *
  */
 {
+  nEltRec=0;
   double eltxMin= std::numeric_limits<double>::infinity();
   double eltzMin= std::numeric_limits<double>::infinity();
   double eltxMax=-std::numeric_limits<double>::infinity();
@@ -154,6 +159,7 @@ void boundaryRec2d(const double* const Nod, const unsigned int& nNod,
         if (dist<0.05*diag)
         {
           boundaryRec[iRec]=true;
+          if (eltRec!=0) eltRec[nEltRec++]=iRec;
           
           // Evaluate interpolation function
           const double Xi=xiRec[0];
@@ -169,7 +175,7 @@ void boundaryRec2d(const double* const Nod, const unsigned int& nNod,
               {
                 const unsigned int ind0 =nRecDof*nDof*iGrSet;
                 const unsigned int rowBeg=nColDof*iRec;
-                const unsigned int colBeg=nColDof*EltCollIndex[iEltColl];
+                const unsigned int colBeg=nColDof*(eltCol ? iEltColl : EltCollIndex[iEltColl]);
                 
                 if (nugComp==1){
                   TRe[ind0+nRecDof*(colBeg+0)+rowBeg+0] = -M[iEltColl];
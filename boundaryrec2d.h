@@ -7,7 +7,8 @@ void boundaryRec2d(const double* const Nod, const unsigned int& nNod,
                    const unsigned int& nEltType, const double* const CollPoints,
                    const unsigned int& nTotalColl, const unsigned int& nCentroidColl,
                    const double* const Rec, const unsigned int& nRec, const unsigned int& nRecDof,
-                   bool* const boundaryRec,double* const TRe,const bool TmatOut,
+                   bool* const boundaryRec,unsigned int* const eltRec,unsigned int& nEltRec,
+                   double* const TRe,const bool TmatOut,
                    const unsigned int& nDof,const unsigned int& nGrSet,const unsigned int& nugComp,
-                   const unsigned int& nColDof);
+                   const unsigned int& nColDof, const bool eltCol);
 #endif
@@ -4,6 +4,7 @@
 #include "bemdimension.h"
 #include <valarray>
 #include "fminstep.h"
+#include "recgrid.h"
 #include <limits>
 #include <complex>
 
@@ -59,6 +60,72 @@ double recDist3d(valarray<double>& xi,const void** const varargin)
   return dist;
 }
 //==============================================================================
+bool recProject3d(double* const xiRec, const unsigned int& nEltNod,
+                  const unsigned int& EltShapeN, const unsigned int& EltParent,
+                  const double* const EltNod, const double* const x)
+/*  Projects the point x on the element by minimizing the distance with a
+ *  Gauss-Newton iteration on the geometry shape functions. The natural
+ *  coordinates are limited to the parent element in every iteration.
+ *  Returns false if the iteration does not converge, e.g. for a degenerate
+ *  element.
+ */
+{
+  double N[9];
+  double dN[18];
+  double a[6];
+  const unsigned int nMaxIter=20;
+  for (unsigned int iIter=0; iIter<nMaxIter; iIter++)
+  {
+    shapefun(EltShapeN,1,xiRec,N);
+    shapederiv(EltShapeN,1,xiRec,dN);
+    shapenatcoord(dN,nEltNod,1,EltNod,a,2);
+
+    double r[3]={-x[0],-x[1],-x[2]};
+    for (unsigned int iEltNod=0; iEltNod<nEltNod; iEltNod++)
+    {
+      r[0]+=N[iEltNod]*EltNod[0*nEltNod+iEltNod];
+      r[1]+=N[iEltNod]*EltNod[1*nEltNod+iEltNod];
+      r[2]+=N[iEltNod]*EltNod[2*nEltNod+iEltNod];
+    }
+
+    // Normal equations of the linearized distance
+    const double G11=a[0]*a[0]+a[1]*a[1]+a[2]*a[2];
+    const double G12=a[0]*a[3]+a[1]*a[4]+a[2]*a[5];
+    const double G22=a[3]*a[3]+a[4]*a[4]+a[5]*a[5];
+    const double g1=a[0]*r[0]+a[1]*r[1]+a[2]*r[2];
+    const double g2=a[3]*r[0]+a[4]*r[1]+a[5]*r[2];
+    const double det=G11*G22-G12*G12;
+    if (!(det>1e-14*G11*G22)) return false;
+    const double dxi0=-( G22*g1-G12*g2)/det;
+    const double dxi1=-(-G12*g1+G11*g2)/det;
+
+    const double xiOld0=xiRec[0];
+    const double xiOld1=xiRec[1];
+    xiRec[0]+=dxi0;
+    xiRec[1]+=dxi1;
+    if (EltParent==1) // Triangular element
+    {
+      if (xiRec[0]<0.0) xiRec[0]=0.0;
+      if (xiRec[1]<0.0) xiRec[1]=0.0;
+      if ((xiRec[0]+xiRec[1])>1.0)
+      {
+        const double sum=xiRec[0]+xiRec[1];
+        xiRec[0]=xiRec[0]/sum;
+        xiRec[1]=xiRec[1]/sum;
+      }
+    }
+    else              // Quadrilateral element
+    {
+      if (xiRec[0]> 1.0) xiRec[0]= 1.0;
+      if (xiRec[0]<-1.0) xiRec[0]=-1.0;
+      if (xiRec[1]> 1.0) xiRec[1]= 1.0;
+      if (xiRec[1]<-1.0) xiRec[1]=-1.0;
+    }
+    if (sqr(xiRec[0]-xiOld0)+sqr(xiRec[1]-xiOld1)<1e-20) return true;
+  }
+  return false;
+}
+//==============================================================================
 void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
                    const double* const Elt, const unsigned int& nElt, const unsigned int& iElt,
                    const unsigned int* const TypeID,
@@ -70,14 +137,23 @@ void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
                    const double* const Rec, 
                    const unsigned int& nRec, const unsigned int& nRecDof,
                    bool* const boundaryRec,
+                   unsigned int* const eltRec, unsigned int& nEltRec,
                    double* const TRe,const bool TmatOut,
                    const unsigned int& nDof,
-                   const unsigned int& nGrSet)
+                   const unsigned int& nGrSet,
+                   const double* const gridGeom, const unsigned int* const cellStart,
+                   const unsigned int* const cellRec, const bool eltCol)
 /*
- *  Look up interface receivers.
+ *  Look up interface receivers. Only the receivers in the cells of the
+ *  receiver grid (see recgrid.cpp) that overlap the element bounding box
+ *  are considered. If eltCol is true, the columns of TRe refer to the
+ *  collocation points of element iElt instead of all collocation points.
+ *  If eltRec is nonzero, the nEltRec receivers matched to element iElt are
+ *  returned in eltRec (nRec).
  *
  */
 {
+  nEltRec=0;
   double eltxMin= std::numeric_limits<double>::infinity();
   double eltyMin= std::numeric_limits<double>::infinity();
   double eltzMin= std::numeric_limits<double>::infinity();
@@ -127,7 +203,7 @@ void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
     eltzMax=max(eltzMax,EltNod[2*nEltNod+iEltNod]);
   }
   double diag=sqrt(sqr(eltxMax-eltxMin)+sqr(eltyMax-eltyMin)
-                                                         +sqr(eltyMax-eltyMin));
+                                                         +sqr(eltzMax-eltzMin));
   eltxMin=eltxMin-0.25*diag;
   eltyMin=eltyMin-0.25*diag;
   eltzMin=eltzMin-0.25*diag;
@@ -135,8 +211,38 @@ void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
   eltyMax=eltyMax+0.25*diag;
   eltzMax=eltzMax+0.25*diag;
 
-  for (unsigned int iRec=0; iRec<nRec; iRec++)
+  const double boxMin[3]={eltxMin,eltyMin,eltzMin};
+  const double boxMax[3]={eltxMax,eltyMax,eltzMax};
+  unsigned int iBeg[3];
+  unsigned int iEnd[3];
+  recGridRange(gridGeom,boxMin,boxMax,iBeg,iEnd);
+  const unsigned int nx=(unsigned int)gridGeom[6];
+  const unsigned int ny=(unsigned int)gridGeom[7];
+
+  // CANDIDATE RECEIVERS IN THE CELLS OVERLAPPING THE BOUNDING BOX
+  unsigned int nCand=0;
+  for (unsigned int iz=iBeg[2]; iz<iEnd[2]; iz++)
+    for (unsigned int iy=iBeg[1]; iy<iEnd[1]; iy++)
+      for (unsigned int ix=iBeg[0]; ix<iEnd[0]; ix++)
+      {
+        const unsigned int iCell=ix+nx*(iy+ny*iz);
+        nCand+=cellStart[iCell+1]-cellStart[iCell];
+      }
+  unsigned int* const Cand=new(nothrow) unsigned int[nCand+1];
+  if (Cand==0) throw("Out of memory.");
+  nCand=0;
+  for (unsigned int iz=iBeg[2]; iz<iEnd[2]; iz++)
+    for (unsigned int iy=iBeg[1]; iy<iEnd[1]; iy++)
+      for (unsigned int ix=iBeg[0]; ix<iEnd[0]; ix++)
+      {
+        const unsigned int iCell=ix+nx*(iy+ny*iz);
+        for (unsigned int iCellRec=cellStart[iCell]; iCellRec<cellStart[iCell+1]; iCellRec++)
+          Cand[nCand++]=cellRec[iCellRec];
+      }
+
+  for (unsigned int iCand=0; iCand<nCand; iCand++)
   {
+    const unsigned int iRec=Cand[iCand];
     if (!(boundaryRec[iRec]))  // If receiver is not yet matched to an element
     {
       // Check if Receiver is near element iElt
@@ -146,19 +252,29 @@ void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
       {
         
         valarray<double> xiRec(0.0,2);
-        const valarray<double> xiRes(0.1,2);
-        const valarray<double> xiTol(1e-4,2);
-        
-        const void** const varargin=new(nothrow) const void*[6];
+        const void* varargin[6];
         varargin[0]=&nEltNod;
         varargin[1]=&EltShapeN;
         varargin[2]=EltNod;
         varargin[3]=Rec;
         varargin[4]=&nRec;
         varargin[5]=&iRec;
-        
-        // Minimize distance between receiver and element.
-        fminstep(recDist3d,xiRec,xiRes,xiTol,30,varargin);
+
+        // Minimize distance between receiver and element: closest point
+        // projection, with the simplex search as a fallback.
+        double xiNewton[2]={(EltParent==1 ? 1.0/3.0 : 0.0),(EltParent==1 ? 1.0/3.0 : 0.0)};
+        const double xRec[3]={Rec[0*nRec+iRec],Rec[1*nRec+iRec],Rec[2*nRec+iRec]};
+        if (recProject3d(xiNewton,nEltNod,EltShapeN,EltParent,EltNod,xRec))
+        {
+          xiRec[0]=xiNewton[0];
+          xiRec[1]=xiNewton[1];
+        }
+        else
+        {
+          const valarray<double> xiRes(0.1,2);
+          const valarray<double> xiTol(1e-4,2);
+          fminstep(recDist3d,xiRec,xiRes,xiTol,30,varargin);
+        }
         
         if (EltParent==1) // Triangular element
         {
@@ -187,6 +303,7 @@ void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
         if (dist<0.05*diag)
         {
           boundaryRec[iRec]=true;
+          if (eltRec!=0) eltRec[nEltRec++]=iRec;
           
           // Evaluate interpolation function
           double* const Xi=new(nothrow) double[2];
@@ -205,7 +322,7 @@ void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
               {
                 const unsigned int ind0 =nRecDof*nDof*iGrSet;
                 unsigned int rowBeg=3*iRec;
-                unsigned int colBeg=3*EltCollIndex[iEltColl];
+                unsigned int colBeg=3*(eltCol ? iEltColl : EltCollIndex[iEltColl]);
                 TRe[ind0+nRecDof*(colBeg+0)+rowBeg+0] = -M[iEltColl]; // txx
                 TRe[ind0+nRecDof*(colBeg+1)+rowBeg+1] = -M[iEltColl]; // tyy
                 TRe[ind0+nRecDof*(colBeg+2)+rowBeg+2] = -M[iEltColl]; // tzz
@@ -218,6 +335,7 @@ void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
       }
     }
   }
+  delete [] Cand;
   delete [] EltCollIndex;
   delete [] EltNod;
 }
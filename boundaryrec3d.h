@@ -11,7 +11,10 @@ void boundaryRec3d(const double* const Nod, const unsigned int& nNod,
                    const double* const Rec, 
                    const unsigned int& nRec, const unsigned int& nRecDof,
                    bool* const boundaryRec,
+                   unsigned int* const eltRec, unsigned int& nEltRec,
                    double* const TRe,const bool TmatOut,
                    const unsigned int& nDof,
-                   const unsigned int& nGrSet);
+                   const unsigned int& nGrSet,
+                   const double* const gridGeom, const unsigned int* const cellStart,
+                   const unsigned int* const cellRec, const bool eltCol);
 #endif
@@ -0,0 +1,66 @@
+/* fft.cpp
+ *
+ * In-place iterative radix-2 fast Fourier transform (decimation in time),
+ * used for the block convolutions in the time domain routines.
+ *
+ * The forward transform is defined as X[k] = sum_n x[n] exp(-2 pi i n k / N)
+ * and the inverse transform includes the factor 1/N.
+ */
+
+#include <math.h>
+#include <complex>
+using namespace std;
+
+void fft(complex<double>* const x, const unsigned int& n, const bool inverse)
+{
+  if (n<2) return;
+  if ((n & (n-1))!=0) throw("Number of samples in fft must be a power of two.");
+  const double pi=3.141592653589793;
+
+  // BIT REVERSAL PERMUTATION
+  unsigned int j=0;
+  for (unsigned int i=1; i<n; i++)
+  {
+    unsigned int bit=n>>1;
+    while (j & bit)
+    {
+      j^=bit;
+      bit>>=1;
+    }
+    j^=bit;
+    if (i<j) swap(x[i],x[j]);
+  }
+
+  // BUTTERFLIES
+  for (unsigned int len=2; len<=n; len<<=1)
+  {
+    const double ang=(inverse ? 2.0 : -2.0)*pi/len;
+    const complex<double> wlen(cos(ang),sin(ang));
+    const unsigned int half=len>>1;
+    for (unsigned int i=0; i<n; i+=len)
+    {
+      complex<double> w(1.0,0.0);
+      for (unsigned int k=0; k<half; k++)
+      {
+        const complex<double> u=x[i+k];
+        const complex<double> v=x[i+k+half]*w;
+        x[i+k]=u+v;
+        x[i+k+half]=u-v;
+        w*=wlen;
+      }
+    }
+  }
+
+  if (inverse)
+  {
+    const double scale=1.0/n;
+    for (unsigned int i=0; i<n; i++) x[i]*=scale;
+  }
+}
+
+unsigned int nextpow2(const unsigned int& n)
+{
+  unsigned int p=1;
+  while (p<n) p<<=1;
+  return p;
+}
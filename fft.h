@@ -0,0 +1,18 @@
+#include <complex>
+
+#ifndef _FFT_
+#define _FFT_
+void fft(std::complex<double>* const x, const unsigned int& n, const bool inverse);
+/*   In-place radix-2 fast Fourier transform.
+ *   x       Data (n), overwritten by its (inverse) discrete Fourier transform.
+ *   n       Number of samples, must be a power of two.
+ *   inverse Flag to compute the inverse transform, including the 1/n scaling.
+ */
+#endif
+
+#ifndef _NEXTPOW2_
+#define _NEXTPOW2_
+unsigned int nextpow2(const unsigned int& n);
+/*   Smallest power of two larger than or equal to n.
+ */
+#endif
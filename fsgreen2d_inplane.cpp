@@ -151,3 +151,47 @@ void fsgreen2d_inplane(const double Cs, const double Cp,
     }
   }
 }
+/******************************************************************************/
+void fsgreen2d_inplane0(const double Cs, const double Cp, const double rho,
+                        const double* const x, const double* const z,
+                        const int nxRec, const int nzRec,
+                        double* const Ug, double* const Sg,
+                        const bool calcUg, const bool calcSg)
+{
+  const double mu=rho*sqr(Cs);
+  const double M=rho*sqr(Cp);
+  const double nu=(M-2.0*mu)/(2.0*(M-mu));
+  const double pi=3.141592653589793;
+
+  for (int ixRec=0;ixRec<nxRec;ixRec++)
+  {
+    for (int izRec=0;izRec<nzRec;izRec++)
+    {
+      const double r=sqrt(sqr(x[ixRec])+sqr(z[izRec]));
+      const double gx=x[ixRec]/r;
+      const double gz=z[izRec]/r;
+      int ind=ixRec+nxRec*izRec;
+      if (calcUg)
+      {
+        const double logr=log(r);
+        const double Au= 1.0/(8.0*pi*mu*(1.0-nu));
+        const double nu3=3.0-4.0*nu;
+        Ug[4*ind+0]=Au*(gx*gx-nu3*logr);          //ugxx
+        Ug[4*ind+1]=Au*(gz*gx);                   //ugxz
+        Ug[4*ind+2]=Au*(gz*gx);                   //ugzx
+        Ug[4*ind+3]=Au*(gz*gz-nu3*logr);          //ugzz
+      }
+      if (calcSg)
+      {
+        const double As=-1.0/(4.0*pi*(1.0-nu)*r);
+        const double nu2=1.0-2.0*nu;
+        Sg[0+6*ind]=As*(2.0*sqr(gx)*gx+nu2*gx);   //sgxxx
+        Sg[1+6*ind]=As*(2.0*gx*sqr(gz)-nu2*gx);   //sgxzz
+        Sg[2+6*ind]=As*(2.0*sqr(gx)*gz+nu2*gz);   //sgxzx
+        Sg[3+6*ind]=As*(2.0*gz*sqr(gx)-nu2*gz);   //sgzxx
+        Sg[4+6*ind]=As*(2.0*sqr(gz)*gz+nu2*gz);   //sgzzz
+        Sg[5+6*ind]=As*(2.0*sqr(gz)*gx+nu2*gx);   //sgzzx
+      }
+    }
+  }
+}
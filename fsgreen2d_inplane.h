@@ -23,4 +23,15 @@ void fsgreen2d_inplane(const double Cs, const double Cp,
  *   ug    Green's displacements (2 * 2 * nxRec * nzRec * nFreq).
  *   sg    Green's stresses (2 * 3 * nxRec * nzRec * nFreq).
  */
+
+void fsgreen2d_inplane0(const double Cs, const double Cp, const double rho,
+                        const double* const x, const double* const z,
+                        const int nxRec, const int nzRec,
+                        double* const Ug, double* const Sg,
+                        const bool calcUg, const bool calcSg);
+
+/*   Static twodimensional Green's function of a homogeneous fullspace,
+ *   evaluated in real arithmetic. Ug (2 * 2 * nxRec * nzRec) and
+ *   Sg (2 * 3 * nxRec * nzRec) are real.
+ */
 #endif
@@ -102,3 +102,33 @@ void fsgreen2d_outofplane(const double Cs, const double Ds, const double rho,
     }
   }
 }
+/******************************************************************************/
+void fsgreen2d_outofplane0(const double Cs, const double rho,
+                           const double* const x, const double* const z,
+                           const int nxRec, const int nzRec,
+                           double* const Ug, double* const Sg,
+                           const bool calcUg, const bool calcSg)
+{
+  const double mu=rho*sqr(Cs);
+  const double pi=3.141592653589793;
+
+  for (int ixRec=0;ixRec<nxRec;ixRec++)
+  {
+    for (int izRec=0;izRec<nzRec;izRec++)
+    {
+      const double r=sqrt(sqr(x[ixRec])+sqr(z[izRec]));
+      const double gx=x[ixRec]/r;
+      const double gz=z[izRec]/r;
+      int ind=ixRec+nxRec*izRec;
+      if (calcUg)
+      {
+        Ug[0+ind]=-1.0/(2.0*pi*mu)*log(r);                          //ugyy
+      }
+      if (calcSg)
+      {
+        Sg[0+2*ind]=-gx/(2.0*pi*r);                                 //sgyxy
+        Sg[1+2*ind]=-gz/(2.0*pi*r);                                 //sgyyz
+      }
+    }
+  }
+}
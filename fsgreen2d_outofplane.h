@@ -22,4 +22,15 @@ void fsgreen2d_outofplane(const double Cs, const double Ds, const double rho,
  *   ug    Green's displacements (1 * 1 * nxRec * nzRec * nFreq).
  *   sg    Green's stresses (1 * 3 * nxRec * nzRec * nFreq).
  */
+
+void fsgreen2d_outofplane0(const double Cs, const double rho,
+                           const double* const x, const double* const z,
+                           const int nxRec, const int nzRec,
+                           double* const Ug, double* const Sg,
+                           const bool calcUg, const bool calcSg);
+
+/*   Static twodimensional Green's function of a homogeneous fullspace,
+ *   evaluated in real arithmetic. Ug (1 * 1 * nxRec * nzRec) and
+ *   Sg (1 * 2 * nxRec * nzRec) are real.
+ */
 #endif
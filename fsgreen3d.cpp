@@ -148,3 +148,48 @@ void fsgreen3d(const double Cs, const double Cp,
     }
   }
 }
+/******************************************************************************/
+void fsgreen3d0(const double Cs, const double Cp, const double rho,
+                const double* const r, const double* const z,
+                const int& nrRec, const int& nzRec,
+                double* const Ug, double* const Sg,
+                const bool calcUg, const bool calcSg)
+{
+  const double pi=3.141592653589793;
+  const double mu=rho*sqr(Cs);
+  const double M=rho*sqr(Cp);
+  const double nu=(M-2.0*mu)/(2.0*(M-mu));
+  for (int irRec=0;irRec<nrRec;irRec++)
+  {
+    for (int izRec=0;izRec<nzRec;izRec++)
+    {
+      const int ind=irRec+nrRec*izRec;
+      const double R=sqrt(sqr(r[irRec])+sqr(z[izRec]));
+      const double rr= r[irRec]/R;
+      const double rz= z[izRec]/R;
+      if (calcUg)
+      {
+        const double facu=1.0/(16.0*pi*mu*(1.0-nu)*R);
+        Ug[5*ind+0]=facu*(rr*rr+(3.0-4.0*nu));  // ugxr
+        Ug[5*ind+1]=facu*(rr*rz);               // ugxz
+        Ug[5*ind+2]=facu*(3.0-4.0*nu);          // ugyt
+        Ug[5*ind+3]=facu*(rz*rr);               // ugzr
+        Ug[5*ind+4]=facu*(rz*rz+(3.0-4.0*nu));  // ugzz
+      }
+      if (calcSg)
+      {
+        const double facs= -1.0/(8.0*pi*(1.0-nu))/sqr(R);
+        Sg[10*ind+0]= facs*(3.0*rr*rr*rr+(1.0-2.0*nu)*rr);  // sgxrr
+        Sg[10*ind+1]=-facs*(1.0-2.0*nu)*rr;                 // sgxtt
+        Sg[10*ind+2]= facs*(3.0*rr*rz*rz-(1.0-2.0*nu)*rr);  // sgxzz
+        Sg[10*ind+3]= facs*(3.0*rr*rr*rz+(1.0-2.0*nu)*rz);  // sgxzr
+        Sg[10*ind+4]= facs*(1.0-2.0*nu)*rr;                 // sgyrt
+        Sg[10*ind+5]= facs*(1.0-2.0*nu)*rz;                 // sgytz
+        Sg[10*ind+6]= facs*(3.0*rz*rr*rr-(1.0-2.0*nu)*rz);  // sgzrr
+        Sg[10*ind+7]=-facs*(1.0-2.0*nu)*rz;                 // sgztt
+        Sg[10*ind+8]= facs*(3.0*rz*rz*rz+(1.0-2.0*nu)*rz);  // sgzzz
+        Sg[10*ind+9]= facs*(3.0*rz*rz*rr+(1.0-2.0*nu)*rr);  // sgzzr
+      }
+    }
+  }
+}
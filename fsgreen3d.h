@@ -25,4 +25,18 @@ void fsgreen3d(const double Cs, const double Cp,
  *   calcUg Flag to compute Ug.
  *   calcSg Flag to compute Sg.
  */
+
+void fsgreen3d0(const double Cs, const double Cp, const double rho,
+                const double* const r, const double* const z,
+                const int& nrRec, const int& nzRec,
+                double* const Ug, double* const Sg,
+                const bool calcUg, const bool calcSg);
+/*   Static Green's function of a homogeneous fullspace in the cylindrical
+ *   (r,theta,z) frame, evaluated in real arithmetic. The arguments are the
+ *   same as for fsgreen3d.
+ *   Ug     Green's displacements (5 * nrRec * nzRec): ugxr, ugxz, ugyt, ugzr
+ *          and ugzz.
+ *   Sg     Green's stresses (10 * nrRec * nzRec): sgxrr, sgxtt, sgxzz, sgxzr,
+ *          sgyrt, sgytz, sgzrr, sgztt, sgzzz and sgzzr.
+ */
 #endif
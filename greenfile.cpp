@@ -0,0 +1,176 @@
+/* greenfile.cpp
+ *
+ * Memory mapped files with the tables of a user defined Green's function.
+ * The layout of the files is documented in greenfile.h.
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include "isinf.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "greenfile.h"
+
+typedef unsigned long long int uint64;
+
+static const uint64 headerSize=4096;
+static const char fileId[8]={'B','E','M','G','R','N','0','1'};
+
+//==============================================================================
+static void* mapFile(const char* const fileName, uint64& fileSize)
+/* Map a complete file read only and shared into memory.
+ */
+//==============================================================================
+{
+#ifdef _WIN32
+  HANDLE file=CreateFileA(fileName,GENERIC_READ,FILE_SHARE_READ,0,OPEN_EXISTING,
+                          FILE_ATTRIBUTE_NORMAL,0);
+  if (file==INVALID_HANDLE_VALUE) throw("Unable to open the Green's function file.");
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file,&size) || ((uint64)size.QuadPart<headerSize))
+  {
+    CloseHandle(file);
+    throw("Invalid Green's function file.");
+  }
+  fileSize=(uint64)size.QuadPart;
+  HANDLE mapping=CreateFileMappingA(file,0,PAGE_READONLY,0,0,0);
+  CloseHandle(file);
+  if (mapping==0) throw("Unable to map the Green's function file.");
+  void* const map=MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+  CloseHandle(mapping);
+  if (map==0) throw("Unable to map the Green's function file.");
+  return map;
+#else
+  const int fd=open(fileName,O_RDONLY);
+  if (fd<0) throw("Unable to open the Green's function file.");
+  struct stat fileStat;
+  if ((fstat(fd,&fileStat)!=0) || ((uint64)fileStat.st_size<headerSize))
+  {
+    close(fd);
+    throw("Invalid Green's function file.");
+  }
+  fileSize=(uint64)fileStat.st_size;
+  void* const map=mmap(0,(size_t)fileSize,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if (map==MAP_FAILED) throw("Unable to map the Green's function file.");
+  return map;
+#endif
+}
+
+//==============================================================================
+static const void* fileBlock(const void* const map, const uint64& fileSize,
+                             const uint64& offset, const uint64& nValue,
+                             const uint64& valueSize, const bool& required)
+/* Pointer to a block of nValue values of valueSize bytes at offset, or 0 if
+ * the offset is zero and the block is optional.
+ */
+//==============================================================================
+{
+  if (offset==0)
+  {
+    if (required) throw("The Green's function file is incomplete.");
+    return 0;
+  }
+  if ((offset<headerSize) || (offset%valueSize!=0)) throw("Invalid Green's function file.");
+  if ((offset>fileSize) || (nValue>(fileSize-offset)/valueSize)) throw("The Green's function file is truncated.");
+  return (const char*)map+offset;
+}
+
+//==============================================================================
+void greenFileOpen(const char* const fileName, GreenTable& table)
+//==============================================================================
+{
+  uint64 fileSize;
+  void* const map=mapFile(fileName,fileSize);
+  table.map=map;
+  table.mapSize=fileSize;
+
+  try
+  {
+    // HEADER
+    const uint64* const header=(const uint64*)map;
+    if (memcmp(header,fileId,8)!=0) throw("Invalid Green's function file.");
+    if ((header[1]<1) || (header[1]>8)) throw("Invalid Green's function file.");
+    if ((header[11]!=8) && (header[11]!=4)) throw("Unsupported precision of the Green's function file.");
+    table.single=(header[11]==4);
+    table.nDim=(unsigned int)header[1];
+    uint64 nug=1;
+    for (unsigned int iDim=0; iDim<8; iDim++)
+    {
+      if (header[2+iDim]==0) throw("The Green's function file is empty.");
+      if ((iDim>=header[1]) && (header[2+iDim]!=1)) throw("Invalid Green's function file.");
+      table.fileDim[iDim]=(size_t)header[2+iDim];
+      nug*=header[2+iDim];
+    }
+    table.dim=table.fileDim;
+    table.nzs=(unsigned int)header[3];
+    table.nr=(unsigned int)header[4];
+    table.nz=(unsigned int)header[5];
+    table.ntgComp=(unsigned int)header[10];
+    const uint64 ntg=nug/header[2]*header[10];
+
+    // TABLES
+    table.zs=(const double*)fileBlock(map,fileSize,header[12],header[3],8,true);
+    table.r=(const double*)fileBlock(map,fileSize,header[13],header[4],8,true);
+    table.z=(const double*)fileBlock(map,fileSize,header[14],header[5],8,true);
+    table.ugRe=fileBlock(map,fileSize,header[15],nug,header[11],true);
+    table.ugIm=fileBlock(map,fileSize,header[16],nug,header[11],false);
+    table.sgRe=fileBlock(map,fileSize,header[17],ntg,header[11],false);
+    table.sgIm=fileBlock(map,fileSize,header[18],ntg,header[11],false);
+    table.sg0Re=fileBlock(map,fileSize,header[19],ntg,header[11],false);
+    table.sg0Im=fileBlock(map,fileSize,header[20],ntg,header[11],false);
+    if ((ntg==0) && ((table.sgRe!=0) || (table.sg0Re!=0))) throw("Invalid Green's function file.");
+    if (((table.sgRe==0) && (table.sgIm!=0)) || ((table.sg0Re==0) && (table.sg0Im!=0)))
+      throw("Invalid Green's function file.");
+  }
+  catch (const char*)
+  {
+    greenFileClose(table);
+    throw;
+  }
+}
+
+//==============================================================================
+template <class T>
+static bool tableFinite(const T* const re, const T* const im, const size_t& n)
+//==============================================================================
+{
+  for (size_t i=0; i<n; i++)
+  {
+    if (isnan(re[i]) || isinf(re[i])) return false;
+    if ((im!=0) && (isnan(im[i]) || isinf(im[i]))) return false;
+  }
+  return true;
+}
+
+//==============================================================================
+bool greenTableFinite(const void* const re, const void* const im,
+                      const size_t& n, const bool& single)
+//==============================================================================
+{
+  if (single) return tableFinite((const float*)re,(const float*)im,n);
+  return tableFinite((const double*)re,(const double*)im,n);
+}
+
+//==============================================================================
+void greenFileClose(GreenTable& table)
+//==============================================================================
+{
+  if (table.map==0) return;
+#ifdef _WIN32
+  UnmapViewOfFile(table.map);
+#else
+  munmap(table.map,(size_t)table.mapSize);
+#endif
+  table.map=0;
+  table.mapSize=0;
+}
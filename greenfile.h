@@ -0,0 +1,77 @@
+#ifndef _GREENTABLE_
+#define _GREENTABLE_
+struct GreenTable
+{
+  unsigned int nzs;          // Number of source depths
+  unsigned int nr;           // Number of receiver distances
+  unsigned int nz;           // Number of receiver depths
+  const double* zs;          // Source depths (nzs)
+  const double* r;           // Receiver distances (nr)
+  const double* z;           // Receiver depths (nz)
+  unsigned int nDim;         // Number of dimensions of ug
+  const size_t* dim;         // Dimensions of ug (nugComp * nzs * nr * nz * ...)
+  unsigned int ntgComp;      // First dimension of sg and sg0, or 0 if absent
+  bool single;               // Tables ug, sg and sg0 in single precision
+  const void* ugRe;          // Green's displacements; the imaginary parts
+  const void* ugIm;          // are 0 for real tables
+  const void* sgRe;          // Green's stresses, or 0 if absent
+  const void* sgIm;
+  const void* sg0Re;         // Static Green's stresses, or 0 if absent
+  const void* sg0Im;
+  size_t fileDim[8];         // Dimensions of ug stored in the file
+  void* map;                 // Mapping of the file, or 0
+  unsigned long long mapSize;
+};
+/*   Tables of a user defined Green's function, passed as arrays or mapped
+ *   from a Green's function file. The axes are double precision; the tables
+ *   are double or, if single is true, single precision values.
+ */
+#endif
+
+#ifndef _GREENTABLEFINITE_
+#define _GREENTABLEFINITE_
+bool greenTableFinite(const void* const re, const void* const im,
+                      const size_t& n, const bool& single);
+/*   True if the n values of the real part re and the imaginary part im (or 0)
+ *   of a table are finite, i.e. contain no NaN or Inf values.
+ */
+#endif
+
+#ifndef _GREENFILEOPEN_
+#define _GREENFILEOPEN_
+void greenFileOpen(const char* const fileName, GreenTable& table);
+/*   Map a Green's function file read only into memory, without copying.
+ *   fileName  File name.
+ *   table     Tables, pointing into the mapping, to be released with
+ *             greenFileClose.
+ *
+ *   The file is mapped as a whole and shared with all processes that map
+ *   the same file, so that the operating system loads the pages of the
+ *   tables only when they are used for the first time and keeps a single
+ *   copy in memory. The file consists of a header of 4096 bytes, followed
+ *   by the axes zs, r and z and the real and imaginary parts of ug, sg and
+ *   sg0 in column major order. The axes are double precision values and the
+ *   tables double or single precision values. Every block
+ *   starts at a multiple of 4096 bytes. The header contains 64 bit integers:
+ *     [0]       File identifier 'BEMGRN01'.
+ *     [1]       Number of dimensions nDim of ug.
+ *     [2..9]    Dimensions of ug (nugComp * nzs * nr * nz * ...), padded
+ *               with ones.
+ *     [10]      First dimension ntgComp of sg and sg0, or zero.
+ *     [11]      Number of bytes per value of the tables (8 or 4).
+ *     [12..14]  Byte offsets of zs, r and z.
+ *     [15..16]  Byte offsets of the real and imaginary part of ug.
+ *     [17..18]  Byte offsets of the real and imaginary part of sg.
+ *     [19..20]  Byte offsets of the real and imaginary part of sg0.
+ *   The offset of a missing block is zero. All values are stored in the
+ *   byte order of the machine that created the file. The tables are
+ *   checked for NaN and Inf values when the file is written by BEMGREENWRITE.
+ */
+#endif
+
+#ifndef _GREENFILECLOSE_
+#define _GREENFILECLOSE_
+void greenFileClose(GreenTable& table);
+/*   Unmap a Green's function file, if the tables are mapped from a file.
+ */
+#endif
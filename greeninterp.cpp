@@ -0,0 +1,447 @@
+#include <math.h>
+#include <new>
+#include "mex.h"
+#include "search1.h"
+#include "greeninterp.h"
+
+using namespace std;
+
+//==============================================================================
+static void splineslopes(const double* const x, const unsigned int& nx,
+                         const size_t& nInner, const size_t& nOuter,
+                         const double* const f, double* const df)
+/* Slopes of the not-a-knot cubic spline through the values f along the
+ * middle dimension of (nInner * nx * nOuter), as in MATLAB's SPLINE. The
+ * tridiagonal system only depends on x and is factored once; all nInner
+ * lines of a slice are solved together, so that f is traversed with unit
+ * stride.
+ */
+//==============================================================================
+{
+  const size_t nLine=nInner*nx;
+  if (nx==1)
+  {
+    for (size_t i=0; i<nLine*nOuter; i++) df[i]=0.0;
+    return;
+  }
+  if (nx==2)
+  {
+    const double h=x[1]-x[0];
+    for (size_t iOuter=0; iOuter<nOuter; iOuter++)
+    {
+      const double* const fo=f+nLine*iOuter;
+      double* const dfo=df+nLine*iOuter;
+      for (size_t i=0; i<nInner; i++) dfo[i]=dfo[nInner+i]=(fo[nInner+i]-fo[i])/h;
+    }
+    return;
+  }
+  if (nx==3)
+  {
+    // Parabola through the three points
+    const double h0=x[1]-x[0];
+    const double h1=x[2]-x[1];
+    for (size_t iOuter=0; iOuter<nOuter; iOuter++)
+    {
+      const double* const fo=f+nLine*iOuter;
+      double* const dfo=df+nLine*iOuter;
+      for (size_t i=0; i<nInner; i++)
+      {
+        const double d0=(fo[nInner+i]-fo[i])/h0;
+        const double d1=(fo[2*nInner+i]-fo[nInner+i])/h1;
+        const double c=(d1-d0)/(h0+h1);
+        dfo[i]=d0-c*h0;
+        dfo[nInner+i]=d0+c*h0;
+        dfo[2*nInner+i]=d0+c*(h0+2.0*h1);
+      }
+    }
+    return;
+  }
+
+  // TRIDIAGONAL SYSTEM a*s[k-1]+b*s[k]+c*s[k+1]=rhs[k] AND ITS FACTORIZATION
+  double* const h=new(nothrow) double[4*nx];
+  if (h==0) throw("Out of memory.");
+  double* const a=h+nx;
+  double* const m=a+nx;        // Inverse pivots
+  double* const cp=m+nx;       // Modified superdiagonal
+  for (unsigned int k=0; k<nx-1; k++) h[k]=x[k+1]-x[k];
+  const unsigned int n=nx-1;
+  double b=h[1];
+  double c=h[0]+h[1];
+  a[0]=0.0;
+  m[0]=1.0/b;
+  cp[0]=c*m[0];
+  for (unsigned int k=1; k<n; k++)
+  {
+    a[k]=h[k];
+    b=2.0*(h[k-1]+h[k]);
+    c=h[k-1];
+    m[k]=1.0/(b-a[k]*cp[k-1]);
+    cp[k]=c*m[k];
+  }
+  a[n]=h[n-1]+h[n-2];
+  b=h[n-2];
+  m[n]=1.0/(b-a[n]*cp[n-1]);
+  cp[n]=0.0;
+
+  const double e0=(h[0]+2.0*(h[0]+h[1]))*h[1]/(h[0]+h[1]);
+  const double e1=h[0]*h[0]/(h[0]+h[1]);
+  const double en2=h[n-1]*h[n-1]/(h[n-2]+h[n-1]);
+  const double en1=(2.0*(h[n-2]+h[n-1])+h[n-1])*h[n-2]/(h[n-2]+h[n-1]);
+
+  for (size_t iOuter=0; iOuter<nOuter; iOuter++)
+  {
+    const double* const fo=f+nLine*iOuter;
+    double* const dfo=df+nLine*iOuter;
+
+    // FORWARD ELIMINATION
+    for (size_t i=0; i<nInner; i++)
+    {
+      const double d0=(fo[nInner+i]-fo[i])/h[0];
+      const double d1=(fo[2*nInner+i]-fo[nInner+i])/h[1];
+      dfo[i]=(e0*d0+e1*d1)*m[0];
+    }
+    for (unsigned int k=1; k<n; k++)
+    {
+      const double* const fk=fo+nInner*k;
+      double* const dk=dfo+nInner*k;
+      const double* const dkm=dk-nInner;
+      for (size_t i=0; i<nInner; i++)
+      {
+        const double dm=(fk[i]-fk[i-nInner])/h[k-1];
+        const double dp=(fk[i+nInner]-fk[i])/h[k];
+        dk[i]=(3.0*(h[k]*dm+h[k-1]*dp)-a[k]*dkm[i])*m[k];
+      }
+    }
+    {
+      const double* const fk=fo+nInner*n;
+      double* const dk=dfo+nInner*n;
+      const double* const dkm=dk-nInner;
+      for (size_t i=0; i<nInner; i++)
+      {
+        const double dm2=(fk[i-nInner]-fk[i-2*nInner])/h[n-2];
+        const double dm1=(fk[i]-fk[i-nInner])/h[n-1];
+        dk[i]=(en2*dm2+en1*dm1-a[n]*dkm[i])*m[n];
+      }
+    }
+
+    // BACK SUBSTITUTION
+    for (unsigned int k=n; k>0; k--)
+    {
+      double* const dk=dfo+nInner*(k-1);
+      const double* const dkp=dk+nInner;
+      for (size_t i=0; i<nInner; i++) dk[i]-=cp[k-1]*dkp[i];
+    }
+  }
+  delete [] h;
+}
+
+//==============================================================================
+static double pchipend(const double& h0, const double& h1, const double& d0,
+                       const double& d1)
+// Shape preserving one-sided three point slope, as in MATLAB's PCHIP.
+//==============================================================================
+{
+  double s=((2.0*h0+h1)*d0-h0*d1)/(h0+h1);
+  if ((s>0.0)!=(d0>0.0) || (d0==0.0)) s=0.0;
+  else if (((d0>0.0)!=(d1>0.0)) && (fabs(s)>fabs(3.0*d0))) s=3.0*d0;
+  return s;
+}
+
+//==============================================================================
+static void pchipslopes(const double* const x, const unsigned int& nx,
+                        const size_t& nInner, const size_t& nOuter,
+                        const double* const f, double* const df)
+/* Slopes of the monotone piecewise cubic Hermite interpolant (Fritsch and
+ * Carlson) through the values f along the middle dimension of
+ * (nInner * nx * nOuter), as in MATLAB's PCHIP. The interpolant has no
+ * overshoots between the grid points.
+ */
+//==============================================================================
+{
+  const size_t nLine=nInner*nx;
+  if (nx<3)
+  {
+    splineslopes(x,nx,nInner,nOuter,f,df);
+    return;
+  }
+  const unsigned int n=nx-1;
+  for (size_t iOuter=0; iOuter<nOuter; iOuter++)
+  {
+    const double* const fo=f+nLine*iOuter;
+    double* const dfo=df+nLine*iOuter;
+    for (size_t i=0; i<nInner; i++)
+    {
+      double dPrev=(fo[nInner+i]-fo[i])/(x[1]-x[0]);
+      for (unsigned int k=1; k<n; k++)
+      {
+        const double hm=x[k]-x[k-1];
+        const double hp=x[k+1]-x[k];
+        const double dNext=(fo[nInner*(k+1)+i]-fo[nInner*k+i])/hp;
+        double s=0.0;
+        if (((dPrev>0.0) && (dNext>0.0)) || ((dPrev<0.0) && (dNext<0.0)))
+        {
+          const double w1=2.0*hp+hm;
+          const double w2=hp+2.0*hm;
+          s=(w1+w2)/(w1/dPrev+w2/dNext);
+        }
+        dfo[nInner*k+i]=s;
+        dPrev=dNext;
+      }
+      const double d0=(fo[nInner+i]-fo[i])/(x[1]-x[0]);
+      const double d1=(fo[2*nInner+i]-fo[nInner+i])/(x[2]-x[1]);
+      dfo[i]=pchipend(x[1]-x[0],x[2]-x[1],d0,d1);
+      const double dn1=(fo[nInner*n+i]-fo[nInner*(n-1)+i])/(x[n]-x[n-1]);
+      const double dn2=(fo[nInner*(n-1)+i]-fo[nInner*(n-2)+i])/(x[n-1]-x[n-2]);
+      dfo[nInner*n+i]=pchipend(x[n]-x[n-1],x[n-1]-x[n-2],dn1,dn2);
+    }
+  }
+}
+
+//==============================================================================
+static void axisslopes(const unsigned int& method, const double* const x,
+                       const unsigned int& nx, const size_t& nInner,
+                       const size_t& nOuter, const double* const f,
+                       double* const df)
+//==============================================================================
+{
+  if (method==2) pchipslopes(x,nx,nInner,nOuter,f,df);
+  else splineslopes(x,nx,nInner,nOuter,f,df);
+}
+
+//==============================================================================
+void greeninterpsource(const bool& zsLinear, const double* const zs,
+                       const unsigned int& nzs, const double* const zc,
+                       const unsigned int& nc, unsigned int* const zsIndex,
+                       double* const zsWeight)
+//==============================================================================
+{
+  SearchGrid zsGrid;
+  searchgridinit(zs,nzs-1,zsGrid);
+  for (unsigned int ic=0; ic<nc; ic++)
+  {
+    zsIndex[ic]=0;
+    if (zsLinear)
+    {
+      unsigned int zs1;
+      unsigned int zs2;
+      double interpzs[2];
+      bool extrapFlag;
+      search1(zc[ic],zs,nzs-1,zsGrid,zs1,zs2,interpzs,extrapFlag);
+      zsWeight[ic]=0.0;
+      if (!extrapFlag && (zs2>zs1))
+      {
+        zsIndex[ic]=zs1;
+        zsWeight[ic]=interpzs[1];
+        continue;
+      }
+    }
+    searchClosest(zc[ic],zs,nzs-1,zsGrid,zsIndex[ic]);
+  }
+  searchgridclear(zsGrid);
+}
+
+//==============================================================================
+void greeninterpinit(const unsigned int& method, const double* const r,
+                     const unsigned int& nr, const double* const z,
+                     const unsigned int& nz, const size_t& nInner,
+                     const size_t& nOuter, const void* const fRe,
+                     const void* const fIm, const bool& single,
+                     GreenTableDeriv& deriv)
+//==============================================================================
+{
+  for (unsigned int iDeriv=0; iDeriv<3; iDeriv++)
+  {
+    deriv.re[iDeriv]=0;
+    deriv.im[iDeriv]=0;
+  }
+  if ((method==0) || (fRe==0)) return;
+
+  const size_t n=nInner*nr*nz*nOuter;
+  for (unsigned int iPart=0; iPart<2; iPart++)
+  {
+    const void* const fPart=(iPart==0 ? fRe : fIm);
+    if (fPart==0) continue;
+    double** const d=(iPart==0 ? deriv.re : deriv.im);
+    for (unsigned int iDeriv=0; iDeriv<3; iDeriv++)
+    {
+      d[iDeriv]=new(nothrow) double[n];
+      if (d[iDeriv]==0)
+      {
+        greeninterpclear(deriv);
+        throw("Out of memory.");
+      }
+    }
+
+    // A single precision table is converted to double precision in the
+    // table of d2/drdz, which is computed last.
+    const double* f=(const double*)fPart;
+    if (single)
+    {
+      const float* const fs=(const float*)fPart;
+      for (size_t i=0; i<n; i++) d[2][i]=fs[i];
+      f=d[2];
+    }
+    axisslopes(method,r,nr,nInner,nz*nOuter,f,d[0]);        // d/dr
+    axisslopes(method,z,nz,nInner*nr,nOuter,f,d[1]);        // d/dz
+    axisslopes(method,z,nz,nInner*nr,nOuter,d[0],d[2]);     // d2/drdz
+  }
+}
+
+//==============================================================================
+void greeninterpclear(GreenTableDeriv& deriv)
+//==============================================================================
+{
+  for (unsigned int iDeriv=0; iDeriv<3; iDeriv++)
+  {
+    if (deriv.re[iDeriv]!=0) delete [] deriv.re[iDeriv];
+    if (deriv.im[iDeriv]!=0) delete [] deriv.im[iDeriv];
+    deriv.re[iDeriv]=0;
+    deriv.im[iDeriv]=0;
+  }
+}
+
+//==============================================================================
+void greeninterpweights(const GreenInterp& gi, const unsigned int& iColl,
+                        const unsigned int& zs1, const unsigned int& nzs,
+                        const unsigned int& nr, const double* const r,
+                        const double* const z, const unsigned int& r1,
+                        const unsigned int& r2, const unsigned int& z1,
+                        const unsigned int& z2, const double* const interpr,
+                        const double* const interpz, const bool& rExtrap,
+                        size_t* const ind, double* const w,
+                        unsigned int& nCorner, unsigned int& nTab)
+//==============================================================================
+{
+  ind[0]=zs1+nzs*(r1+(size_t)nr*z1);
+  ind[1]=zs1+nzs*(r1+(size_t)nr*z2);
+  ind[2]=zs1+nzs*(r2+(size_t)nr*z1);
+  ind[3]=zs1+nzs*(r2+(size_t)nr*z2);
+
+  if ((gi.method==0) || rExtrap || (r1==r2) || (z1==z2))
+  {
+    w[0]=interpr[0]*interpz[0];
+    w[1]=interpr[0]*interpz[1];
+    w[2]=interpr[1]*interpz[0];
+    w[3]=interpr[1]*interpz[1];
+    nTab=1;
+  }
+  else
+  {
+    // CUBIC HERMITE BASIS FUNCTIONS FOR VALUES (A,C) AND SLOPES (B,D)
+    const double hr=r[r2]-r[r1];
+    const double hz=z[z2]-z[z1];
+    const double t=interpr[1];
+    const double u=interpz[1];
+    const double A[2]={(2.0*t-3.0)*t*t+1.0, (3.0-2.0*t)*t*t};
+    const double B[2]={hr*((t-2.0)*t+1.0)*t, hr*(t-1.0)*t*t};
+    const double C[2]={(2.0*u-3.0)*u*u+1.0, (3.0-2.0*u)*u*u};
+    const double D[2]={hz*((u-2.0)*u+1.0)*u, hz*(u-1.0)*u*u};
+    for (unsigned int ia=0; ia<2; ia++)
+    {
+      for (unsigned int ib=0; ib<2; ib++)
+      {
+        const unsigned int k=2*ia+ib;
+        w[k]=A[ia]*C[ib];
+        w[4+k]=B[ia]*C[ib];
+        w[8+k]=A[ia]*D[ib];
+        w[12+k]=B[ia]*D[ib];
+      }
+    }
+    nTab=4;
+  }
+
+  // LINEAR INTERPOLATION BETWEEN THE SOURCE DEPTHS zs1 AND zs1+1
+  const double ws=(gi.zsLinear ? gi.zsWeight[iColl] : 0.0);
+  if (ws==0.0)
+  {
+    nCorner=4;
+    return;
+  }
+  for (unsigned int k=0; k<4; k++) ind[4+k]=ind[k]+1;
+  for (unsigned int iTab=nTab; iTab>0; iTab--)
+  {
+    for (unsigned int k=0; k<4; k++)
+    {
+      const double wk=w[4*(iTab-1)+k];
+      w[8*(iTab-1)+k]=(1.0-ws)*wk;
+      w[8*(iTab-1)+4+k]=ws*wk;
+    }
+  }
+  nCorner=8;
+}
+
+//==============================================================================
+template <class T>
+static void interpsum(const unsigned int& nComp, const unsigned int& nGrSet,
+                      const size_t& nPoint, const unsigned int& nCorner,
+                      const size_t* const ind, const double* const w,
+                      const unsigned int& nTab, const T* const f,
+                      double* const* const deriv,
+                      const unsigned int* const comp, double* const out)
+/* Weighted sum for a function table f of type T. The products with the
+ * weights are accumulated in double precision.
+ */
+//==============================================================================
+{
+  if ((nTab==1) && (nCorner==4))
+  {
+    // BILINEAR INTERPOLATION FOR A SINGLE SOURCE DEPTH
+    for (unsigned int iGrSet=0; iGrSet<nGrSet; iGrSet++)
+    {
+      const size_t off=nPoint*iGrSet;
+      const T* const t11=f+nComp*(ind[0]+off);
+      const T* const t12=f+nComp*(ind[1]+off);
+      const T* const t21=f+nComp*(ind[2]+off);
+      const T* const t22=f+nComp*(ind[3]+off);
+      double* const o=out+nComp*iGrSet;
+      if (comp==0)
+      {
+        for (unsigned int iComp=0; iComp<nComp; iComp++)
+          o[iComp]=t11[iComp]*w[0]+t12[iComp]*w[1]+t21[iComp]*w[2]+t22[iComp]*w[3];
+      }
+      else
+      {
+        for (unsigned int iComp=0; iComp<nComp; iComp++)
+        {
+          const unsigned int c=comp[iComp];
+          o[iComp]=t11[c]*w[0]+t12[c]*w[1]+t21[c]*w[2]+t22[c]*w[3];
+        }
+      }
+    }
+    return;
+  }
+
+  for (unsigned int iGrSet=0; iGrSet<nGrSet; iGrSet++)
+  {
+    const size_t off=nPoint*iGrSet;
+    size_t pos[8];
+    for (unsigned int k=0; k<nCorner; k++) pos[k]=nComp*(ind[k]+off);
+    for (unsigned int iComp=0; iComp<nComp; iComp++)
+    {
+      const unsigned int c=(comp==0 ? iComp : comp[iComp]);
+      double sum=f[pos[0]+c]*w[0];
+      for (unsigned int k=1; k<nCorner; k++) sum+=f[pos[k]+c]*w[k];
+      for (unsigned int iTab=1; iTab<nTab; iTab++)
+      {
+        const double* const t=deriv[iTab-1];
+        if (t==0) continue;
+        const double* const wt=w+nCorner*iTab;
+        for (unsigned int k=0; k<nCorner; k++) sum+=t[pos[k]+c]*wt[k];
+      }
+      out[nComp*iGrSet+iComp]=sum;
+    }
+  }
+}
+
+//==============================================================================
+void greeninterpsum(const unsigned int& nComp, const unsigned int& nGrSet,
+                    const size_t& nPoint, const unsigned int& nCorner,
+                    const size_t* const ind, const double* const w,
+                    const unsigned int& nTab, const void* const f,
+                    const bool& single, double* const* const deriv,
+                    const unsigned int* const comp, double* const out)
+//==============================================================================
+{
+  if (single) interpsum(nComp,nGrSet,nPoint,nCorner,ind,w,nTab,(const float*)f,deriv,comp,out);
+  else interpsum(nComp,nGrSet,nPoint,nCorner,ind,w,nTab,(const double*)f,deriv,comp,out);
+}
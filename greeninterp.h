@@ -0,0 +1,100 @@
+#ifndef _GREENINTERP_
+#define _GREENINTERP_
+struct GreenTableDeriv
+{
+  double* re[3];           // Derivatives d/dr, d/dz and d2/drdz of the real
+  double* im[3];           // and imaginary part of a table, or 0
+};
+
+struct GreenInterp
+{
+  unsigned int method;     // 0: linear, 1: cubic spline, 2: monotone cubic
+  bool zsLinear;           // Linear instead of nearest interpolation in zs
+  bool single;             // Tables ug, sg and sg0 in single precision
+  const double* zsWeight;  // Weight of the source depth zsIndex+1 per
+                           // collocation point, or 0 for nearest
+  GreenTableDeriv ug;      // Derivative tables of ug, sg and sg0 for the
+  GreenTableDeriv tg;      // cubic methods
+  GreenTableDeriv tg0;
+};
+/*   Interpolation of a user defined Green's function, which is tabulated on
+ *   the grid (zs,r,z). In the plane (r,z), the function is interpolated
+ *   bilinearly or by bicubic Hermite interpolation, with the derivatives at
+ *   the grid points taken from a not-a-knot cubic spline or a monotone
+ *   piecewise cubic (Fritsch-Carlson) interpolant along r and z. The
+ *   derivatives are computed once per call and stored in three double
+ *   precision tables (d/dr, d/dz and d2/drdz) of the same size as the
+ *   Green's function. They need three times the memory of double precision
+ *   tables and six times the memory of single precision tables.
+ *   In zs, the nearest source depth is used, or the results for the two
+ *   neighbouring source depths are interpolated linearly. Single precision
+ *   tables are interpolated as they are stored; the derivative tables and
+ *   all sums are double precision.
+ */
+#endif
+
+#ifndef _GREENINTERPINIT_
+#define _GREENINTERPINIT_
+void greeninterpsource(const bool& zsLinear, const double* const zs,
+                       const unsigned int& nzs, const double* const zc,
+                       const unsigned int& nc, unsigned int* const zsIndex,
+                       double* const zsWeight);
+/*   Source depth of the Green's function for the nc points with vertical
+ *   coordinate zc. For nearest interpolation, zsIndex is the closest source
+ *   depth. For linear interpolation, zsIndex is the source depth at or above
+ *   zc and zsWeight the weight of the next source depth; outside the range
+ *   of zs, the closest source depth is used with weight 0.
+ */
+
+void greeninterpinit(const unsigned int& method, const double* const r,
+                     const unsigned int& nr, const double* const z,
+                     const unsigned int& nz, const size_t& nInner,
+                     const size_t& nOuter, const void* const fRe,
+                     const void* const fIm, const bool& single,
+                     GreenTableDeriv& deriv);
+/*   Computes the derivative tables of a Green's function table f with the
+ *   layout (nInner * nr * nz * nOuter), where nInner = nComp*nzs and
+ *   nOuter = nGrSet. If fIm is 0, only the real part is processed. The
+ *   values of f are double or, if single is true, single precision.
+ */
+
+void greeninterpclear(GreenTableDeriv& deriv);
+/*   Releases the derivative tables.
+ */
+
+void greeninterpweights(const GreenInterp& gi, const unsigned int& iColl,
+                        const unsigned int& zs1, const unsigned int& nzs,
+                        const unsigned int& nr, const double* const r,
+                        const double* const z, const unsigned int& r1,
+                        const unsigned int& r2, const unsigned int& z1,
+                        const unsigned int& z2, const double* const interpr,
+                        const double* const interpz, const bool& rExtrap,
+                        size_t* const ind, double* const w,
+                        unsigned int& nCorner, unsigned int& nTab);
+/*   Grid points ind (zs+nzs*(r+nr*z)) and interpolation weights w that
+ *   contribute to the Green's function in collocation point iColl. The
+ *   corners of the cell are (r1,z1), (r1,z2), (r2,z1) and (r2,z2) for the
+ *   source depth zs1, followed by the same corners for the source depth
+ *   zs1+1 if zs is interpolated linearly (nCorner is 4 or 8). The weights are
+ *   stored as w[iTab*nCorner+iCorner] for the function values (iTab=0) and,
+ *   for the cubic methods, the derivatives d/dr, d/dz and d2/drdz (iTab=1..3).
+ *   nTab is the number of tables that contribute (1 or 4). Cells of zero
+ *   width and extrapolation in r fall back to bilinear weights. The arrays
+ *   ind and w must hold 8 and 32 values.
+ */
+
+void greeninterpsum(const unsigned int& nComp, const unsigned int& nGrSet,
+                    const size_t& nPoint, const unsigned int& nCorner,
+                    const size_t* const ind, const double* const w,
+                    const unsigned int& nTab, const void* const f,
+                    const bool& single, double* const* const deriv,
+                    const unsigned int* const comp, double* const out);
+/*   Weighted sum out[nComp*iGrSet+iComp] of the entries
+ *   tab[iTab][nComp*(ind[iCorner]+nPoint*iGrSet)+comp[iComp]] over the tables
+ *   and corners, with nPoint = nzs*nr*nz the number of grid points per set.
+ *   The table tab[0] is the function f, in double or, if single is true,
+ *   single precision, and tab[1..3] are the derivative tables deriv[0..2].
+ *   If comp is 0, the components are stored in the same order in the table
+ *   and the output. Derivative tables that are 0 are skipped.
+ */
+#endif
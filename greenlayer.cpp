@@ -0,0 +1,1258 @@
+/* greenlayer.cpp
+ *
+ * Green's functions of a horizontally layered halfspace, computed with the
+ * direct stiffness method in the wavenumber domain. See greenlayer.h.
+ */
+
+#include <math.h>
+#include <complex>
+#include <thread>
+#include <new>
+#include <algorithm>
+#include "gausspw.h"
+#include "greenlayer.h"
+
+#ifdef _WIN32
+#define j0 _j0
+#define j1 _j1
+#endif
+
+using namespace std;
+
+typedef complex<double> cplx;
+
+static const double pi=3.141592653589793;
+static const cplx i(0.0,1.0);
+
+// Number of Gauss points per wavenumber panel
+static const unsigned int nGauss=8;
+
+// Number of wavenumber domain quantities per source and receiver:
+// ux, uz, dux/dz and duz/dz for a horizontal load, the same for a vertical
+// load, and uy and duy/dz for a horizontal load in the y-direction.
+static const unsigned int nQuant=10;
+
+//==============================================================================
+// MATERIAL OF A LAYER AT A GIVEN FREQUENCY
+//==============================================================================
+struct LayerMaterial
+{
+  cplx mu;                      // Shear modulus
+  cplx lambda;                  // Lame's first parameter
+  cplx M;                       // Constrained modulus
+  cplx ks2;                     // Squared shear wavenumber
+  cplx kp2;                     // Squared dilatational wavenumber
+};
+
+//==============================================================================
+// WAVE COEFFICIENTS OF A LAYER AT A GIVEN WAVENUMBER
+//==============================================================================
+struct WaveCoef
+{
+  double k;                     // Horizontal wavenumber
+  cplx nup;                     // Vertical decay rates sqrt(k^2-kp^2) and
+  cplx nus;                     // sqrt(k^2-ks^2), with a positive real part
+  cplx delta;                   // nus-nup
+  cplx a;                       // (nus-k)/delta
+  cplx b;                       // (nup-k)/delta
+};
+
+//==============================================================================
+// LAYERED HALFSPACE, DISCRETIZED WITH NODES AT ALL INTERFACES, SOURCES AND
+// RECEIVERS
+//==============================================================================
+struct LayerModel
+{
+  unsigned int greenType;
+  unsigned int nLayer;
+  const LayerMaterial* mat;     // Materials of the layers (nLayer)
+  unsigned int nNode;
+  const double* zNode;          // Node depths (nNode)
+  const unsigned int* nodeMat;  // Layer below every node (nNode)
+  unsigned int nzs;
+  const unsigned int* srcNode;  // Node of every source depth (nzs)
+  unsigned int nz;
+  const unsigned int* recNode;  // Node of every receiver depth (nz)
+  unsigned int nr;
+  const double* r;              // Receiver distances (nr)
+  const double* kmax;           // Upper wavenumber per source and receiver
+                                // depth (nzs * nz)
+  const double* kmaxSrc;        // Upper wavenumber per source depth (nzs)
+  const cplx* asym;             // Static response around every source at
+                                // k=1 (nQuant * nzs)
+  double k0;                    // Wavenumber beyond which the static
+                                // response is subtracted
+  unsigned int nBasic;          // Number of wavenumber integrals
+  bool calcUg;
+  bool calcSg;
+  unsigned int nPanel;
+  const double* panel;          // Bounds of the wavenumber panels (nPanel+1)
+  double xi[nGauss];            // Gauss points and weights on [-1,1]
+  double H[nGauss];
+};
+
+//==============================================================================
+// WORKSPACE OF A THREAD
+//==============================================================================
+struct LayerWork
+{
+  WaveCoef* coef;               // Wave coefficients (nLayer)
+  cplx* K;                      // Stiffness matrices of the elements below
+                                // every node (16 * nNode), 4 * 4 column major
+                                // for the P-SV waves
+  cplx* KSH;                    // Idem for the SH waves (4 * nNode)
+  cplx* Dinv;                   // Inverse of the reduced diagonal blocks
+  cplx* L;                      // Elimination factors (4 * nNode)
+  cplx* DinvSH;                 // Idem for the SH waves (nNode)
+  cplx* LSH;
+  cplx* u;                      // Displacements (2 * nNode * 2 * nzs)
+  cplx* v;                      // SH displacements (nNode * nzs)
+  cplx* q;                      // Wavenumber domain Green's functions
+                                // (nQuant * nzs * nz)
+  double* kern;                 // Kernels of the transform (4 * nr)
+  cplx* S;                      // Wavenumber integrals (nr * nBasic * nzs * nz)
+};
+
+//==============================================================================
+static cplx cexpm1(const cplx& x)
+// exp(x)-1, accurate for small x.
+//==============================================================================
+{
+  if (abs(x)<1e-3) return x*(1.0+x*(0.5+x*(1.0/6.0+x/24.0)));
+  return exp(x)-1.0;
+}
+
+//==============================================================================
+static void cisi(const double& x, double& ci, double& si)
+/* Cosine and sine integrals Ci(x) and Si(x) for x>0, by their power series
+ * for small x and by the continued fraction of E1(ix) for large x.
+ */
+//==============================================================================
+{
+  const double eps=1e-16;
+  if (x<2.0)
+  {
+    const double gamma=0.5772156649015329;
+    double term=1.0;
+    double sumc=0.0;
+    double sums=x;
+    for (unsigned int n=1; n<100; n++)
+    {
+      term*=-x*x/((2.0*n-1.0)*(2.0*n));
+      const double tc=term/(2.0*n);
+      const double ts=term*x/((2.0*n+1.0)*(2.0*n+1.0));
+      sumc+=tc;
+      sums+=ts;
+      if ((fabs(tc)<eps*fabs(sumc)) && (fabs(ts)<eps*fabs(sums))) break;
+    }
+    ci=gamma+log(x)+sumc;
+    si=sums;
+  }
+  else
+  {
+    const double tiny=1e-300;
+    cplx b(1.0,x);
+    cplx c=1.0/tiny;
+    cplx d=1.0/b;
+    cplx h=d;
+    for (unsigned int n=1; n<1000; n++)
+    {
+      const double an=-double(n)*double(n);
+      b+=2.0;
+      d=1.0/(an*d+b);
+      c=b+an/c;
+      const cplx del=c*d;
+      h*=del;
+      if (fabs(del.real()-1.0)+fabs(del.imag())<eps) break;
+    }
+    h*=cplx(cos(x),-sin(x));
+    ci=-h.real();
+    si=0.5*pi+h.imag();
+  }
+}
+
+//==============================================================================
+static void solvedense(cplx* const A, cplx* const B, const unsigned int& n,
+                       const unsigned int& nRhs)
+/* Solve A*X=B by Gaussian elimination with partial pivoting. A (n * n) and
+ * B (n * nRhs) are column major; B is overwritten by X.
+ */
+//==============================================================================
+{
+  for (unsigned int iCol=0; iCol<n; iCol++)
+  {
+    unsigned int iPiv=iCol;
+    for (unsigned int iRow=iCol+1; iRow<n; iRow++)
+    {
+      if (abs(A[iRow+n*iCol])>abs(A[iPiv+n*iCol])) iPiv=iRow;
+    }
+    if (iPiv!=iCol)
+    {
+      for (unsigned int jCol=0; jCol<n; jCol++) swap(A[iCol+n*jCol],A[iPiv+n*jCol]);
+      for (unsigned int iRhs=0; iRhs<nRhs; iRhs++) swap(B[iCol+n*iRhs],B[iPiv+n*iRhs]);
+    }
+    const cplx piv=1.0/A[iCol+n*iCol];
+    for (unsigned int iRow=iCol+1; iRow<n; iRow++)
+    {
+      const cplx f=A[iRow+n*iCol]*piv;
+      if (f==0.0) continue;
+      for (unsigned int jCol=iCol+1; jCol<n; jCol++) A[iRow+n*jCol]-=f*A[iCol+n*jCol];
+      for (unsigned int iRhs=0; iRhs<nRhs; iRhs++) B[iRow+n*iRhs]-=f*B[iCol+n*iRhs];
+    }
+  }
+  for (unsigned int iRhs=0; iRhs<nRhs; iRhs++)
+  {
+    for (unsigned int iRow=n; iRow-->0; )
+    {
+      cplx sum=B[iRow+n*iRhs];
+      for (unsigned int jCol=iRow+1; jCol<n; jCol++) sum-=A[iRow+n*jCol]*B[jCol+n*iRhs];
+      B[iRow+n*iRhs]=sum/A[iRow+n*iRow];
+    }
+  }
+}
+
+//==============================================================================
+static void wavecoef(const LayerMaterial& mat, const double& k, WaveCoef& c)
+/* Wave coefficients of a layer. The differences nus-k and nup-k are
+ * evaluated without cancellation, so that the basis of the P-SV waves
+ * remains well conditioned at large wavenumbers and at zero frequency.
+ */
+//==============================================================================
+{
+  c.k=k;
+  c.nup=sqrt(k*k-mat.kp2);
+  c.nus=sqrt(k*k-mat.ks2);
+  const cplx sum=c.nus+c.nup;
+  c.delta=(mat.kp2-mat.ks2)/sum;
+  c.a=mat.M/(mat.M-mat.mu)*sum/(c.nus+k);
+  c.b=mat.mu/(mat.M-mat.mu)*sum/(c.nup+k);
+}
+
+//==============================================================================
+static void downmodes(const WaveCoef& c, const double& zeta, cplx* const u,
+                      cplx* const du)
+/* Displacements u and their derivatives du with respect to z of the two
+ * down going P-SV waves at a distance zeta below their reference depth, for
+ * a horizontal dependence exp(-i*k*x). u[2*iMode+iDir], with iDir 0 for x
+ * and 1 for z. Mode 0 is the P-wave, mode 1 the combination
+ * (S-i*P)/delta of the S- and P-wave, which tends to the static solution
+ * z*exp(-k*z) if ks and kp tend to zero.
+ */
+//==============================================================================
+{
+  const double k=c.k;
+  const cplx ep=exp(-c.nup*zeta);
+  const cplx x=c.delta*zeta;
+  cplx d;             // (exp(-nus*zeta)-exp(-nup*zeta))/delta
+  if (abs(x)<1e-3) d=-zeta*ep*(1.0-x*(0.5-x*(1.0/6.0-x/24.0)));
+  else d=(exp(-c.nus*zeta)-ep)/c.delta;
+
+  u[0]=-i*k*ep;
+  u[1]=-c.nup*ep;
+  du[0]=-c.nup*u[0];
+  du[1]=-c.nup*u[1];
+  u[2]=c.nus*d+c.a*ep;
+  u[3]=-i*k*d+i*c.b*ep;
+  du[2]=-c.nus*c.nus*d+(k*c.b-c.a*(c.nus+k))*ep;
+  du[3]=i*k*c.nus*d+i*(k*c.a-c.b*(c.nup+k))*ep;
+}
+
+//==============================================================================
+static void traction(const LayerMaterial& mat, const double& k,
+                     const cplx* const u, const cplx* const du, cplx* const t)
+// Traction (sxz,szz) on a horizontal plane.
+//==============================================================================
+{
+  t[0]=mat.mu*(du[0]-i*k*u[1]);
+  t[1]=-i*k*mat.lambda*u[0]+mat.M*du[1];
+}
+
+//==============================================================================
+static void layerstiffness(const LayerMaterial& mat, const WaveCoef& c,
+                           const double& h, cplx* const K)
+/* Stiffness matrix of a layer of thickness h for the P-SV waves (4 * 4,
+ * column major), relating the nodal forces to the displacements (ux,uz) at
+ * the top and the bottom. The down going waves are referenced at the top and
+ * the up going waves, the mirror images of the down going waves, at the
+ * bottom of the layer, so that all exponentials decay.
+ */
+//==============================================================================
+{
+  cplx u0[4], du0[4], uh[4], duh[4];
+  downmodes(c,0.0,u0,du0);
+  downmodes(c,h,uh,duh);
+
+  // DISPLACEMENTS (D) AND NODAL FORCES (F) OF THE WAVES
+  cplx D[16];
+  cplx F[16];
+  for (unsigned int iMode=0; iMode<2; iMode++)
+  {
+    cplx t[2];
+    const unsigned int down=iMode;
+    D[4*down+0]=u0[2*iMode];
+    D[4*down+1]=u0[2*iMode+1];
+    D[4*down+2]=uh[2*iMode];
+    D[4*down+3]=uh[2*iMode+1];
+    traction(mat,c.k,u0+2*iMode,du0+2*iMode,t);
+    F[4*down+0]=-t[0];
+    F[4*down+1]=-t[1];
+    traction(mat,c.k,uh+2*iMode,duh+2*iMode,t);
+    F[4*down+2]=t[0];
+    F[4*down+3]=t[1];
+
+    const unsigned int up=iMode+2;
+    cplx u[2], du[2];
+    u[0]=uh[2*iMode];
+    u[1]=-uh[2*iMode+1];
+    du[0]=-duh[2*iMode];
+    du[1]=duh[2*iMode+1];
+    D[4*up+0]=u[0];
+    D[4*up+1]=u[1];
+    traction(mat,c.k,u,du,t);
+    F[4*up+0]=-t[0];
+    F[4*up+1]=-t[1];
+    u[0]=u0[2*iMode];
+    u[1]=-u0[2*iMode+1];
+    du[0]=-du0[2*iMode];
+    du[1]=du0[2*iMode+1];
+    D[4*up+2]=u[0];
+    D[4*up+3]=u[1];
+    traction(mat,c.k,u,du,t);
+    F[4*up+2]=t[0];
+    F[4*up+3]=t[1];
+  }
+
+  // K=F*inv(D), SOLVED AS D^T*K^T=F^T
+  cplx A[16];
+  cplx B[16];
+  for (unsigned int iRow=0; iRow<4; iRow++)
+  {
+    for (unsigned int iCol=0; iCol<4; iCol++)
+    {
+      A[iRow+4*iCol]=D[iCol+4*iRow];
+      B[iRow+4*iCol]=F[iCol+4*iRow];
+    }
+  }
+  solvedense(A,B,4,4);
+  for (unsigned int iRow=0; iRow<4; iRow++)
+  {
+    for (unsigned int iCol=0; iCol<4; iCol++) K[iRow+4*iCol]=B[iCol+4*iRow];
+  }
+}
+
+//==============================================================================
+static void halfspacestiffness(const LayerMaterial& mat, const WaveCoef& c,
+                               cplx* const K)
+/* Stiffness matrix of a halfspace for the P-SV waves (2 * 2, column major),
+ * stored in the upper left block of a 4 * 4 matrix.
+ */
+//==============================================================================
+{
+  cplx u0[4], du0[4];
+  downmodes(c,0.0,u0,du0);
+  cplx A[4];
+  cplx B[4];
+  for (unsigned int iMode=0; iMode<2; iMode++)
+  {
+    cplx t[2];
+    traction(mat,c.k,u0+2*iMode,du0+2*iMode,t);
+    // Transposed displacements and forces
+    A[iMode+0]=u0[2*iMode];
+    A[iMode+2]=u0[2*iMode+1];
+    B[iMode+0]=-t[0];
+    B[iMode+2]=-t[1];
+  }
+  solvedense(A,B,2,2);
+  K[0]=B[0];
+  K[1]=B[2];
+  K[4]=B[1];
+  K[5]=B[3];
+}
+
+//==============================================================================
+static void layerstiffnessSH(const LayerMaterial& mat, const WaveCoef& c,
+                             const double& h, cplx* const K)
+// Stiffness matrix of a layer for the SH waves (2 * 2).
+//==============================================================================
+{
+  const cplx E=exp(-c.nus*h);
+  const cplx fac=-mat.mu*c.nus/cexpm1(-2.0*c.nus*h);
+  K[0]=fac*(1.0+E*E);
+  K[1]=-2.0*fac*E;
+  K[2]=K[1];
+  K[3]=K[0];
+}
+
+//==============================================================================
+static void inv2(const cplx* const A, cplx* const Ainv)
+//==============================================================================
+{
+  const cplx det=A[0]*A[3]-A[1]*A[2];
+  Ainv[0]=A[3]/det;
+  Ainv[1]=-A[1]/det;
+  Ainv[2]=-A[2]/det;
+  Ainv[3]=A[0]/det;
+}
+
+//==============================================================================
+static void mul2(const cplx* const A, const cplx* const B, cplx* const C)
+//==============================================================================
+{
+  C[0]=A[0]*B[0]+A[2]*B[1];
+  C[1]=A[1]*B[0]+A[3]*B[1];
+  C[2]=A[0]*B[2]+A[2]*B[3];
+  C[3]=A[1]*B[2]+A[3]*B[3];
+}
+
+//==============================================================================
+static void block(const cplx* const K, const unsigned int& iRow,
+                  const unsigned int& iCol, cplx* const B)
+// Block (iRow:iRow+1,iCol:iCol+1) of a 4 * 4 matrix.
+//==============================================================================
+{
+  B[0]=K[iRow+4*iCol];
+  B[1]=K[iRow+1+4*iCol];
+  B[2]=K[iRow+4*(iCol+1)];
+  B[3]=K[iRow+1+4*(iCol+1)];
+}
+
+//==============================================================================
+static void layerresponse(const LayerModel& model, const double& k,
+                          LayerWork& work)
+/* Wavenumber domain Green's functions at all receiver depths for all source
+ * depths.
+ */
+//==============================================================================
+{
+  const unsigned int nNode=model.nNode;
+  const unsigned int nzs=model.nzs;
+  const bool psv=(model.greenType!=3);
+  const bool sh=(model.greenType!=2);
+
+  // ELEMENT STIFFNESS MATRICES
+  for (unsigned int iLayer=0; iLayer<model.nLayer; iLayer++) wavecoef(model.mat[iLayer],k,work.coef[iLayer]);
+  for (unsigned int iNode=0; iNode<nNode; iNode++)
+  {
+    const unsigned int iMat=model.nodeMat[iNode];
+    const LayerMaterial& mat=model.mat[iMat];
+    const WaveCoef& c=work.coef[iMat];
+    if (iNode<nNode-1)
+    {
+      const double h=model.zNode[iNode+1]-model.zNode[iNode];
+      if (psv) layerstiffness(mat,c,h,work.K+16*iNode);
+      if (sh) layerstiffnessSH(mat,c,h,work.KSH+4*iNode);
+    }
+    else
+    {
+      if (psv) halfspacestiffness(mat,c,work.K+16*iNode);
+      if (sh) work.KSH[4*iNode]=mat.mu*c.nus;
+    }
+  }
+
+  // FACTORIZATION OF THE BLOCK TRIDIAGONAL GLOBAL STIFFNESS MATRIX
+  for (unsigned int iNode=0; iNode<nNode; iNode++)
+  {
+    if (psv)
+    {
+      cplx D[4];
+      block(work.K+16*iNode,0,0,D);
+      if (iNode>0)
+      {
+        const cplx* const Kp=work.K+16*(iNode-1);
+        cplx Kbb[4], Kbt[4], Ktb[4], LK[4];
+        block(Kp,2,2,Kbb);
+        block(Kp,2,0,Kbt);
+        block(Kp,0,2,Ktb);
+        mul2(Kbt,work.Dinv+4*(iNode-1),work.L+4*iNode);
+        mul2(work.L+4*iNode,Ktb,LK);
+        for (unsigned int iComp=0; iComp<4; iComp++) D[iComp]+=Kbb[iComp]-LK[iComp];
+      }
+      inv2(D,work.Dinv+4*iNode);
+    }
+    if (sh)
+    {
+      cplx D=work.KSH[4*iNode];
+      if (iNode>0)
+      {
+        const cplx* const Kp=work.KSH+4*(iNode-1);
+        work.LSH[iNode]=Kp[1]*work.DinvSH[iNode-1];
+        D+=Kp[3]-work.LSH[iNode]*Kp[2];
+      }
+      work.DinvSH[iNode]=1.0/D;
+    }
+  }
+
+  // DISPLACEMENTS DUE TO UNIT LOADS AT THE SOURCE NODES
+  for (unsigned int izs=0; izs<nzs; izs++)
+  {
+    if (!(k<=model.kmaxSrc[izs])) continue;
+    const unsigned int iSrc=model.srcNode[izs];
+    if (psv)
+    {
+      for (unsigned int iDir=0; iDir<2; iDir++)
+      {
+        cplx* const u=work.u+2*nNode*(2*izs+iDir);
+        for (unsigned int iNode=0; iNode<iSrc; iNode++)
+        {
+          u[2*iNode]=0.0;
+          u[2*iNode+1]=0.0;
+        }
+        u[2*iSrc]=(iDir==0 ? 1.0 : 0.0);
+        u[2*iSrc+1]=(iDir==1 ? 1.0 : 0.0);
+        for (unsigned int iNode=iSrc+1; iNode<nNode; iNode++)
+        {
+          const cplx* const L=work.L+4*iNode;
+          const cplx y0=u[2*iNode-2];
+          const cplx y1=u[2*iNode-1];
+          u[2*iNode]=-(L[0]*y0+L[2]*y1);
+          u[2*iNode+1]=-(L[1]*y0+L[3]*y1);
+        }
+        for (unsigned int iNode=nNode; iNode-->0; )
+        {
+          cplx y0=u[2*iNode];
+          cplx y1=u[2*iNode+1];
+          if (iNode<nNode-1)
+          {
+            const cplx* const K=work.K+16*iNode;
+            y0-=K[8]*u[2*iNode+2]+K[12]*u[2*iNode+3];
+            y1-=K[9]*u[2*iNode+2]+K[13]*u[2*iNode+3];
+          }
+          const cplx* const Dinv=work.Dinv+4*iNode;
+          u[2*iNode]=Dinv[0]*y0+Dinv[2]*y1;
+          u[2*iNode+1]=Dinv[1]*y0+Dinv[3]*y1;
+        }
+      }
+    }
+    if (sh)
+    {
+      cplx* const v=work.v+nNode*izs;
+      for (unsigned int iNode=0; iNode<iSrc; iNode++) v[iNode]=0.0;
+      v[iSrc]=1.0;
+      for (unsigned int iNode=iSrc+1; iNode<nNode; iNode++) v[iNode]=-work.LSH[iNode]*v[iNode-1];
+      for (unsigned int iNode=nNode; iNode-->0; )
+      {
+        cplx y=v[iNode];
+        if (iNode<nNode-1) y-=work.KSH[4*iNode+2]*v[iNode+1];
+        v[iNode]=work.DinvSH[iNode]*y;
+      }
+    }
+  }
+
+  // DISPLACEMENTS AND THEIR DERIVATIVES AT THE RECEIVERS
+  // The traction at a node is the mean of the tractions of the elements
+  // above and below, which excludes the load itself at the source node, and
+  // zero at the free surface. The derivatives are those of the layer below.
+  for (unsigned int iz=0; iz<model.nz; iz++)
+  {
+    const unsigned int iNode=model.recNode[iz];
+    const LayerMaterial& mat=model.mat[model.nodeMat[iNode]];
+    for (unsigned int izs=0; izs<nzs; izs++)
+    {
+      if (!(k<=model.kmax[izs+nzs*iz])) continue;
+      cplx* const q=work.q+nQuant*(izs+nzs*iz);
+      if (psv)
+      {
+        for (unsigned int iDir=0; iDir<2; iDir++)
+        {
+          const cplx* const u=work.u+2*nNode*(2*izs+iDir);
+          cplx t[2]={0.0,0.0};
+          if (iNode>0)
+          {
+            const cplx* const K=work.K+16*iNode;
+            const cplx* const Kp=work.K+16*(iNode-1);
+            const cplx* const uj=u+2*iNode;
+            const cplx* const up=u+2*iNode-2;
+            cplx tBelow[2];
+            cplx tAbove[2];
+            tBelow[0]=-(K[0]*uj[0]+K[4]*uj[1]);
+            tBelow[1]=-(K[1]*uj[0]+K[5]*uj[1]);
+            if (iNode<nNode-1)
+            {
+              const cplx* const un=u+2*iNode+2;
+              tBelow[0]-=K[8]*un[0]+K[12]*un[1];
+              tBelow[1]-=K[9]*un[0]+K[13]*un[1];
+            }
+            tAbove[0]=Kp[2]*up[0]+Kp[6]*up[1]+Kp[10]*uj[0]+Kp[14]*uj[1];
+            tAbove[1]=Kp[3]*up[0]+Kp[7]*up[1]+Kp[11]*uj[0]+Kp[15]*uj[1];
+            t[0]=0.5*(tBelow[0]+tAbove[0]);
+            t[1]=0.5*(tBelow[1]+tAbove[1]);
+          }
+          const cplx ux=u[2*iNode];
+          const cplx uz=u[2*iNode+1];
+          q[4*iDir+0]=ux;
+          q[4*iDir+1]=uz;
+          q[4*iDir+2]=t[0]/mat.mu+i*k*uz;
+          q[4*iDir+3]=(t[1]+i*k*mat.lambda*ux)/mat.M;
+        }
+      }
+      if (sh)
+      {
+        const cplx* const v=work.v+nNode*izs;
+        cplx t=0.0;
+        if (iNode>0)
+        {
+          const cplx* const K=work.KSH+4*iNode;
+          const cplx* const Kp=work.KSH+4*(iNode-1);
+          cplx tBelow=-K[0]*v[iNode];
+          if (iNode<nNode-1) tBelow-=K[2]*v[iNode+1];
+          const cplx tAbove=Kp[1]*v[iNode-1]+Kp[3]*v[iNode];
+          t=0.5*(tBelow+tAbove);
+        }
+        q[8]=v[iNode];
+        q[9]=t/mat.mu;
+      }
+    }
+  }
+}
+
+//==============================================================================
+static void staticresponse(const LayerMaterial& above,
+                           const LayerMaterial& below, const bool& surface,
+                           const unsigned int& greenType, cplx* const q)
+/* Static response at k=1 of two halfspaces of the materials above and below
+ * a source (or of the halfspace below a source at the free surface), which
+ * is the limit of the wavenumber domain Green's functions at the source depth
+ * for large wavenumbers: the displacements decay as q/k and their
+ * derivatives tend to q. The complex moduli of the layers are used.
+ */
+//==============================================================================
+{
+  const double k=1.0;
+  for (unsigned int iQuant=0; iQuant<nQuant; iQuant++) q[iQuant]=0.0;
+  LayerMaterial matA=above;
+  LayerMaterial matB=below;
+  matA.ks2=0.0;
+  matA.kp2=0.0;
+  matB.ks2=0.0;
+  matB.kp2=0.0;
+  WaveCoef cA, cB;
+  wavecoef(matA,k,cA);
+  wavecoef(matB,k,cB);
+  if (greenType!=3)
+  {
+    cplx KA[16], KB[16];
+    halfspacestiffness(matB,cB,KB);
+    halfspacestiffness(matA,cA,KA);
+    // The halfspace above is the mirror image of a halfspace below.
+    KA[1]=-KA[1];
+    KA[4]=-KA[4];
+    cplx Ktot[4]={KB[0],KB[1],KB[4],KB[5]};
+    if (!surface)
+    {
+      Ktot[0]+=KA[0];
+      Ktot[1]+=KA[1];
+      Ktot[2]+=KA[4];
+      Ktot[3]+=KA[5];
+    }
+    cplx Kinv[4];
+    inv2(Ktot,Kinv);
+    for (unsigned int iDir=0; iDir<2; iDir++)
+    {
+      const cplx ux=Kinv[2*iDir];
+      const cplx uz=Kinv[2*iDir+1];
+      cplx t[2]={0.0,0.0};
+      if (!surface)
+      {
+        t[0]=0.5*(KA[0]*ux+KA[4]*uz-KB[0]*ux-KB[4]*uz);
+        t[1]=0.5*(KA[1]*ux+KA[5]*uz-KB[1]*ux-KB[5]*uz);
+      }
+      q[4*iDir+0]=ux;
+      q[4*iDir+1]=uz;
+      q[4*iDir+2]=t[0]/matB.mu+i*k*uz;
+      q[4*iDir+3]=(t[1]+i*k*matB.lambda*ux)/matB.M;
+    }
+  }
+  if (greenType!=2)
+  {
+    const cplx KA=matA.mu*k;
+    const cplx KB=matB.mu*k;
+    const cplx v=1.0/(surface ? KB : KA+KB);
+    const cplx t=(surface ? cplx(0.0) : 0.5*(KA*v-KB*v));
+    q[8]=v;
+    q[9]=t/matB.mu;
+  }
+}
+
+//==============================================================================
+// KERNEL OF THE TRANSFORM, POWER OF k IN THE ASYMPTOTIC BEHAVIOUR FOR LARGE
+// WAVENUMBERS AND USE FOR THE DISPLACEMENTS OF THE WAVENUMBER INTEGRALS
+//==============================================================================
+// 3D: kernels J0(kr), J1(kr), J1(kr)/kr and J2(kr)/kr.
+static const unsigned int kern3d[20]={0,2,0,3,1,1,0,2,0,1,0,2,1,1,0,2,1,0,1,0};
+static const int pow3d[20]={0,0,0,1,1,1,1,1,1,0,1,1,1,0,1,1,1,0,1,1};
+static const bool ug3d[20]={true,true,true,false,false,false,false,false,false,true,
+                            false,false,false,true,false,false,false,true,false,false};
+// 2D: kernels cos(kr) and sin(kr).
+static const unsigned int kernInplane[12]={0,1,1,1,0,0,1,0,0,0,1,1};
+static const int powInplane[12]={-1,-1,0,0,0,0,-1,-1,0,0,0,0};
+static const bool ugInplane[12]={true,true,false,false,false,false,true,true,false,false,false,false};
+static const unsigned int kernOutofplane[3]={0,1,0};
+static const int powOutofplane[3]={-1,0,0};
+static const bool ugOutofplane[3]={true,false,false};
+
+//==============================================================================
+static void basiccoef(const unsigned int& greenType, const double& k,
+                      const cplx* const q, cplx* const coef)
+/* Wavenumber domain factors of the wavenumber integrals, which are
+ * multiplied by the kernels of the transform.
+ */
+//==============================================================================
+{
+  const cplx& X=q[0];
+  const cplx& Zx=q[1];
+  const cplx& dX=q[2];
+  const cplx& dZx=q[3];
+  const cplx& Xz=q[4];
+  const cplx& Z=q[5];
+  const cplx& dXz=q[6];
+  const cplx& dZ=q[7];
+  const cplx& Y=q[8];
+  const cplx& dY=q[9];
+  switch (greenType)
+  {
+    case 1:
+      coef[0]=k*X;
+      coef[1]=k*(Y-X);
+      coef[2]=k*Y;
+      coef[3]=k*k*(X-Y);
+      coef[4]=k*k*X;
+      coef[5]=k*k*Y;
+      coef[6]=k*dX;
+      coef[7]=k*(dY-dX);
+      coef[8]=k*dY;
+      coef[9]=k*Zx;
+      coef[10]=k*k*Zx;
+      coef[11]=k*k*Zx;
+      coef[12]=k*dZx;
+      coef[13]=k*Xz;
+      coef[14]=k*k*Xz;
+      coef[15]=k*k*Xz;
+      coef[16]=k*dXz;
+      coef[17]=k*Z;
+      coef[18]=k*k*Z;
+      coef[19]=k*dZ;
+      break;
+    case 2:
+      coef[0]=X;
+      coef[1]=Zx;
+      coef[2]=k*X;
+      coef[3]=dZx;
+      coef[4]=dX;
+      coef[5]=k*Zx;
+      coef[6]=Xz;
+      coef[7]=Z;
+      coef[8]=k*Xz;
+      coef[9]=dZ;
+      coef[10]=dXz;
+      coef[11]=k*Z;
+      break;
+    case 3:
+      coef[0]=Y;
+      coef[1]=k*Y;
+      coef[2]=dY;
+      break;
+  }
+}
+
+//==============================================================================
+static double moment(const unsigned int& greenType, const unsigned int& kern,
+                     const int& p, const double& k0, const double& r)
+/* Integral of k^p times a kernel over the wavenumbers from k0 (2D) or 0 (3D)
+ * to infinity, in the sense of distributions.
+ */
+//==============================================================================
+{
+  if (greenType==1)
+  {
+    if (p==0) return 1.0/r;
+    if (kern==0) return 0.0;
+    return 1.0/(r*r);
+  }
+  const double x=k0*r;
+  if (p<0)
+  {
+    double ci, si;
+    cisi(x,ci,si);
+    return (kern==0 ? -ci : 0.5*pi-si);
+  }
+  return (kern==0 ? -sin(x)/r : cos(x)/r);
+}
+
+//==============================================================================
+static void layerworker(const LayerModel* const model, const unsigned int iWorker,
+                        const unsigned int nWorker, LayerWork* const work)
+/* Accumulate the wavenumber integrals over the panels iWorker,
+ * iWorker+nWorker, ...
+ */
+//==============================================================================
+{
+  const unsigned int greenType=model->greenType;
+  const unsigned int nzs=model->nzs;
+  const unsigned int nz=model->nz;
+  const unsigned int nr=model->nr;
+  const unsigned int nBasic=model->nBasic;
+  const unsigned int* const kernType=(greenType==1 ? kern3d : (greenType==2 ? kernInplane : kernOutofplane));
+  const bool* const ugBasic=(greenType==1 ? ug3d : (greenType==2 ? ugInplane : ugOutofplane));
+
+  for (unsigned int iS=0; iS<nr*nBasic*nzs*nz; iS++) work->S[iS]=0.0;
+  for (unsigned int iPanel=iWorker; iPanel<model->nPanel; iPanel+=nWorker)
+  {
+    const double ka=model->panel[iPanel];
+    const double kb=model->panel[iPanel+1];
+    for (unsigned int iGauss=0; iGauss<nGauss; iGauss++)
+    {
+      const double k=0.5*(ka+kb)+0.5*(kb-ka)*model->xi[iGauss];
+      const double w=0.5*(kb-ka)*model->H[iGauss];
+      layerresponse(*model,k,*work);
+
+      // KERNELS
+      double* const kern=work->kern;
+      for (unsigned int ir=0; ir<nr; ir++)
+      {
+        const double x=k*model->r[ir];
+        if (greenType==1)
+        {
+          const double J0=j0(x);
+          kern[ir]=J0;
+          kern[nr+ir]=j1(x);
+          if (x<0.01)
+          {
+            const double x2=x*x;
+            kern[2*nr+ir]=0.5-x2/16.0+x2*x2/384.0;
+            kern[3*nr+ir]=x*(0.125-x2/96.0+x2*x2/3072.0);
+          }
+          else
+          {
+            kern[2*nr+ir]=kern[nr+ir]/x;
+            kern[3*nr+ir]=(2.0*kern[2*nr+ir]-J0)/x;
+          }
+        }
+        else
+        {
+          kern[ir]=cos(x);
+          kern[nr+ir]=sin(x);
+        }
+      }
+
+      // WAVENUMBER INTEGRALS
+      for (unsigned int iz=0; iz<nz; iz++)
+      {
+        for (unsigned int izs=0; izs<nzs; izs++)
+        {
+          const unsigned int iPair=izs+nzs*iz;
+          if (!(k<=model->kmax[iPair])) continue;
+          cplx q[nQuant];
+          for (unsigned int iQuant=0; iQuant<nQuant; iQuant++) q[iQuant]=work->q[nQuant*iPair+iQuant];
+          if ((model->srcNode[izs]==model->recNode[iz]) && (k>model->k0))
+          {
+            const cplx* const asym=model->asym+nQuant*izs;
+            for (unsigned int iQuant=0; iQuant<nQuant; iQuant++)
+            {
+              // Displacements decay as 1/k, their derivatives tend to a constant.
+              const bool displ=(iQuant<8 ? (iQuant%4<2) : (iQuant==8));
+              q[iQuant]-=(displ ? asym[iQuant]/k : asym[iQuant]);
+            }
+          }
+          cplx coef[20];
+          basiccoef(greenType,k,q,coef);
+          cplx* const S=work->S+nr*nBasic*iPair;
+          for (unsigned int iBasic=0; iBasic<nBasic; iBasic++)
+          {
+            if (!model->calcSg && !ugBasic[iBasic]) continue;
+            const cplx c=w*coef[iBasic];
+            const double* const kernBasic=kern+nr*kernType[iBasic];
+            for (unsigned int ir=0; ir<nr; ir++) S[nr*iBasic+ir]+=c*kernBasic[ir];
+          }
+        }
+      }
+    }
+  }
+}
+
+//==============================================================================
+static unsigned int findnode(const unsigned int& nNode, const double* const zNode,
+                             const double& z, const double& tol)
+// Node at depth z.
+//==============================================================================
+{
+  unsigned int iNode=0;
+  while ((iNode<nNode-1) && (zNode[iNode]<z-tol)) iNode++;
+  return iNode;
+}
+
+//==============================================================================
+void greenlayer(const unsigned int& greenType, const unsigned int& nLayer,
+                const double* const h, const double* const Cs,
+                const double* const Cp, const double* const Ds,
+                const double* const Dp, const double* const rho,
+                const double& omega, const unsigned int& nzs,
+                const double* const zs, const unsigned int& nr,
+                const double* const r, const unsigned int& nz,
+                const double* const z, const unsigned int& nThread,
+                complex<double>* const ug, complex<double>* const sg)
+//==============================================================================
+{
+  const unsigned int nBasic=(greenType==1 ? 20 : (greenType==2 ? 12 : 3));
+  const unsigned int nugComp=(greenType==1 ? 5 : (greenType==2 ? 4 : 1));
+  const unsigned int ntgComp=(greenType==1 ? 10 : (greenType==2 ? 6 : 2));
+  const unsigned int nPair=nzs*nz;
+  const unsigned int nNodeMax=nLayer+nzs+nz;
+
+  LayerModel model;
+  model.greenType=greenType;
+  model.nLayer=nLayer;
+  model.nzs=nzs;
+  model.nz=nz;
+  model.nr=nr;
+  model.r=r;
+  model.nBasic=nBasic;
+  model.calcUg=(ug!=0);
+  model.calcSg=(sg!=0);
+  gausspw1D_nodiv(nGauss,model.xi,model.H);
+
+  LayerMaterial* const mat=new (nothrow) LayerMaterial[nLayer];
+  double* const zInt=new (nothrow) double[nLayer];
+  double* const zNode=new (nothrow) double[nNodeMax];
+  unsigned int* const nodeMat=new (nothrow) unsigned int[nNodeMax+nzs+nz];
+  double* const kmax=new (nothrow) double[nPair+nzs];
+  cplx* const asym=new (nothrow) cplx[nQuant*nzs];
+  LayerWork* const work=new (nothrow) LayerWork[nThread];
+  double* panel=0;
+  if ((mat==0) || (zInt==0) || (zNode==0) || (nodeMat==0) || (kmax==0) || (asym==0) || (work==0))
+  {
+    delete [] mat;
+    delete [] zInt;
+    delete [] zNode;
+    delete [] nodeMat;
+    delete [] kmax;
+    delete [] asym;
+    delete [] work;
+    throw("Out of memory.");
+  }
+  for (unsigned int iWorker=0; iWorker<nThread; iWorker++)
+  {
+    work[iWorker].coef=0;
+    work[iWorker].K=0;
+    work[iWorker].kern=0;
+  }
+  unsigned int* const srcNode=nodeMat+nNodeMax;
+  unsigned int* const recNode=srcNode+nzs;
+
+  try
+  {
+    // MATERIALS
+    const double sgn=(omega>0.0 ? 1.0 : (omega<0.0 ? -1.0 : 0.0));
+    for (unsigned int iLayer=0; iLayer<nLayer; iLayer++)
+    {
+      mat[iLayer].mu=rho[iLayer]*Cs[iLayer]*Cs[iLayer]*(1.0+sgn*2.0*i*Ds[iLayer]);
+      mat[iLayer].M=rho[iLayer]*Cp[iLayer]*Cp[iLayer]*(1.0+sgn*2.0*i*Dp[iLayer]);
+      mat[iLayer].lambda=mat[iLayer].M-2.0*mat[iLayer].mu;
+      mat[iLayer].ks2=rho[iLayer]*omega*omega/mat[iLayer].mu;
+      mat[iLayer].kp2=rho[iLayer]*omega*omega/mat[iLayer].M;
+      zInt[iLayer]=(iLayer==0 ? 0.0 : zInt[iLayer-1]+h[iLayer-1]);
+    }
+
+    // NODES AT THE INTERFACES, SOURCES AND RECEIVERS
+    unsigned int nNode=0;
+    for (unsigned int iLayer=0; iLayer<nLayer; iLayer++) zNode[nNode++]=zInt[iLayer];
+    for (unsigned int izs=0; izs<nzs; izs++) zNode[nNode++]=zs[izs];
+    for (unsigned int iz=0; iz<nz; iz++) zNode[nNode++]=z[iz];
+    sort(zNode,zNode+nNode);
+    const double tol=1e-9*zNode[nNode-1];
+    unsigned int nUnique=1;
+    for (unsigned int iNode=1; iNode<nNode; iNode++)
+    {
+      if (zNode[iNode]-zNode[nUnique-1]>tol) zNode[nUnique++]=zNode[iNode];
+    }
+    nNode=nUnique;
+    for (unsigned int iNode=0; iNode<nNode; iNode++)
+    {
+      const double zMid=(iNode<nNode-1 ? 0.5*(zNode[iNode]+zNode[iNode+1]) : zNode[iNode]+1.0);
+      unsigned int iLayer=0;
+      while ((iLayer<nLayer-1) && (zMid>zInt[iLayer+1])) iLayer++;
+      nodeMat[iNode]=iLayer;
+    }
+    for (unsigned int izs=0; izs<nzs; izs++) srcNode[izs]=findnode(nNode,zNode,zs[izs],tol);
+    for (unsigned int iz=0; iz<nz; iz++) recNode[iz]=findnode(nNode,zNode,z[iz],tol);
+
+    model.mat=mat;
+    model.nNode=nNode;
+    model.zNode=zNode;
+    model.nodeMat=nodeMat;
+    model.srcNode=srcNode;
+    model.recNode=recNode;
+
+    // REFERENCE WAVENUMBER, CRITICAL REGION AND PANEL WIDTHS
+    // The critical region contains all surface wave poles and the branch
+    // points; its panels resolve the width of the poles, which is
+    // proportional to the damping ratio.
+    double kRef=0.0;
+    double Dmin=1.0;
+    for (unsigned int iLayer=0; iLayer<nLayer; iLayer++)
+    {
+      kRef=max(kRef,fabs(omega)/Cs[iLayer]);
+      Dmin=min(Dmin,min(Ds[iLayer],Dp[iLayer]));
+    }
+    const double kc=1.5*kRef;
+    double L=2.0*zNode[nNode-1];
+    for (unsigned int ir=0; ir<nr; ir++) L=max(L,r[ir]);
+    const double hc=(L>0.0 ? min(pi/L,0.5*Dmin*kRef) : 0.5*Dmin*kRef);
+    const double ht=(L>0.0 ? (kRef>0.0 ? min(pi/L,0.5*kRef) : pi/L) : 0.5*kRef);
+    model.k0=(greenType==1 ? 0.0 : kc);
+
+    // STATIC RESPONSE AROUND THE SOURCES AND UPPER BOUNDS OF THE WAVENUMBERS
+    // Beyond the upper bound, the response (minus the static response of
+    // the material around the source) has decayed exponentially.
+    double* const kmaxSrc=kmax+nPair;
+    for (unsigned int izs=0; izs<nzs; izs++)
+    {
+      const unsigned int iSrc=srcNode[izs];
+      const LayerMaterial& below=mat[nodeMat[iSrc]];
+      const LayerMaterial& above=(iSrc>0 ? mat[nodeMat[iSrc-1]] : below);
+      staticresponse(above,below,iSrc==0,greenType,asym+nQuant*izs);
+      double dloc=HUGE_VAL;
+      for (unsigned int iLayer=0; iLayer<nLayer; iLayer++)
+      {
+        const double dist=fabs(zInt[iLayer]-zNode[iSrc]);
+        if (dist>tol) dloc=min(dloc,dist);
+      }
+      kmaxSrc[izs]=0.0;
+      for (unsigned int iz=0; iz<nz; iz++)
+      {
+        const unsigned int iPair=izs+nzs*iz;
+        const double delta=fabs(zNode[recNode[iz]]-zNode[iSrc]);
+        if (recNode[iz]!=iSrc) kmax[iPair]=kc+30.0/delta;
+        else
+        {
+          for (unsigned int ir=0; ir<nr; ir++)
+          {
+            if (!(r[ir]>0.0)) throw("The Green's function is singular for r=0 at the source depth.");
+          }
+          kmax[iPair]=kc+max(100.0*kRef,20.0/dloc);
+        }
+        kmaxSrc[izs]=max(kmaxSrc[izs],kmax[iPair]);
+      }
+    }
+    model.kmax=kmax;
+    model.kmaxSrc=kmaxSrc;
+    model.asym=asym;
+
+    // WAVENUMBER PANELS
+    double kEnd=0.0;
+    for (unsigned int izs=0; izs<nzs; izs++) kEnd=max(kEnd,kmaxSrc[izs]);
+    const unsigned int nc=(kc>0.0 ? (unsigned int)ceil(kc/hc) : 0);
+    const unsigned int nt=(kEnd>kc ? (unsigned int)ceil((kEnd-kc)/ht) : 0);
+    const unsigned int nPanel=nc+nt;
+    panel=new (nothrow) double[nPanel+1];
+    if (panel==0) throw("Out of memory.");
+    for (unsigned int iPanel=0; iPanel<nc; iPanel++) panel[iPanel]=kc*iPanel/nc;
+    for (unsigned int iPanel=0; iPanel<=nt; iPanel++) panel[nc+iPanel]=kc+(kEnd-kc)*iPanel/nt;
+    if (nPanel==0) panel[0]=0.0;
+    model.nPanel=nPanel;
+    model.panel=panel;
+
+    // WORKSPACE
+    const unsigned int nWorker=max(1u,min(nThread,nPanel));
+    const unsigned int nS=nr*nBasic*nPair;
+    const unsigned int nCplx=32*nNode+4*nNode*nzs+nNode*nzs+nQuant*nPair+nS;
+    for (unsigned int iWorker=0; iWorker<nWorker; iWorker++)
+    {
+      LayerWork& w=work[iWorker];
+      w.coef=new (nothrow) WaveCoef[nLayer];
+      w.K=new (nothrow) cplx[nCplx];
+      w.kern=new (nothrow) double[4*nr];
+      if ((w.coef==0) || (w.K==0) || (w.kern==0)) throw("Out of memory.");
+      w.KSH=w.K+16*nNode;
+      w.Dinv=w.KSH+4*nNode;
+      w.L=w.Dinv+4*nNode;
+      w.DinvSH=w.L+4*nNode;
+      w.LSH=w.DinvSH+nNode;
+      w.u=w.LSH+nNode;
+      w.v=w.u+4*nNode*nzs;
+      w.q=w.v+nNode*nzs;
+      w.S=w.q+nQuant*nPair;
+    }
+
+    // WAVENUMBER INTEGRALS, PANELS INTERLEAVED OVER THE THREADS
+    thread* const threads=new (nothrow) thread[nWorker];
+    unsigned int nStarted=0;
+    if (threads!=0)
+    {
+      try
+      {
+        for (unsigned int iWorker=1; iWorker<nWorker; iWorker++)
+        {
+          threads[iWorker]=thread(layerworker,&model,iWorker,nWorker,work+iWorker);
+          nStarted=iWorker;
+        }
+      }
+      catch (...)
+      {
+      }
+    }
+    layerworker(&model,0,nWorker,work);
+    for (unsigned int iWorker=1; iWorker<=nStarted; iWorker++) threads[iWorker].join();
+    for (unsigned int iWorker=nStarted+1; iWorker<nWorker; iWorker++) layerworker(&model,iWorker,nWorker,work+iWorker);
+    delete [] threads;
+    cplx* const S=work[0].S;
+    for (unsigned int iWorker=1; iWorker<nWorker; iWorker++)
+    {
+      for (unsigned int iS=0; iS<nS; iS++) S[iS]+=work[iWorker].S[iS];
+    }
+
+    // TRANSFORM OF THE STATIC RESPONSE FOR RECEIVERS AT THE SOURCE DEPTH
+    const unsigned int* const kernType=(greenType==1 ? kern3d : (greenType==2 ? kernInplane : kernOutofplane));
+    const int* const powBasic=(greenType==1 ? pow3d : (greenType==2 ? powInplane : powOutofplane));
+    const bool* const ugBasic=(greenType==1 ? ug3d : (greenType==2 ? ugInplane : ugOutofplane));
+    for (unsigned int iz=0; iz<nz; iz++)
+    {
+      for (unsigned int izs=0; izs<nzs; izs++)
+      {
+        if (srcNode[izs]!=recNode[iz]) continue;
+        cplx coef[20];
+        basiccoef(greenType,1.0,asym+nQuant*izs,coef);
+        cplx* const Spair=S+nr*nBasic*(izs+nzs*iz);
+        for (unsigned int iBasic=0; iBasic<nBasic; iBasic++)
+        {
+          if (!model.calcSg && !ugBasic[iBasic]) continue;
+          if (coef[iBasic]==0.0) continue;
+          for (unsigned int ir=0; ir<nr; ir++)
+          {
+            Spair[nr*iBasic+ir]+=coef[iBasic]*moment(greenType,kernType[iBasic],powBasic[iBasic],model.k0,r[ir]);
+          }
+        }
+      }
+    }
+
+    // DISPLACEMENTS AND STRESSES
+    for (unsigned int iz=0; iz<nz; iz++)
+    {
+      const LayerMaterial& m=mat[nodeMat[recNode[iz]]];
+      const cplx& mu=m.mu;
+      const cplx& lambda=m.lambda;
+      const cplx& M=m.M;
+      for (unsigned int ir=0; ir<nr; ir++)
+      {
+        for (unsigned int izs=0; izs<nzs; izs++)
+        {
+          const cplx* const Spair=S+nr*nBasic*(izs+nzs*iz)+ir;
+          cplx B[20];
+          for (unsigned int iBasic=0; iBasic<nBasic; iBasic++) B[iBasic]=Spair[nr*iBasic];
+          const unsigned int iTable=izs+nzs*(ir+nr*iz);
+          complex<double>* const ugi=(model.calcUg ? ug+nugComp*iTable : 0);
+          complex<double>* const sgi=(model.calcSg ? sg+ntgComp*iTable : 0);
+          if (greenType==1)
+          {
+            const double fac=0.5/pi;
+            const cplx A=fac*(B[0]+B[1]);
+            const cplx Bt=fac*(B[2]-B[1]);
+            const cplx C=-i*fac*B[9];
+            const cplx E=-i*fac*B[13];
+            const cplx F=fac*B[17];
+            if (ugi!=0)
+            {
+              ugi[0]=A;
+              ugi[1]=C;
+              ugi[2]=Bt;
+              ugi[3]=E;
+              ugi[4]=F;
+            }
+            if (sgi!=0)
+            {
+              // Horizontal load: ur=cos(theta)*A, ut=-sin(theta)*Bt, uz=cos(theta)*C
+              const cplx dAdr=fac*(B[3]-B[4]);
+              const cplx dBdr=-fac*(B[3]+B[5]);
+              const cplx AmBr=-fac*B[3];
+              const cplx dAdz=fac*(B[6]+B[7]);
+              const cplx dBdz=fac*(B[8]-B[7]);
+              const cplx dCdr=-i*fac*(B[10]-B[11]);
+              const cplx Cr=-i*fac*B[11];
+              const cplx dCdz=-i*fac*B[12];
+              const cplx divx=dAdr+AmBr+dCdz;
+              sgi[0]=lambda*divx+2.0*mu*dAdr;
+              sgi[1]=lambda*divx+2.0*mu*AmBr;
+              sgi[2]=lambda*divx+2.0*mu*dCdz;
+              sgi[3]=mu*(dAdz+dCdr);
+              sgi[4]=mu*(AmBr+dBdr);
+              sgi[5]=mu*(dBdz+Cr);
+              // Vertical load: ur=E, uz=F
+              const cplx dEdr=-i*fac*(B[14]-B[15]);
+              const cplx Er=-i*fac*B[15];
+              const cplx dEdz=-i*fac*B[16];
+              const cplx dFdr=-fac*B[18];
+              const cplx dFdz=fac*B[19];
+              const cplx divz=dEdr+Er+dFdz;
+              sgi[6]=lambda*divz+2.0*mu*dEdr;
+              sgi[7]=lambda*divz+2.0*mu*Er;
+              sgi[8]=lambda*divz+2.0*mu*dFdz;
+              sgi[9]=mu*(dEdz+dFdr);
+            }
+          }
+          else if (greenType==2)
+          {
+            const double fac=1.0/pi;
+            if (ugi!=0)
+            {
+              ugi[0]=fac*B[0];
+              ugi[1]=-i*fac*B[6];
+              ugi[2]=-i*fac*B[1];
+              ugi[3]=fac*B[7];
+            }
+            if (sgi!=0)
+            {
+              sgi[0]=-fac*(M*B[2]+i*lambda*B[3]);
+              sgi[2]=-fac*(lambda*B[2]+i*M*B[3]);
+              sgi[4]=fac*mu*(B[4]-i*B[5]);
+              sgi[1]=fac*(-i*M*B[8]+lambda*B[9]);
+              sgi[3]=fac*(-i*lambda*B[8]+M*B[9]);
+              sgi[5]=-fac*mu*(i*B[10]+B[11]);
+            }
+          }
+          else
+          {
+            const double fac=1.0/pi;
+            if (ugi!=0) ugi[0]=fac*B[0];
+            if (sgi!=0)
+            {
+              sgi[0]=-fac*mu*B[1];
+              sgi[1]=fac*mu*B[2];
+            }
+          }
+        }
+      }
+    }
+  }
+  catch (const char*)
+  {
+    for (unsigned int iWorker=0; iWorker<nThread; iWorker++)
+    {
+      delete [] work[iWorker].coef;
+      delete [] work[iWorker].K;
+      delete [] work[iWorker].kern;
+    }
+    delete [] mat;
+    delete [] zInt;
+    delete [] zNode;
+    delete [] nodeMat;
+    delete [] kmax;
+    delete [] asym;
+    delete [] work;
+    delete [] panel;
+    throw;
+  }
+
+  for (unsigned int iWorker=0; iWorker<nThread; iWorker++)
+  {
+    delete [] work[iWorker].coef;
+    delete [] work[iWorker].K;
+    delete [] work[iWorker].kern;
+  }
+  delete [] mat;
+  delete [] zInt;
+  delete [] zNode;
+  delete [] nodeMat;
+  delete [] kmax;
+  delete [] asym;
+  delete [] work;
+  delete [] panel;
+}
@@ -0,0 +1,55 @@
+#ifndef _GREENLAYER_
+#define _GREENLAYER_
+void greenlayer(const unsigned int& greenType, const unsigned int& nLayer,
+                const double* const h, const double* const Cs,
+                const double* const Cp, const double* const Ds,
+                const double* const Dp, const double* const rho,
+                const double& omega, const unsigned int& nzs,
+                const double* const zs, const unsigned int& nr,
+                const double* const r, const unsigned int& nz,
+                const double* const z, const unsigned int& nThread,
+                std::complex<double>* const ug, std::complex<double>* const sg);
+/*   Green's function of a horizontally layered halfspace, tabulated in the
+ *   layout of a user defined Green's function.
+ *   greenType  1 for the 3D Green's function, 2 for the 2D in-plane and 3
+ *              for the 2D out-of-plane Green's function.
+ *   nLayer     Number of layers, including the halfspace.
+ *   h          Layer thickness (nLayer). The last value is not used.
+ *   Cs         Shear wave velocity (nLayer).
+ *   Cp         Dilatational wave velocity (nLayer).
+ *   Ds         Shear damping ratio (nLayer).
+ *   Dp         Dilatational damping ratio (nLayer).
+ *   rho        Density (nLayer).
+ *   omega      Circular frequency. If omega is 0, the static Green's
+ *              function is computed.
+ *   nzs        Number of source depths.
+ *   zs         Source depths (nzs).
+ *   nr         Number of receiver distances.
+ *   r          Receiver distances (nr).
+ *   nz         Number of receiver depths.
+ *   z          Receiver depths (nz).
+ *   nThread    Number of threads.
+ *   ug         Green's displacements (nugComp * nzs * nr * nz), or 0.
+ *   sg         Green's stresses (ntgComp * nzs * nr * nz), or 0.
+ *
+ *   The z-axis points downwards from the free surface at z=0. The 3D tables
+ *   contain the 5 displacement and 10 stress components of greeneval3d in
+ *   the cylindrical frame. The 2D tables contain the components of
+ *   greeneval2d column by column (nDof * nDof displacements and nDof * 3 or
+ *   nDof * 2 stresses, the load direction first) for a receiver at x=r.
+ *   At a layer interface, the stresses are those of the layer below the
+ *   interface.
+ *
+ *   The response of the layered halfspace to a point load is computed in the
+ *   wavenumber domain with the exact stiffness matrices of the layers, using
+ *   a basis of waves which decay away from their reference interface, so
+ *   that the formulation remains stable for thick layers, large wavenumbers
+ *   and at zero frequency. Nodes are added at the source and receiver
+ *   depths. The inverse Hankel (3D) or Fourier (2D) transform is evaluated
+ *   with Gauss-Legendre quadrature on panels that resolve the surface wave
+ *   poles and the oscillation of the kernel at the largest receiver
+ *   distance. The panels are distributed over the threads. For receivers at
+ *   the source depth, the static response of the material around the source
+ *   is subtracted at large wavenumbers and transformed analytically.
+ */
+#endif
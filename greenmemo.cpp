@@ -0,0 +1,211 @@
+#include <math.h>
+#include <string.h>
+#include <new>
+#include "greeninterp.h"
+#include "greenmemo.h"
+
+using namespace std;
+
+//==============================================================================
+static size_t hashkey(const long long* const k)
+// Hash of a key (src, r, z).
+//==============================================================================
+{
+  unsigned long long h=0x9e3779b97f4a7c15ULL;
+  for (unsigned int i=0; i<3; i++)
+  {
+    h^=(unsigned long long)k[i]+0x9e3779b97f4a7c15ULL+(h<<6)+(h>>2);
+    h*=0xbf58476d1ce4e5b9ULL;
+    h^=h>>31;
+  }
+  return (size_t)h;
+}
+
+//==============================================================================
+static long long quantise(const double& x, const double& tol)
+//==============================================================================
+{
+  return (long long)floor(x/tol+0.5);
+}
+
+//==============================================================================
+static bool growmemo(GreenMemo& memo)
+/* Doubles the hash table and, if necessary, the storage of the entries.
+ * Returns false if no memory is available, in which case the cache is left
+ * unchanged.
+ */
+//==============================================================================
+{
+  if (memo.nEntry==memo.nAlloc)
+  {
+    size_t nAlloc=(memo.nAlloc==0 ? 256 : 2*memo.nAlloc);
+    if (nAlloc>memo.maxEntry) nAlloc=memo.maxEntry;
+    long long* const key=new(nothrow) long long[3*nAlloc];
+    double* const val=new(nothrow) double[memo.nVal*nAlloc];
+    if ((key==0) || (val==0))
+    {
+      delete [] key;
+      delete [] val;
+      return false;
+    }
+    if (memo.nEntry>0)
+    {
+      memcpy(key,memo.key,3*memo.nEntry*sizeof(long long));
+      memcpy(val,memo.val,memo.nVal*memo.nEntry*sizeof(double));
+    }
+    delete [] memo.key;
+    delete [] memo.val;
+    memo.key=key;
+    memo.val=val;
+    memo.nAlloc=nAlloc;
+  }
+  if (2*(memo.nEntry+1)>memo.nSlot)
+  {
+    const size_t nSlot=(memo.nSlot==0 ? 512 : 2*memo.nSlot);
+    size_t* const slot=new(nothrow) size_t[nSlot];
+    if (slot==0) return false;
+    for (size_t iSlot=0; iSlot<nSlot; iSlot++) slot[iSlot]=0;
+    for (size_t iEntry=0; iEntry<memo.nEntry; iEntry++)
+    {
+      size_t iSlot=hashkey(&memo.key[3*iEntry])&(nSlot-1);
+      while (slot[iSlot]!=0) iSlot=(iSlot+1)&(nSlot-1);
+      slot[iSlot]=iEntry+1;
+    }
+    delete [] memo.slot;
+    memo.slot=slot;
+    memo.nSlot=nSlot;
+  }
+  return true;
+}
+
+//==============================================================================
+void greenmemoinit(const void* const* const greenPtr, const double& tol,
+                   const size_t& maxEntry, const unsigned int& nGrSet,
+                   const bool& ugCmplx, const bool& tgCmplx,
+                   const bool& tg0Cmplx, const bool& TmatOut, GreenMemo& memo)
+//==============================================================================
+{
+  memo.tol=tol;
+  memo.srcType=0;
+  memo.zsIndex=0;
+  const unsigned int GreenFunType=*((const unsigned int*)greenPtr[0]);
+  if (GreenFunType==1)
+  {
+    const GreenInterp& gi=*((const GreenInterp*)greenPtr[17]);
+    memo.srcType=(gi.zsLinear ? 2 : 1);
+    memo.zsIndex=(const unsigned int*)greenPtr[14];
+  }
+  memo.nGrSet=nGrSet;
+  memo.ugCmplx=ugCmplx;
+  memo.tgCmplx=tgCmplx;
+  memo.tg0Cmplx=tg0Cmplx;
+  memo.TmatOut=TmatOut;
+  memo.nVal=5*nGrSet*(ugCmplx ? 2 : 1);
+  if (TmatOut) memo.nVal+=10*nGrSet*((tgCmplx ? 2 : 1)+(tg0Cmplx ? 2 : 1));
+  memo.maxEntry=maxEntry;
+  if (memo.maxEntry==0) memo.maxEntry=(256*1024*1024)/(sizeof(double)*memo.nVal);
+  if (memo.maxEntry==0) memo.maxEntry=1;
+  memo.nSlot=0;
+  memo.slot=0;
+  memo.nEntry=0;
+  memo.nAlloc=0;
+  memo.key=0;
+  memo.val=0;
+  memo.nHit=0;
+  memo.nMiss=0;
+}
+
+//==============================================================================
+double* greenmemofind(GreenMemo& memo, const double& xiR, const double& xiZ,
+                      const double* const Coll, const unsigned int& nColl,
+                      const unsigned int& iColl, const unsigned int& zPos,
+                      bool& found)
+//==============================================================================
+{
+  long long k[3];
+  const double zc=Coll[zPos*nColl+iColl];
+  if (memo.srcType==1)
+  {
+    k[0]=memo.zsIndex[iColl];
+    k[1]=quantise(xiR,memo.tol);
+    k[2]=quantise(xiZ+zc,memo.tol);
+  }
+  else
+  {
+    k[0]=(memo.srcType==2 ? quantise(zc,memo.tol) : 0);
+    k[1]=quantise(xiR,memo.tol);
+    k[2]=quantise(xiZ,memo.tol);
+  }
+
+  found=false;
+  if (memo.nSlot>0)
+  {
+    size_t iSlot=hashkey(k)&(memo.nSlot-1);
+    while (memo.slot[iSlot]!=0)
+    {
+      const size_t iEntry=memo.slot[iSlot]-1;
+      const long long* const ke=&memo.key[3*iEntry];
+      if ((ke[0]==k[0]) && (ke[1]==k[1]) && (ke[2]==k[2]))
+      {
+        found=true;
+        memo.nHit++;
+        return &memo.val[memo.nVal*iEntry];
+      }
+      iSlot=(iSlot+1)&(memo.nSlot-1);
+    }
+  }
+
+  // NEW ENTRY
+  memo.nMiss++;
+  if (memo.nEntry>=memo.maxEntry) return 0;
+  if (!growmemo(memo)) return 0;
+  size_t iSlot=hashkey(k)&(memo.nSlot-1);
+  while (memo.slot[iSlot]!=0) iSlot=(iSlot+1)&(memo.nSlot-1);
+  const size_t iEntry=memo.nEntry++;
+  memo.slot[iSlot]=iEntry+1;
+  for (unsigned int i=0; i<3; i++) memo.key[3*iEntry+i]=k[i];
+  return &memo.val[memo.nVal*iEntry];
+}
+
+//==============================================================================
+static void copyblock(double* const val, size_t& pos, const bool& store,
+                      double* const x, const size_t& n)
+//==============================================================================
+{
+  if (store) memcpy(val+pos,x,n*sizeof(double));
+  else memcpy(x,val+pos,n*sizeof(double));
+  pos+=n;
+}
+
+//==============================================================================
+void greenmemocopy(const GreenMemo& memo, double* const val, const bool& store,
+                   double* const UgrRe, double* const UgrIm,
+                   double* const TgrRe, double* const TgrIm,
+                   double* const Tgr0Re, double* const Tgr0Im)
+//==============================================================================
+{
+  const size_t n=memo.nGrSet;
+  size_t pos=0;
+  copyblock(val,pos,store,UgrRe,5*n);
+  if (memo.ugCmplx) copyblock(val,pos,store,UgrIm,5*n);
+  if (!memo.TmatOut) return;
+  copyblock(val,pos,store,TgrRe,10*n);
+  if (memo.tgCmplx) copyblock(val,pos,store,TgrIm,10*n);
+  copyblock(val,pos,store,Tgr0Re,10*n);
+  if (memo.tg0Cmplx) copyblock(val,pos,store,Tgr0Im,10*n);
+}
+
+//==============================================================================
+void greenmemoclear(GreenMemo& memo)
+//==============================================================================
+{
+  delete [] memo.slot;
+  delete [] memo.key;
+  delete [] memo.val;
+  memo.slot=0;
+  memo.key=0;
+  memo.val=0;
+  memo.nSlot=0;
+  memo.nEntry=0;
+  memo.nAlloc=0;
+}
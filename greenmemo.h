@@ -0,0 +1,93 @@
+#include <stddef.h>
+#include <atomic>
+
+#ifndef _GREENMEMOOPTIONS_
+#define _GREENMEMOOPTIONS_
+struct GreenMemoOptions
+{
+  double tol;                                 // Quantisation step of r and z,
+                                              // or 0 if the cache is disabled
+  size_t maxEntry;                            // Maximum number of entries per
+                                              // cache, or 0 for the default
+  std::atomic<unsigned long long> nHit;       // Evaluations served by a cache
+  std::atomic<unsigned long long> nMiss;      // Evaluations of the Green's
+                                              // function
+  std::atomic<unsigned long long> nEntry;     // Entries stored in all caches
+};
+/*   Options of the memo cache of Green's function evaluations and the
+ *   statistics of all caches of a call to BEMMAT, which are created by the
+ *   threads of a frequency sweep at the same time.
+ */
+#endif
+
+#ifndef _GREENMEMO_
+#define _GREENMEMO_
+struct GreenMemo
+{
+  double tol;                // Quantisation step of r and z
+  unsigned int srcType;      // Source key: 0 none, 1 zs index, 2 source depth
+  const unsigned int* zsIndex; // Source depth per collocation point (user)
+  unsigned int nGrSet;       // Number of function sets
+  bool ugCmplx;              // Parts of the Green's function that are stored
+  bool tgCmplx;
+  bool tg0Cmplx;
+  bool TmatOut;
+  size_t nVal;               // Number of values per entry
+  size_t nSlot;              // Number of slots of the hash table (power of 2)
+  size_t* slot;              // Entry+1 per slot, 0 if the slot is empty
+  size_t nEntry;             // Number of entries
+  size_t maxEntry;           // Maximum number of entries
+  size_t nAlloc;             // Number of allocated entries
+  long long* key;            // Keys (3 * nAlloc)
+  double* val;               // Values (nVal * nAlloc)
+  unsigned long long nHit;
+  unsigned long long nMiss;
+};
+/*   Memo cache of the Green's function in the cylindrical frame, as
+ *   evaluated by greeneval3d, for the source to receiver offsets (r,z) that
+ *   recur on regular meshes. The offsets are rounded to multiples of tol.
+ *   The cached value is that of the first offset that is rounded to the same
+ *   key, so that it differs from the exact one by at most the change of the
+ *   Green's function over a distance of tol in r and z. The key
+ *   contains the source as well: for a user defined Green's function with
+ *   the nearest source depth, the zs index of the collocation point and the
+ *   absolute receiver depth; with linear interpolation in zs, the rounded
+ *   depth of the collocation point; for the full space solutions only (r,z).
+ *   The entries are stored in an open addressing hash table with linear
+ *   probing, which grows up to maxEntry entries; further offsets are not
+ *   cached.
+ */
+#endif
+
+#ifndef _GREENMEMOINIT_
+#define _GREENMEMOINIT_
+void greenmemoinit(const void* const* const greenPtr, const double& tol,
+                   const size_t& maxEntry, const unsigned int& nGrSet,
+                   const bool& ugCmplx, const bool& tgCmplx,
+                   const bool& tg0Cmplx, const bool& TmatOut, GreenMemo& memo);
+/*   Initializes an empty cache for the Green's function greenPtr. If
+ *   maxEntry is 0, the values of the cache are limited to 256 MB.
+ */
+
+double* greenmemofind(GreenMemo& memo, const double& xiR, const double& xiZ,
+                      const double* const Coll, const unsigned int& nColl,
+                      const unsigned int& iColl, const unsigned int& zPos,
+                      bool& found);
+/*   Values of the Green's function for the offset (xiR,xiZ) from collocation
+ *   point iColl, with the same arguments as greeneval3d. If found is false,
+ *   a new entry is returned, which is to be filled with greenmemocopy after
+ *   the evaluation of the Green's function, or 0 if the cache is full.
+ */
+
+void greenmemocopy(const GreenMemo& memo, double* const val, const bool& store,
+                   double* const UgrRe, double* const UgrIm,
+                   double* const TgrRe, double* const TgrIm,
+                   double* const Tgr0Re, double* const Tgr0Im);
+/*   Copies the Green's function of greeneval3d to the entry val (store) or
+ *   the entry val to the Green's function.
+ */
+
+void greenmemoclear(GreenMemo& memo);
+/*   Releases the cache.
+ */
+#endif
@@ -0,0 +1,485 @@
+/* krylov.cpp
+ *
+ * Restarted GMRES and BiCGStab for a block of right hand sides, with the
+ * operator applied to all unconverged columns at once, so that a dense
+ * matrix is read from memory once per iteration rather than once per
+ * column.
+ */
+
+#include <math.h>
+#include <complex>
+#include <new>
+#include "krylov.h"
+
+using namespace std;
+
+typedef complex<double> cplx;
+
+//==============================================================================
+static cplx dot(const cplx* const a, const cplx* const b, const size_t& n)
+// Inner product conj(a)'*b.
+//==============================================================================
+{
+  cplx s=0.0;
+  for (size_t i=0; i<n; i++) s+=conj(a[i])*b[i];
+  return s;
+}
+
+//==============================================================================
+static double norm2(const cplx* const a, const size_t& n)
+//==============================================================================
+{
+  double s=0.0;
+  for (size_t i=0; i<n; i++) s+=norm(a[i]);
+  return sqrt(s);
+}
+
+//==============================================================================
+static void applyBlock(KrylovApply op, void* const data, const size_t& n,
+                       const unsigned int* const act, const unsigned int& nAct,
+                       cplx* const* const src, cplx* const* const dst,
+                       cplx* const bufIn, cplx* const bufOut)
+/* Apply the operator to the vectors src[act[i]] and store the result in
+ * dst[act[i]], by gathering the vectors in a contiguous block.
+ */
+//==============================================================================
+{
+  for (unsigned int i=0; i<nAct; i++)
+    for (size_t k=0; k<n; k++) bufIn[n*i+k]=src[act[i]][k];
+  op(bufIn,bufOut,nAct,data);
+  for (unsigned int i=0; i<nAct; i++)
+    for (size_t k=0; k<n; k++) dst[act[i]][k]=bufOut[n*i+k];
+}
+
+//==============================================================================
+static void givens(const cplx& a, const cplx& b, double& c, cplx& s)
+/* Complex Givens rotation G = [c s; -conj(s) c] such that G*[a; b] has a
+ * zero second component.
+ */
+//==============================================================================
+{
+  const double absa=abs(a);
+  const double r=sqrt(absa*absa+norm(b));
+  if (r==0.0)
+  {
+    c=1.0;
+    s=0.0;
+  }
+  else if (absa==0.0)
+  {
+    c=0.0;
+    s=1.0;
+  }
+  else
+  {
+    c=absa/r;
+    s=(a/absa)*conj(b)/r;
+  }
+}
+
+//==============================================================================
+static void gmres(const size_t& n, const unsigned int& nRhs, KrylovApply matvec,
+                  KrylovApply precond, void* const data, const cplx* const b,
+                  cplx* const x, const double& tol, const unsigned int& maxIt,
+                  const unsigned int& m, const double* const bnorm,
+                  bool* const done, double* const relres,
+                  unsigned int* const nIter, cplx* const work)
+//==============================================================================
+{
+  // WORKSPACE PER COLUMN: V (n*(m+1)), Z (n*m, preconditioned only),
+  // H ((m+1)*m), g (m+1), sn (m), cs (m), y (m)
+  const size_t nZ=(precond==0 ? 0 : n*m);
+  const size_t nCol=n*(m+1)+nZ+(m+1)*m+(m+1)+3*m;
+  cplx* const bufIn=work;
+  cplx* const bufOut=work+n*nRhs;
+  cplx* const colWork=work+2*n*nRhs;
+  unsigned int* const act=new(nothrow) unsigned int[2*nRhs];
+  cplx** const ptr=new(nothrow) cplx*[3*nRhs];
+  unsigned int* const jEnd=new(nothrow) unsigned int[nRhs];
+  bool* const stop=new(nothrow) bool[nRhs];
+  if ((act==0) || (ptr==0) || (jEnd==0) || (stop==0))
+  {
+    if (act!=0) delete [] act;
+    if (ptr!=0) delete [] ptr;
+    if (jEnd!=0) delete [] jEnd;
+    if (stop!=0) delete [] stop;
+    throw("Out of memory.");
+  }
+  unsigned int* const it=act+nRhs;
+  cplx** const src=ptr;
+  cplx** const dst=ptr+nRhs;
+  cplx** const zdst=ptr+2*nRhs;
+
+  try
+  {
+    while (true)
+    {
+      // TRUE RESIDUAL OF THE ACTIVE COLUMNS
+      unsigned int nAct=0;
+      for (unsigned int c=0; c<nRhs; c++)
+      {
+        if (done[c]) continue;
+        act[nAct++]=c;
+        src[c]=x+n*c;
+        dst[c]=colWork+nCol*c;   // V(:,0)
+      }
+      if (nAct==0) break;
+      applyBlock(matvec,data,n,act,nAct,src,dst,bufIn,bufOut);
+      unsigned int nCycle=0;
+      for (unsigned int i=0; i<nAct; i++)
+      {
+        const unsigned int c=act[i];
+        cplx* const V=colWork+nCol*c;
+        for (size_t k=0; k<n; k++) V[k]=b[n*c+k]-V[k];
+        nIter[c]++;
+        const double beta=norm2(V,n);
+        relres[c]=beta/bnorm[c];
+        if ((relres[c]<=tol) || (nIter[c]>=maxIt))
+        {
+          done[c]=true;
+          continue;
+        }
+        for (size_t k=0; k<n; k++) V[k]/=beta;
+        cplx* const g=V+n*(m+1)+nZ+(m+1)*m;
+        for (unsigned int j=0; j<=m; j++) g[j]=0.0;
+        g[0]=beta;
+        jEnd[c]=0;
+        stop[c]=false;
+        act[nCycle++]=c;
+      }
+      if (nCycle==0) break;
+
+      // ARNOLDI CYCLE
+      for (unsigned int j=0; j<m; j++)
+      {
+        unsigned int nIt=0;
+        for (unsigned int i=0; i<nCycle; i++)
+        {
+          const unsigned int c=act[i];
+          if (stop[c]) continue;
+          it[nIt++]=c;
+          cplx* const V=colWork+nCol*c;
+          src[c]=V+n*j;
+          dst[c]=V+n*(j+1);
+          zdst[c]=V+n*(m+1)+n*j;
+        }
+        if (nIt==0) break;
+        if (precond!=0)
+        {
+          applyBlock(precond,data,n,it,nIt,src,zdst,bufIn,bufOut);
+          applyBlock(matvec,data,n,it,nIt,zdst,dst,bufIn,bufOut);
+        }
+        else applyBlock(matvec,data,n,it,nIt,src,dst,bufIn,bufOut);
+
+        for (unsigned int i=0; i<nIt; i++)
+        {
+          const unsigned int c=it[i];
+          cplx* const V=colWork+nCol*c;
+          cplx* const H=V+n*(m+1)+nZ;
+          cplx* const g=H+(m+1)*m;
+          cplx* const sn=g+(m+1);
+          cplx* const cs=sn+m;
+          cplx* const w=V+n*(j+1);
+          cplx* const h=H+(m+1)*j;
+
+          // Modified Gram-Schmidt orthogonalisation
+          for (unsigned int l=0; l<=j; l++)
+          {
+            h[l]=dot(V+n*l,w,n);
+            for (size_t k=0; k<n; k++) w[k]-=h[l]*V[n*l+k];
+          }
+          const double hNext=norm2(w,n);
+          h[j+1]=hNext;
+          if (hNext>0.0) for (size_t k=0; k<n; k++) w[k]/=hNext;
+
+          // Previous rotations and a new rotation for the last column of H
+          for (unsigned int l=0; l<j; l++)
+          {
+            const double cl=cs[l].real();
+            const cplx t=cl*h[l]+sn[l]*h[l+1];
+            h[l+1]=-conj(sn[l])*h[l]+cl*h[l+1];
+            h[l]=t;
+          }
+          double cj;
+          cplx sj;
+          givens(h[j],h[j+1],cj,sj);
+          h[j]=cj*h[j]+sj*h[j+1];
+          h[j+1]=0.0;
+          cs[j]=cj;
+          sn[j]=sj;
+          g[j+1]=-conj(sj)*g[j];
+          g[j]=cj*g[j];
+
+          nIter[c]++;
+          jEnd[c]=j+1;
+          relres[c]=abs(g[j+1])/bnorm[c];
+          if ((relres[c]<=tol) || (nIter[c]>=maxIt) || (hNext==0.0)) stop[c]=true;
+        }
+      }
+
+      // UPDATE OF THE SOLUTION
+      for (unsigned int i=0; i<nCycle; i++)
+      {
+        const unsigned int c=act[i];
+        const unsigned int nj=jEnd[c];
+        cplx* const V=colWork+nCol*c;
+        cplx* const H=V+n*(m+1)+nZ;
+        cplx* const g=H+(m+1)*m;
+        cplx* const y=g+(m+1)+2*m;
+        for (int l=(int)nj-1; l>=0; l--)
+        {
+          cplx s=g[l];
+          for (unsigned int q=l+1; q<nj; q++) s-=H[(m+1)*q+l]*y[q];
+          y[l]=s/H[(m+1)*l+l];
+        }
+        const cplx* const Z=(precond==0 ? V : V+n*(m+1));
+        for (unsigned int l=0; l<nj; l++)
+          for (size_t k=0; k<n; k++) x[n*c+k]+=y[l]*Z[n*l+k];
+      }
+    }
+  }
+  catch (const char*)
+  {
+    delete [] act;
+    delete [] ptr;
+    delete [] jEnd;
+    delete [] stop;
+    throw;
+  }
+  delete [] act;
+  delete [] ptr;
+  delete [] jEnd;
+  delete [] stop;
+}
+
+//==============================================================================
+static void bicgstab(const size_t& n, const unsigned int& nRhs,
+                     KrylovApply matvec, KrylovApply precond, void* const data,
+                     const cplx* const b, cplx* const x, const double& tol,
+                     const unsigned int& maxIt, const double* const bnorm,
+                     bool* const done, double* const relres,
+                     unsigned int* const nIter, cplx* const work)
+//==============================================================================
+{
+  // WORKSPACE PER COLUMN: r, rhat, p, v, s, t, phat, shat (n each)
+  // and the scalars rho, alpha, omega
+  const size_t nCol=8*n+3;
+  cplx* const bufIn=work;
+  cplx* const bufOut=work+n*nRhs;
+  cplx* const colWork=work+2*n*nRhs;
+  unsigned int* const act=new(nothrow) unsigned int[nRhs];
+  cplx** const ptr=new(nothrow) cplx*[2*nRhs];
+  if ((act==0) || (ptr==0))
+  {
+    if (act!=0) delete [] act;
+    if (ptr!=0) delete [] ptr;
+    throw("Out of memory.");
+  }
+  cplx** const src=ptr;
+  cplx** const dst=ptr+nRhs;
+
+  try
+  {
+    // INITIAL RESIDUAL
+    unsigned int nAct=0;
+    for (unsigned int c=0; c<nRhs; c++)
+    {
+      if (done[c]) continue;
+      act[nAct++]=c;
+      src[c]=x+n*c;
+      dst[c]=colWork+nCol*c;
+    }
+    if (nAct>0) applyBlock(matvec,data,n,act,nAct,src,dst,bufIn,bufOut);
+    for (unsigned int i=0; i<nAct; i++)
+    {
+      const unsigned int c=act[i];
+      cplx* const r=colWork+nCol*c;
+      cplx* const rhat=r+n;
+      cplx* const p=r+2*n;
+      cplx* const v=r+3*n;
+      cplx* const scal=r+8*n;
+      for (size_t k=0; k<n; k++)
+      {
+        r[k]=b[n*c+k]-r[k];
+        rhat[k]=r[k];
+        p[k]=0.0;
+        v[k]=0.0;
+      }
+      scal[0]=1.0;   // rho
+      scal[1]=1.0;   // alpha
+      scal[2]=1.0;   // omega
+      nIter[c]++;
+      relres[c]=norm2(r,n)/bnorm[c];
+      if ((relres[c]<=tol) || (nIter[c]>=maxIt)) done[c]=true;
+    }
+
+    while (true)
+    {
+      // p = r + beta*(p - omega*v), phat = M*p, v = A*phat
+      nAct=0;
+      for (unsigned int c=0; c<nRhs; c++)
+      {
+        if (done[c]) continue;
+        cplx* const r=colWork+nCol*c;
+        cplx* const rhat=r+n;
+        cplx* const p=r+2*n;
+        cplx* const v=r+3*n;
+        cplx* const phat=r+6*n;
+        cplx* const scal=r+8*n;
+        const cplx rho=dot(rhat,r,n);
+        if (abs(rho)==0.0)
+        {
+          done[c]=true;   // Breakdown
+          continue;
+        }
+        const cplx beta=(rho/scal[0])*(scal[1]/scal[2]);
+        scal[0]=rho;
+        for (size_t k=0; k<n; k++) p[k]=r[k]+beta*(p[k]-scal[2]*v[k]);
+        act[nAct++]=c;
+        src[c]=p;
+        dst[c]=(precond==0 ? p : phat);
+      }
+      if (nAct==0) break;
+      if (precond!=0) applyBlock(precond,data,n,act,nAct,src,dst,bufIn,bufOut);
+      for (unsigned int i=0; i<nAct; i++)
+      {
+        const unsigned int c=act[i];
+        cplx* const r=colWork+nCol*c;
+        src[c]=(precond==0 ? r+2*n : r+6*n);
+        dst[c]=r+3*n;
+      }
+      applyBlock(matvec,data,n,act,nAct,src,dst,bufIn,bufOut);
+
+      // s = r - alpha*v, shat = M*s, t = A*shat
+      unsigned int nHalf=0;
+      for (unsigned int i=0; i<nAct; i++)
+      {
+        const unsigned int c=act[i];
+        cplx* const r=colWork+nCol*c;
+        cplx* const rhat=r+n;
+        cplx* const v=r+3*n;
+        cplx* const s=r+4*n;
+        cplx* const scal=r+8*n;
+        const cplx* const phat=(precond==0 ? r+2*n : r+6*n);
+        nIter[c]++;
+        const cplx rv=dot(rhat,v,n);
+        if (abs(rv)==0.0)
+        {
+          done[c]=true;
+          continue;
+        }
+        const cplx alpha=scal[0]/rv;
+        scal[1]=alpha;
+        for (size_t k=0; k<n; k++) s[k]=r[k]-alpha*v[k];
+        relres[c]=norm2(s,n)/bnorm[c];
+        if ((relres[c]<=tol) || (nIter[c]>=maxIt))
+        {
+          for (size_t k=0; k<n; k++) x[n*c+k]+=alpha*phat[k];
+          done[c]=true;
+          continue;
+        }
+        act[nHalf++]=c;
+        src[c]=s;
+        dst[c]=(precond==0 ? s : r+7*n);
+      }
+      if (nHalf==0) continue;
+      if (precond!=0) applyBlock(precond,data,n,act,nHalf,src,dst,bufIn,bufOut);
+      for (unsigned int i=0; i<nHalf; i++)
+      {
+        const unsigned int c=act[i];
+        cplx* const r=colWork+nCol*c;
+        src[c]=(precond==0 ? r+4*n : r+7*n);
+        dst[c]=r+5*n;
+      }
+      applyBlock(matvec,data,n,act,nHalf,src,dst,bufIn,bufOut);
+
+      // omega = (t'*s)/(t'*t), x = x + alpha*phat + omega*shat, r = s - omega*t
+      for (unsigned int i=0; i<nHalf; i++)
+      {
+        const unsigned int c=act[i];
+        cplx* const r=colWork+nCol*c;
+        const cplx* const s=r+4*n;
+        const cplx* const t=r+5*n;
+        const cplx* const phat=(precond==0 ? r+2*n : r+6*n);
+        const cplx* const shat=(precond==0 ? r+4*n : r+7*n);
+        cplx* const scal=r+8*n;
+        nIter[c]++;
+        const double tt=norm(norm2(t,n));
+        const cplx omega=(tt==0.0 ? cplx(0.0) : dot(t,s,n)/tt);
+        scal[2]=omega;
+        for (size_t k=0; k<n; k++)
+        {
+          x[n*c+k]+=scal[1]*phat[k]+omega*shat[k];
+          r[k]=s[k]-omega*t[k];
+        }
+        relres[c]=norm2(r,n)/bnorm[c];
+        if ((relres[c]<=tol) || (nIter[c]>=maxIt) || (abs(omega)==0.0)) done[c]=true;
+      }
+    }
+  }
+  catch (const char*)
+  {
+    delete [] act;
+    delete [] ptr;
+    throw;
+  }
+  delete [] act;
+  delete [] ptr;
+}
+
+//==============================================================================
+void krylov(const bool& bicgstab_, const size_t& n, const unsigned int& nRhs,
+            KrylovApply matvec, KrylovApply precond, void* const data,
+            const cplx* const b, cplx* const x, const double& tol,
+            const unsigned int& maxIt, const unsigned int& restart,
+            double* const relres, unsigned int* const nIter)
+//==============================================================================
+{
+  if (nRhs==0) return;
+  unsigned int m=(restart<1 ? 1 : restart);
+  if (m>n) m=(unsigned int)n;
+  if (m<1) m=1;
+
+  double* const bnorm=new(nothrow) double[nRhs];
+  bool* const done=new(nothrow) bool[nRhs];
+  if ((bnorm==0) || (done==0))
+  {
+    if (bnorm!=0) delete [] bnorm;
+    if (done!=0) delete [] done;
+    throw("Out of memory.");
+  }
+  for (unsigned int c=0; c<nRhs; c++)
+  {
+    bnorm[c]=norm2(b+n*c,n);
+    nIter[c]=0;
+    relres[c]=0.0;
+    done[c]=(bnorm[c]==0.0);
+    if (done[c]) for (size_t k=0; k<n; k++) x[n*c+k]=0.0;
+  }
+
+  const size_t nCol=(bicgstab_ ? 8*n+3
+                               : n*(m+1)+(precond==0 ? 0 : n*m)+(m+1)*m+(m+1)+3*m);
+  cplx* const work=new(nothrow) cplx[2*n*nRhs+nCol*nRhs];
+  if (work==0)
+  {
+    delete [] bnorm;
+    delete [] done;
+    throw("Out of memory.");
+  }
+
+  try
+  {
+    if (bicgstab_) bicgstab(n,nRhs,matvec,precond,data,b,x,tol,maxIt,bnorm,done,relres,nIter,work);
+    else gmres(n,nRhs,matvec,precond,data,b,x,tol,maxIt,m,bnorm,done,relres,nIter,work);
+  }
+  catch (const char*)
+  {
+    delete [] work;
+    delete [] bnorm;
+    delete [] done;
+    throw;
+  }
+  delete [] work;
+  delete [] bnorm;
+  delete [] done;
+}
@@ -0,0 +1,42 @@
+#ifndef _KRYLOVAPPLY_
+#define _KRYLOVAPPLY_
+typedef void (*KrylovApply)(const std::complex<double>* const x,
+                            std::complex<double>* const y,
+                            const unsigned int& nVec, void* const data);
+/*   Linear operator y = A*x applied to a block of vectors.
+ *   x     Vectors (n * nVec).
+ *   y     Result (n * nVec).
+ *   nVec  Number of vectors.
+ *   data  User data passed to the solver.
+ *   The operator may throw a string exception, which is passed on by the
+ *   solver after its workspace has been released.
+ */
+#endif
+
+#ifndef _KRYLOV_
+#define _KRYLOV_
+void krylov(const bool& bicgstab, const size_t& n, const unsigned int& nRhs,
+            KrylovApply matvec, KrylovApply precond, void* const data,
+            const std::complex<double>* const b, std::complex<double>* const x,
+            const double& tol, const unsigned int& maxIt,
+            const unsigned int& restart, double* const relres,
+            unsigned int* const nIter);
+/*   Iterative solution of A*x = b for a block of right hand sides with the
+ *   restarted GMRES method or the BiCGStab method. The right hand sides are
+ *   solved simultaneously: in every iteration, the operator is applied once
+ *   to the block of vectors of all columns that have not converged yet.
+ *   bicgstab  True for BiCGStab, false for GMRES.
+ *   n         Number of unknowns.
+ *   nRhs      Number of right hand sides.
+ *   matvec    Operator A.
+ *   precond   Right preconditioner, an approximation of inv(A), or 0.
+ *   data      User data passed to matvec and precond.
+ *   b         Right hand sides (n * nRhs).
+ *   x         Initial guess on input, solution on output (n * nRhs).
+ *   tol       Tolerance on the relative residual norm(b-A*x)/norm(b).
+ *   maxIt     Maximum number of operator applications per right hand side.
+ *   restart   Number of GMRES iterations between restarts.
+ *   relres    Relative residual per right hand side (nRhs).
+ *   nIter     Number of operator applications per right hand side (nRhs).
+ */
+#endif
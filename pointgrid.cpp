@@ -0,0 +1,192 @@
+#include <math.h>
+#include <new>
+#include "pointgrid.h"
+
+using namespace std;
+
+//==============================================================================
+static size_t hashcell(const long long* const k)
+// Hash of the grid indices of a cell.
+//==============================================================================
+{
+  unsigned long long h=0x9e3779b97f4a7c15ULL;
+  for (unsigned int i=0; i<3; i++)
+  {
+    h^=(unsigned long long)k[i]+0x9e3779b97f4a7c15ULL+(h<<6)+(h>>2);
+    h*=0xbf58476d1ce4e5b9ULL;
+    h^=h>>31;
+  }
+  return (size_t)h;
+}
+
+//==============================================================================
+static int findcell(const PointGrid& grid, const long long* const k)
+// Index of the cell with grid indices k, or -1 if the cell is empty.
+//==============================================================================
+{
+  size_t iSlot=hashcell(k)&(grid.nSlot-1);
+  while (grid.slot[iSlot]!=0)
+  {
+    const unsigned int iCell=grid.slot[iSlot]-1;
+    const long long* const kc=&grid.cellKey[3*iCell];
+    if ((kc[0]==k[0]) && (kc[1]==k[1]) && (kc[2]==k[2])) return (int)iCell;
+    iSlot=(iSlot+1)&(grid.nSlot-1);
+  }
+  return -1;
+}
+
+//==============================================================================
+static void cellindex(const PointGrid& grid, const unsigned int& iPoint,
+                      long long* const k)
+// Grid indices of the cell of point iPoint.
+//==============================================================================
+{
+  for (unsigned int iCoord=0; iCoord<3; iCoord++)
+  {
+    k[iCoord]=(long long)floor((grid.xyz[iCoord*grid.nPoint+iPoint]-grid.xMin[iCoord])/grid.h);
+  }
+}
+
+//==============================================================================
+void pointgridinit(const double* const xyz, const unsigned int& nPoint,
+                   const double& tol, PointGrid& grid)
+//==============================================================================
+{
+  grid.xyz=xyz;
+  grid.nPoint=nPoint;
+  grid.nSlot=0;
+  grid.slot=0;
+  grid.nCell=0;
+  grid.cellKey=0;
+  grid.cellPtr=0;
+  grid.cellPoint=0;
+
+  // CELL SIZE: AT LEAST tol, WITH AT MOST 1e9 CELLS IN EACH DIRECTION
+  double extent=0.0;
+  for (unsigned int iCoord=0; iCoord<3; iCoord++)
+  {
+    grid.xMin[iCoord]=0.0;
+    double xMax=0.0;
+    for (unsigned int iPoint=0; iPoint<nPoint; iPoint++)
+    {
+      const double x=xyz[iCoord*nPoint+iPoint];
+      if ((iPoint==0) || (x<grid.xMin[iCoord])) grid.xMin[iCoord]=x;
+      if ((iPoint==0) || (x>xMax)) xMax=x;
+    }
+    if (xMax-grid.xMin[iCoord]>extent) extent=xMax-grid.xMin[iCoord];
+  }
+  grid.h=(tol>1.0e-9*extent ? tol : 1.0e-9*extent);
+  if (!(grid.h>0.0)) grid.h=1.0;
+
+  // CELLS
+  grid.nSlot=1;
+  while (grid.nSlot<2*(size_t)nPoint) grid.nSlot*=2;
+  grid.slot=new(nothrow) unsigned int[grid.nSlot];
+  grid.cellKey=new(nothrow) long long[3*(size_t)nPoint];
+  grid.cellPtr=new(nothrow) unsigned int[nPoint+1];
+  grid.cellPoint=new(nothrow) unsigned int[nPoint];
+  if ((grid.slot==0) || (grid.cellKey==0) || (grid.cellPtr==0) || (grid.cellPoint==0))
+  {
+    pointgridclear(grid);
+    throw("Out of memory.");
+  }
+  for (size_t iSlot=0; iSlot<grid.nSlot; iSlot++) grid.slot[iSlot]=0;
+  for (unsigned int iPoint=0; iPoint<nPoint; iPoint++)
+  {
+    long long k[3];
+    cellindex(grid,iPoint,k);
+    size_t iSlot=hashcell(k)&(grid.nSlot-1);
+    int iCell=-1;
+    while ((grid.slot[iSlot]!=0) && (iCell<0))
+    {
+      const long long* const kc=&grid.cellKey[3*(grid.slot[iSlot]-1)];
+      if ((kc[0]==k[0]) && (kc[1]==k[1]) && (kc[2]==k[2])) iCell=grid.slot[iSlot]-1;
+      else iSlot=(iSlot+1)&(grid.nSlot-1);
+    }
+    if (iCell<0)
+    {
+      iCell=grid.nCell++;
+      grid.slot[iSlot]=iCell+1;
+      for (unsigned int i=0; i<3; i++) grid.cellKey[3*iCell+i]=k[i];
+      grid.cellPtr[iCell+1]=0;
+    }
+    grid.cellPoint[iPoint]=iCell;
+    grid.cellPtr[iCell+1]++;
+  }
+
+  // POINTS SORTED BY CELL, IN ASCENDING ORDER WITHIN EACH CELL
+  unsigned int* const pointCell=new(nothrow) unsigned int[nPoint];
+  if (pointCell==0)
+  {
+    pointgridclear(grid);
+    throw("Out of memory.");
+  }
+  for (unsigned int iPoint=0; iPoint<nPoint; iPoint++) pointCell[iPoint]=grid.cellPoint[iPoint];
+  grid.cellPtr[0]=0;
+  for (unsigned int iCell=0; iCell<grid.nCell; iCell++) grid.cellPtr[iCell+1]+=grid.cellPtr[iCell];
+  for (unsigned int iPoint=0; iPoint<nPoint; iPoint++) grid.cellPoint[grid.cellPtr[pointCell[iPoint]]++]=iPoint;
+  for (unsigned int iCell=grid.nCell; iCell>0; iCell--) grid.cellPtr[iCell]=grid.cellPtr[iCell-1];
+  grid.cellPtr[0]=0;
+  delete [] pointCell;
+}
+
+//==============================================================================
+unsigned int pointgridnear(const PointGrid& grid, const unsigned int& iPoint,
+                           const double& tol, const bool& box,
+                           unsigned int* const near)
+//==============================================================================
+{
+  unsigned int nNear=0;
+  long long k[3];
+  cellindex(grid,iPoint,k);
+  const double* const x=grid.xyz;
+  const unsigned int n=grid.nPoint;
+  for (int i0=-1; i0<=1; i0++)
+  {
+    for (int i1=-1; i1<=1; i1++)
+    {
+      for (int i2=-1; i2<=1; i2++)
+      {
+        const long long kn[3]={k[0]+i0,k[1]+i1,k[2]+i2};
+        const int iCell=findcell(grid,kn);
+        if (iCell<0) continue;
+        for (unsigned int i=grid.cellPtr[iCell]; i<grid.cellPtr[iCell+1]; i++)
+        {
+          const unsigned int jPoint=grid.cellPoint[i];
+          if (jPoint==iPoint) continue;
+          const double dx=fabs(x[jPoint]-x[iPoint]);
+          const double dy=fabs(x[n+jPoint]-x[n+iPoint]);
+          const double dz=fabs(x[2*n+jPoint]-x[2*n+iPoint]);
+          if (box ? ((dx<tol) && (dy<tol) && (dz<tol)) : (sqrt(dx*dx+dy*dy+dz*dz)<tol))
+          {
+            // Insertion in ascending order
+            unsigned int iNear=nNear++;
+            while ((iNear>0) && (near[iNear-1]>jPoint))
+            {
+              near[iNear]=near[iNear-1];
+              iNear--;
+            }
+            near[iNear]=jPoint;
+          }
+        }
+      }
+    }
+  }
+  return nNear;
+}
+
+//==============================================================================
+void pointgridclear(PointGrid& grid)
+//==============================================================================
+{
+  delete [] grid.slot;
+  delete [] grid.cellKey;
+  delete [] grid.cellPtr;
+  delete [] grid.cellPoint;
+  grid.slot=0;
+  grid.cellKey=0;
+  grid.cellPtr=0;
+  grid.cellPoint=0;
+  grid.nSlot=0;
+  grid.nCell=0;
+}
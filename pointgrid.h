@@ -0,0 +1,47 @@
+#include <stddef.h>
+
+#ifndef _POINTGRID_
+#define _POINTGRID_
+struct PointGrid
+{
+  const double* xyz;         // Coordinates of the points (nPoint * 3)
+  unsigned int nPoint;       // Number of points
+  double xMin[3];            // Origin of the grid
+  double h;                  // Cell size
+  size_t nSlot;              // Number of slots of the hash table (power of 2)
+  unsigned int* slot;        // Cell index+1 per slot, 0 if the slot is empty
+  unsigned int nCell;        // Number of nonempty cells
+  long long* cellKey;        // Grid indices of the cells (3 * nCell)
+  unsigned int* cellPtr;     // First point of each cell in cellPoint (nCell+1)
+  unsigned int* cellPoint;   // Points sorted by cell (nPoint)
+};
+/*   Grid of cubic cells with a size of at least the tolerance tol, with a
+ *   hash table of the nonempty cells, for the search of the points that
+ *   coincide with a given point. The points within a distance tol are found
+ *   in the 27 cells around the cell of the point, so that the search for all
+ *   points takes O(nPoint) operations if the points are distributed evenly.
+ */
+#endif
+
+#ifndef _POINTGRIDINIT_
+#define _POINTGRIDINIT_
+void pointgridinit(const double* const xyz, const unsigned int& nPoint,
+                   const double& tol, PointGrid& grid);
+/*   Sorts the points xyz into a grid for the tolerance tol. The grid refers
+ *   to xyz, which must not be changed or released before the grid.
+ */
+
+unsigned int pointgridnear(const PointGrid& grid, const unsigned int& iPoint,
+                           const double& tol, const bool& box,
+                           unsigned int* const near);
+/*   Returns the number of points that coincide with point iPoint and their
+ *   indices near, in ascending order. The points coincide if each coordinate
+ *   differs less than tol (box) or if the distance is smaller than tol.
+ *   The tolerance must not exceed the tolerance of the grid. near must have
+ *   room for nPoint indices.
+ */
+
+void pointgridclear(PointGrid& grid);
+/*   Releases the grid.
+ */
+#endif
@@ -0,0 +1,28 @@
+function nColDof=coldof(elt,typ,green)
+
+%COLDOF   Number of degrees of freedom per collocation point.
+%   nColDof=COLDOF(elt,typ,green) returns the number of degrees of freedom
+%   per collocation point of the boundary element matrices computed by BEMMAT
+%   for the Green's function green (the cell array of its arguments).
+%
+%   elt      Elements.
+%   typ      Element types.
+%   green    Green's function name and parameters (cell array).
+%   nColDof  Number of degrees of freedom per collocation point.
+
+axi=bemisaxisym(elt,typ);
+switch lower(green{1})
+  case {'fsgreen2d_outofplane','fsgreen2d_outofplane0'}
+    nColDof=1;
+  case {'fsgreen2d_inplane','fsgreen2d_inplane0'}
+    nColDof=2;
+  case 'user'
+    switch size(green{5},1)
+      case 1, nColDof=1;
+      case 4, nColDof=2;
+      case 5, nColDof=3-axi;
+      otherwise, nColDof=3;
+    end
+  otherwise
+    nColDof=3-axi;
+end
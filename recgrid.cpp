@@ -0,0 +1,129 @@
+/* recgrid.cpp
+ *
+ * Uniform grid over the receiver points, used to look up the receivers
+ * near an element without testing all receivers.
+ */
+
+#include <math.h>
+#include <new>
+using namespace std;
+
+// Maximum number of cells in each direction
+const unsigned int nCellMax=1024;
+
+//==============================================================================
+inline unsigned int cellIndex(const double& x, const double& x0, const double& h,
+                              const unsigned int& n)
+//==============================================================================
+{
+  if (!(h>0.0)) return 0;
+  const double s=(x-x0)/h;
+  if (s<=0.0) return 0;
+  if (s>=n-1) return n-1;
+  return (unsigned int)s;
+}
+
+//==============================================================================
+void recGridSize(const double* const Rec, const unsigned int& nRec,
+                 double* const gridGeom, unsigned int& nCell)
+//==============================================================================
+{
+  double xMin[3];
+  double xMax[3];
+  for (unsigned int iDim=0; iDim<3; iDim++)
+  {
+    xMin[iDim]=(nRec>0 ? Rec[iDim*nRec] : 0.0);
+    xMax[iDim]=xMin[iDim];
+    for (unsigned int iRec=1; iRec<nRec; iRec++)
+    {
+      if (Rec[iDim*nRec+iRec]<xMin[iDim]) xMin[iDim]=Rec[iDim*nRec+iRec];
+      if (Rec[iDim*nRec+iRec]>xMax[iDim]) xMax[iDim]=Rec[iDim*nRec+iRec];
+    }
+  }
+
+  // Cell size such that there is about one receiver per cell in the
+  // dimensions in which the receivers are spread.
+  double extent=1.0;
+  unsigned int nSpreadDim=0;
+  for (unsigned int iDim=0; iDim<3; iDim++)
+  {
+    if (xMax[iDim]>xMin[iDim])
+    {
+      extent*=(xMax[iDim]-xMin[iDim]);
+      nSpreadDim++;
+    }
+  }
+  const double h=(nSpreadDim>0 ? pow(extent/(nRec>0 ? nRec : 1),1.0/nSpreadDim) : 0.0);
+
+  nCell=1;
+  for (unsigned int iDim=0; iDim<3; iDim++)
+  {
+    unsigned int n=1;
+    if ((xMax[iDim]>xMin[iDim]) && (h>0.0))
+    {
+      const double nd=floor((xMax[iDim]-xMin[iDim])/h)+1.0;
+      n=(nd>nCellMax ? nCellMax : (unsigned int)nd);
+    }
+    gridGeom[iDim]=xMin[iDim];
+    gridGeom[3+iDim]=(n>1 ? (xMax[iDim]-xMin[iDim])/n : 0.0);
+    gridGeom[6+iDim]=n;
+    nCell*=n;
+  }
+}
+
+//==============================================================================
+void recGridFill(const double* const Rec, const unsigned int& nRec,
+                 const double* const gridGeom, const unsigned int& nCell,
+                 unsigned int* const cellStart, unsigned int* const cellRec)
+//==============================================================================
+{
+  const unsigned int nx=(unsigned int)gridGeom[6];
+  const unsigned int ny=(unsigned int)gridGeom[7];
+  const unsigned int nz=(unsigned int)gridGeom[8];
+
+  unsigned int* const recCell=new(nothrow) unsigned int[nRec];
+  if (recCell==0) throw("Out of memory.");
+
+  for (unsigned int iCell=0; iCell<=nCell; iCell++) cellStart[iCell]=0;
+  for (unsigned int iRec=0; iRec<nRec; iRec++)
+  {
+    const unsigned int ix=cellIndex(Rec[0*nRec+iRec],gridGeom[0],gridGeom[3],nx);
+    const unsigned int iy=cellIndex(Rec[1*nRec+iRec],gridGeom[1],gridGeom[4],ny);
+    const unsigned int iz=cellIndex(Rec[2*nRec+iRec],gridGeom[2],gridGeom[5],nz);
+    recCell[iRec]=ix+nx*(iy+ny*iz);
+    cellStart[recCell[iRec]+1]++;
+  }
+  for (unsigned int iCell=0; iCell<nCell; iCell++) cellStart[iCell+1]+=cellStart[iCell];
+
+  // Receivers are stored in increasing order within each cell.
+  for (unsigned int iRec=0; iRec<nRec; iRec++) cellRec[cellStart[recCell[iRec]]++]=iRec;
+  for (unsigned int iCell=nCell; iCell>0; iCell--) cellStart[iCell]=cellStart[iCell-1];
+  cellStart[0]=0;
+
+  delete [] recCell;
+}
+
+//==============================================================================
+void recGridRange(const double* const gridGeom, const double* const boxMin,
+                  const double* const boxMax, unsigned int* const iBeg,
+                  unsigned int* const iEnd)
+//==============================================================================
+{
+  for (unsigned int iDim=0; iDim<3; iDim++)
+  {
+    const double x0=gridGeom[iDim];
+    const double h=gridGeom[3+iDim];
+    const unsigned int n=(unsigned int)gridGeom[6+iDim];
+    const double x1=x0+h*n;
+    if ((boxMax[iDim]<x0) || (boxMin[iDim]>x1))
+    {
+      iBeg[iDim]=0;
+      iEnd[iDim]=0;
+    }
+    else
+    {
+      iBeg[iDim]=cellIndex(boxMin[iDim],x0,h,n);
+      iEnd[iDim]=cellIndex(boxMax[iDim],x0,h,n)+1;
+    }
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef _RECGRID_
+#define _RECGRID_
+void recGridSize(const double* const Rec, const unsigned int& nRec,
+                 double* const gridGeom, unsigned int& nCell);
+/*   Uniform grid of cells over the receivers, with approximately one receiver
+ *   per cell. Dimensions in which all receivers coincide have a single cell.
+ *   Rec       Receiver coordinates (nRec * 3).
+ *   nRec      Number of receivers.
+ *   gridGeom  Grid geometry [x0 y0 z0 hx hy hz nx ny nz] (9), with the origin,
+ *             the cell size and the number of cells in each direction.
+ *   nCell     Total number of cells.
+ */
+#endif
+
+#ifndef _RECGRIDFILL_
+#define _RECGRIDFILL_
+void recGridFill(const double* const Rec, const unsigned int& nRec,
+                 const double* const gridGeom, const unsigned int& nCell,
+                 unsigned int* const cellStart, unsigned int* const cellRec);
+/*   Sorts the receivers in the cells of the grid.
+ *   cellStart Receivers of cell iCell are cellRec[cellStart[iCell]] to
+ *             cellRec[cellStart[iCell+1]-1] (nCell+1).
+ *   cellRec   Receiver indices sorted per cell (nRec).
+ */
+#endif
+
+#ifndef _RECGRIDRANGE_
+#define _RECGRIDRANGE_
+void recGridRange(const double* const gridGeom, const double* const boxMin,
+                  const double* const boxMax, unsigned int* const iBeg,
+                  unsigned int* const iEnd);
+/*   Range of cells [iBeg,iEnd) in each direction that overlaps the box
+ *   [boxMin,boxMax]. The range is empty if the box is outside the grid.
+ */
+#endif
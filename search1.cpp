@@ -1,5 +1,7 @@
 #include <math.h>
+#include <new>
 #include "mex.h"
+#include "search1.h"
 
 void search1(const double xi, const double* const x, const unsigned int& indEnd,
              unsigned int& ind1, unsigned int& ind2, double* const interpval, bool& extrapFlag)
@@ -97,3 +99,158 @@ void searchClosest(const double xi, const double* const x, const unsigned int& x
   }
   else throw("unexpected error in searchClosest");
 }
+
+void searchgridinit(const double* const x, const unsigned int& xend, SearchGrid& grid)
+/* SEARCHGRIDINIT classifies the strictly monotonically increasing vector X
+ * with XEND+1 entries as uniform, log-uniform or irregular, and stores the
+ * lookup plan in GRID. A grid is considered uniform if every abscissa
+ * deviates less than 1e-3 steps from its uniform position; the tolerance
+ * only affects the performance, as the lookup corrects the interval.
+ */
+{
+  const double tol=1e-3;
+
+  grid.type=0;
+  grid.x0=x[0];
+  grid.invStep=0.0;
+  grid.nBucket=0;
+  grid.bucket=0;
+  if (xend==0) return;
+
+  // UNIFORM GRID
+  const double step=(x[xend]-x[0])/xend;
+  bool uniform=true;
+  for (unsigned int i=1; i<xend; i++)
+  {
+    if (fabs(x[i]-(x[0]+i*step))>tol*step)
+    {
+      uniform=false;
+      break;
+    }
+  }
+  if (uniform)
+  {
+    grid.type=1;
+    grid.invStep=1.0/step;
+    return;
+  }
+
+  // LOG-UNIFORM GRID
+  if (x[0]>0.0)
+  {
+    const double logStep=(log(x[xend])-log(x[0]))/xend;
+    bool logUniform=true;
+    for (unsigned int i=1; i<xend; i++)
+    {
+      if (fabs(log(x[i])-(log(x[0])+i*logStep))>tol*logStep)
+      {
+        logUniform=false;
+        break;
+      }
+    }
+    if (logUniform)
+    {
+      grid.type=2;
+      grid.x0=log(x[0]);
+      grid.invStep=1.0/logStep;
+      return;
+    }
+  }
+
+  // IRREGULAR GRID: BUCKET INDEX
+  // The bucket width is the smallest interval, so that a bucket contains at
+  // most two intervals, unless the number of buckets exceeds maxBucket.
+  double minStep=x[1]-x[0];
+  for (unsigned int i=1; i<xend; i++) if (x[i+1]-x[i]<minStep) minStep=x[i+1]-x[i];
+  const double maxBucket=(xend<65536 ? 65536.0 : 1.0*xend);
+  const double nBucket=ceil((x[xend]-x[0])/minStep);
+  grid.nBucket=(unsigned int)(nBucket<maxBucket ? nBucket : maxBucket);
+  if (grid.nBucket<xend) grid.nBucket=xend;
+  grid.bucket=new(std::nothrow) unsigned int[grid.nBucket+1];
+  if (grid.bucket==0) throw("Out of memory.");
+  grid.invStep=grid.nBucket/(x[xend]-x[0]);
+  unsigned int ind=0;
+  for (unsigned int iBucket=0; iBucket<grid.nBucket; iBucket++)
+  {
+    const double xb=x[0]+iBucket/grid.invStep;
+    while ((ind<xend-1) && (x[ind+1]<=xb)) ind++;
+    grid.bucket[iBucket]=ind;
+  }
+  grid.bucket[grid.nBucket]=xend-1;
+}
+
+void searchgridclear(SearchGrid& grid)
+/* SEARCHGRIDCLEAR releases the bucket index of GRID.
+ */
+{
+  if (grid.bucket!=0) delete [] grid.bucket;
+  grid.bucket=0;
+  grid.nBucket=0;
+}
+
+static unsigned int searchgridinterval(const double xi, const double* const x,
+                                       const unsigned int& xend, const SearchGrid& grid)
+/* Returns the index ind of the interval x[ind] <= xi <= x[ind+1] for
+ * x[0] < xi < x[xend].
+ */
+{
+  double t;
+  if (grid.type==2) t=(log(xi)-grid.x0)*grid.invStep;
+  else t=(xi-grid.x0)*grid.invStep;
+  unsigned int ind=0;
+  if (grid.type==0)
+  {
+    // Bisection among the intervals of the bucket
+    unsigned int iBucket=0;
+    if (t>0.0) iBucket=(t<grid.nBucket ? (unsigned int)t : grid.nBucket-1);
+    ind=grid.bucket[iBucket];
+    unsigned int indEnd=grid.bucket[iBucket+1];
+    while (indEnd>ind)
+    {
+      const unsigned int mid=ind+(indEnd-ind+1)/2;
+      if (x[mid]<=xi) ind=mid;
+      else indEnd=mid-1;
+    }
+  }
+  else if (t>0.0) ind=(t<xend ? (unsigned int)t : xend-1);
+  if (ind>xend-1) ind=xend-1;
+  while ((ind>0) && (xi<x[ind])) ind--;
+  while ((ind<xend-1) && (x[ind+1]<xi)) ind++;
+  return ind;
+}
+
+void search1(const double xi, const double* const x, const unsigned int& indEnd,
+             const SearchGrid& grid, unsigned int& ind1, unsigned int& ind2,
+             double* const interpval, bool& extrapFlag)
+/* SEARCH1 performs a 1D table lookup with the lookup plan GRID of X, see
+ * SEARCHGRIDINIT. The results are the same as for SEARCH1 without plan,
+ * but the cost does not depend on the initial guess of ind1.
+ */
+{
+  if ((indEnd==0) || (xi<=x[0]) || (xi>=x[indEnd]))
+  {
+    search1(xi,x,indEnd,ind1,ind2,interpval,extrapFlag);
+    return;
+  }
+  ind1=searchgridinterval(xi,x,indEnd,grid);
+  ind2=ind1+1;
+  interpval[0]=(x[ind2]-xi)/(x[ind2]-x[ind1]);
+  interpval[1]=1.0-interpval[0];
+  extrapFlag=false;
+}
+
+void searchClosest(const double xi, const double* const x, const unsigned int& xend,
+                   const SearchGrid& grid, unsigned int& xind)
+/* SEARCHCLOSEST performs a 1D table lookup of the closest value with the
+ * lookup plan GRID of X, see SEARCHGRIDINIT.
+ */
+{
+  if (xend==0)             xind=0;
+  else if (xi <= x[0])     xind=0;
+  else if (xi >= x[xend])  xind=xend;
+  else
+  {
+    xind=searchgridinterval(xi,x,xend,grid);
+    if (((xi-x[xind])/(x[xind+1]-x[xind]))>0.50) xind+=1;
+  }
+}
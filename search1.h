@@ -13,3 +13,39 @@ void searchClosest(const double xi, const double* const x,
                    const unsigned int& xend, unsigned int& xind);
 
 #endif
+
+#ifndef _SEARCHGRID_
+#define _SEARCHGRID_
+struct SearchGrid
+{
+  unsigned int type;       // 0: irregular, 1: uniform, 2: log-uniform
+  double x0;               // First abscissa, or its logarithm
+  double invStep;          // Inverse of the (logarithmic) step or bucket width
+  unsigned int nBucket;    // Number of buckets of an irregular grid
+  unsigned int* bucket;    // First interval of every bucket (nBucket+1)
+};
+/*   Lookup plan of a strictly monotonically increasing vector x, which
+ *   allows to locate a value in constant time. The type of the grid is
+ *   determined once by SEARCHGRIDINIT. For a uniform or log-uniform grid,
+ *   the interval is computed directly from the (logarithmic) distance to the
+ *   first abscissa. For an irregular grid, the range of x is divided in
+ *   buckets with the width of the smallest interval, at most
+ *   max(65536,nInterval) buckets, and the interval that contains the start
+ *   of the bucket is stored. The interval is then found by bisection among
+ *   the intervals of the bucket, which are at most two unless the number of
+ *   buckets is limited. In all cases, the computed interval is corrected by
+ *   a short local search, so that the result does not depend on the
+ *   classification and rounding errors.
+ */
+
+void searchgridinit(const double* const x, const unsigned int& xend,
+                    SearchGrid& grid);
+void searchgridclear(SearchGrid& grid);
+void search1(const double xi, const double* const x,
+             const unsigned int& xend, const SearchGrid& grid,
+             unsigned int& x1, unsigned int& x2,
+             double* const interpval, bool& extrapFlag);
+void searchClosest(const double xi, const double* const x,
+                   const unsigned int& xend, const SearchGrid& grid,
+                   unsigned int& xind);
+#endif
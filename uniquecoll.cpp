@@ -1,4 +1,5 @@
 #include <math.h>
+#include <limits.h>
 #include <new>
 
 #include "mex.h"
@@ -23,68 +24,56 @@ void uniquecoll(const unsigned int& ms,
                 unsigned int* nuniquescolli,
                 unsigned int* uniquescolliind)
 //==============================================================================
-{          
+{
+       // The unique collocation points are numbered in order of first
+       // appearance in s, and their entries are listed row by row. A lookup
+       // table indexed by the collocation point replaces the search in the
+       // list of unique collocation points, so that the cost is linear in
+       // the number of entries of s.
+       Nuniquescolli[0] = 0;
+       const size_t nEntry=(size_t)ms*ns;
 
-       Nuniquescolli[0] = 0;  
+       unsigned int maxColl=0;
+       for (size_t iColli=0; iColli<nEntry; iColli++)
+       {
+            if (scolli[iColli]>maxColl) maxColl=scolli[iColli];
+       }
+       unsigned int* const uniqueInd=new(nothrow) unsigned int[(size_t)maxColl+1];
+       if (uniqueInd==0) throw("Out of memory.");
+       for (size_t iColl=0; iColl<=maxColl; iColl++) uniqueInd[iColl]=UINT_MAX;
 
        // Get unique collocation points
-       // Determine the total number of unique collocation points
-       // Determine the number of each unique collocation point
-       for (unsigned int iColli=0; iColli<ms*ns; iColli++)
+       for (size_t iColli=0; iColli<nEntry; iColli++)
        {
-
-            unsigned int iuniquescolli=0;
-            unsigned int keyUnique=0;
-
-            while (keyUnique !=1 && iuniquescolli<Nuniquescolli[0])
+            unsigned int& iuniquescolli=uniqueInd[scolli[iColli]];
+            if (iuniquescolli==UINT_MAX)
             {
-               if (scolli[iColli]==uniquescolli[iuniquescolli])
-               {
-                   nuniquescolli[iuniquescolli]++;                                      
-                   keyUnique=1;                   
-               }
-               else
-               {
-                 iuniquescolli++;  
-               }  
+               iuniquescolli=Nuniquescolli[0];
+               uniquescolli[Nuniquescolli[0]]=scolli[iColli];
+               nuniquescolli[Nuniquescolli[0]]=0;
+               Nuniquescolli[0]++;
             }
-            
-            if (keyUnique !=1)
+            nuniquescolli[iuniquescolli]++;
+       }
+
+       // Entries per unique collocation point, row by row
+       unsigned int* const nFilled=new(nothrow) unsigned int[Nuniquescolli[0]+1];
+       if (nFilled==0) {delete [] uniqueInd; throw("Out of memory.");}
+       unsigned int nuniquescollicumsum = 0;
+       for (unsigned int iuniquescolli=0; iuniquescolli<Nuniquescolli[0]; iuniquescolli++)
+       {
+            nFilled[iuniquescolli]=nuniquescollicumsum;
+            nuniquescollicumsum+=nuniquescolli[iuniquescolli];
+       }
+       for (unsigned int iRow=0; iRow<ms; iRow++)
+       {
+            for (unsigned int iCol=0; iCol<ns; iCol++)
             {
-               uniquescolli[Nuniquescolli[0]]=scolli[iColli];          
-               nuniquescolli[Nuniquescolli[0]]=1;
-               Nuniquescolli[0]++;
+               const unsigned int iscolli=iRow+ms*iCol;
+               uniquescolliind[nFilled[uniqueInd[scolli[iscolli]]]++]=iscolli;
             }
-        }
-        
-		// mexPrintf("ms: %d \n",ms);
-		// mexPrintf("ns: %d \n",ns);
-		
-        
-        // Determine the indices of the unique collocation points    
-        unsigned int nuniquescollicumsum = 0;    
-            
-        for (unsigned int iuniquescolli=0;iuniquescolli<Nuniquescolli[0];iuniquescolli++)
-        {
-		   // mexPrintf("iuniquescolli: %d \n",iuniquescolli);
-           unsigned int iscolli = 0;
-           unsigned int inuniquescolli = 0;
-           
-           while (iscolli<ms*ns && inuniquescolli<nuniquescolli[iuniquescolli])
-           {	
-				// mexPrintf("iscolli: %d \n",iscolli);
-                 if (scolli[iscolli] == uniquescolli[iuniquescolli])
-                 {
-                    uniquescolliind[nuniquescollicumsum+inuniquescolli]=iscolli; 
-                    inuniquescolli++;                                   
-                 }
-                 // iscolli++;
-				// iscolli = 
-				if ((iscolli+ms) < (ms*ns)){iscolli+=ms;}
-				else {iscolli=(iscolli + ms) % (ms*ns)+1;}
-				
-           }
-          nuniquescollicumsum+=nuniquescolli[iuniquescolli];  
-        }
+       }
 
+       delete [] nFilled;
+       delete [] uniqueInd;
 }